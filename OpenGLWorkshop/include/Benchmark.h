@@ -0,0 +1,50 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Benchmark.h
+Description : Definitions for the command line benchmark runner
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+class Benchmark
+{
+public:
+	// Runs the named benchmark, returns false if no benchmark has that name
+	static bool run(const std::string& Name, std::uint64_t Seed);
+	static void printUsage();
+
+private:
+	static void instancePoolChurn();
+	static void transformComposition();
+	static void instanceScatter(std::uint64_t Seed);
+	static void impostorRendering(std::uint64_t Seed);
+	static void occlusionCulling(std::uint64_t Seed);
+	static void instanceBvh(std::uint64_t Seed);
+	static void instancePicking(std::uint64_t Seed);
+	static void collisionBroadphase(std::uint64_t Seed);
+	static void swarmSimulation(std::uint64_t Seed);
+	static void instanceAnimation(std::uint64_t Seed);
+	static void fixedTimestep(std::uint64_t Seed);
+	static void simulationPipeline(std::uint64_t Seed);
+	static void jobSystem();
+	static void frameGraph(std::uint64_t Seed);
+	static void renderQueue(std::uint64_t Seed);
+	static void stateFiltering(std::uint64_t Seed);
+	static void commandRecording(std::uint64_t Seed);
+	static void frameProfiler(std::uint64_t Seed);
+	static void traceRecording(std::uint64_t Seed);
+	static void nullBackend(std::uint64_t Seed);
+	static void softwareRasteriser(std::uint64_t Seed);
+};
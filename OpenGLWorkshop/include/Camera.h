@@ -18,23 +18,49 @@ Mail : ayoub.ahmad@mds.ac.nz
 #include <gtc/matrix_transform.hpp>
 #include <glfw3.h>
 
+// Held keys that drive the camera, sampled once per frame and applied on every fixed step of it
+struct CameraInput
+{
+	bool RotateClockwise;
+	bool RotateAntiClockwise;
+	bool MoveCloser;
+	bool MoveAway;
+	bool Fast;
+};
+
 class Camera
 {
 public:
-	Camera(float Radius, float Speed);
+	static constexpr float DefaultRadius = 20.0f;
+	static constexpr float DefaultSpeed = 1.0f; // Radians a second, radius changes five times as fast
+	static constexpr float NearPlane = 0.1f;
+	static constexpr float FarPlane = 100.0f;
+
+	explicit Camera(float Radius = DefaultRadius, float Speed = DefaultSpeed);
 	void toggleMode();
-	void update(float DeltaTime);
-	void processInput(GLFWwindow* Window, float DeltaTime);
+
+	// One fixed simulation step, then interpolate poses the view between the last two steps for rendering
+	void update(float DeltaTime, const CameraInput& Input);
+	void interpolate(float Alpha);
+	static CameraInput sampleInput(GLFWwindow* Window);
 	[[nodiscard]] glm::mat4 getViewMatrix() const;
 	[[nodiscard]] glm::mat4 getProjectionMatrix(float AspectRatio) const;
+	[[nodiscard]] glm::vec3 getPosition() const;
+	[[nodiscard]] float getFieldOfView() const; // Vertical, in radians
+
+	// World space ray from the near plane through a window position, as reported by glfwGetCursorPos
+	void getCursorRay(double CursorX, double CursorY, int WindowWidth, int WindowHeight, glm::vec3& Origin,
+	                  glm::vec3& Direction) const;
 
 private:
 	void updateViewMatrix();
-	void updatePosition();
+	void updatePosition(float Radius, float Angle);
 
 	float MRadius;
 	float MSpeed;
 	float MAngle;
+	float MPreviousRadius; // State before the latest step, the start of the interpolation
+	float MPreviousAngle;
 	bool MAutomatic;
 	float MShiftMultiplier;
 	glm::mat4 MViewMatrix{};
@@ -0,0 +1,112 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : CollisionGrid.h
+Description : Definitions for a uniform hash grid broadphase over the
+			  instance field and sphere against box contacts with it
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "InstanceBvh.h"
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+struct Contact
+{
+	InstanceHandle Instance;
+	glm::vec3 Normal; // Unit, from the box towards the instance
+	float Depth; // Moving the box this far against Normal separates them
+};
+
+enum class ContactEventType
+{
+	Begin,
+	End
+};
+
+struct ContactEvent
+{
+	ContactEventType Type;
+	InstanceHandle Instance;
+};
+
+struct CollisionStats
+{
+	unsigned int Instances;
+	unsigned int Moved; // Instances that changed cell in the last sync
+	unsigned int CellsVisited;
+	unsigned int Candidates; // Broadphase output, before the sphere against box test
+	unsigned int Contacts;
+	double SyncMilliseconds;
+	double QueryMilliseconds;
+};
+
+class CollisionGrid
+{
+public:
+	static constexpr float DefaultCellSize = 2.0f; // About one mine across at the default scatter scale
+
+	explicit CollisionGrid(float CellSize = DefaultCellSize);
+
+	// Incremental updates keyed by handle, moving an instance within its cell only rewrites its sphere
+	void insert(InstanceHandle Handle, const glm::vec3& Center, float Radius);
+	void move(InstanceHandle Handle, const glm::vec3& Center, float Radius);
+	void remove(InstanceHandle Handle);
+
+	// Brings the grid in line with the pool through the calls above. Does nothing while the pool's revision
+	// is unchanged, otherwise only instances that changed cell or were spawned or despawned touch the cells
+	void sync(const InstancePool& Instances, const Model& Model);
+
+	// Finds the instances whose bounding spheres overlap the box and records the contacts, plus Begin and
+	// End events against the previous call
+	void collide(const BvhBounds& Box);
+
+	[[nodiscard]] const std::vector<Contact>& getContacts() const;
+	[[nodiscard]] const std::vector<ContactEvent>& getEvents() const;
+	[[nodiscard]] const CollisionStats& getStats() const;
+
+	// World bounding sphere of a model under Transform
+	static void transformSphere(const Model& Model, const glm::mat4& Transform, glm::vec3& Center, float& Radius);
+
+private:
+	struct Entry
+	{
+		glm::vec3 Center;
+		float Radius;
+		std::uint64_t Cell;
+		std::uint32_t CellIndex; // Position in the cell's list
+		std::uint32_t Generation;
+		std::uint32_t SyncStamp; // Last sync that found it in the pool
+		bool Present;
+	};
+
+	[[nodiscard]] glm::ivec3 cellOf(const glm::vec3& Position) const;
+	static std::uint64_t cellKey(const glm::ivec3& Cell);
+	void unlink(std::uint32_t Slot);
+	void link(std::uint32_t Slot);
+
+	float MCellSize;
+	float MMaxRadius; // Largest sphere ever inserted, queries widen by it since spheres are filed by centre
+	std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> MCells; // Slots per cell
+	std::vector<Entry> MEntries; // Indexed by handle slot
+	std::uint64_t MRevision;
+	std::uint32_t MSyncStamp;
+
+	std::vector<Contact> MContacts;
+	std::vector<Contact> MPreviousContacts;
+	std::vector<ContactEvent> MEvents;
+	CollisionStats MStats{};
+};
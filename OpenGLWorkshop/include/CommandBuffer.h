@@ -0,0 +1,77 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : CommandBuffer.h
+Description : Definitions for draw commands recorded on any thread
+			  and replayed into a render queue by the GL thread
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "InstanceAnimation.h"
+#include "RenderQueue.h"
+
+// A draw as recorded, its uniform set and base instance counting within the buffer that recorded it
+struct RecordedDraw
+{
+	std::uint64_t Key;
+	DrawPacket Packet;
+};
+
+// Draws recorded as plain data, with the per instance data they read copied in alongside. Recording makes no GL
+// call, so any thread may record a buffer while others record theirs. Only replay, on the GL thread, turns it
+// into packets of a render queue
+class CommandBuffer
+{
+public:
+	// As a packet's instance or animation buffer, reads this buffer's own instances from its base instance on
+	static constexpr GLuint RecordedInstances = ~0u;
+
+	CommandBuffer() = default;
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+	// Drops everything recorded, keeping capacity, and starts timing the recording
+	void begin();
+	void end();
+
+	// Uniform values shared by every packet naming the returned index, as RenderQueue::addUniforms
+	std::uint32_t addUniforms(RenderQueue::UniformSetter Setter,
+	                          const std::optional<SceneUniforms>& Scene = std::nullopt);
+	// Copies Count instances in, returning the first one's index among this buffer's instances. Animations may be
+	// null, those instances then read zeros if others in the buffer are animated
+	std::uint32_t addInstances(const glm::mat4* Transforms, const InstanceAnimation* Animations, std::size_t Count);
+	void push(std::uint64_t Key, const DrawPacket& Packet);
+
+	// Pushes every draw into Bucket, with the recorded instances read from the given buffers starting at
+	// BaseInstance. GL thread only, though it makes no GL call itself
+	void replay(RenderQueue& Queue, BucketId Bucket, GLuint TransformBuffer, GLuint AnimationBuffer,
+	            GLuint BaseInstance) const;
+
+	[[nodiscard]] const std::vector<RecordedDraw>& getDraws() const;
+	[[nodiscard]] const std::vector<glm::mat4>& getTransforms() const;
+	[[nodiscard]] const std::vector<InstanceAnimation>& getAnimations() const; // Empty unless any were given
+	[[nodiscard]] double getRecordMilliseconds() const; // From begin to end
+
+private:
+	std::vector<RecordedDraw> MDraws;
+	std::vector<RenderQueue::UniformSet> MUniforms;
+	std::vector<glm::mat4> MTransforms;
+	std::vector<InstanceAnimation> MAnimations;
+	std::chrono::steady_clock::time_point MStart;
+	double MRecordMilliseconds = 0.0;
+};
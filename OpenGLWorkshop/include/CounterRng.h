@@ -0,0 +1,68 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : CounterRng.h
+Description : Definitions for the Philox4x32-10 counter-based random
+			  number generator (Salmon et al. 2011)
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Stateless generator: the same (key, counter) pair always gives the same four numbers,
+// so any element of a sequence can be produced on any thread without stepping a shared state
+class Philox4x32
+{
+public:
+	using Counter = std::array<std::uint32_t, 4>;
+	using Key = std::array<std::uint32_t, 2>;
+
+	static Key makeKey(const std::uint64_t Seed)
+	{
+		return {static_cast<std::uint32_t>(Seed), static_cast<std::uint32_t>(Seed >> 32)};
+	}
+
+	static Counter generate(Counter Block, Key Seed)
+	{
+		for (int Round = 0; Round < 10; Round++)
+		{
+			Block = round(Block, Seed);
+			Seed[0] += 0x9E3779B9u; // Weyl sequence key schedule
+			Seed[1] += 0xBB67AE85u;
+		}
+		return Block;
+	}
+
+	// Uniform float in [0, 1) from the top 24 bits
+	static float toUnitFloat(const std::uint32_t Value)
+	{
+		return static_cast<float>(Value >> 8) * (1.0f / 16777216.0f);
+	}
+
+	static float toRange(const std::uint32_t Value, const float Min, const float Max)
+	{
+		return Min + (Max - Min) * toUnitFloat(Value);
+	}
+
+private:
+	static Counter round(const Counter& Block, const Key& Seed)
+	{
+		const std::uint64_t Product0 = static_cast<std::uint64_t>(0xD2511F53u) * Block[0];
+		const std::uint64_t Product1 = static_cast<std::uint64_t>(0xCD9E8D57u) * Block[2];
+		return {
+			static_cast<std::uint32_t>(Product1 >> 32) ^ Block[1] ^ Seed[0],
+			static_cast<std::uint32_t>(Product1),
+			static_cast<std::uint32_t>(Product0 >> 32) ^ Block[3] ^ Seed[1],
+			static_cast<std::uint32_t>(Product0)
+		};
+	}
+};
@@ -0,0 +1,134 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FlockSimulation.h
+Description : Definitions for a flock of ships steering by separation,
+			  alignment and cohesion around the instance field
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+#include "SpatialHash.h"
+
+struct FlockSettings
+{
+	std::uint64_t Seed = 0;
+	float NeighbourRadius = 1.5f; // Also the agent hash's cell size
+	float SeparationRadius = 0.5f;
+	unsigned int MaxNeighbours = 16; // Nearby agents past this are ignored, keeps dense clumps affordable
+	float SeparationWeight = 2.0f;
+	float AlignmentWeight = 1.0f;
+	float CohesionWeight = 0.6f;
+	float AvoidanceWeight = 6.0f;
+	float AvoidanceMargin = 0.75f; // Clearance kept from the surface of each instance's bounding sphere
+	float BoundsRadius = 12.0f; // Agents further than this from the origin turn back
+	float BoundsWeight = 1.0f;
+	float MinSpeed = 1.0f;
+	float MaxSpeed = 3.0f;
+	float MaxAcceleration = 6.0f;
+	float ShipScale = 0.0003f; // The moving object's model is the ship, at a third of its scale
+};
+
+struct FlockStats
+{
+	unsigned int Agents;
+	unsigned int Obstacles;
+	double Neighbours; // Average considered per agent in the last step
+	double HashMilliseconds;
+	double SteerMilliseconds;
+	double IntegrateMilliseconds;
+	double TransformMilliseconds;
+};
+
+// Agent state kept component-wise so the integration kernels can load several agents per register
+struct FlockAgents
+{
+	std::vector<float> PositionX;
+	std::vector<float> PositionY;
+	std::vector<float> PositionZ;
+	std::vector<float> VelocityX;
+	std::vector<float> VelocityY;
+	std::vector<float> VelocityZ;
+	std::vector<float> AccelerationX;
+	std::vector<float> AccelerationY;
+	std::vector<float> AccelerationZ;
+
+	[[nodiscard]] std::size_t size() const;
+	void resize(std::size_t Count);
+};
+
+class FlockSimulation
+{
+public:
+	explicit FlockSimulation(const FlockSettings& Settings = {});
+
+	// Places Count agents inside the bounds with random headings, derived from the seed alone
+	void spawn(unsigned int Count);
+
+	// Instances the flock steers around. The pool overload only rebuilds when the pool's revision changes
+	void setObstacles(const InstancePool& Instances, const Model& Model);
+	void setObstacles(const std::vector<glm::vec4>& Spheres); // Centre and radius
+
+	// Rebuilds the agent hash, steers every agent against its neighbours and obstacles, then integrates
+	// and writes the ship transforms, all across the worker threads
+	void step(float DeltaTime);
+
+	// Moves the ship transforms Alpha of the way from the positions before the last step to those after it
+	void interpolate(float Alpha);
+
+	[[nodiscard]] std::size_t getCount() const;
+	[[nodiscard]] const FlockAgents& getAgents() const;
+	[[nodiscard]] const std::vector<glm::mat4>& getTransforms() const;
+	[[nodiscard]] const FlockStats& getStats() const;
+	[[nodiscard]] FlockSettings& getSettings();
+
+	// Velocity += acceleration * DeltaTime with speed clamped to [MinSpeed, MaxSpeed], then position +=
+	// velocity * DeltaTime, for agents [Begin, End) using the widest kernel the CPU supports
+	static void integrate(FlockAgents& Agents, std::size_t Begin, std::size_t End, float DeltaTime, float MinSpeed,
+	                      float MaxSpeed);
+	static void integrateScalar(FlockAgents& Agents, std::size_t Begin, std::size_t End, float DeltaTime,
+	                            float MinSpeed, float MaxSpeed);
+	static void integrateSse(FlockAgents& Agents, std::size_t Begin, std::size_t End, float DeltaTime,
+	                         float MinSpeed, float MaxSpeed);
+	static void integrateAvx2(FlockAgents& Agents, std::size_t Begin, std::size_t End, float DeltaTime,
+	                          float MinSpeed, float MaxSpeed);
+	static const char* getKernelName();
+
+private:
+	// Agent state gathered into hash order, so the agents of a cell sit in one run of memory
+	struct Neighbour
+	{
+		glm::vec3 Position;
+		std::uint32_t Index;
+		glm::vec3 Velocity;
+		float Padding;
+	};
+
+	void steer(std::size_t BeginSlot, std::size_t EndSlot, unsigned long long& Neighbours);
+	void writeTransforms(std::size_t Begin, std::size_t End);
+
+	FlockSettings MSettings;
+	FlockAgents MAgents;
+	SpatialHash MAgentHash;
+	std::vector<Neighbour> MNeighbours;
+	SpatialHash MObstacleHash; // Cell size covers the largest sphere plus the margin
+	std::vector<glm::vec4> MObstacles; // Centre and radius, in obstacle hash order
+	std::uint64_t MObstacleRevision;
+	std::vector<glm::vec3> MPreviousPositions; // Before the latest step, for interpolate
+	std::vector<glm::mat4> MTransforms;
+	FlockStats MStats{};
+};
@@ -0,0 +1,50 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FrameClock.h
+Description : Definitions for the fixed step accumulator that decouples
+			  simulation from the frame rate
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+// Each frame adds the real time since the last one and hands back how many whole fixed steps to simulate.
+// What's left over becomes the blend between the last two simulated states for rendering
+class FrameClock
+{
+public:
+	static constexpr double DefaultStep = 1.0 / 60.0;
+	static constexpr int DefaultMaxSteps = 8; // Beyond this a frame falls behind rather than spiralling
+
+	explicit FrameClock(double StepSeconds = DefaultStep, int MaxSteps = DefaultMaxSteps);
+
+	// Starts a frame at Now, in seconds from any steady clock, and returns the fixed steps to run before
+	// rendering it. The first call only starts the clock
+	int beginFrame(double Now);
+
+	[[nodiscard]] float getStep() const; // Seconds per fixed step
+	[[nodiscard]] float getAlpha() const; // Blend from the previous simulated state (0) to the latest (1)
+	[[nodiscard]] int getSteps() const; // Fixed steps the current frame asked for
+	[[nodiscard]] double getFrameSeconds() const; // Real time since the previous frame
+	[[nodiscard]] double getSimulationTime() const; // Time of the latest simulated state
+	[[nodiscard]] double getRenderTime() const; // Time of the blended state the frame shows
+	[[nodiscard]] double getDroppedSeconds() const; // Real time thrown away over MaxSteps, in total
+
+private:
+	double MStep;
+	int MMaxSteps;
+	bool MStarted;
+	double MLastTime;
+	double MAccumulator;
+	double MFrameSeconds;
+	double MSimulationTime;
+	double MDroppedSeconds;
+	int MSteps;
+};
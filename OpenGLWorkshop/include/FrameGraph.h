@@ -0,0 +1,102 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FrameGraph.h
+Description : Definitions for declaring a frame as a graph of tasks
+			  with dependencies, run across the job system's threads
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+using TaskId = std::size_t;
+
+enum class TaskAffinity
+{
+	Any, // Whichever thread picks it up
+	MainThread // The thread calling run, for anything that needs the GL context
+};
+
+// One task as declared, with its timing from the latest run
+struct FrameTask
+{
+	std::string Name;
+	std::function<void()> Body;
+	TaskAffinity Affinity;
+	std::vector<TaskId> Dependencies;
+	std::vector<TaskId> Successors;
+	double StartMilliseconds; // From the start of the run
+	double Milliseconds;
+	bool RanOnMainThread;
+};
+
+class FrameGraph
+{
+public:
+	FrameGraph();
+
+	FrameGraph(const FrameGraph&) = delete;
+	FrameGraph& operator=(const FrameGraph&) = delete;
+
+	// Dependencies must already be in the graph, so the order tasks are added in is always a valid serial order
+	TaskId addTask(std::string Name, std::function<void()> Body, std::initializer_list<TaskId> Dependencies = {},
+	               TaskAffinity Affinity = TaskAffinity::Any);
+
+	// Runs every task once, each as soon as its dependencies are done. Main thread tasks run on the caller, which
+	// helps with the job system's queue while it has none ready. Unthreaded, every task runs on the caller in
+	// the order they were added
+	void run();
+	void setThreaded(bool Threaded);
+	[[nodiscard]] bool isThreaded() const;
+
+	[[nodiscard]] const std::deque<FrameTask>& getTasks() const;
+	[[nodiscard]] const FrameTask& getTask(TaskId Task) const;
+	[[nodiscard]] double getFrameMilliseconds() const; // Wall time of the latest run
+	// Latest run less the graph's tasks the caller ran, its time waiting on workers or helping with other jobs
+	[[nodiscard]] double getIdleMilliseconds() const;
+
+	// Longest chain of dependent tasks by their own durations in the latest run, first to last. No schedule
+	// can finish a run sooner than its length
+	[[nodiscard]] std::vector<TaskId> getCriticalPath() const;
+	[[nodiscard]] double getCriticalPathMilliseconds() const;
+
+	void printTasks(std::ostream& Out) const; // Every task with its dependencies and timing
+	void printCriticalPath(std::ostream& Out) const; // One line
+
+private:
+	void release(TaskId Task);
+	void execute(TaskId Task);
+
+	std::deque<FrameTask> MTasks; // A deque so the counters below never move
+	std::deque<std::atomic<int>> MPending; // Dependencies of each task still running this run
+	bool MThreaded;
+	std::size_t MMainThreadTasks;
+	std::mutex MReadyMutex; // Guards MMainReady
+	std::vector<TaskId> MMainReady; // Main thread tasks whose dependencies are done
+	std::atomic<std::size_t> MMainDone;
+	JobCounter MWorkers; // Tasks handed to the job system and not yet finished
+	std::thread::id MMainThread;
+	std::chrono::steady_clock::time_point MStart;
+	double MFrameMilliseconds;
+	double MIdleMilliseconds;
+};
@@ -0,0 +1,213 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlCapture.h
+Description : Definitions for recording every GL call with the contents
+			  it passes into a binary trace, for replaying offline
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <cstddef>
+#include <cstdint>
+
+// Every call a trace records, by its GL name without the prefix, as the byte starting its record
+enum class GlCall : std::uint8_t
+{
+	AttachShader,
+	BindBuffer,
+	BindFramebuffer,
+	BindRenderbuffer,
+	BindTextureUnit,
+	BindVertexArray,
+	BlendFunc,
+	BlitNamedFramebuffer,
+	CheckFramebufferStatus,
+	CheckNamedFramebufferStatus,
+	Clear,
+	ClearColor,
+	ClearNamedFramebufferfv,
+	ClientWaitSync,
+	CompileShader,
+	CopyNamedBufferSubData,
+	CreateBuffers,
+	CreateFramebuffers,
+	CreateProgram,
+	CreateQueries,
+	CreateRenderbuffers,
+	CreateShader,
+	CreateTextures,
+	CreateVertexArrays,
+	CullFace,
+	DeleteBuffers,
+	DeleteFramebuffers,
+	DeleteProgram,
+	DeleteQueries,
+	DeleteRenderbuffers,
+	DeleteShader,
+	DeleteSync,
+	DeleteTextures,
+	DeleteVertexArrays,
+	DepthFunc,
+	DepthMask,
+	Disable,
+	DisableVertexArrayAttrib,
+	DrawArrays,
+	DrawArraysInstancedBaseInstance,
+	DrawElements,
+	DrawElementsInstancedBaseInstance,
+	Enable,
+	EnableVertexArrayAttrib,
+	FenceSync,
+	Finish,
+	FramebufferRenderbuffer,
+	FramebufferTexture2D,
+	GenFramebuffers,
+	GenRenderbuffers,
+	GenerateTextureMipmap,
+	GetError,
+	GetFloatv,
+	GetInteger64v,
+	GetIntegerv,
+	GetNamedBufferParameteriv,
+	GetNamedBufferSubData,
+	GetProgramInfoLog,
+	GetProgramiv,
+	GetQueryObjectiv,
+	GetQueryObjectui64v,
+	GetShaderInfoLog,
+	GetShaderiv,
+	GetTextureImage,
+	GetTextureLevelParameteriv,
+	GetUniformLocation,
+	LinkProgram,
+	MapNamedBufferRange,
+	NamedBufferData,
+	NamedBufferStorage,
+	NamedBufferSubData,
+	NamedFramebufferRenderbuffer,
+	NamedFramebufferTexture,
+	NamedRenderbufferStorage,
+	PolygonMode,
+	QueryCounter,
+	ReadPixels,
+	RenderbufferStorage,
+	ShaderSource,
+	TextureParameteri,
+	TextureStorage2D,
+	TextureSubImage2D,
+	Uniform1f,
+	Uniform1i,
+	Uniform2fv,
+	Uniform3fv,
+	Uniform4fv,
+	UniformMatrix4fv,
+	UseProgram,
+	VertexArrayAttribBinding,
+	VertexArrayAttribFormat,
+	VertexArrayBindingDivisor,
+	VertexArrayElementBuffer,
+	VertexArrayVertexBuffer,
+	Viewport,
+	MappedWrite, // Bytes copied into mapped memory, which never passes through GL
+	EndFrame,
+	Count
+};
+
+// Since the capture started
+struct GlCaptureStats
+{
+	std::uint64_t Calls;
+	std::uint64_t Frames;
+	std::uint64_t Bytes; // Of the whole trace
+	std::uint64_t ContentBytes; // Of buffers, textures, shader sources and mapped writes
+};
+
+// Records every GL call made while capturing into a trace that GlReplay runs again without the app. Calls through
+// GLEW are caught by swapping its function pointers, and GL 1.1 through the GlCore pointers below, so nothing
+// calling GL has to know. Writes into persistently mapped buffers never reach GL and are recorded by the code
+// making them. GL thread only.
+//
+// A trace starts with Magic, Version and the window's framebuffer size as 32 bit words, then each call is its
+// GlCall byte followed by its arguments in order. Booleans take 8 bits, enums, names and counts 32, sizes,
+// offsets and syncs 64, and contents a 64 bit length then the bytes. Names made and values returned follow the
+// arguments. All in the machine's byte order, little endian wherever the app builds
+class GlCapture
+{
+public:
+	static constexpr const char* DefaultPath = "capture.gltrace";
+	static constexpr std::uint32_t Magic = 0x50434c47; // "GLCP"
+	static constexpr std::uint32_t Version = 1;
+
+	// Straight after glewInit, as a replay only has the objects made while capturing. The size is of the window's
+	// framebuffer, which a replay stands in for with one of its own. Returns false if the file couldn't be opened
+	static bool start(const char* Path, unsigned int Width, unsigned int Height);
+	// Puts the driver's functions back and writes out the rest. Returns false if the file couldn't be written
+	static bool stop();
+	[[nodiscard]] static bool isRecording();
+
+	// Once the frame's last call is made. Call it once loading is done too, as a replay reports its first frame as
+	// the loading
+	static void endFrame();
+	// Size bytes from Source, copied to Destination in memory mapped from a GL buffer. Does nothing while not
+	// recording or for memory GL didn't map
+	static void recordMappedWrite(const void* Destination, const void* Source, std::size_t Size);
+
+	[[nodiscard]] static const GlCaptureStats& getStats();
+	[[nodiscard]] static const char* getCallName(GlCall Call);
+};
+
+// GL 1.1 is linked straight to the driver rather than through GLEW's pointers, which capture couldn't swap. The
+// entry points the app calls get pointers of their own here. Include this last, after glew.h, in any file calling
+// them, and their calls are made through these
+namespace GlCore
+{
+	extern decltype(&::glBlendFunc) BlendFunc;
+	extern decltype(&::glClear) Clear;
+	extern decltype(&::glClearColor) ClearColor;
+	extern decltype(&::glCullFace) CullFace;
+	extern decltype(&::glDeleteTextures) DeleteTextures;
+	extern decltype(&::glDepthFunc) DepthFunc;
+	extern decltype(&::glDepthMask) DepthMask;
+	extern decltype(&::glDisable) Disable;
+	extern decltype(&::glDrawArrays) DrawArrays;
+	extern decltype(&::glDrawElements) DrawElements;
+	extern decltype(&::glEnable) Enable;
+	extern decltype(&::glFinish) Finish;
+	extern decltype(&::glGetError) GetError;
+	extern decltype(&::glGetFloatv) GetFloatv;
+	extern decltype(&::glGetIntegerv) GetIntegerv;
+	extern decltype(&::glPolygonMode) PolygonMode;
+	extern decltype(&::glReadPixels) ReadPixels;
+	extern decltype(&::glViewport) Viewport;
+}
+
+// Left out where the pointers are set to the driver's functions
+#ifndef GL_CORE_DIRECT
+#define glBlendFunc GlCore::BlendFunc
+#define glClear GlCore::Clear
+#define glClearColor GlCore::ClearColor
+#define glCullFace GlCore::CullFace
+#define glDeleteTextures GlCore::DeleteTextures
+#define glDepthFunc GlCore::DepthFunc
+#define glDepthMask GlCore::DepthMask
+#define glDisable GlCore::Disable
+#define glDrawArrays GlCore::DrawArrays
+#define glDrawElements GlCore::DrawElements
+#define glEnable GlCore::Enable
+#define glFinish GlCore::Finish
+#define glGetError GlCore::GetError
+#define glGetFloatv GlCore::GetFloatv
+#define glGetIntegerv GlCore::GetIntegerv
+#define glPolygonMode GlCore::PolygonMode
+#define glReadPixels GlCore::ReadPixels
+#define glViewport GlCore::Viewport
+#endif
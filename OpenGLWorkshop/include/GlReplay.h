@@ -0,0 +1,40 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlReplay.h
+Description : Definitions for running a recorded GL trace again off screen,
+			  timing every call and frame
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include "GlCapture.h"
+#include "HeadlessHarness.h"
+
+struct ReplaySettings
+{
+	const char* TracePath = GlCapture::DefaultPath;
+	HeadlessContext Context = HeadlessContext::Native;
+	const char* OutputPath = nullptr; // Standard output when null
+	const char* ImagePath = nullptr; // The last frame as a PPM when set
+};
+
+// Runs a trace from GlCapture again in a hidden window with none of the app, so the same workload can be
+// profiled over and over against different drivers or builds. The window's framebuffer is stood in for by a
+// framebuffer object of the size recorded. Names, uniform locations, syncs and mapped memory are the replay's
+// own, looked up from the ones recorded. Each call's CPU time is taken as it's made; GL queues most of them, so
+// the GPU's share shows in the frame times, which wait for it at the end of every frame. The trace is read whole
+// before anything runs, and its first frame is the app's loading, reported on its own
+class GlReplay
+{
+public:
+	// Returns the process exit code, 0 once the report is written
+	static int run(const ReplaySettings& Settings);
+};
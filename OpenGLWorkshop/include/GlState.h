@@ -0,0 +1,80 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlState.h
+Description : Definitions for a cache of bound GL state that drops
+			  calls which would change nothing, with counters
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+
+enum class GlStateCall
+{
+	Program,
+	VertexArray,
+	Texture,
+	Buffer,
+	Capability, // Enabling or disabling blending, depth testing or face culling
+	BlendFunc,
+	DepthFunc,
+	DepthMask,
+	CullFace,
+	PolygonMode,
+	Count
+};
+
+// Calls through the cache since the last reset, by kind
+struct GlStateStats
+{
+	unsigned int Issued[static_cast<int>(GlStateCall::Count)];
+	unsigned int Filtered[static_cast<int>(GlStateCall::Count)]; // Already the current state, never reached GL
+	unsigned int TotalIssued;
+	unsigned int TotalFiltered;
+};
+
+// Remembers what the context has bound and enabled, so setting what is already current costs nothing. Everything
+// outside it that changes the same state must go through it, or call invalidate afterwards. Only for the thread
+// that owns the context. Objects are edited through direct state access elsewhere, so binds only happen for draws
+class GlState
+{
+public:
+	static constexpr GLuint TextureUnits = 16; // Tracked, higher units always reach GL
+
+	static void useProgram(GLuint Program);
+	static void bindVertexArray(GLuint Vao);
+	static void bindTexture(GLuint Unit, GLuint Texture); // Any target, without changing the active unit
+	// Element array buffers belong to the bound VAO and always reach GL
+	static void bindBuffer(GLenum Target, GLuint Buffer);
+
+	static void setEnabled(GLenum Capability, bool Enabled); // GL_BLEND, GL_DEPTH_TEST and GL_CULL_FACE are tracked
+	static void blendFunc(GLenum Source, GLenum Destination);
+	static void depthFunc(GLenum Function);
+	static void depthMask(bool Write);
+	static void cullFace(GLenum Face);
+	static void polygonMode(GLenum Mode); // Front and back together
+
+	// Deletes the objects, forgetting any binding of them the way GL reverts those to 0
+	static void deleteVertexArrays(GLsizei Count, const GLuint* VertexArrays);
+	static void deleteTextures(GLsizei Count, const GLuint* Textures);
+	static void deleteBuffers(GLsizei Count, const GLuint* Buffers);
+
+	// Treats everything as unknown, so the next call of each kind reaches GL. For a new context, or after code
+	// that set state directly
+	static void invalidate();
+
+	// Off sends every call to GL, counted as issued, to measure what filtering saves
+	static void setFilteringEnabled(bool Enabled);
+	[[nodiscard]] static bool isFilteringEnabled();
+
+	[[nodiscard]] static const GlStateStats& getStats();
+	static void resetStats();
+};
@@ -0,0 +1,74 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : HeadlessHarness.h
+Description : Definitions for a scripted run of the scene rendered off
+			  screen, reported as JSON
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct GLFWwindow;
+
+// How the hidden window's context is created. Native is the platform's own, EGL and OSMesa suit machines with
+// no display or GPU, where Mesa's llvmpipe renders
+enum class HeadlessContext
+{
+	Native,
+	Egl,
+	OsMesa
+};
+
+// What the renderer submits through. Null times the CPU side alone, software rasterises on the CPU with no GPU
+enum class HeadlessBackend
+{
+	Gl,
+	Null,
+	Software
+};
+
+struct HeadlessSettings
+{
+	unsigned int Frames = 600;
+	std::uint64_t Seed = 0;
+	unsigned int Width = 1280; // Of the framebuffer drawn into, the window is never shown
+	unsigned int Height = 720;
+	unsigned int InstanceCount = 1000; // As the app
+	unsigned int SwarmCount = 2000;
+	bool Animate = false;
+	HeadlessBackend Backend = HeadlessBackend::Gl;
+	HeadlessContext Context = HeadlessContext::Native;
+	const char* OutputPath = nullptr; // Standard output when null
+	const char* ImagePath = nullptr; // The last frame as a PPM when set
+	const char* CapturePath = nullptr; // Every GL call of the run recorded here for GlReplay when set
+};
+
+// Loads the app's scene into a hidden window and draws it into a framebuffer object for a set number of frames,
+// along a camera path scripted from the frame number alone. With the same seed every run draws the same frames,
+// so runs can be compared across machines and builds. Each stage of the frame is timed on the CPU, which bounds
+// the frame rate from above whatever the GPU
+class HeadlessHarness
+{
+public:
+	// Returns the process exit code, 0 once the report is written
+	static int run(const HeadlessSettings& Settings);
+
+	// A hidden window current with a 4.6 core context and GLEW initialised. Returns false, with GLFW terminated,
+	// if either failed
+	static bool openContext(HeadlessContext Context, GLFWwindow*& Window);
+	// FNV-1a over the pixels' bytes, as the report gives the image
+	[[nodiscard]] static std::uint64_t hashImage(const std::vector<std::uint32_t>& Pixels);
+	// As a line of the report, the mean and nearest rank percentiles of the values
+	static void writeDistribution(std::ostream& Out, const char* Name, const std::vector<double>& Values);
+};
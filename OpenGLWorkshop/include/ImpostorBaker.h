@@ -0,0 +1,52 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : ImpostorBaker.h
+Description : Definitions for baking a model into an octahedral atlas of
+			  views that far instances draw as camera facing quads
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+
+#include "ModelLoader.h"
+
+// Grid of views over the octahedrally mapped sphere of directions around a model. Frame (X, Y) looks at the
+// model from octahedralDirection((X, Y) / (GridSize - 1)) with frameUp of that direction as its up vector
+struct ImpostorAtlas
+{
+	GLuint Texture;
+	int GridSize;
+	int FrameResolution;
+	glm::vec3 Center; // Model space bounding sphere the frames are framed on
+	float Radius;
+	GLuint QuadVao; // Unit quad, instance matrices go to attributes 3-6 like the mesh VAOs
+	GLuint QuadVbo;
+};
+
+class ImpostorBaker
+{
+public:
+	static constexpr int DefaultGridSize = 8;
+	static constexpr int DefaultFrameResolution = 128;
+
+	// Renders LOD 0 of the model once per frame into an offscreen framebuffer with the scene shader program.
+	// Requires a current OpenGL context, the previous framebuffer, viewport and clear colour are restored
+	static ImpostorAtlas bake(const Model& Model, GLuint ShaderProgram, int GridSize = DefaultGridSize,
+	                          int FrameResolution = DefaultFrameResolution);
+	static void release(ImpostorAtlas& Atlas);
+
+	// Unit direction for a point of the [0, 1] square and back, the lower hemisphere folds into the corners
+	static glm::vec3 octahedralDirection(const glm::vec2& Coordinate);
+	static glm::vec2 octahedralCoordinate(const glm::vec3& Direction);
+	static glm::vec3 frameUp(const glm::vec3& Direction);
+};
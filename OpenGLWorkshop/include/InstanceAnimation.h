@@ -0,0 +1,46 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceAnimation.h
+Description : Definitions for per instance motion evaluated from time,
+			  on the GPU when drawing and on the CPU when picking or
+			  culling
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+
+#include "ModelLoader.h"
+
+// A spin about a model space axis through the model's origin, then a bob along world Y. All zero is static.
+// Matches the instanceSpin and instanceBob attributes of VertexShader.vert
+struct InstanceAnimation
+{
+	glm::vec4 Spin; // xyz unit axis, w radians per second
+	glm::vec4 Bob; // x amplitude, y radians per second, z phase in radians, w unused
+};
+
+class InstanceAnimator
+{
+public:
+	[[nodiscard]] static bool isAnimated(const InstanceAnimation& Animation);
+
+	// Base transform posed at Time, the same expression the vertex shaders evaluate
+	[[nodiscard]] static glm::mat4 evaluate(const glm::mat4& Base, const InstanceAnimation& Animation, float Time);
+
+	// Where a model space point is at Time, cheaper than evaluate when only a point is needed
+	[[nodiscard]] static glm::vec3 evaluatePoint(const glm::mat4& Base, const InstanceAnimation& Animation, float Time,
+	                                             const glm::vec3& Point);
+
+	// World bounding sphere holding the model in every pose, for structures that aren't rebuilt per frame
+	static void sweptSphere(const Model& Model, const glm::mat4& Base, const InstanceAnimation& Animation,
+	                        glm::vec3& Center, float& Radius);
+};
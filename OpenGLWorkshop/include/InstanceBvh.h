@@ -0,0 +1,130 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceBvh.h
+Description : Definitions for a bounding volume hierarchy over instance
+			  world bounds with frustum, ray and sphere queries
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+struct BvhBounds
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+};
+
+// 32 bytes, two nodes per cache line. Nodes are stored depth first, so an interior node's left child is the
+// next node and LeftOrFirst holds the right child. A leaf holds Count primitives starting at LeftOrFirst
+struct BvhNode
+{
+	glm::vec3 Min;
+	std::uint32_t LeftOrFirst;
+	glm::vec3 Max;
+	std::uint32_t Count; // 0 for interior nodes
+};
+
+struct BvhRayHit
+{
+	std::uint32_t Index; // Dense pool index, NoHit when nothing was hit
+	float Distance;
+};
+
+class InstanceBvh
+{
+public:
+	static constexpr std::uint32_t NoHit = 0xFFFFFFFFu;
+	static constexpr int BinCount = 16;
+	static constexpr std::uint32_t MaxLeafSize = 4;
+	static constexpr float RebuildThreshold = 1.5f; // Refit SAH cost relative to the cost after the last build
+
+	// Returns the exact hit distance along the ray for an instance whose box was hit, or a negative value
+	using RayTest = std::function<float(std::uint32_t Index)>;
+
+	InstanceBvh() = default;
+	~InstanceBvh();
+
+	// Delete the copy constructor and copy assignment operator
+	InstanceBvh(const InstanceBvh&) = delete;
+	InstanceBvh& operator=(const InstanceBvh&) = delete;
+
+	// Box around a model space box after Transform
+	static BvhBounds transformBounds(const glm::vec3& Min, const glm::vec3& Max, const glm::mat4& Transform);
+
+	// World bounds of every pooled instance, the model's local box transformed by each instance matrix, or
+	// a box around the swept sphere of an animated one
+	static void computeBounds(const InstancePool& Instances, const Model& Model, std::vector<BvhBounds>& Bounds);
+
+	// Binned SAH build over dense pool indices [0, Bounds.size())
+	void build(const InstancePool& Instances, const Model& Model);
+	void build(const std::vector<BvhBounds>& Bounds);
+
+	// Recomputes node bounds bottom up for moved instances without changing the topology. Spawns and
+	// despawns change the dense indices, so they need a build instead
+	void refit(const InstancePool& Instances, const Model& Model);
+	[[nodiscard]] bool needsRebuild() const;
+
+	// Builds a replacement tree on a worker thread from a snapshot of the current bounds while this one keeps
+	// answering queries. finishRebuild swaps it in once it's ready and returns true, it never blocks
+	void rebuildAsync(const InstancePool& Instances, const Model& Model);
+	bool finishRebuild();
+	[[nodiscard]] bool isRebuilding() const;
+
+	// Appends the dense indices of instances whose boxes touch the frustum or sphere
+	void queryFrustum(const glm::mat4& ViewProjection, std::vector<std::uint32_t>& Out) const;
+	void querySphere(const glm::vec3& Center, float Radius, std::vector<std::uint32_t>& Out) const;
+
+	// Nearest instance along the ray. Without a test the box entry distance counts as the hit, with one the
+	// boxes are visited front to back and only the test's distances count
+	[[nodiscard]] BvhRayHit raycast(const glm::vec3& Origin, const glm::vec3& Direction, float MaxDistance,
+	                                const RayTest& Test = {}) const;
+
+	[[nodiscard]] const std::vector<BvhNode>& getNodes() const;
+	[[nodiscard]] std::size_t getPrimitiveCount() const;
+	[[nodiscard]] float getCost() const; // SAH cost of the current bounds
+	[[nodiscard]] float getBuildCost() const;
+
+private:
+	struct Tree
+	{
+		std::vector<BvhNode> Nodes;
+		std::vector<std::uint32_t> Indices; // Leaf ranges index into this, its entries are dense pool indices
+		std::vector<BvhBounds> Bounds; // Primitive bounds in the same order as Indices
+		float Cost = 0.0f;
+	};
+
+	struct BuildPrimitive
+	{
+		glm::vec3 Min;
+		std::uint32_t Index;
+		glm::vec3 Max;
+		glm::vec3 Centroid;
+	};
+
+	static Tree buildTree(const std::vector<BvhBounds>& Bounds);
+	static void buildNode(Tree& Result, std::vector<BuildPrimitive>& Primitives, std::uint32_t NodeIndex,
+	                      std::uint32_t First, std::uint32_t Count, const BvhBounds& NodeBounds,
+	                      const BvhBounds& CentroidBounds, std::uint32_t Depth);
+	static float computeCost(const std::vector<BvhNode>& Nodes);
+
+	Tree MTree;
+	float MBuildCost = 0.0f;
+	std::vector<BvhBounds> MBounds; // Scratch for refits
+	std::future<Tree> MPendingTree;
+};
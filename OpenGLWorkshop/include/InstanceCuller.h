@@ -0,0 +1,76 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceCuller.h
+Description : Definitions for per instance frustum and screen-size
+			  contribution culling over bounding spheres
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+struct CullSettings
+{
+	bool FrustumCulling = true;
+	bool ContributionCulling = true;
+	float MinPixelDiameter = 2.0f; // Instances projecting smaller than this are dropped
+};
+
+struct CullStats
+{
+	unsigned int Tested;
+	unsigned int FrustumCulled;
+	unsigned int ContributionCulled;
+	unsigned int Visible;
+	double Milliseconds;
+};
+
+class InstanceCuller
+{
+public:
+	// Tests every pooled instance's bounding sphere against the frustum planes and the pixel threshold in one
+	// pass. ProjectionScale converts world size at unit distance into pixels (viewport height / (2 tan(fov / 2))).
+	// Animated instances are posed at Time first
+	void cull(const InstancePool& Instances, const Model& Model, const glm::mat4& ViewProjection,
+	          const glm::vec3& CameraPosition, float ProjectionScale, const CullSettings& Settings,
+	          float Time = 0.0f);
+
+	// Dense pool indices that survived, in pool order, with the projected diameter of each
+	[[nodiscard]] const std::vector<std::uint32_t>& getVisible() const;
+	[[nodiscard]] const std::vector<float>& getPixelDiameters() const;
+	[[nodiscard]] const CullStats& getStats() const;
+
+	static float projectedDiameter(float Radius, float Distance, float ProjectionScale);
+
+private:
+	void gatherSpheres(const InstancePool& Instances, const Model& Model, float Time);
+	void testScalar(std::size_t Begin, std::size_t End, const glm::vec4* Planes, const glm::vec3& CameraPosition,
+	                float ProjectionScale, const CullSettings& Settings);
+	void testSse(std::size_t Begin, std::size_t End, const glm::vec4* Planes, const glm::vec3& CameraPosition,
+	             float ProjectionScale, const CullSettings& Settings);
+	void testAvx2(std::size_t Begin, std::size_t End, const glm::vec4* Planes, const glm::vec3& CameraPosition,
+	              float ProjectionScale, const CullSettings& Settings);
+
+	// World bounding spheres as SoA so the test pass loads several instances per register
+	std::vector<float> MCenterX;
+	std::vector<float> MCenterY;
+	std::vector<float> MCenterZ;
+	std::vector<float> MRadius;
+
+	std::vector<std::uint32_t> MVisible;
+	std::vector<float> MPixelDiameters;
+	CullStats MStats{};
+};
@@ -0,0 +1,81 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstancePicker.h
+Description : Definitions for picking instances and the moving object
+			  under the cursor by casting rays on the CPU
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+
+#include "InstanceBvh.h"
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+enum class PickTarget
+{
+	None,
+	Instance,
+	MovingObject
+};
+
+struct PickHit
+{
+	PickTarget Target;
+	std::uint32_t Instance; // Dense pool index when Target is Instance
+	InstanceHandle Handle;
+	float Distance; // Along the ray, in world units
+	glm::vec3 Position;
+	double Microseconds; // Time the pick took
+};
+
+// Triangle BVH over LOD 0 of a model in model space
+class MeshRaycaster
+{
+public:
+	void build(const Model& Model);
+
+	// Nearest hit distance along Origin + T * Direction, negative on a miss. Direction needn't be normalised,
+	// distances are in multiples of its length
+	[[nodiscard]] float raycast(const glm::vec3& Origin, const glm::vec3& Direction, float MaxDistance) const;
+	[[nodiscard]] bool isBuilt() const;
+
+private:
+	[[nodiscard]] float intersectTriangle(const glm::vec3& Origin, const glm::vec3& Direction,
+	                                      std::uint32_t Triangle) const;
+
+	std::vector<glm::vec3> MVertices; // Three per triangle, unindexed so a hit test reads one run of memory
+	InstanceBvh MTriangles;
+};
+
+class InstancePicker
+{
+public:
+	void setModels(const Model& InstanceModel, const Model& MovingObjectModel);
+
+	// Keeps the instance BVH in step with the pool. Only moved instances cost anything, a refit after
+	// transforms change, a background rebuild once refits have degraded the tree
+	void update(const InstancePool& Instances, const Model& InstanceModel);
+
+	// Nearest instance or moving object along the ray, instances as of the last update and animated ones
+	// posed at Time
+	[[nodiscard]] PickHit pick(const glm::vec3& Origin, const glm::vec3& Direction,
+	                           const glm::mat4& MovingObjectMatrix, float Time = 0.0f) const;
+
+private:
+	MeshRaycaster MInstanceMesh;
+	MeshRaycaster MMovingObjectMesh;
+	InstanceBvh MInstanceBvh;
+	const InstancePool* MInstances = nullptr;
+	std::uint64_t MRevision = 0;
+};
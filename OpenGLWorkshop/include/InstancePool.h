@@ -0,0 +1,98 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstancePool.h
+Description : Definitions for a pooled instance transform store with
+			  stable handles and a dense GPU instance buffer
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "InstanceAnimation.h"
+
+// Stable reference to a pooled instance. Stays valid until the instance is despawned,
+// the generation guards against stale handles after the slot is reused
+struct InstanceHandle
+{
+	std::uint32_t Slot;
+	std::uint32_t Generation;
+};
+
+constexpr InstanceHandle InvalidInstanceHandle = {0xFFFFFFFFu, 0};
+
+class InstancePool
+{
+public:
+	explicit InstancePool(unsigned int InitialCapacity = 1024);
+	~InstancePool();
+
+	// Delete the copy constructor and copy assignment operator
+	InstancePool(const InstancePool&) = delete;
+	InstancePool& operator=(const InstancePool&) = delete;
+
+	InstanceHandle spawn(const glm::mat4& Transform, const InstanceAnimation& Animation = {});
+	bool despawn(InstanceHandle Handle);
+	void clear();
+
+	[[nodiscard]] bool isAlive(InstanceHandle Handle) const;
+	bool setTransform(InstanceHandle Handle, const glm::mat4& Transform);
+	[[nodiscard]] const glm::mat4* getTransform(InstanceHandle Handle) const;
+	bool setAnimation(InstanceHandle Handle, const InstanceAnimation& Animation);
+
+	// Dense view, index I is the I-th instance in the GPU buffer
+	[[nodiscard]] const std::vector<glm::mat4>& getTransforms() const;
+	[[nodiscard]] unsigned int getCount() const;
+	[[nodiscard]] InstanceHandle getHandle(unsigned int DenseIndex) const;
+
+	// Animations run on the GPU from the base transforms above, the pool itself never changes over time.
+	// getAnimatedTransform gives the pose an instance is drawn in at Time
+	[[nodiscard]] const std::vector<InstanceAnimation>& getAnimations() const;
+	[[nodiscard]] bool hasAnimations() const;
+	[[nodiscard]] glm::mat4 getAnimatedTransform(unsigned int DenseIndex, float Time) const;
+
+	// Changes whenever an instance is spawned, moved or despawned, so derived data knows when it's stale
+	[[nodiscard]] std::uint64_t getRevision() const;
+
+	// GPU side. Requires a current OpenGL context. Transforms take attributes FirstAttribute to
+	// FirstAttribute + 3, animations the two after
+	void attachToVao(GLuint Vao, GLuint FirstAttribute);
+	void upload();
+	[[nodiscard]] GLuint getBuffer() const;
+	[[nodiscard]] GLuint getAnimationBuffer() const;
+	[[nodiscard]] unsigned int getUploadCount() const;
+	void releaseBuffer();
+
+private:
+	void markDirty(std::uint32_t DenseIndex);
+	void growBuffer(unsigned int RequiredCapacity);
+	void bindAttributes(GLuint Vao, GLuint FirstAttribute) const;
+
+	std::vector<glm::mat4> MTransforms; // Dense, mirrors the GPU buffer
+	std::vector<InstanceAnimation> MAnimations; // Dense alongside the transforms, mirrors the animation buffer
+	unsigned int MAnimatedCount;
+	std::vector<std::uint32_t> MDenseToSlot;
+	std::vector<std::uint32_t> MSlotToDense;
+	std::vector<std::uint32_t> MGenerations;
+	std::vector<std::uint32_t> MFreeSlots; // Free list of reusable slots
+
+	GLuint MBuffer;
+	GLuint MAnimationBuffer;
+	unsigned int MBufferCapacity;
+	unsigned int MUploadCount;
+	std::uint32_t MDirtyBegin;
+	std::uint32_t MDirtyEnd;
+	std::uint64_t MRevision;
+	std::vector<std::pair<GLuint, GLuint>> MAttachedVaos;
+};
@@ -0,0 +1,61 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceScatter.h
+Description : Definitions for deterministic random instance placement
+			  keyed by (seed, instance index)
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "InstanceAnimation.h"
+#include "TransformStorage.h"
+
+struct ScatterSettings
+{
+	std::uint64_t Seed = 0;
+	float MinAngle = 0.0f; // Degrees
+	float MaxAngle = 360.0f;
+	float MinDisplacement = -10.0f;
+	float MaxDisplacement = 10.0f;
+	float MinScale = 0.005f;
+	float MaxScale = 0.01f;
+	glm::vec3 RotationAxis = glm::vec3(1.0f, 0.3f, 0.5f);
+
+	// Animation, spin axes are uniform on the sphere and rates are in radians per second
+	float MinSpinRate = -1.5f;
+	float MaxSpinRate = 1.5f;
+	float MinBobAmplitude = 0.0f;
+	float MaxBobAmplitude = 0.3f;
+	float MinBobRate = 0.5f;
+	float MaxBobRate = 2.0f;
+};
+
+class InstanceScatter
+{
+public:
+	// Fills Transforms[Begin, End). Instance I only depends on the seed and I, so any
+	// split of the range across threads gives bit-identical results
+	static void generate(const ScatterSettings& Settings, std::size_t Begin, std::size_t End,
+	                     TransformStorage& Transforms);
+
+	// Resizes Transforms to Count and fills it across all worker threads
+	static void generateParallel(const ScatterSettings& Settings, std::size_t Count, TransformStorage& Transforms);
+
+	// Fills Animations[Begin, End), resizing it to End if needed. Drawn from counter blocks the placement
+	// doesn't use, so turning animation on leaves the scatter itself unchanged
+	static void generateAnimations(const ScatterSettings& Settings, std::size_t Begin, std::size_t End,
+	                               std::vector<InstanceAnimation>& Animations);
+};
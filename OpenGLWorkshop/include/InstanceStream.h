@@ -0,0 +1,75 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceStream.h
+Description : Definitions for per frame instance data written straight
+			  into persistently mapped buffers, fenced as a ring
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "InstanceAnimation.h"
+
+class RenderBackend;
+
+// Transforms and animations for draws of one submission, copied into buffers mapped once for their lifetime.
+// Each submission writes its own region of a ring and fences it, so a region is only written again once the
+// GPU has finished the draws reading it. Transforms and animations share instance indices, so draws read both
+// from the same base instance. Buffers and fences come from a backend, GL's unless given another. GL thread only
+class InstanceStream
+{
+public:
+	static constexpr int Regions = 3;
+
+	InstanceStream();
+	~InstanceStream();
+
+	InstanceStream(const InstanceStream&) = delete;
+	InstanceStream& operator=(const InstanceStream&) = delete;
+
+	// Room for Count instances in the current region, returning the base instance to draw them from. The first
+	// reserve of a region waits for the GPU to release it. Growing swaps the buffers, so read their names after
+	GLuint reserve(std::size_t Count);
+	// Animations may be null, leaving those instances' animations as they were
+	void write(GLuint BaseInstance, const glm::mat4* Transforms, const InstanceAnimation* Animations,
+	           std::size_t Count);
+	// Fences the region once the draws reading it are submitted and moves on to the next
+	void finishRegion();
+
+	// Releases everything made by the previous backend, the stream starts again empty
+	void setBackend(RenderBackend& Backend);
+
+	[[nodiscard]] GLuint getTransformBuffer() const;
+	[[nodiscard]] GLuint getAnimationBuffer() const;
+	[[nodiscard]] double getWaitMilliseconds() const; // For the GPU, in the latest reserve
+
+private:
+	void grow(std::size_t RequiredCapacity);
+	void waitForRegion();
+	void release();
+
+	RenderBackend* MBackend;
+	GLuint MTransformBuffer = 0;
+	GLuint MAnimationBuffer = 0;
+	glm::mat4* MTransforms = nullptr; // Mapped for as long as the buffer lives
+	InstanceAnimation* MAnimations = nullptr;
+	std::size_t MRegionCapacity = 0; // Instances in each region
+	int MRegion = 0;
+	std::size_t MUsed = 0; // Of the current region
+	bool MRegionWaited = false;
+	GLsync MFences[Regions]{};
+	std::vector<GLuint> MRetired; // Replaced by growing, still named by this region's packets until submitted
+	double MWaitMilliseconds = 0.0;
+};
@@ -0,0 +1,104 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : JobSystem.h
+Description : Definitions for a work-stealing job system with one
+			  worker per core, job counters and parallel loops
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+class JobCounter;
+
+// A unit of work. Function is called with the job itself, Data and the range are for it to interpret
+struct Job
+{
+	void (*Function)(const Job& Task);
+	void* Data;
+	std::size_t Begin;
+	std::size_t End;
+	std::size_t Grain;
+	JobCounter* Counter; // Optional, counts the job until it has run
+	const JobCounter* After; // Optional, the job runs once this reaches zero and it must outlive the job
+};
+
+// Jobs submitted against a counter and not yet finished, waiting for zero waits for all of them. A job's
+// last touch of its counter is the decrement, so a counter can go out of scope as soon as it reads done
+class JobCounter
+{
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	[[nodiscard]] bool isDone() const;
+
+private:
+	friend class JobSystem;
+
+	std::atomic<int> MCount{0};
+};
+
+struct JobSystemStats
+{
+	std::uint64_t Executed;
+	std::uint64_t Stolen; // Taken from another thread's deque
+	std::uint64_t StealAttempts;
+	std::uint64_t Inline; // Run by the submitter straight away because its deque or job ring was full
+};
+
+// Each thread that submits jobs owns a Chase-Lev deque. Owners push and pop at the bottom, idle threads steal
+// from the top of the others. Threads outside the workers get a deque on first use, and any thread waiting
+// on a counter runs jobs until it clears rather than blocking
+class JobSystem
+{
+public:
+	using RangeFunction = std::function<void(std::size_t Begin, std::size_t End)>;
+
+	static constexpr std::size_t DequeCapacity = 4096; // Jobs queued per thread, a power of two
+
+	// Starts ThreadCount - 1 workers, the calling thread being the last. 0 means one per core. Restarting
+	// waits for the old workers to go idle, so no jobs may be outstanding. Everything else starts it on demand
+	static void start(unsigned int ThreadCount = 0);
+	[[nodiscard]] static unsigned int getThreadCount();
+
+	// Queues Task on the calling thread's deque, counting it against Task.Counter when set. A job whose
+	// After counter isn't done when it's picked up helps with other jobs until it is
+	static void submit(const Job& Task);
+
+	// Queues Body(), which must outlive the job, counted against Counter and run once After is done
+	template <typename Function>
+	static void submit(JobCounter& Counter, Function& Body, const JobCounter* After = nullptr)
+	{
+		submit({[](const Job& Task) { (*static_cast<Function*>(Task.Data))(); }, &Body, 0, 0, 0, &Counter, After});
+	}
+
+	// Runs Task on the calling thread now, the way a thread that picked it up would, and counts it done
+	static void run(const Job& Task);
+
+	// Runs queued jobs on the calling thread until Counter reaches zero
+	static void wait(const JobCounter& Counter);
+
+	// Runs one queued job on the calling thread if it can find one, for threads waiting on something else
+	static bool tryRunJob();
+
+	// Calls Body on disjoint subranges covering [0, Count), returning once all are done. Ranges are split
+	// lazily, only while the splitting thread's deque is empty, so grains stay coarse when every thread is
+	// busy and shrink towards MinGrain when some are idle
+	static void parallelFor(std::size_t Count, std::size_t MinGrain, const RangeFunction& Body);
+
+	[[nodiscard]] static JobSystemStats getStats(); // Since the last reset, over every thread
+	static void resetStats();
+};
@@ -0,0 +1,62 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : LodSelector.h
+Description : Definitions for per instance level of detail selection by
+			  projected screen size, batched into one bucket per level
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+class LodSelector
+{
+public:
+	static constexpr int MaxLods = ModelLoader::LodCount;
+
+	LodSelector();
+
+	// Assigns each visible instance a level from its projected diameter (as produced by InstanceCuller)
+	// and groups their transforms by level, in parallel over fixed blocks of the visible list
+	void select(const InstancePool& Instances, const std::vector<std::uint32_t>& Visible,
+	            const std::vector<float>& PixelDiameters, int LevelCount);
+
+	// Projected diameter in pixels below which level I + 1 is used instead of level I
+	void setThreshold(int Level, float PixelDiameter);
+	void setHysteresis(float Fraction);
+
+	// Transforms of every selected instance, grouped so each level is one contiguous range
+	[[nodiscard]] const std::vector<glm::mat4>& getBatchedTransforms() const;
+	// Matching animations, empty when the pool has none
+	[[nodiscard]] const std::vector<InstanceAnimation>& getBatchedAnimations() const;
+	// Swaps the batches into the caller's vectors, the next select reuses whatever it gets back
+	void takeBatches(std::vector<glm::mat4>& Transforms, std::vector<InstanceAnimation>& Animations);
+	[[nodiscard]] unsigned int getBucketOffset(int Level) const;
+	[[nodiscard]] unsigned int getBucketCount(int Level) const;
+
+private:
+	int chooseLevel(int Current, float PixelDiameter, int LevelCount) const;
+
+	float MThresholds[MaxLods - 1];
+	float MHysteresis;
+	std::vector<std::uint8_t> MSlotLevels; // Last level per pool slot, survives swap-remove reordering
+	std::vector<std::uint8_t> MFrameLevels; // Level per visible instance this frame
+	std::vector<unsigned int> MBlockCursors; // Per block and level, counts and then write positions
+	std::vector<glm::mat4> MBatched;
+	std::vector<InstanceAnimation> MBatchedAnimations;
+	unsigned int MBucketOffsets[MaxLods];
+	unsigned int MBucketCounts[MaxLods];
+};
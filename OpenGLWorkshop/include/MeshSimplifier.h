@@ -0,0 +1,32 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : MeshSimplifier.h
+Description : Definitions for quadric error metric mesh simplification
+			  (Garland and Heckbert 1997) used to build LOD chains
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class MeshSimplifier
+{
+public:
+	// Collapses edges of an indexed triangle list until it reaches TargetIndexCount or no collapse stays under
+	// TargetError. Vertices are interleaved with Stride floats each, position first, and the remaining floats
+	// are treated as attributes (texture coordinates) when picking which vertex a collapsed corner moves to.
+	// Errors are distances relative to the mesh extent, so 0.01 allows 1% deviation from the surface.
+	// Returns the new index list referencing the same vertex array
+	static std::vector<unsigned int> simplify(const std::vector<float>& Vertices, std::size_t Stride,
+	                                          const std::vector<unsigned int>& Indices, std::size_t TargetIndexCount,
+	                                          float TargetError, float* ResultError = nullptr);
+};
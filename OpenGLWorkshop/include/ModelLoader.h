@@ -22,21 +22,55 @@ Mail : ayoub.ahmad@mds.ac.nz
 #include <vector>
 #include <iostream>
 
+// One level of detail, a range of the model's shared element buffer
+struct ModelLod
+{
+	int IndexOffset;
+	int IndexCount;
+	float Error; // Simplification error relative to the model extent
+};
+
 struct Model
 {
 	GLuint Vao;
 	GLuint Vbo;
 	GLuint Ebo;
 	GLuint Texture;
-	int IndexCount;
+	int IndexCount; // LOD 0
+	std::vector<ModelLod> Lods; // Finest first, LOD 0 is the loaded mesh
+	glm::vec3 BoundsCenter; // Model space bounding sphere
+	float BoundsRadius;
+	glm::vec3 BoundsMin; // Model space bounding box
+	glm::vec3 BoundsMax;
+	std::vector<glm::vec3> OccluderVertices; // Coarsest LOD kept on the CPU for occlusion culling
+	std::vector<unsigned int> OccluderIndices;
+	std::vector<glm::vec3> PickVertices; // LOD 0 kept on the CPU for ray picking
+	std::vector<unsigned int> PickIndices;
 };
 
 class ModelLoader
 {
 public:
+	static constexpr int LodCount = 4;
+
+	// The texture decodes as a job while the mesh is parsed and simplified, GL objects are made on this thread
 	Model loadModel(const char* ModelPath, const char* TexturePath) const;
 
 private:
+	// Pixels straight from the image file, null when it failed to load
+	struct DecodedTexture
+	{
+		unsigned char* Data;
+		int Width;
+		int Height;
+		int Components;
+	};
+
 	static void setupModel(Model& Model, const std::vector<float>& Vertices, const std::vector<unsigned int>& Indices);
-	static GLuint loadTexture(const char* Path);
+	static void generateLods(Model& Model, const std::vector<float>& Vertices, std::vector<unsigned int>& Indices);
+	static void computeBounds(Model& Model, const std::vector<float>& Vertices);
+	static void buildOccluder(Model& Model, const std::vector<float>& Vertices, const std::vector<unsigned int>& Indices);
+	static void buildPickMesh(Model& Model, const std::vector<float>& Vertices, const std::vector<unsigned int>& Indices);
+	static void decodeTexture(const char* Path, DecodedTexture& Texture); // Touches no GL, safe on any thread
+	static GLuint uploadTexture(const DecodedTexture& Texture, const char* Path); // Frees the pixels
 };
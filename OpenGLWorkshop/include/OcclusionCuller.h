@@ -0,0 +1,107 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : OcclusionCuller.h
+Description : Definitions for CPU occlusion culling. Large occluders are
+			  rasterised into a low resolution depth buffer and instance
+			  bounding boxes are tested against its tile maxima
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+
+struct OcclusionSettings
+{
+	int MaxOccluders = 32; // Largest visible instances rasterised each frame
+	float MinOccluderPixels = 48.0f; // Instances projecting smaller than this never occlude
+};
+
+struct OcclusionStats
+{
+	unsigned int Occluders;
+	unsigned int OccluderTriangles; // After back face and near plane rejection
+	unsigned int Tested;
+	unsigned int Occluded;
+	double RasterMilliseconds;
+	double TestMilliseconds;
+};
+
+// Screen space triangle set up for edge function rasterisation. Pixel (X, Y) is covered when all three
+// EdgeA * X + EdgeB * Y + EdgeC are non-negative at its centre, its depth is DepthA * X + DepthB * Y + DepthC
+struct OccluderTriangle
+{
+	float EdgeA[3];
+	float EdgeB[3];
+	float EdgeC[3];
+	float DepthA;
+	float DepthB;
+	float DepthC;
+	int MinX;
+	int MinY;
+	int MaxX;
+	int MaxY;
+};
+
+class OcclusionCuller
+{
+public:
+	static constexpr int TileSize = 8;
+	static constexpr int BufferWidth = 256;
+
+	OcclusionCuller();
+
+	// Matches the depth buffer's aspect ratio to the viewport, its width stays at BufferWidth
+	void setViewport(unsigned int Width, unsigned int Height);
+
+	// Extra occluder for the next cull only, such as an object that isn't part of the instance pool
+	void addOccluder(const Model& Model, const glm::mat4& Transform);
+
+	// Rasterises the queued occluders and the largest visible instances, then filters Visible (as produced by
+	// InstanceCuller) down to the instances whose bounding boxes are not fully behind the depth buffer.
+	// Animated instances are posed at Time for both
+	void cull(const InstancePool& Instances, const Model& Model, const std::vector<std::uint32_t>& Visible,
+	          const std::vector<float>& PixelDiameters, const glm::mat4& ViewProjection,
+	          const OcclusionSettings& Settings, float Time = 0.0f);
+
+	[[nodiscard]] const std::vector<std::uint32_t>& getVisible() const;
+	[[nodiscard]] const std::vector<float>& getPixelDiameters() const;
+	[[nodiscard]] const OcclusionStats& getStats() const;
+
+	// Depth buffer rows bottom to top, 0 near and 1 far
+	[[nodiscard]] const std::vector<float>& getDepth() const;
+	[[nodiscard]] int getWidth() const;
+	[[nodiscard]] int getHeight() const;
+
+private:
+	void setupTriangles(const Model& Model, const glm::mat4& Mvp);
+	void rasteriseTiles(int TileRowBegin, int TileRowEnd);
+	[[nodiscard]] bool isOccluded(const Model& Model, const glm::mat4& Mvp) const;
+
+	int MWidth;
+	int MHeight;
+	int MTilesX;
+	int MTilesY;
+	std::vector<float> MDepth;
+	std::vector<float> MTileMaxDepth; // Farthest depth in each tile, an instance behind it is behind every pixel
+	std::vector<OccluderTriangle> MTriangles;
+	std::vector<std::pair<const Model*, glm::mat4>> MQueuedOccluders;
+
+	std::vector<std::pair<float, std::uint32_t>> MCandidates; // Pixel diameter, position in Visible
+	std::vector<std::uint8_t> MResults; // Per visible instance, 1 when it must still be drawn
+	std::vector<std::uint32_t> MVisible;
+	std::vector<float> MPixelDiameters;
+	OcclusionStats MStats{};
+};
@@ -0,0 +1,33 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Parallel.h
+Description : Definitions for splitting index ranges across the job
+			  system's threads
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+#include "JobSystem.h"
+
+class Parallel
+{
+public:
+	using RangeFunction = JobSystem::RangeFunction;
+
+	// Calls Body on disjoint subranges covering [0, Count), blocking until all are done. Ranges smaller than
+	// MinGrain are never split further, and the calling thread works through the jobs while it waits
+	static void forRange(std::size_t Count, std::size_t MinGrain, const RangeFunction& Body);
+
+	[[nodiscard]] static unsigned int getThreadCount();
+	static void setThreadCount(unsigned int Count); // 0 restores one thread per core, no jobs may be in flight
+};
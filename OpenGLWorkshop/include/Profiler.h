@@ -0,0 +1,99 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Profiler.h
+Description : Definitions for a frame profiler of nested CPU scopes with
+			  matching GPU timer queries read back frames later
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+// Times over the rolling history of a scope, in milliseconds per frame
+struct ProfileSummary
+{
+	double Min;
+	double Average;
+	double P99;
+	std::size_t Samples; // Frames the scope ran in, up to the history length
+};
+
+// One scope of the tree, listed depth first, children in the order they first ran
+struct ProfileEntry
+{
+	const char* Name;
+	int Depth;
+	unsigned int Calls; // In the latest frame it ran in
+	ProfileSummary Cpu;
+	ProfileSummary Gpu; // No samples for scopes without GPU timing
+};
+
+struct ProfilerStats
+{
+	std::size_t Frames;
+	std::size_t GpuFramesRead;
+	std::size_t GpuFramesDropped; // Still in flight when their queries were needed again, never waited for
+	std::size_t Queries; // Timer queries created
+};
+
+// Scopes nest under whichever scope their thread has open, into a tree keyed by name under each parent, and a
+// scope's CPU time is summed over its calls in a frame. Scopes on the thread that begins frames can also time the
+// GPU, with a timestamp query at each end so they nest too. A frame's queries are only read once their results are
+// available, FrameLatency frames later, and dropped if they still aren't, so reading never stalls the pipeline
+class Profiler
+{
+public:
+	static constexpr int FrameLatency = 4; // Frames of queries in flight
+	static constexpr std::size_t HistoryLength = 256; // Frames kept per scope
+
+	// Frames bound the samples, on the GL thread, outside any scope. Beginning a frame reads back the GPU
+	// timings of the frame that used its queries last. The frame is timed as a scope of its own under Name, so
+	// loading can be a frame apart from the rest
+	static void beginFrame(const char* Name = "frame");
+	static void endFrame();
+
+	// Off makes scopes do nothing, to measure what they cost
+	static void setEnabled(bool Enabled);
+	[[nodiscard]] static bool isEnabled();
+
+	// Drops every scope and its history, GL thread only as it deletes the queries
+	static void reset();
+
+	[[nodiscard]] static std::vector<ProfileEntry> getReport();
+	static void printReport(std::ostream& Out);
+	[[nodiscard]] static ProfilerStats getStats();
+
+	// For ProfileScope, the node pushed or -1 while off
+	static int pushScope(const char* Name, bool Gpu);
+	static void popScope(int Node, double Milliseconds);
+};
+
+// Times its own lifetime as a scope of the calling thread, and records it to the trace while one is recording.
+// Name must outlive the profiler, a literal in practice
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* Name, bool Gpu = false);
+	~ProfileScope();
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* MName;
+	int MNode; // -1 while the profiler is off
+	bool MTraced;
+	std::chrono::steady_clock::time_point MStart;
+};
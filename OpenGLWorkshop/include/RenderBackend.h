@@ -0,0 +1,162 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : RenderBackend.h
+Description : Definitions for the backends a frame's draws are submitted
+			  through, GL and a null backend that only validates and counts
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "RenderQueue.h"
+
+// Commands handed to a backend since its stats were last reset
+struct BackendStats
+{
+	unsigned int Clears;
+	unsigned int ProgramBinds;
+	unsigned int UniformSets;
+	unsigned int TextureBinds;
+	unsigned int VaoBinds;
+	unsigned int SourceBinds;
+	unsigned int Draws;
+	unsigned long long Elements; // Indices or vertices read, over every instance
+	unsigned int BuffersCreated;
+	unsigned int Fences;
+	unsigned int Invalid; // Failed validation and were dropped, the GL backend leaves checking to GL
+	unsigned int Skipped; // Valid but beyond what the backend can draw
+};
+
+// Where a frame's draws end up. The render queue binds and draws through one and the renderer's instance stream
+// gets its mapped buffers and fences from one, so the frame pipeline runs the same whichever it is. Loading,
+// impostor baking and the instance pool's own buffer still go to GL directly. GL thread only
+class RenderBackend
+{
+public:
+	RenderBackend() = default;
+	virtual ~RenderBackend() = default;
+
+	RenderBackend(const RenderBackend&) = delete;
+	RenderBackend& operator=(const RenderBackend&) = delete;
+
+	[[nodiscard]] virtual const char* getName() const = 0;
+
+	virtual void clear(GLbitfield Mask) = 0;
+	virtual void useProgram(GLuint Program) = 0;
+	// Sets the bound program's uniforms, the set's setter making its own GL calls
+	virtual void setUniforms(const RenderQueue::UniformSet& Set, GLuint Program) = 0;
+	virtual void bindTexture(GLuint Unit, GLuint Texture) = 0;
+	virtual void bindVertexArray(GLuint Vao) = 0;
+	// The VAO's instance attributes 3-6 read Transforms, 7-8 read Animations or are switched off when it's 0
+	virtual void bindInstanceSources(GLuint Vao, GLuint Transforms, GLuint Animations) = 0;
+	// With the packet's state bound beforehand
+	virtual void draw(const DrawPacket& Packet) = 0;
+	// Finishes whatever the draws so far left pending, once the frame's last has been issued
+	virtual void flush() = 0;
+
+	// Size bytes written through Mapped for as long as the buffer lives, seen by every draw issued after
+	virtual GLuint createMappedBuffer(std::size_t Size, void*& Mapped) = 0;
+	virtual void deleteBuffers(GLsizei Count, const GLuint* Buffers) = 0;
+	// Fences everything issued so far, null when there is nothing to wait for
+	virtual GLsync fence() = 0;
+	// Blocks until the fence has passed and deletes it
+	virtual void waitFence(GLsync Fence) = 0;
+	virtual void deleteFence(GLsync Fence) = 0;
+
+	// Reports what went wrong since the previous check to the console, naming Stage
+	virtual void checkErrors(const char* Stage) = 0;
+
+	[[nodiscard]] const BackendStats& getStats() const;
+	void resetStats();
+
+protected:
+	BackendStats MStats{};
+};
+
+// Everything reaches GL, binds through GlState
+class GlBackend final : public RenderBackend
+{
+public:
+	// What renderers submit through until given another
+	static GlBackend& get();
+
+	[[nodiscard]] const char* getName() const override;
+	void clear(GLbitfield Mask) override;
+	void useProgram(GLuint Program) override;
+	void setUniforms(const RenderQueue::UniformSet& Set, GLuint Program) override;
+	void bindTexture(GLuint Unit, GLuint Texture) override;
+	void bindVertexArray(GLuint Vao) override;
+	void bindInstanceSources(GLuint Vao, GLuint Transforms, GLuint Animations) override;
+	void draw(const DrawPacket& Packet) override;
+	void flush() override;
+	GLuint createMappedBuffer(std::size_t Size, void*& Mapped) override;
+	void deleteBuffers(GLsizei Count, const GLuint* Buffers) override;
+	GLsync fence() override;
+	void waitFence(GLsync Fence) override;
+	void deleteFence(GLsync Fence) override;
+	void checkErrors(const char* Stage) override;
+};
+
+// Makes no GL call at all. Each command is checked against the state the ones before it left, as far as that
+// state is known here, and counted, so what the CPU spends producing a frame can be measured without the driver.
+// Mapped buffers are plain memory and fences never need waiting for
+class NullBackend final : public RenderBackend
+{
+public:
+	NullBackend() = default;
+
+	[[nodiscard]] const char* getName() const override;
+	void clear(GLbitfield Mask) override;
+	void useProgram(GLuint Program) override;
+	void setUniforms(const RenderQueue::UniformSet& Set, GLuint Program) override;
+	void bindTexture(GLuint Unit, GLuint Texture) override;
+	void bindVertexArray(GLuint Vao) override;
+	void bindInstanceSources(GLuint Vao, GLuint Transforms, GLuint Animations) override;
+	void draw(const DrawPacket& Packet) override;
+	void flush() override;
+	GLuint createMappedBuffer(std::size_t Size, void*& Mapped) override;
+	void deleteBuffers(GLsizei Count, const GLuint* Buffers) override;
+	GLsync fence() override;
+	void waitFence(GLsync Fence) override;
+	void deleteFence(GLsync Fence) override;
+	void checkErrors(const char* Stage) override;
+
+private:
+	struct HostBuffer
+	{
+		GLuint Name;
+		std::size_t Size;
+		std::unique_ptr<unsigned char[]> Memory;
+	};
+
+	// Instance sources of a VAO
+	struct VaoSources
+	{
+		GLuint Vao;
+		GLuint Transforms;
+		GLuint Animations;
+	};
+
+	void reject(const char* Problem);
+	[[nodiscard]] const HostBuffer* findBuffer(GLuint Name) const;
+
+	GLuint MProgram = 0;
+	GLuint MVao = 0;
+	std::vector<HostBuffer> MBuffers;
+	std::vector<VaoSources> MSources;
+	GLuint MNextName = ~0u - 1; // Counting down, clear of GL's names and CommandBuffer::RecordedInstances
+	unsigned int MUnreported = 0; // Invalid commands since the last check
+	const char* MProblem = nullptr; // First since the last check
+};
@@ -0,0 +1,170 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : RenderQueue.h
+Description : Definitions for a render queue of draw packets collected
+			  into buckets, radix sorted by state and submitted in order
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Packets of a bucket draw in this order whatever else their keys hold
+enum class RenderPass : std::uint8_t
+{
+	Opaque,
+	Impostor, // Alpha tested quads, behind the depth every mesh has written
+	Overlay
+};
+
+// One draw with every piece of state it needs, nothing is inherited from the packet drawn before it
+struct DrawPacket
+{
+	GLuint Program;
+	GLuint Texture; // Bound to unit 0, 0 leaves the unit as it is
+	GLuint Vao;
+	GLuint InstanceBuffer; // Read by the VAO's instance attributes 3-6, 0 leaves its sources as they are
+	GLuint AnimationBuffer; // Read by attributes 7-8 alongside an instance buffer, 0 switches them off
+	GLenum Mode;
+	bool Indexed; // Unsigned int indices from the VAO's element buffer
+	GLsizei Count; // Indices or vertices
+	GLuint First; // First index or vertex
+	GLsizei InstanceCount; // 0 draws once without instancing
+	GLuint BaseInstance;
+	std::uint32_t Uniforms; // From addUniforms, or NoUniforms when the program needs nothing set
+};
+
+// Everything the scene shader reads besides its vertex streams, set whole for each uniform set queued
+struct SceneUniforms
+{
+	glm::mat4 Mvp;
+	bool Instanced;
+	bool Animated;
+	float Time;
+	bool Fading; // The rest only matter when set
+	glm::vec3 CameraPosition;
+	glm::vec4 Bounds;
+	float ProjectionScale;
+	glm::vec2 FadeRange;
+};
+
+// Per submission counters, since the last clear
+struct RenderQueueStats
+{
+	unsigned int Packets;
+	unsigned int Draws;
+	unsigned int StateChanges; // Every bind and uniform set below, before GlState filters what is already bound
+	unsigned int ProgramBinds;
+	unsigned int TextureBinds;
+	unsigned int VaoBinds;
+	unsigned int SourceBinds; // Instance and animation buffers pointed at
+	unsigned int UniformSets;
+	double SortMilliseconds;
+	double SubmitMilliseconds;
+};
+
+using BucketId = std::size_t;
+
+class RenderBackend;
+
+// Draw packets collected into buckets, one for each view or target, submitted in the order the buckets were
+// added. Each packet carries a 64 bit key of pass, program, texture, VAO and depth from the top bit down, so
+// sorting a bucket groups its packets by the state that costs most to change and submission binds only what
+// differs from the packet before
+class RenderQueue
+{
+public:
+	using UniformSetter = std::function<void(GLuint Program)>;
+
+	// Setter makes the GL calls. Scene holds the same values as data when they are the scene shader's, for
+	// backends that shade without GL
+	struct UniformSet
+	{
+		UniformSetter Setter;
+		std::optional<SceneUniforms> Scene;
+	};
+
+	// A packet's place in its bucket
+	struct Entry
+	{
+		std::uint64_t Key;
+		std::uint32_t Packet;
+	};
+
+	static constexpr std::uint32_t NoUniforms = ~0u;
+
+	// Width of each key field, from the top bit down
+	static constexpr int PassBits = 4;
+	static constexpr int ProgramBits = 8;
+	static constexpr int TextureBits = 12;
+	static constexpr int VaoBits = 12;
+	static constexpr int DepthBits = 28;
+
+	RenderQueue() = default;
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	BucketId addBucket(std::string Name);
+	[[nodiscard]] std::size_t getBucketCount() const;
+	[[nodiscard]] const std::string& getBucketName(BucketId Bucket) const;
+
+	// Depth runs from 0 at the camera to 1 at the far plane and orders packets front to back where their state
+	// matches. GL names wider than their field wrap, which only costs grouping, never correctness
+	static std::uint64_t makeKey(RenderPass Pass, GLuint Program, GLuint Texture, GLuint Vao, float Depth);
+
+	// Uniform values shared by every packet naming the returned index. They are set on a packet's program
+	// whenever it last had a different set, so each set must write everything its packets read
+	std::uint32_t addUniforms(UniformSetter Setter, const std::optional<SceneUniforms>& Scene = std::nullopt);
+	void push(BucketId Bucket, std::uint64_t Key, const DrawPacket& Packet);
+
+	// Radix sorts every bucket by key. Stable, so packets with equal keys keep the order they were pushed in
+	void sort();
+	// Draws every bucket in its current order, push order until sorted, through Backend or GL. Binds through
+	// GlState on GL, so whatever the previous submission left bound is not bound again
+	void submit();
+	void submit(RenderBackend& Backend);
+	// Drops every packet and uniform set, keeping the buckets and their capacity
+	void clear();
+
+	[[nodiscard]] const std::vector<Entry>& getEntries(BucketId Bucket) const; // In their current order
+	[[nodiscard]] std::size_t getPacketCount() const;
+	[[nodiscard]] const RenderQueueStats& getStats() const;
+
+	// Points the VAO's instance attributes 3-6 at Buffer without touching the vertex format or binding the VAO
+	static void bindInstanceSource(GLuint Vao, GLuint Buffer);
+	// Attributes 7-8 of the VAO read Buffer, or are switched off when it's 0
+	static void bindAnimationSource(GLuint Vao, GLuint Buffer);
+
+	// Eight passes of eight bits from the lowest, skipping any digit every key shares
+	static void radixSort(std::vector<Entry>& Entries, std::vector<Entry>& Scratch);
+
+private:
+	struct CommandBucket
+	{
+		std::string Name;
+		std::vector<Entry> Entries;
+		std::vector<Entry> Scratch;
+		std::vector<DrawPacket> Packets;
+	};
+
+	std::vector<CommandBucket> MBuckets;
+	std::vector<UniformSet> MUniforms;
+	std::vector<std::pair<GLuint, std::uint32_t>> MProgramUniforms; // Set each program has, while submitting
+	RenderQueueStats MStats{};
+};
@@ -23,28 +23,208 @@ Mail : ayoub.ahmad@mds.ac.nz
 
 #include "ModelLoader.h"
 #include "Camera.h"
+#include "InstancePool.h"
+#include "LodSelector.h"
+#include "InstanceCuller.h"
+#include "ImpostorBaker.h"
+#include "OcclusionCuller.h"
+#include "InstancePicker.h"
+#include "CollisionGrid.h"
+#include "FlockSimulation.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
+#include "RenderQueue.h"
+#include "GlState.h"
+#include "CommandBuffer.h"
+#include "InstanceStream.h"
+#include "RenderBackend.h"
+#include "Profiler.h"
+
+// Command buffers executed this frame, recorded on whichever threads recorded them
+struct CommandStats
+{
+	unsigned int Buffers;
+	unsigned int Packets;
+	unsigned int Instances; // Copied into the instance stream
+	double RecordMilliseconds; // Summed over the buffers, which may have recorded side by side
+	double ExecuteMilliseconds; // Copying instances and replaying packets on the GL thread
+	double WaitMilliseconds; // Of the execution, for the GPU to release a region of the instance stream
+};
+
+// Per frame submission counters for the instanced scene
+struct RenderStats
+{
+	unsigned int DrawCalls;
+	unsigned int Instances;
+	unsigned long long Triangles;
+	unsigned long long TrianglesWithoutLod; // What the same instances cost at LOD 0
+	unsigned int LodInstances[LodSelector::MaxLods];
+	unsigned int ImpostorInstances; // Includes those still fading out against their mesh
+	CullStats Culling;
+	OcclusionStats Occlusion;
+	CollisionStats Collision;
+	FlockStats Swarm;
+	unsigned int SimulationSteps; // Fixed steps run since the previous frame
+	float Interpolation; // Blend between the last two simulated states this frame was drawn at
+	PipelineStats Pipeline;
+	RenderQueueStats Queue; // The latest submission
+	GlStateStats State; // Calls through GlState this frame, up to the latest submission
+	CommandStats Commands;
+	BackendStats Backend; // Handed to the backend this frame, up to the latest submission
+};
+
+// The CPU half of drawing the instanced scene for one snapshot: culled, split between meshes and impostors and
+// batched per LOD, with nothing touching GL. Preparing only reads the pool, so the next frame can be prepared
+// on another thread while this one is submitted
+struct PreparedScene
+{
+	const FrameSnapshot* Frame = nullptr;
+	bool Culled = false; // Otherwise the whole pool draws in one call
+	bool Fading = false; // Impostors are on, the fade band draws both ways
+	float ProjectionScale = 0.0f;
+	int LevelCount = 1;
+	unsigned int VisibleCount = 0; // Surviving culling and occlusion, before the impostor split
+	std::vector<glm::mat4> Batched; // Mesh instances grouped by level
+	std::vector<InstanceAnimation> BatchedAnimations;
+	unsigned int BucketOffsets[LodSelector::MaxLods]{};
+	unsigned int BucketCounts[LodSelector::MaxLods]{};
+	std::vector<glm::mat4> ImpostorTransforms;
+	std::vector<InstanceAnimation> ImpostorAnimations;
+	CullStats Culling{};
+	OcclusionStats Occlusion{};
+};
 
 class Renderer
 {
 public:
+	static constexpr float ImpostorFadeRatio = 1.5f;
+
 	Renderer(unsigned int Width, unsigned int Height, GLFWwindow* Window);
-	void renderScene(GLuint ShaderProgram, const Model& Model, GLuint InstanceBuffer, GLuint InstanceCount,
-	                 const std::vector<glm::mat4>& ModelMatrices);
+	~Renderer();
+
+	// Delete the copy constructor and copy assignment operator
+	Renderer(const Renderer&) = delete;
+	Renderer& operator=(const Renderer&) = delete;
+
+	// Once per frame. Handles toggles and samples the held keys every fixed step of the next simulated
+	// frame reads, which takeSimulationInput then hands over
+	void processInput();
+	[[nodiscard]] SimulationInput takeSimulationInput();
+	void toggleCameraMode();
+
+	// Draws from Frame until the next call, the snapshot must stay untouched until then. Before the first
+	// call the camera and object sit where a new simulation starts
+	void setFrame(const FrameSnapshot& Frame, const PipelineStats& Pipeline = {});
+
+	// Culls and batches the instances as seen from Frame, which must outlive Prepared's use. Touches no GL, so it
+	// may run on another thread alongside beginScene, the record calls, execute and submit for another prepared
+	// scene. It writes only Prepared, the frustum and occlusion cullers, the LOD selector and the impostor split's
+	// lists, which none of those use, and reads the pool's CPU side, which upload leaves alone. It also reads the
+	// toggles, settings and window size, so processInput, the setters and updateWindowSize must wait for it, and
+	// nothing may spawn, move or despawn instances meanwhile
+	void prepareScene(const FrameSnapshot& Frame, const Model& Model, const InstancePool& Instances,
+	                  PreparedScene& Prepared);
+	// Pushes the pool's changes to the GPU, updates the picker and starts a new frame's render stats from the
+	// prepared scene. On the GL thread, before the scene is recorded
+	void beginScene(const Model& Model, InstancePool& Instances, const PreparedScene& Prepared);
+
+	// Record draws from the frame's camera without touching GL or changing the renderer, so each may run on a
+	// worker thread alongside the others and alongside preparing the next frame
+	void recordScene(CommandBuffer& Commands, GLuint ShaderProgram, const Model& Model,
+	                 const InstancePool& Instances, const PreparedScene& Prepared) const;
+	void recordMovingObject(CommandBuffer& Commands, GLuint ShaderProgram, const Model& MovingObjectModel) const;
+	void recordSwarm(CommandBuffer& Commands, GLuint ShaderProgram) const;
+	// Copies a recorded buffer's instances into the instance stream and replays its draws into Bucket
+	void execute(RenderQueue& Queue, BucketId Bucket, const CommandBuffer& Commands);
+
+	// Begin, record and execute in one go on the calling thread
+	void queueScene(RenderQueue& Queue, BucketId Bucket, GLuint ShaderProgram, const Model& Model,
+	                InstancePool& Instances, const PreparedScene& Prepared);
+	void queueMovingObject(RenderQueue& Queue, BucketId Bucket, GLuint ShaderProgram, const Model& MovingObjectModel);
+	void queueSwarm(RenderQueue& Queue, BucketId Bucket, GLuint ShaderProgram);
+	// Sorts and draws everything queued, adding the queue's counters to the render stats
+	void submit(RenderQueue& Queue);
+
+	// Each queues into a queue of the renderer's own and submits it straight away
+	void renderScene(GLuint ShaderProgram, const Model& Model, InstancePool& Instances, const PreparedScene& Prepared);
+	void renderScene(GLuint ShaderProgram, const Model& Model, InstancePool& Instances); // Prepares it first
 	void renderMovingObject(GLuint ShaderProgram, const Model& MovingObjectModel);
+	void renderSwarm(GLuint ShaderProgram);
 	void renderUiElement(GLuint ShaderProgram) const;
-	void processInput();
-	Camera& getCamera();
+	[[nodiscard]] const Camera& getCamera() const; // As posed for the frame being drawn
 	void updateWindowSize(int Width, int Height);
+	void setMinPixelDiameter(float PixelDiameter);
+
+	// Instances projecting smaller than PixelDiameter draw as impostors, fading to meshes over the next
+	// ImpostorFadeRatio times that size. The atlas must outlive the renderer
+	void setImpostors(const ImpostorAtlas& Atlas, GLuint ImpostorProgram);
+	void setImpostorsEnabled(bool Enabled);
+	void setImpostorPixelDiameter(float PixelDiameter);
+	void setOcclusionEnabled(bool Enabled);
+	void setCollisionEnabled(bool Enabled);
+	void setMovingObjectOccluder(const Model& MovingObjectModel); // Must outlive the renderer
+	void setPickModels(const Model& InstanceModel, const Model& MovingObjectModel);
+
+	// Draws the frame's swarm instanced with ShipModel, whose VAO gains instance attributes 3-6. The model
+	// must outlive the renderer
+	void setSwarmModel(const Model& ShipModel);
+	void setSwarmRunning(bool Running);
+
+	// Where submissions go, GL until set. Before the first frame, the instance stream starts over. The backend
+	// must outlive the renderer
+	void setBackend(RenderBackend& Backend);
+	[[nodiscard]] RenderBackend& getBackend() const;
+	[[nodiscard]] const RenderStats& getStats() const;
+	void printStats() const;
+
+	static glm::mat4 getMovingObjectMatrix(const glm::vec3& Position);
 
 private:
 	unsigned int MWidth;
 	unsigned int MHeight;
 	GLFWwindow* MWindow;
-	glm::vec3 MObjectPosition;
-	Camera MCamera;
+	SimulationInput MInput; // Sampled once per frame for the simulation
+	FrameSnapshot MInitialFrame;
+	const FrameSnapshot* MFrame; // Being drawn, owned by whoever simulated it
+	PipelineStats MPipeline;
+	LodSelector MLodSelector;
+	bool MLodEnabled;
+	InstanceCuller MCuller;
+	CullSettings MCullSettings;
+	bool MCullingEnabled;
+	const ImpostorAtlas* MImpostorAtlas;
+	GLuint MImpostorProgram;
+	bool MImpostorsEnabled;
+	float MImpostorPixelDiameter;
+	std::vector<std::uint32_t> MMeshVisible; // Culler output minus instances drawn only as impostors
+	std::vector<float> MMeshPixelDiameters;
+	PreparedScene MPrepared; // For frames prepared and drawn in one call
+	OcclusionCuller MOcclusionCuller;
+	OcclusionSettings MOcclusionSettings;
+	bool MOcclusionEnabled;
+	const Model* MMovingObjectOccluder;
+	InstancePicker MPicker;
+	bool MCollisionEnabled;
+	const Model* MSwarmModel;
+	bool MSwarmRunning;
+	RenderStats MStats;
+	RenderBackend* MBackend;
+	InstanceStream MStream; // Instances of every executed command buffer, per submission
+	GLuint MDefaultInstance; // One identity matrix, the ship VAO's instance source until the swarm first draws
+	CommandBuffer MCommands; // For the queue calls that record and execute straight away
+	RenderQueue MQueue; // For the render calls that submit straight away
+	BucketId MQueueBucket;
 
 	static void checkOpenGlError(const std::string& Stmt);
 	static bool isMouseOverQuad(double MouseX, double MouseY, float QuadX, float QuadY, float QuadWidth,
 	                            float QuadHeight);
-	void processObjectMovement(float DeltaTime);
+	[[nodiscard]] glm::vec3 sampleObjectInput() const;
+	void pickUnderCursor() const;
+	[[nodiscard]] glm::mat4 getMovingObjectMatrix() const;
+	void applyFading(SceneUniforms& Uniforms, const Model& Model, const PreparedScene& Prepared) const;
+	static void setSceneUniforms(GLuint Program, const SceneUniforms& Uniforms);
+	static void setFadeUniforms(GLuint Program, const SceneUniforms& Uniforms);
+	// Scene's Mvp is the view projection, impostor transforms start at BaseInstance of the recorded instances
+	void recordImpostors(CommandBuffer& Commands, const SceneUniforms& Scene, const PreparedScene& Prepared,
+	                     unsigned int BaseInstance) const;
 };
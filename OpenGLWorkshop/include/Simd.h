@@ -0,0 +1,79 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Simd.h
+Description : Definitions for SIMD instruction set selection. Kernels
+			  are compiled for AVX2 per function and picked at runtime
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+// MSVC allows AVX2 intrinsics anywhere, GCC and Clang need the function to opt in
+#if SIMD_X86 && !defined(_MSC_VER)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+
+namespace Simd
+{
+	// True when the CPU and the OS both support 256-bit AVX2 registers, and the CPU has FMA, which every AVX2
+	// kernel is compiled with
+	inline bool hasAvx2()
+	{
+#if SIMD_X86
+		static const bool Supported = []
+		{
+			int Info[4] = {};
+#if defined(_MSC_VER)
+			__cpuid(Info, 1);
+#else
+			__cpuid(1, Info[0], Info[1], Info[2], Info[3]);
+#endif
+			if ((Info[2] & (1 << 12)) == 0 || (Info[2] & (1 << 27)) == 0 || (Info[2] & (1 << 28)) == 0)
+			{
+				return false;
+			}
+#if defined(_MSC_VER)
+			const unsigned long long Xcr0 = _xgetbv(0);
+#else
+			unsigned int Low, High;
+			__asm__("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+			const unsigned long long Xcr0 = (static_cast<unsigned long long>(High) << 32) | Low;
+#endif
+			if ((Xcr0 & 0x6) != 0x6)
+			{
+				return false;
+			}
+#if defined(_MSC_VER)
+			__cpuidex(Info, 7, 0);
+#else
+			__cpuid_count(7, 0, Info[0], Info[1], Info[2], Info[3]);
+#endif
+			return (Info[1] & (1 << 5)) != 0;
+		}();
+		return Supported;
+#else
+		return false;
+#endif
+	}
+}
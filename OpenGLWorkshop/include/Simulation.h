@@ -0,0 +1,94 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Simulation.h
+Description : Definitions for the simulated world, stepped on a fixed
+			  timestep and posed into snapshots for the renderer
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "InstancePool.h"
+#include "ModelLoader.h"
+#include "CollisionGrid.h"
+#include "FlockSimulation.h"
+#include "Camera.h"
+#include "FrameClock.h"
+
+// Everything the simulation reads from one frame of input, sampled on the render thread
+struct SimulationInput
+{
+	CameraInput Camera;
+	glm::vec3 Object; // Held movement keys as a direction
+	unsigned int CameraModeToggles; // Presses since the previous frame, odd counts flip the mode
+	bool CollisionEnabled;
+	bool SwarmRunning;
+};
+
+// What a frame draws, posed between the last two fixed steps. Never written again once handed to the renderer
+struct FrameSnapshot
+{
+	std::uint64_t Frame = 0; // Simulated frames before this one
+	Camera Viewpoint;
+	glm::vec3 ObjectPosition{0.0f};
+	std::vector<glm::mat4> SwarmTransforms;
+	std::vector<ContactEvent> ContactEvents; // From every step of the frame, in order
+	CollisionStats Collision{};
+	FlockStats Swarm{};
+	float AnimationTime = 0.0f;
+	float Interpolation = 1.0f;
+	unsigned int Steps = 0;
+	double SimulationMilliseconds = 0.0; // Spent producing it, steps and posing
+};
+
+class Simulation
+{
+public:
+	Simulation();
+
+	// Collision obstacles, read every step and rebuilt only when the pool's revision changes. The pool
+	// must not change while a step runs on another thread
+	void setInstances(const InstancePool& Instances, const Model& Model);
+	void setMovingObject(const Model& MovingObjectModel); // Only its bounds are used
+	void setSwarm(FlockSimulation& Swarm);
+
+	// Steps the clock to Now with Input held throughout, then poses the result into Snapshot
+	void runFrame(const SimulationInput& Input, double Now, FrameSnapshot& Snapshot);
+
+	// One fixed step of the camera, the moving object and the swarm
+	void step(float DeltaTime);
+
+	// Poses everything Alpha of the way from the previous step to the latest, with animated instances at Time
+	void capture(float Alpha, float Time, FrameSnapshot& Snapshot);
+
+	void setInput(const SimulationInput& Input);
+	[[nodiscard]] const glm::vec3& getObjectPosition() const;
+	[[nodiscard]] const FrameClock& getClock() const;
+
+private:
+	void resolveCollisions();
+
+	FrameClock MClock;
+	std::uint64_t MFrame;
+	SimulationInput MInput;
+	Camera MCamera;
+	glm::vec3 MObjectPosition;
+	glm::vec3 MPreviousObjectPosition; // Before the latest step
+	const InstancePool* MInstances;
+	const Model* MInstanceModel;
+	const Model* MMovingObjectModel;
+	CollisionGrid MCollisionGrid;
+	std::vector<ContactEvent> MContactEvents; // Since the last capture
+	FlockSimulation* MSwarm;
+};
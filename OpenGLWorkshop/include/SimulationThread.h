@@ -0,0 +1,74 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SimulationThread.h
+Description : Definitions for running the simulation a frame ahead of
+			  rendering on its own thread through double-buffered
+			  snapshots
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Simulation.h"
+
+// Time per stage for the latest frame. Overlapped, a frame costs the larger stage rather than their sum
+struct PipelineStats
+{
+	bool Threaded;
+	double SimulationMilliseconds; // Producing the snapshot the frame drew
+	double RenderMilliseconds; // The caller's time between two acquires, less any simulation it ran itself
+	double WaitMilliseconds; // Blocked in acquire on a simulation still running
+	double FrameMilliseconds; // Between the last two acquires
+};
+
+// Runs the simulation on a thread of its own a frame ahead of rendering. The app has since moved to the frame
+// graph, so this is kept only as the baseline the pipeline benchmark measures
+class SimulationThread
+{
+public:
+	// Threaded false runs each frame inline in submit, the serial baseline the overlap is measured against
+	explicit SimulationThread(Simulation& World, bool Threaded = true);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// Once per frame, in that order. acquire waits for the frame submitted last time and returns it, then
+	// submit starts the next one into the other buffer while the caller draws. The snapshot stays untouched
+	// until the following acquire, and before any submit it holds the world as constructed
+	const FrameSnapshot& acquire();
+	void submit(const SimulationInput& Input, double Now);
+
+	[[nodiscard]] const PipelineStats& getStats() const;
+
+private:
+	void run();
+
+	Simulation& MWorld;
+	FrameSnapshot MSnapshots[2];
+	int MReading; // Snapshot the caller holds, the worker writes the other
+	bool MPending; // Submitted and still being simulated
+	bool MReady; // Finished and not yet acquired
+	bool MStopping;
+	SimulationInput MInput;
+	double MNow;
+	PipelineStats MStats;
+	bool MAcquired; // Whether MLastAcquire has been set
+	std::chrono::steady_clock::time_point MLastAcquire;
+	std::mutex MMutex;
+	std::condition_variable MSubmitted;
+	std::condition_variable MFinished;
+	std::thread MThread;
+};
@@ -0,0 +1,248 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SoftwareBackend.h
+Description : Definitions for a backend rasterising on the CPU, binned
+			  into screen tiles and shaded eight pixels at a time
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "InstanceAnimation.h"
+#include "InstancePool.h"
+#include "ModelLoader.h"
+#include "RenderBackend.h"
+
+// Per flush counters, since the last clear
+struct SoftwareStats
+{
+	unsigned int Chunks; // Pieces of geometry work handed out
+	unsigned int Triangles; // Read from index buffers, over every instance
+	unsigned int Rasterised; // Left after culling and near plane clipping
+	unsigned int BinEntries; // Triangle and tile pairs
+	unsigned int TileSize;
+	unsigned int Threads;
+	bool Avx2;
+	double GeometryMilliseconds; // Transforming, clipping, setting up and binning
+	double RasterMilliseconds;
+};
+
+// A vertex after the perspective divide, in pixels with depth from 0 to 1. Texture coordinates are divided by w
+struct ProjectedVertex
+{
+	float X;
+	float Y;
+	float Z;
+	float InverseW;
+	float U;
+	float V;
+};
+
+// Screen space triangle set up for rasterising. Pixel (X, Y) is covered when all three EdgeA * X + EdgeB * Y + EdgeC
+// are non-negative at its centre. Each plane gives a value at a pixel as A * X + B * Y + C, depth directly and the
+// texture coordinates divided by w, so dividing by the interpolated 1 / w corrects them for perspective
+struct RasterTriangle
+{
+	float EdgeA[3];
+	float EdgeB[3];
+	float EdgeC[3];
+	float Depth[3];
+	float InverseW[3];
+	float U[3];
+	float V[3];
+	int MinX;
+	int MinY;
+	int MaxX;
+	int MaxY;
+	std::uint32_t Texture; // Index into the backend's textures
+};
+
+// Draws the scene shader's meshes with no GPU at all. Draws are queued as they arrive and rasterised together when
+// the frame is flushed or the buffers cleared. Geometry runs across every core in chunks of whole instances, each
+// binning its triangles into screen tiles; tiles then rasterise in parallel, each walking its triangles in draw
+// order, so the image is the same whatever the tile size or thread count. Coverage, depth and perspective correct
+// texture coordinates are evaluated eight pixels at a time with AVX2 where the CPU has it. Meshes and textures are
+// read back from GL once by addModel, and instances are read from mapped buffers made here or from the CPU side of a
+// pool given to addInstancePool. Packets without scene uniforms, such as impostors, are skipped, each reason logged
+// the first time, and fading draws solid. Mapped buffers are plain memory and fences never need waiting for. Rows
+// run bottom to top as GL's do
+class SoftwareBackend final : public RenderBackend
+{
+public:
+	static constexpr unsigned int DefaultTileSize = 32;
+
+	SoftwareBackend(unsigned int Width, unsigned int Height, unsigned int TileSize = DefaultTileSize);
+
+	// Copies the model's vertices, indices and texture out of GL so its draws can be rasterised
+	void addModel(const Model& Model);
+	// Draws sourcing the pool's buffer read its dense transforms and animations instead. The pool must outlive this
+	// and be uploaded whenever drawn, as it is for GL
+	void addInstancePool(const InstancePool& Pool);
+	// Clears to black when the size changes
+	void resize(unsigned int Width, unsigned int Height);
+	// A multiple of 8, rounded down, no smaller than 8
+	void setTileSize(unsigned int TileSize);
+	// Off rasterises a pixel at a time, for comparison. Only takes effect where the CPU has AVX2
+	void setAvx2Enabled(bool Enabled);
+
+	[[nodiscard]] unsigned int getWidth() const;
+	[[nodiscard]] unsigned int getHeight() const;
+	[[nodiscard]] unsigned int getTileSize() const;
+	[[nodiscard]] const SoftwareStats& getRasterStats() const;
+	// RGBA8 rows from the bottom up, as glReadPixels would give them
+	void readPixels(std::vector<std::uint32_t>& Pixels) const;
+	// Stretches the image over the window's framebuffer and clears its depth, so GL can draw on top. The texture
+	// and framebuffer it goes through stay with the context
+	void present(int WindowWidth, int WindowHeight);
+	// Binary PPM, top row first
+	static bool writeImage(const char* Path, const std::vector<std::uint32_t>& Pixels, unsigned int Width,
+	                       unsigned int Height);
+
+	[[nodiscard]] const char* getName() const override;
+	void clear(GLbitfield Mask) override;
+	void useProgram(GLuint Program) override;
+	void setUniforms(const RenderQueue::UniformSet& Set, GLuint Program) override;
+	void bindTexture(GLuint Unit, GLuint Texture) override;
+	void bindVertexArray(GLuint Vao) override;
+	void bindInstanceSources(GLuint Vao, GLuint Transforms, GLuint Animations) override;
+	void draw(const DrawPacket& Packet) override;
+	void flush() override;
+	GLuint createMappedBuffer(std::size_t Size, void*& Mapped) override;
+	void deleteBuffers(GLsizei Count, const GLuint* Buffers) override;
+	GLsync fence() override;
+	void waitFence(GLsync Fence) override;
+	void deleteFence(GLsync Fence) override;
+	void checkErrors(const char* Stage) override;
+
+private:
+	// An index range of a mesh with only the vertices it uses, renumbered from 0
+	struct MeshRange
+	{
+		GLuint First;
+		GLsizei Count;
+		std::vector<glm::vec3> Positions;
+		std::vector<glm::vec2> TexCoords;
+		std::vector<std::uint32_t> Indices;
+	};
+
+	struct Mesh
+	{
+		GLuint Vao;
+		std::vector<float> Vertices; // Position then texture coordinate
+		std::vector<unsigned int> Indices;
+		std::vector<std::unique_ptr<MeshRange>> Ranges; // Made on first draw, kept where the pointers stay put
+	};
+
+	struct Texture
+	{
+		GLuint Name;
+		int Width;
+		int Height;
+		std::vector<std::uint32_t> Texels; // RGBA8, rows from t = 0 up
+	};
+
+	struct HostBuffer
+	{
+		GLuint Name;
+		std::size_t Size;
+		std::unique_ptr<unsigned char[]> Memory;
+	};
+
+	struct VaoSources
+	{
+		GLuint Vao;
+		GLuint Transforms;
+		GLuint Animations;
+	};
+
+	// A draw waiting for the flush, with everything it reads resolved
+	struct QueuedDraw
+	{
+		const MeshRange* Range;
+		std::uint32_t Texture;
+		SceneUniforms Scene;
+		const glm::mat4* Transforms; // Null draws once with an identity model matrix
+		const InstanceAnimation* Animations; // Null unless animated
+		std::size_t InstanceCount;
+	};
+
+	// Instances [First, End) of a draw, set up and binned by one job
+	struct GeometryChunk
+	{
+		std::uint32_t Draw;
+		std::size_t First;
+		std::size_t End;
+		std::vector<glm::vec4> Clip; // Scratch, the range's vertices in clip space, then projected
+		std::vector<ProjectedVertex> Projected;
+		std::vector<std::uint8_t> Outcodes;
+		std::vector<RasterTriangle> Triangles;
+		std::vector<std::uint32_t> Bins; // Tile of each binned triangle, paired with BinTriangles
+		std::vector<std::uint32_t> BinTriangles;
+		unsigned int Read;
+	};
+
+	void layoutTiles();
+	void transformChunk(GeometryChunk& Chunk) const;
+	[[nodiscard]] ProjectedVertex project(const glm::vec4& Clip, const glm::vec2& TexCoord) const;
+	void setupTriangle(GeometryChunk& Chunk, const ProjectedVertex* const (&Corners)[3], std::uint32_t Texture) const;
+	void rasteriseTile(std::size_t Tile);
+	void reject(const char* Problem);
+	void skip(const char* Reason);
+
+	[[nodiscard]] const HostBuffer* findBuffer(GLuint Name) const;
+	[[nodiscard]] const MeshRange* findRange(GLuint Vao, GLuint First, GLsizei Count);
+	[[nodiscard]] std::optional<std::uint32_t> findTexture(GLuint Name) const;
+
+	unsigned int MWidth;
+	unsigned int MHeight;
+	unsigned int MTileSize;
+	unsigned int MTilesX;
+	unsigned int MTilesY;
+	unsigned int MStride; // Width padded to whole tiles, so eight pixel steps never leave a row
+	bool MAvx2;
+	std::vector<std::uint32_t> MColour;
+	std::vector<float> MDepth;
+
+	std::vector<Mesh> MMeshes;
+	std::vector<Texture> MTextures;
+	std::vector<HostBuffer> MBuffers;
+	std::vector<VaoSources> MSources;
+	const InstancePool* MPool = nullptr;
+	GLuint MNextName = ~0u - 1; // Counting down, clear of GL's names and CommandBuffer::RecordedInstances
+
+	GLuint MProgram = 0;
+	GLuint MVao = 0;
+	GLuint MTexture = 0; // On unit 0
+	std::vector<std::pair<GLuint, std::optional<SceneUniforms>>> MProgramScenes; // Latest set of each program
+
+	std::vector<QueuedDraw> MDraws;
+	std::vector<GeometryChunk> MChunks;
+	std::vector<std::uint32_t> MTileStarts; // Each tile's triangles are [Start, next tile's Start) of MTileTriangles
+	std::vector<std::uint32_t> MTileCursors; // Scratch for filling MTileTriangles
+	std::vector<const RasterTriangle*> MTileTriangles;
+	SoftwareStats MRasterStats{};
+
+	GLuint MPresentTexture = 0;
+	GLuint MPresentFramebuffer = 0;
+	unsigned int MPresentWidth = 0;
+	unsigned int MPresentHeight = 0;
+
+	unsigned int MUnreported = 0; // Invalid commands since the last check
+	const char* MProblem = nullptr; // First since the last check
+	std::vector<const char*> MSkipReasons; // Each logged once
+};
@@ -0,0 +1,106 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SpatialHash.h
+Description : Definitions for a uniform grid over points with cells
+			  folded into a Z-order bucket table, rebuilt from scratch
+			  by a parallel counting sort
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SpatialHash
+{
+public:
+	explicit SpatialHash(float CellSize = 1.0f);
+
+	// Cells map to buckets by the low bits of their Z-order index, so neighbouring cells land in nearby
+	// buckets and the points of a neighbourhood share cache lines. The table has at least four buckets per
+	// point and wraps around beyond that many cells, distant cells sharing a bucket only cost false candidates
+	void setCellSize(float CellSize);
+	void build(const float* X, const float* Y, const float* Z, std::size_t Count);
+
+	// Calls Visit(Slot) once for every point in the buckets of the 27 cells around Position, which covers
+	// every point within one cell size of it. Slots index getSorted(), so data gathered into that order is
+	// read in contiguous runs
+	template <typename Visitor>
+	void forEachNear(const glm::vec3& Position, Visitor&& Visit) const;
+
+	// Point indices grouped by bucket, ascending within each
+	[[nodiscard]] const std::vector<std::uint32_t>& getSorted() const;
+	[[nodiscard]] float getCellSize() const;
+	[[nodiscard]] std::size_t getBucketCount() const;
+	[[nodiscard]] std::size_t getPointCount() const;
+
+private:
+	// The low ten bits of V moved to every third bit, one axis of a Z-order index
+	static std::uint32_t spreadBits(int V);
+	[[nodiscard]] std::uint32_t bucketOf(int X, int Y, int Z) const;
+
+	float MCellSize;
+	float MInverseCellSize;
+	std::uint32_t MBucketMask;
+	std::vector<std::atomic<std::uint32_t>> MCursors; // Counts, then write positions during the scatter
+	std::vector<std::uint32_t> MBucketStarts; // Bucket B holds MSorted[MBucketStarts[B], MBucketStarts[B + 1])
+	std::vector<std::uint32_t> MPointBuckets;
+	std::vector<std::uint32_t> MSorted;
+};
+
+inline std::uint32_t SpatialHash::spreadBits(const int V)
+{
+	std::uint32_t Bits = static_cast<std::uint32_t>(V) & 0x3ff;
+	Bits = (Bits | (Bits << 16)) & 0x030000ff;
+	Bits = (Bits | (Bits << 8)) & 0x0300f00f;
+	Bits = (Bits | (Bits << 4)) & 0x030c30c3;
+	Bits = (Bits | (Bits << 2)) & 0x09249249;
+	return Bits;
+}
+
+inline std::uint32_t SpatialHash::bucketOf(const int X, const int Y, const int Z) const
+{
+	return (spreadBits(X) | (spreadBits(Y) << 1) | (spreadBits(Z) << 2)) & MBucketMask;
+}
+
+template <typename Visitor>
+void SpatialHash::forEachNear(const glm::vec3& Position, Visitor&& Visit) const
+{
+	if (MSorted.empty())
+	{
+		return;
+	}
+
+	// Even the smallest table has four cells per axis before wrapping, so the 27 buckets are distinct
+	const int CellX = static_cast<int>(std::floor(Position.x * MInverseCellSize));
+	const int CellY = static_cast<int>(std::floor(Position.y * MInverseCellSize));
+	const int CellZ = static_cast<int>(std::floor(Position.z * MInverseCellSize));
+	const std::uint32_t SpreadX[3] = {spreadBits(CellX - 1), spreadBits(CellX), spreadBits(CellX + 1)};
+	for (int Z = CellZ - 1; Z <= CellZ + 1; Z++)
+	{
+		for (int Y = CellY - 1; Y <= CellY + 1; Y++)
+		{
+			const std::uint32_t SpreadYz = (spreadBits(Y) << 1) | (spreadBits(Z) << 2);
+			for (const std::uint32_t X : SpreadX)
+			{
+				const std::uint32_t Bucket = (X | SpreadYz) & MBucketMask;
+				for (std::uint32_t Slot = MBucketStarts[Bucket]; Slot < MBucketStarts[Bucket + 1]; Slot++)
+				{
+					Visit(Slot);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,86 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : TraceRecorder.h
+Description : Definitions for recording timed events into per thread
+			  buffers and writing them out in Chrome's trace format
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+enum class TraceCategory
+{
+	Scope, // Profile scopes
+	Task, // Frame graph tasks
+	Job, // Every job the job system runs
+	Gpu, // GPU timings of profile scopes, shifted onto the CPU clock
+	Asset, // Models, textures and shaders loading
+	Count
+};
+
+struct TraceStats
+{
+	std::size_t Threads; // That have recorded anything
+	std::size_t Written; // Events written by the latest flush
+	std::size_t Dropped; // Since recording started, their thread's buffer was full
+};
+
+// Each thread records into a ring of its own, which only it writes and only a flush reads, so recording takes no
+// lock. Flushing writes everything recorded since the last flush as Chrome Trace Event JSON, which chrome://tracing
+// and Perfetto open. Names are kept by pointer and must outlive the flush, details are copied
+class TraceRecorder
+{
+public:
+	static constexpr std::size_t EventsPerThread = 32768; // Further events are dropped until the next flush
+	static constexpr std::size_t DetailLength = 64; // Characters kept of a detail, from its end
+
+	// Starting drops anything recorded and not yet flushed
+	static void start();
+	static void stop();
+	[[nodiscard]] static bool isRecording();
+
+	// Writes and drains everything recorded so far. Threads may keep recording meanwhile, what they add after
+	// the flush starts waits for the next one. Returns false if the file couldn't be written
+	static bool flush(const char* Path);
+
+	// Shown as the calling thread's name, which must outlive the flush
+	static void setThreadName(const char* Name);
+
+	// Times are nanoseconds on the steady clock
+	[[nodiscard]] static std::uint64_t now();
+	[[nodiscard]] static std::uint64_t toNanoseconds(std::chrono::steady_clock::time_point Time);
+
+	// Detail, a file name or the like, may be null. Does nothing while not recording
+	static void record(TraceCategory Category, const char* Name, std::uint64_t Start, std::uint64_t End,
+	                   const char* Detail = nullptr);
+
+	[[nodiscard]] static TraceStats getStats();
+};
+
+// Records its own lifetime as an event of the calling thread while recording
+class TraceScope
+{
+public:
+	TraceScope(TraceCategory Category, const char* Name, const char* Detail = nullptr);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	TraceCategory MCategory;
+	const char* MName;
+	const char* MDetail; // Copied when the event is recorded, at the end
+	std::uint64_t MStart; // 0 when not recording at the start
+};
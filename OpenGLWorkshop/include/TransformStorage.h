@@ -0,0 +1,56 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : TransformStorage.h
+Description : Definitions for structure of arrays transform storage and
+			  batched composition into instance model matrices
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#pragma once
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+#include <cstddef>
+#include <vector>
+
+// Position, rotation and scale kept component-wise so kernels can load several instances per register
+struct TransformStorage
+{
+	std::vector<float> PositionX;
+	std::vector<float> PositionY;
+	std::vector<float> PositionZ;
+	std::vector<float> RotationX;
+	std::vector<float> RotationY;
+	std::vector<float> RotationZ;
+	std::vector<float> RotationW;
+	std::vector<float> ScaleX;
+	std::vector<float> ScaleY;
+	std::vector<float> ScaleZ;
+
+	[[nodiscard]] std::size_t size() const;
+	void resize(std::size_t Count);
+	void setTransform(std::size_t Index, const glm::vec3& Position, const glm::quat& Rotation, const glm::vec3& Scale);
+	void pushTransform(const glm::vec3& Position, const glm::quat& Rotation, const glm::vec3& Scale);
+};
+
+class TransformComposer
+{
+public:
+	// Writes translate * rotate * scale for transforms [Begin, End) into Out[0, End - Begin),
+	// using the widest kernel the CPU supports. Rotations must be unit quaternions
+	static void compose(const TransformStorage& Transforms, std::size_t Begin, std::size_t End, glm::mat4* Out);
+	// compose over every transform, split across the job system in whole blocks of eight so each lane takes the
+	// same kernel path as a serial call would
+	static void composeParallel(const TransformStorage& Transforms, glm::mat4* Out);
+	static void composeScalar(const TransformStorage& Transforms, std::size_t Begin, std::size_t End, glm::mat4* Out);
+	static void composeSse(const TransformStorage& Transforms, std::size_t Begin, std::size_t End, glm::mat4* Out);
+	static void composeAvx2(const TransformStorage& Transforms, std::size_t Begin, std::size_t End, glm::mat4* Out);
+	static const char* getKernelName();
+};
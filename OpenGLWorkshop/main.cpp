@@ -17,6 +17,8 @@ Mail : ayoub.ahmad@mds.ac.nz
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdint>
+#include <cstdio>
 #include <random>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
@@ -28,18 +30,43 @@ Mail : ayoub.ahmad@mds.ac.nz
 #include "ModelLoader.h"
 #include "Camera.h"
 #include "Renderer.h"
+#include "InstancePool.h"
+#include "TransformStorage.h"
+#include "InstanceScatter.h"
+#include "Simulation.h"
+#include "FrameGraph.h"
+#include "RenderQueue.h"
+#include "CommandBuffer.h"
+#include "RenderBackend.h"
+#include "SoftwareBackend.h"
+#include "GlState.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include "ImpostorBaker.h"
+#include "FlockSimulation.h"
+#include "Benchmark.h"
+#include "HeadlessHarness.h"
+#include "GlReplay.h"
 // TODO: Input A, Input A+
 
 #include "UI.h"
+#include "GlCapture.h" // Last, so GL 1.1 calls go through its pointers
 
 // Window dimensions
 constexpr unsigned int Width = 800;
 constexpr unsigned int Height = 600;
 GLFWwindow* GWindow;
 Renderer* GRenderer;
+bool GPrintFrameGraph = false; // Critical path printed every frame while set
+bool GPrintProfile = false; // Set by the key, printed after the frame
+bool GToggleTrace = false; // Set by the key, a trace starts or is written after the frame
+constexpr const char* TracePath = "trace.json";
 
-// Function to initialise OpenGL and GLFW
-bool initOpenGl(GLFWwindow*& Window);
+// Function to initialise OpenGL and GLFW, capturing its calls from the start when asked
+bool initOpenGl(GLFWwindow*& Window, bool Capture);
+
+// Function to write out the GL capture
+void stopCapture();
 
 // Function to handle key events
 void keyCallback(GLFWwindow* Window, int Key, int ScanCode, int Action, int Mods);
@@ -50,9 +77,141 @@ void checkOpenGlError(const std::string& Stmt);
 // Frame buffer size callback function
 void frameBufferSizeCallback(GLFWwindow* Window, int Width, int Height);
 
-int main()
+int main(const int Argc, char* Argv[])
 {
-    if (!initOpenGl(GWindow))
+    // Seed for the instance field, random unless given so runs can be reproduced
+    std::random_device Rd; // Random device for seed
+    std::uint64_t Seed = (static_cast<std::uint64_t>(Rd()) << 32) | Rd();
+    float MinPixelDiameter = 2.0f;
+    float ImpostorPixelDiameter = 16.0f;
+    unsigned int SwarmCount = 2000;
+    bool Animate = false;
+    bool SerialSimulation = false;
+    std::string BackendName = "gl";
+    unsigned int TraceFrames = 0;
+    const char* BenchmarkName = nullptr;
+    bool BenchmarkRequested = false;
+    HeadlessSettings Headless;
+    bool HeadlessRequested = false;
+    unsigned int CaptureFrames = 0;
+    const char* ReplayPath = nullptr;
+
+    for (int I = 1; I < Argc; I++)
+    {
+        const std::string Argument = Argv[I];
+        if (Argument == "--seed" && I + 1 < Argc)
+        {
+            Seed = std::strtoull(Argv[++I], nullptr, 10);
+        }
+        else if (Argument == "--min-pixels" && I + 1 < Argc)
+        {
+            MinPixelDiameter = std::strtof(Argv[++I], nullptr);
+        }
+        else if (Argument == "--impostor-pixels" && I + 1 < Argc)
+        {
+            ImpostorPixelDiameter = std::strtof(Argv[++I], nullptr);
+        }
+        else if (Argument == "--swarm" && I + 1 < Argc)
+        {
+            SwarmCount = static_cast<unsigned int>(std::strtoul(Argv[++I], nullptr, 10));
+        }
+        else if (Argument == "--animate")
+        {
+            Animate = true;
+        }
+        else if (Argument == "--serial-simulation")
+        {
+            SerialSimulation = true;
+        }
+        else if (Argument == "--backend" && I + 1 < Argc)
+        {
+            BackendName = Argv[++I];
+        }
+        else if (Argument == "--trace" && I + 1 < Argc)
+        {
+            TraceFrames = static_cast<unsigned int>(std::strtoul(Argv[++I], nullptr, 10));
+        }
+        else if (Argument == "--headless" && I + 1 < Argc)
+        {
+            HeadlessRequested = true;
+            Headless.Frames = static_cast<unsigned int>(std::strtoul(Argv[++I], nullptr, 10));
+        }
+        else if (Argument == "--json" && I + 1 < Argc)
+        {
+            Headless.OutputPath = Argv[++I];
+        }
+        else if (Argument == "--context" && I + 1 < Argc)
+        {
+            const std::string Context = Argv[++I];
+            Headless.Context = Context == "egl" ? HeadlessContext::Egl
+                : Context == "osmesa" ? HeadlessContext::OsMesa : HeadlessContext::Native;
+        }
+        else if (Argument == "--image" && I + 1 < Argc)
+        {
+            Headless.ImagePath = Argv[++I];
+        }
+        else if (Argument == "--size" && I + 1 < Argc)
+        {
+            std::sscanf(Argv[++I], "%ux%u", &Headless.Width, &Headless.Height);
+        }
+        else if (Argument == "--capture" && I + 1 < Argc)
+        {
+            CaptureFrames = static_cast<unsigned int>(std::strtoul(Argv[++I], nullptr, 10));
+        }
+        else if (Argument == "--replay" && I + 1 < Argc)
+        {
+            ReplayPath = Argv[++I];
+        }
+        else if (Argument == "--bench")
+        {
+            BenchmarkRequested = true;
+            BenchmarkName = I + 1 < Argc ? Argv[++I] : nullptr;
+        }
+    }
+
+    // Benchmarks run headless and exit before any window is created
+    if (BenchmarkRequested)
+    {
+        if (BenchmarkName && Benchmark::run(BenchmarkName, Seed))
+        {
+            return 0;
+        }
+        Benchmark::printUsage();
+        return -1;
+    }
+
+    // As are scripted headless runs, which need the seed given to be comparable. A capture covers the whole run
+    if (HeadlessRequested)
+    {
+        Headless.Seed = Seed;
+        Headless.SwarmCount = SwarmCount;
+        Headless.Animate = Animate;
+        Headless.Backend = BackendName == "null" ? HeadlessBackend::Null
+            : BackendName == "software" ? HeadlessBackend::Software : HeadlessBackend::Gl;
+        Headless.CapturePath = CaptureFrames > 0 ? GlCapture::DefaultPath : nullptr;
+        return HeadlessHarness::run(Headless);
+    }
+
+    // And replays of GL captures, which need none of the app
+    if (ReplayPath != nullptr)
+    {
+        ReplaySettings Replay;
+        Replay.TracePath = ReplayPath;
+        Replay.Context = Headless.Context;
+        Replay.OutputPath = Headless.OutputPath;
+        Replay.ImagePath = Headless.ImagePath;
+        return GlReplay::run(Replay);
+    }
+    std::cout << "Instance seed: " << Seed << " (pass --seed " << Seed << " to reproduce)" << std::endl;
+
+    // Started before loading so the trace covers the assets too
+    TraceRecorder::setThreadName("main");
+    if (TraceFrames > 0)
+    {
+        TraceRecorder::start();
+    }
+
+    if (!initOpenGl(GWindow, CaptureFrames > 0))
     {
         std::cerr << "Failed to initialise OpenGL" << std::endl;
         return -1;
@@ -61,7 +220,26 @@ int main()
     glfwSetKeyCallback(GWindow, keyCallback);
     glfwSetFramebufferSizeCallback(GWindow, frameBufferSizeCallback); // Set the framebuffer size callback
 
+    // Loading is profiled as a frame of its own, its GPU timings read back a few frames into the loop
+    Profiler::beginFrame("load");
     GRenderer = new Renderer(Width, Height, GWindow); // Initialise the renderer
+    GRenderer->setMinPixelDiameter(MinPixelDiameter);
+
+    // Draws go nowhere with the null backend, leaving only the CPU's share of each frame to profile. The software
+    // backend rasterises on the CPU instead and its image is shown in the window, without impostors
+    NullBackend LNullBackend;
+    SoftwareBackend LSoftwareBackend(Width, Height);
+    const bool UseSoftwareBackend = BackendName == "software";
+    if (BackendName == "null")
+    {
+        GRenderer->setBackend(LNullBackend);
+    }
+    else if (UseSoftwareBackend)
+    {
+        GRenderer->setBackend(LSoftwareBackend);
+        GRenderer->setImpostorsEnabled(false);
+    }
+    GRenderer->setImpostorPixelDiameter(ImpostorPixelDiameter);
 
     const GLuint ShaderProgram = ShaderLoader::createProgram("resources/shaders/VertexShader.vert",
         "resources/shaders/FragmentShader.frag");
@@ -80,6 +258,17 @@ int main()
         return -1;
     }
 
+    // Far instances draw as quads showing the nearest of a set of views baked once here
+    const GLuint ImpostorProgram = ShaderLoader::createProgram("resources/shaders/ImpostorVertexShader.vert",
+        "resources/shaders/ImpostorFragmentShader.frag");
+    if (!ImpostorProgram)
+    {
+        std::cerr << "Failed to create impostor shader program" << std::endl;
+        return -1;
+    }
+    ImpostorAtlas LImpostorAtlas = ImpostorBaker::bake(LModel, ShaderProgram);
+    GRenderer->setImpostors(LImpostorAtlas, ImpostorProgram);
+
     const Model MovingObjectModel = LModelLoader.loadModel("resources/models/SciFiSpace/SM_Ship_Fighter_02.obj",
         "resources/textures/PolygonAncientWorlds_Texture_01_A.png");
     if (MovingObjectModel.Vao == 0)
@@ -87,80 +276,243 @@ int main()
         std::cerr << "Failed to load moving object model" << std::endl;
         return -1;
     }
+    GRenderer->setMovingObjectOccluder(MovingObjectModel);
+    GRenderer->setPickModels(LModel, MovingObjectModel);
+    if (UseSoftwareBackend)
+    {
+        LSoftwareBackend.addModel(LModel);
+        LSoftwareBackend.addModel(MovingObjectModel);
+    }
 
     constexpr unsigned int InstanceCount = 1000;
-    std::vector<glm::mat4> ModelMatrices(InstanceCount);
-
-    std::random_device Rd; // Random device for seed
-    std::mt19937 Gen(Rd()); // Mersenne Twister random number generator
-    std::uniform_real_distribution<float> AngleDist(0.0f, 360.0f);
-    std::uniform_real_distribution<float> DisplacementDist(-10.0f, 10.0f);
-    std::uniform_real_distribution<float> ScaleDist(0.005f, 0.01f);
-
-    for (unsigned int I = 0; I < InstanceCount; I++)
+    InstancePool Instances(InstanceCount);
+    if (UseSoftwareBackend)
     {
-        const float Angle = AngleDist(Gen);
+        // Culling and LOD off draw the field straight from the pool
+        LSoftwareBackend.addInstancePool(Instances);
+    }
 
-        const float DisplacementX = DisplacementDist(Gen);
-        const float DisplacementY = DisplacementDist(Gen);
-        const float DisplacementZ = DisplacementDist(Gen);
+    // Each instance is derived from (seed, index) alone, so the field is reproducible and generated in parallel
+    ScatterSettings Scatter;
+    Scatter.Seed = Seed;
+    TransformStorage InstanceTransforms;
+    InstanceScatter::generateParallel(Scatter, InstanceCount, InstanceTransforms);
 
-        glm::mat4 ModelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(DisplacementX, DisplacementY, DisplacementZ));
-        ModelMatrix = glm::rotate(ModelMatrix, glm::radians(Angle), glm::vec3(1.0f, 0.3f, 0.5f));
-        const float Scale = ScaleDist(Gen);
-        ModelMatrix = glm::scale(ModelMatrix, glm::vec3(Scale));
+    std::vector<glm::mat4> ModelMatrices(InstanceCount);
+    TransformComposer::composeParallel(InstanceTransforms, ModelMatrices.data());
 
-        ModelMatrices[I] = ModelMatrix;
+    // Spinning and bobbing is evaluated by the vertex shader from time, the pool never changes for it
+    std::vector<InstanceAnimation> Animations(InstanceCount);
+    if (Animate)
+    {
+        InstanceScatter::generateAnimations(Scatter, 0, InstanceCount, Animations);
     }
-
-    unsigned int InstanceBuffer;
-    glGenBuffers(1, &InstanceBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, InstanceBuffer);
-    glBufferData(GL_ARRAY_BUFFER, InstanceCount * sizeof(glm::mat4), ModelMatrices.data(), GL_STATIC_DRAW);
-
-    // Ensure VAO is bound before setting vertex attributes
-    glBindVertexArray(LModel.Vao);
-    for (unsigned int i = 0; i < 4; i++)
+    for (unsigned int I = 0; I < InstanceCount; I++)
     {
-        glEnableVertexAttribArray(2 + i);
-        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-            reinterpret_cast<void*>(i * sizeof(glm::vec4)));
-        glVertexAttribDivisor(2 + i, 1);
+        Instances.spawn(ModelMatrices[I], Animations[I]);
     }
-    glBindVertexArray(0); // Unbind VAO
 
-    while (!glfwWindowShouldClose(GWindow))
+    // Instance matrices feed vertex attributes 3-6 of the model's VAO, animations 7-8
+    Instances.attachToVao(LModel.Vao, 3);
+    Instances.upload();
+
+    // Ships flocking through the field, drawn instanced with the moving object's model
+    FlockSettings SwarmSettings;
+    SwarmSettings.Seed = Seed;
+    FlockSimulation Swarm(SwarmSettings);
+    Swarm.spawn(SwarmCount);
+    Swarm.setObstacles(Instances, LModel);
+    GRenderer->setSwarmModel(MovingObjectModel);
+
+    // Camera, moving object and swarm run in fixed steps whatever the frame rate. Frames draw between the last
+    // two steps of their snapshot
+    Simulation World;
+    World.setInstances(Instances, LModel);
+    World.setMovingObject(MovingObjectModel);
+    World.setSwarm(Swarm);
+
+    // Each frame is a graph of tasks. The next frame is simulated and culled on the job system's threads while
+    // this one is submitted to GL, into the other snapshot and prepared scene, so a frame costs the longer of
+    // the two chains rather than both
+    FrameSnapshot Snapshots[2];
+    PreparedScene Prepared[2];
+    int Drawing = 0;
+    World.capture(1.0f, 0.0f, Snapshots[Drawing]);
+    GRenderer->prepareScene(Snapshots[Drawing], LModel, Instances, Prepared[Drawing]);
+    SimulationInput Input{};
+    double Now = 0.0;
+    PipelineStats Pipeline{};
+    Profiler::endFrame();
+    GlCapture::endFrame();
+
+    FrameGraph Frame;
+    Frame.setThreaded(!SerialSimulation);
+    const TaskId InputTask = Frame.addTask("input", [&]
     {
+        GlState::resetStats();
+        GRenderer->setFrame(Snapshots[Drawing], Pipeline);
         GRenderer->processInput();
-
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(ShaderProgram);
-
-        // Bind the texture for the main model
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, LModel.Texture);
-        glUniform1i(glGetUniformLocation(ShaderProgram, "textureSampler"), 0);
-        GRenderer->renderScene(ShaderProgram, LModel, InstanceBuffer, InstanceCount, ModelMatrices);
-
-        // Bind the texture for the moving object
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, MovingObjectModel.Texture);
-        glUniform1i(glGetUniformLocation(ShaderProgram, "textureSampler"), 0);
-        GRenderer->renderMovingObject(ShaderProgram, MovingObjectModel);
-
+        Input = GRenderer->takeSimulationInput();
+        Now = glfwGetTime();
+    }, {}, TaskAffinity::MainThread);
+    const TaskId SimulateTask = Frame.addTask("simulate", [&]
+    {
+        const ProfileScope Scope("simulate");
+        World.runFrame(Input, Now, Snapshots[1 - Drawing]);
+    }, {InputTask});
+    const TaskId CullTask = Frame.addTask("cull", [&]
+    {
+        GRenderer->prepareScene(Snapshots[1 - Drawing], LModel, Instances, Prepared[1 - Drawing]);
+    }, {SimulateTask});
+    // Every draw of the frame is a packet carrying its own program, texture, VAO and uniforms, sorted by that
+    // state before any of it is submitted. Workers record the packets and copy the instances they read into a
+    // command buffer per group, the GL thread only copies those instances into mapped memory and replays them
+    RenderQueue Queue;
+    const BucketId SceneBucket = Queue.addBucket("scene");
+    CommandBuffer SceneCommands;
+    CommandBuffer ObjectCommands;
+    CommandBuffer SwarmCommands;
+    const TaskId BeginTask = Frame.addTask("begin", [&]
+    {
+        GRenderer->beginScene(LModel, Instances, Prepared[Drawing]);
+    }, {InputTask}, TaskAffinity::MainThread);
+    const TaskId RecordSceneTask = Frame.addTask("record scene", [&]
+    {
+        SceneCommands.begin();
+        GRenderer->recordScene(SceneCommands, ShaderProgram, LModel, Instances, Prepared[Drawing]);
+        SceneCommands.end();
+    }, {BeginTask});
+    const TaskId RecordObjectTask = Frame.addTask("record object", [&]
+    {
+        ObjectCommands.begin();
+        GRenderer->recordMovingObject(ObjectCommands, ShaderProgram, MovingObjectModel);
+        ObjectCommands.end();
+    }, {InputTask});
+    const TaskId RecordSwarmTask = Frame.addTask("record swarm", [&]
+    {
+        SwarmCommands.begin();
+        GRenderer->recordSwarm(SwarmCommands, ShaderProgram);
+        SwarmCommands.end();
+    }, {InputTask});
+    const TaskId SubmitTask = Frame.addTask("submit", [&]
+    {
+        {
+            const ProfileScope Scope("submit", true);
+            int FramebufferWidth = 0;
+            int FramebufferHeight = 0;
+            glfwGetFramebufferSize(GWindow, &FramebufferWidth, &FramebufferHeight);
+            if (UseSoftwareBackend)
+            {
+                LSoftwareBackend.resize(static_cast<unsigned int>(FramebufferWidth),
+                    static_cast<unsigned int>(FramebufferHeight));
+            }
+            GRenderer->getBackend().clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            Queue.clear();
+            GRenderer->execute(Queue, SceneBucket, SceneCommands);
+            GRenderer->execute(Queue, SceneBucket, ObjectCommands);
+            GRenderer->execute(Queue, SceneBucket, SwarmCommands);
+            GRenderer->submit(Queue);
+            if (UseSoftwareBackend)
+            {
+                LSoftwareBackend.present(FramebufferWidth, FramebufferHeight);
+            }
+        }
+
+        GlState::useProgram(ShaderProgram);
         GRenderer->renderUiElement(ShaderProgram);
+    }, {BeginTask, RecordSceneTask, RecordObjectTask, RecordSwarmTask}, TaskAffinity::MainThread);
 
+    // Resizes arrive while polling, after culling has read the window size
+    Frame.addTask("present", [&]
+    {
+        const ProfileScope Scope("present");
         glfwSwapBuffers(GWindow);
         glfwPollEvents();
+    }, {SubmitTask, CullTask}, TaskAffinity::MainThread);
+
+    bool FrameGraphPrinted = false;
+    unsigned int TracedFrames = 0;
+    while (!glfwWindowShouldClose(GWindow))
+    {
+        Profiler::beginFrame();
+        Frame.run();
+        Profiler::endFrame();
+
+        // A capture covers loading, recorded as a frame of its own, and the frames asked for
+        if (GlCapture::isRecording())
+        {
+            GlCapture::endFrame();
+            if (GlCapture::getStats().Frames > CaptureFrames)
+            {
+                stopCapture();
+            }
+        }
+        Drawing = 1 - Drawing;
+
+        // Shown in the render stats, the simulation of the frame about to be drawn against this frame's submit
+        Pipeline.Threaded = Frame.isThreaded();
+        Pipeline.SimulationMilliseconds = Frame.getTask(SimulateTask).Milliseconds;
+        Pipeline.RenderMilliseconds = Frame.getTask(SubmitTask).Milliseconds;
+        Pipeline.WaitMilliseconds = Frame.getIdleMilliseconds();
+        Pipeline.FrameMilliseconds = Frame.getFrameMilliseconds();
+
+        if (GPrintFrameGraph && !FrameGraphPrinted)
+        {
+            Frame.printTasks(std::cout);
+        }
+        if (GPrintFrameGraph)
+        {
+            Frame.printCriticalPath(std::cout);
+        }
+        FrameGraphPrinted = GPrintFrameGraph;
+
+        if (GPrintProfile)
+        {
+            Profiler::printReport(std::cout);
+            GPrintProfile = false;
+        }
+
+        // A trace runs until the key is pressed again, or for the frames asked for on the command line. GPU
+        // timings of its last few frames are still in flight when it's written and miss it
+        if (TraceRecorder::isRecording() && TraceFrames > 0 && ++TracedFrames >= TraceFrames)
+        {
+            GToggleTrace = true;
+            TraceFrames = 0;
+        }
+        if (GToggleTrace)
+        {
+            GToggleTrace = false;
+            if (!TraceRecorder::isRecording())
+            {
+                TraceRecorder::start();
+                std::cout << "Trace recording, press T again to write " << TracePath << std::endl;
+            }
+            else
+            {
+                TraceRecorder::stop();
+                if (TraceRecorder::flush(TracePath))
+                {
+                    const TraceStats Stats = TraceRecorder::getStats();
+                    std::cout << "Trace of " << Stats.Written << " events from " << Stats.Threads
+                        << " threads written to " << TracePath << " (" << Stats.Dropped << " dropped as their "
+                        << "thread's buffer was full)" << std::endl;
+                }
+            }
+        }
     }
 
+    stopCapture(); // If the window closed first
+    Instances.releaseBuffer(); // Free GPU memory while the context is still alive
+    ImpostorBaker::release(LImpostorAtlas);
+    glDeleteProgram(ImpostorProgram);
+    Profiler::reset(); // Its queries go with the context
     delete GRenderer; // Clean up renderer
     glfwTerminate();
     return 0;
 }
 
 // Function to initialise OpenGL
-bool initOpenGl(GLFWwindow*& Window)
+bool initOpenGl(GLFWwindow*& Window, const bool Capture)
 {
 	if (!glfwInit())
 	{
@@ -188,9 +540,24 @@ bool initOpenGl(GLFWwindow*& Window)
 		return false;
 	}
 
-	glEnable(GL_DEPTH_TEST); // Enable depth testing
-	glEnable(GL_CULL_FACE); // Enable culling
-	glCullFace(GL_BACK); // Cull back faces
+	// From the first call, as a replay only has the objects made while capturing
+	if (Capture)
+	{
+		int FramebufferWidth = 0;
+		int FramebufferHeight = 0;
+		glfwGetFramebufferSize(Window, &FramebufferWidth, &FramebufferHeight);
+		if (GlCapture::start(GlCapture::DefaultPath, static_cast<unsigned int>(FramebufferWidth),
+		                     static_cast<unsigned int>(FramebufferHeight)))
+		{
+			std::cout << "Capturing GL calls to " << GlCapture::DefaultPath << std::endl;
+		}
+	}
+
+	// State changes go through the cache from here on, so it starts from a context it knows nothing about
+	GlState::invalidate();
+	GlState::setEnabled(GL_DEPTH_TEST, true); // Enable depth testing
+	GlState::setEnabled(GL_CULL_FACE, true); // Enable culling
+	GlState::cullFace(GL_BACK); // Cull back faces
 	glViewport(0, 0, Width, Height);
 
 	// Set window color
@@ -199,6 +566,18 @@ bool initOpenGl(GLFWwindow*& Window)
 	return true;
 }
 
+// Write out the GL capture
+void stopCapture()
+{
+	if (GlCapture::isRecording() && GlCapture::stop())
+	{
+		const GlCaptureStats& Stats = GlCapture::getStats();
+		std::cout << "GL capture of " << Stats.Calls << " calls over " << Stats.Frames << " frames written to "
+			<< GlCapture::DefaultPath << " (" << Stats.Bytes << " bytes, " << Stats.ContentBytes << " of contents)"
+			<< std::endl;
+	}
+}
+
 // Key callback function
 void keyCallback(GLFWwindow* Window, const int Key, int ScanCode, const int Action, int Mods)
 {
@@ -208,7 +587,25 @@ void keyCallback(GLFWwindow* Window, const int Key, int ScanCode, const int Acti
 	// Toggle camera mode with space key
 	if (Key == GLFW_KEY_SPACE && Action == GLFW_PRESS)
 	{
-		GRenderer->getCamera().toggleMode();
+		GRenderer->toggleCameraMode();
+	}
+
+	// Frame graph printing, every task once and then the critical path each frame
+	if (Key == GLFW_KEY_F && Action == GLFW_PRESS)
+	{
+		GPrintFrameGraph = !GPrintFrameGraph;
+	}
+
+	// Chrome trace of every scope, task, job, GPU timing and asset load between two presses
+	if (Key == GLFW_KEY_T && Action == GLFW_PRESS)
+	{
+		GToggleTrace = true;
+	}
+
+	// Rolling CPU and GPU times of every profiled scope
+	if (Key == GLFW_KEY_P && Action == GLFW_PRESS)
+	{
+		GPrintProfile = true;
 	}
 }
 
@@ -2,12 +2,21 @@
 
 in vec2 TexCoord;
 in vec3 Normal;
+flat in float Fade;
 
 out vec4 FragColor;
 
-uniform sampler2D textureSampler;
+layout(binding = 0) uniform sampler2D textureSampler; // Unit 0, fixed here so no frame sets it
+
+// Same ordered dither as ImpostorFragmentShader.frag so the two fades cover complementary pixels
+const float Bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
 
 void main()
 {
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    if (Fade < (Bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0)
+    {
+        discard;
+    }
     FragColor = texture(textureSampler, TexCoord);
 }
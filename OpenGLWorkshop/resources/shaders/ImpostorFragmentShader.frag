@@ -0,0 +1,23 @@
+#version 460 core
+
+in vec2 TexCoord;
+flat in float Fade;
+
+out vec4 FragColor;
+
+layout(binding = 0) uniform sampler2D atlasSampler;
+
+// 4x4 ordered dither, the mesh keeps the pixels where Fade passes and the impostor keeps the rest
+const float Bayer[16] = float[](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    float threshold = (Bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+    vec4 colour = texture(atlasSampler, TexCoord);
+    if (colour.a < 0.5 || Fade >= threshold)
+    {
+        discard;
+    }
+    FragColor = vec4(colour.rgb / colour.a, 1.0); // Filtering blends towards the transparent black background
+}
@@ -0,0 +1,96 @@
+#version 460 core
+
+layout(location = 0) in vec2 corner;
+layout(location = 3) in mat4 instanceMatrix; // Occupies locations 3 to 6
+layout(location = 7) in vec4 instanceSpin; // See VertexShader.vert
+layout(location = 8) in vec4 instanceBob;
+
+uniform mat4 viewProjection;
+uniform vec3 cameraPosition;
+uniform vec4 bounds; // Model space bounding sphere, xyz centre and w radius
+uniform float projectionScale; // Pixels covered by one world unit at distance one
+uniform vec2 fadeRange; // Projected diameters in pixels where the mesh fades in over the impostor
+uniform int gridSize;
+uniform bool animated;
+uniform float time;
+
+out vec2 TexCoord;
+flat out float Fade;
+
+// Must match InstanceAnimator::evaluate
+mat4 animatedMatrix()
+{
+    if (!animated)
+    {
+        return instanceMatrix;
+    }
+    vec3 axis = instanceSpin.xyz;
+    float angle = instanceSpin.w * time;
+    float c = cos(angle);
+    mat3 skew = mat3(0.0, axis.z, -axis.y, -axis.z, 0.0, axis.x, axis.y, -axis.x, 0.0);
+    mat3 spin = mat3(c) + (1.0 - c) * outerProduct(axis, axis) + sin(angle) * skew;
+    mat4 posed = instanceMatrix * mat4(spin);
+    posed[3].y += instanceBob.x * sin(instanceBob.y * time + instanceBob.z);
+    return posed;
+}
+
+vec2 signNotZero(vec2 value)
+{
+    return vec2(value.x >= 0.0 ? 1.0 : -1.0, value.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Must match ImpostorBaker::octahedralCoordinate, octahedralDirection and frameUp
+vec2 octahedralCoordinate(vec3 direction)
+{
+    vec3 projected = direction / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    vec2 point = projected.xz;
+    if (projected.y < 0.0)
+    {
+        point = (1.0 - abs(point.yx)) * signNotZero(point);
+    }
+    return point * 0.5 + 0.5;
+}
+
+vec3 octahedralDirection(vec2 coordinate)
+{
+    vec2 point = coordinate * 2.0 - 1.0;
+    vec3 direction = vec3(point.x, 1.0 - abs(point.x) - abs(point.y), point.y);
+    if (direction.y < 0.0)
+    {
+        direction.xz = (1.0 - abs(direction.zx)) * signNotZero(direction.xz);
+    }
+    return normalize(direction);
+}
+
+vec3 frameUp(vec3 direction)
+{
+    return abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+}
+
+void main()
+{
+    mat4 model = animatedMatrix();
+    mat3 basis = mat3(model);
+    vec3 center = (model * vec4(bounds.xyz, 1.0)).xyz;
+    float radius = bounds.w * max(length(basis[0]), max(length(basis[1]), length(basis[2])));
+    vec3 toCamera = cameraPosition - center;
+    float distance = length(toCamera);
+    vec3 viewDirection = toCamera / distance;
+
+    // Nearest baked view of the direction to the camera in model space
+    vec3 localDirection = normalize(inverse(basis) * viewDirection);
+    float lastFrame = float(gridSize - 1);
+    vec2 frame = clamp(round(octahedralCoordinate(localDirection) * lastFrame), 0.0, lastFrame);
+    vec3 frameDirection = octahedralDirection(frame / lastFrame);
+
+    // Face the camera, rolled so the baked up vector stays up on screen
+    vec3 up = basis * frameUp(frameDirection);
+    up = normalize(up - dot(up, viewDirection) * viewDirection);
+    vec3 right = cross(-viewDirection, up);
+    vec3 position = center + (corner.x * right + corner.y * up) * radius;
+
+    TexCoord = (frame + corner * 0.5 + 0.5) / float(gridSize);
+    float diameter = 2.0 * radius * projectionScale / distance;
+    Fade = clamp((diameter - fadeRange.x) / (fadeRange.y - fadeRange.x), 0.0, 1.0);
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
@@ -3,15 +3,56 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
 layout(location = 2) in vec3 normal;
+layout(location = 3) in mat4 instanceMatrix; // Occupies locations 3 to 6
+layout(location = 7) in vec4 instanceSpin; // xyz axis, w radians per second
+layout(location = 8) in vec4 instanceBob; // x amplitude, y radians per second, z phase
 
 uniform mat4 mvp;
+uniform bool instanced; // mvp holds only projection * view when instanced
+uniform bool animated; // Instances move by instanceSpin and instanceBob, only set with the animation stream bound
+uniform float time;
+
+// Crossfade with impostors, see ImpostorVertexShader.vert
+uniform bool fading;
+uniform vec3 cameraPosition;
+uniform vec4 bounds;
+uniform float projectionScale;
+uniform vec2 fadeRange;
 
 out vec2 TexCoord;
 out vec3 Normal;
+flat out float Fade;
+
+// Must match InstanceAnimator::evaluate
+mat4 animatedMatrix()
+{
+    if (!animated)
+    {
+        return instanceMatrix;
+    }
+    vec3 axis = instanceSpin.xyz;
+    float angle = instanceSpin.w * time;
+    float c = cos(angle);
+    mat3 skew = mat3(0.0, axis.z, -axis.y, -axis.z, 0.0, axis.x, axis.y, -axis.x, 0.0);
+    mat3 spin = mat3(c) + (1.0 - c) * outerProduct(axis, axis) + sin(angle) * skew;
+    mat4 posed = instanceMatrix * mat4(spin);
+    posed[3].y += instanceBob.x * sin(instanceBob.y * time + instanceBob.z);
+    return posed;
+}
 
 void main()
 {
     TexCoord = texCoord;
     Normal = normal;
-    gl_Position = mvp * vec4(position, 1.0);
+    Fade = 1.0;
+    mat4 model = instanced ? animatedMatrix() : mat4(1.0);
+    if (instanced && fading)
+    {
+        mat3 basis = mat3(model);
+        vec3 center = (model * vec4(bounds.xyz, 1.0)).xyz;
+        float radius = bounds.w * max(length(basis[0]), max(length(basis[1]), length(basis[2])));
+        float diameter = 2.0 * radius * projectionScale / length(cameraPosition - center);
+        Fade = clamp((diameter - fadeRange.x) / (fadeRange.y - fadeRange.x), 0.0, 1.0);
+    }
+    gl_Position = mvp * model * vec4(position, 1.0);
 }
@@ -0,0 +1,3027 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Benchmark.cpp
+Description : Implementations for the command line benchmarks. These
+			  run before any window or OpenGL context is created
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "Benchmark.h"
+#include "InstancePool.h"
+#include "TransformStorage.h"
+#include "Simd.h"
+#include "InstanceScatter.h"
+#include "Parallel.h"
+#include "Renderer.h"
+#include "ShaderLoader.h"
+#include "ImpostorBaker.h"
+#include "InstanceBvh.h"
+#include "InstancePicker.h"
+#include "Camera.h"
+#include "CollisionGrid.h"
+#include "FlockSimulation.h"
+#include "FrameClock.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
+#include "JobSystem.h"
+#include "FrameGraph.h"
+#include "RenderQueue.h"
+#include "GlState.h"
+#include "CommandBuffer.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include "RenderBackend.h"
+#include "SoftwareBackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "GlCapture.h"
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+bool Benchmark::run(const std::string& Name, const std::uint64_t Seed)
+{
+	if (Name == "pool")
+	{
+		instancePoolChurn();
+		return true;
+	}
+	if (Name == "transforms")
+	{
+		transformComposition();
+		return true;
+	}
+	if (Name == "scatter")
+	{
+		instanceScatter(Seed);
+		return true;
+	}
+	if (Name == "impostors")
+	{
+		impostorRendering(Seed);
+		return true;
+	}
+	if (Name == "occlusion")
+	{
+		occlusionCulling(Seed);
+		return true;
+	}
+	if (Name == "bvh")
+	{
+		instanceBvh(Seed);
+		return true;
+	}
+	if (Name == "picking")
+	{
+		instancePicking(Seed);
+		return true;
+	}
+	if (Name == "collision")
+	{
+		collisionBroadphase(Seed);
+		return true;
+	}
+	if (Name == "swarm")
+	{
+		swarmSimulation(Seed);
+		return true;
+	}
+	if (Name == "animation")
+	{
+		instanceAnimation(Seed);
+		return true;
+	}
+	if (Name == "timestep")
+	{
+		fixedTimestep(Seed);
+		return true;
+	}
+	if (Name == "pipeline")
+	{
+		simulationPipeline(Seed);
+		return true;
+	}
+	if (Name == "jobs")
+	{
+		jobSystem();
+		return true;
+	}
+	if (Name == "graph")
+	{
+		frameGraph(Seed);
+		return true;
+	}
+	if (Name == "queue")
+	{
+		renderQueue(Seed);
+		return true;
+	}
+	if (Name == "state")
+	{
+		stateFiltering(Seed);
+		return true;
+	}
+	if (Name == "commands")
+	{
+		commandRecording(Seed);
+		return true;
+	}
+	if (Name == "profiler")
+	{
+		frameProfiler(Seed);
+		return true;
+	}
+	if (Name == "trace")
+	{
+		traceRecording(Seed);
+		return true;
+	}
+	if (Name == "backend")
+	{
+		nullBackend(Seed);
+		return true;
+	}
+	if (Name == "software")
+	{
+		softwareRasteriser(Seed);
+		return true;
+	}
+	return false;
+}
+
+void Benchmark::printUsage()
+{
+	std::cout << "Available benchmarks (--bench <name>):\n";
+	std::cout << "  pool        Instance pool spawn/despawn churn at steady state\n";
+	std::cout << "  transforms  SoA SIMD matrix composition against the glm path at 1M transforms\n";
+	std::cout << "  scatter     Parallel counter-based instance generation of 10M transforms (uses --seed)\n";
+	std::cout << "  impostors   Frame time of 100k instances with and without far field impostors (uses --seed,\n";
+	std::cout << "              opens a hidden window, set LIBGL_ALWAYS_SOFTWARE=1 with Mesa to measure llvmpipe)\n";
+	std::cout << "  occlusion   Frame time and triangles of a dense 5k instance cloud with and without CPU\n";
+	std::cout << "              occlusion culling, and the culler's own cost (uses --seed, opens a hidden window)\n";
+	std::cout << "  bvh         Build, refit, async rebuild and frustum/ray/sphere query throughput of the instance\n";
+	std::cout << "              BVH at 1M instances, checked against brute force scans (uses --seed)\n";
+	std::cout << "  picking     Cursor pick latency at 100k instances against every instance's mesh tested in turn\n";
+	std::cout << "              (uses --seed, opens a hidden window to load the models)\n";
+	std::cout << "  collision   Grid sync and moving object contact queries at 100k instances against a brute force\n";
+	std::cout << "              test of every instance (uses --seed, opens a hidden window to load the models)\n";
+	std::cout << "  swarm       Flocking step time of 50k ships around 25k obstacles against the 60 Hz budget, SIMD\n";
+	std::cout << "              integration kernels and determinism across thread counts (uses --seed, headless)\n";
+	std::cout << "  animation   Frame cost of 100k spinning, bobbing instances posed on the CPU and uploaded against\n";
+	std::cout << "              posed in the vertex shader, culling cost and picks against the posed meshes (uses\n";
+	std::cout << "              --seed, opens a hidden window)\n";
+	std::cout << "  timestep    Held camera input over 10 s at several steady and jittered frame rates, checking the\n";
+	std::cout << "              fixed step simulation ends in the same state and frames draw where they should (uses\n";
+	std::cout << "              --seed, headless)\n";
+	std::cout << "  pipeline    Frame time with the simulation on its own thread a frame ahead of rendering against\n";
+	std::cout << "              both run in turn, per stage, and whether both end in the same state (uses --seed,\n";
+	std::cout << "              opens a hidden window)\n";
+	std::cout << "  jobs        Job system scheduling overhead against a thread per task, parallel loop coverage,\n";
+	std::cout << "              dependency order and compute scaling from 1 thread to one per core (headless)\n";
+	std::cout << "  graph       Frame time of the app's frame graph with every task run in turn against run across\n";
+	std::cout << "              threads, per task, the critical path and whether both end in the same state (uses\n";
+	std::cout << "              --seed, opens a hidden window)\n";
+	std::cout << "  queue       Render queue push, radix sort and submission of 100k draw packets sorted by state\n";
+	std::cout << "              against submitted in push order, with state changes of each (uses --seed, opens a\n";
+	std::cout << "              hidden window)\n";
+	std::cout << "  state       GL calls issued and filtered by the state cache over a frame of the scene submitted\n";
+	std::cout << "              once per view, against every call sent to GL, and whether both draw the same image\n";
+	std::cout << "              (uses --seed, opens a hidden window)\n";
+	std::cout << "  commands    Draw recording of the scene, moving object and swarm into command buffers on worker\n";
+	std::cout << "              threads against recorded in turn on the GL thread, with record, execute and submit\n";
+	std::cout << "              times and whether both draw the same image (uses --seed, opens a hidden window)\n";
+	std::cout << "  profiler    Cost of a profile scope on and off, frame time of the scene with the profiler on and\n";
+	std::cout << "              off, GPU timings read back without waiting and the report (uses --seed, opens a\n";
+	std::cout << "              hidden window)\n";
+	std::cout << "  trace       Cost of a trace event, frame time with a trace recording and not, and the events of\n";
+	std::cout << "              loading and 33 frames written to benchmark_trace.json by category (uses --seed, opens\n";
+	std::cout << "              a hidden window)\n";
+	std::cout << "  backend     The frame pipeline per stage submitting to GL against to the null backend, with the\n";
+	std::cout << "              frame rate its CPU side allows, whether both were handed the same draws and GL\n";
+	std::cout << "              calls made in the null backend's frames, counted by a capture (uses --seed, opens a\n";
+	std::cout << "              hidden window to load)\n";
+	std::cout << "  software    The app's scene rasterised on the CPU at each tile size and thread count, scalar\n";
+	std::cout << "              against AVX2, whether every configuration draws the same image and how close it is\n";
+	std::cout << "              to GL's, written to benchmark_software.ppm, and whether a floor crossing the near\n";
+	std::cout << "              plane is clipped as GL clips it (uses --seed, opens a hidden window)\n";
+}
+
+void Benchmark::instancePoolChurn()
+{
+	constexpr unsigned int LiveCount = 100000; // Steady state population
+	constexpr unsigned int ChurnPerTick = 5000; // Spawns and despawns per simulated frame
+	constexpr unsigned int TickCount = 2000;
+
+	InstancePool Pool(LiveCount);
+	std::vector<InstanceHandle> Live;
+	Live.reserve(LiveCount);
+
+	std::mt19937 Gen(1234);
+	std::uniform_real_distribution<float> DisplacementDist(-10.0f, 10.0f);
+	auto makeTransform = [&]()
+	{
+		return translate(glm::mat4(1.0f),
+		                 glm::vec3(DisplacementDist(Gen), DisplacementDist(Gen), DisplacementDist(Gen)));
+	};
+
+	for (unsigned int I = 0; I < LiveCount; I++)
+	{
+		Live.push_back(Pool.spawn(makeTransform()));
+	}
+
+	// Pre-generate the transforms and victims so the timed loop measures the pool and not the RNG. Each tick
+	// reuses them, and as the handles move around Live every tick, each despawns different instances
+	std::vector<glm::mat4> Transforms(ChurnPerTick);
+	for (auto& Transform : Transforms)
+	{
+		Transform = makeTransform();
+	}
+	std::vector<unsigned int> Victims(ChurnPerTick);
+	for (unsigned int I = 0; I < ChurnPerTick; I++)
+	{
+		Victims[I] = Gen() % (LiveCount - I); // Live shrinks by one per despawn
+	}
+
+	unsigned long long Operations = 0;
+	const auto Start = BenchmarkClock::now();
+	for (unsigned int Tick = 0; Tick < TickCount; Tick++)
+	{
+		for (unsigned int I = 0; I < ChurnPerTick; I++)
+		{
+			const unsigned int Victim = Victims[I];
+			Pool.despawn(Live[Victim]);
+			Live[Victim] = Live.back();
+			Live.pop_back();
+		}
+		for (unsigned int I = 0; I < ChurnPerTick; I++)
+		{
+			Live.push_back(Pool.spawn(Transforms[I]));
+		}
+		Operations += 2ull * ChurnPerTick;
+	}
+	const std::chrono::duration<double> Elapsed = BenchmarkClock::now() - Start;
+
+	std::cout << "Instance pool churn\n";
+	std::cout << "  Live instances : " << Pool.getCount() << "\n";
+	std::cout << "  Operations     : " << Operations << " (" << TickCount << " ticks)\n";
+	std::cout << "  Elapsed        : " << Elapsed.count() * 1000.0 << " ms\n";
+	std::cout << "  Throughput     : " << static_cast<double>(Operations) / Elapsed.count() / 1.0e6
+		<< " M spawns+despawns/sec\n";
+}
+
+void Benchmark::transformComposition()
+{
+	constexpr unsigned int TransformCount = 1000000;
+	constexpr int Repeats = 5; // Best of, to keep scheduler noise out
+
+	std::mt19937 Gen(1234);
+	std::uniform_real_distribution<float> AngleDist(0.0f, 360.0f);
+	std::uniform_real_distribution<float> DisplacementDist(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> ScaleDist(0.005f, 0.01f);
+
+	std::vector<float> Angles(TransformCount);
+	std::vector<glm::vec3> Positions(TransformCount);
+	std::vector<float> Scales(TransformCount);
+	for (unsigned int I = 0; I < TransformCount; I++)
+	{
+		Angles[I] = AngleDist(Gen);
+		Positions[I] = glm::vec3(DisplacementDist(Gen), DisplacementDist(Gen), DisplacementDist(Gen));
+		Scales[I] = ScaleDist(Gen);
+	}
+
+	const glm::vec3 Axis = normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+	TransformStorage Transforms;
+	Transforms.resize(TransformCount);
+	for (unsigned int I = 0; I < TransformCount; I++)
+	{
+		Transforms.setTransform(I, Positions[I], angleAxis(glm::radians(Angles[I]), Axis), glm::vec3(Scales[I]));
+	}
+
+	std::vector<glm::mat4> Reference(TransformCount);
+	std::vector<glm::mat4> Composed(TransformCount);
+
+	auto timeBest = [&](auto&& Body)
+	{
+		double Best = 1.0e30;
+		for (int Run = 0; Run < Repeats; Run++)
+		{
+			const auto Start = BenchmarkClock::now();
+			Body();
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			Best = std::min(Best, Elapsed.count());
+		}
+		return Best;
+	};
+
+	// The per instance chain main.cpp used before transforms were stored as SoA
+	const double GlmMs = timeBest([&]
+	{
+		for (unsigned int I = 0; I < TransformCount; I++)
+		{
+			glm::mat4 ModelMatrix = translate(glm::mat4(1.0f), Positions[I]);
+			ModelMatrix = rotate(ModelMatrix, glm::radians(Angles[I]), glm::vec3(1.0f, 0.3f, 0.5f));
+			Reference[I] = scale(ModelMatrix, glm::vec3(Scales[I]));
+		}
+	});
+
+	auto report = [&](const char* Name, const double Milliseconds)
+	{
+		float MaxError = 0.0f;
+		for (unsigned int I = 0; I < TransformCount; I++)
+		{
+			for (int Column = 0; Column < 4; Column++)
+			{
+				for (int Row = 0; Row < 4; Row++)
+				{
+					MaxError = std::max(MaxError, std::abs(Composed[I][Column][Row] - Reference[I][Column][Row]));
+				}
+			}
+		}
+		std::cout << "  " << Name << " : " << Milliseconds << " ms (" << GlmMs / Milliseconds
+			<< "x vs glm, max error " << MaxError << ")\n";
+	};
+
+	std::cout << "Transform composition (" << TransformCount << " transforms, best of " << Repeats << ")\n";
+	std::cout << "  glm translate/rotate/scale : " << GlmMs << " ms\n";
+	report("SoA scalar                ", timeBest([&]
+	{
+		TransformComposer::composeScalar(Transforms, 0, TransformCount, Composed.data());
+	}));
+#if SIMD_X86
+	report("SoA SSE (4 wide)          ", timeBest([&]
+	{
+		TransformComposer::composeSse(Transforms, 0, TransformCount, Composed.data());
+	}));
+	if (Simd::hasAvx2())
+	{
+		report("SoA AVX2 (8 wide)         ", timeBest([&]
+		{
+			TransformComposer::composeAvx2(Transforms, 0, TransformCount, Composed.data());
+		}));
+	}
+#endif
+	std::cout << "  Runtime kernel : " << TransformComposer::getKernelName() << "\n";
+}
+
+// FNV-1a over the raw bits so serial and parallel output can be compared exactly
+static std::uint64_t hashTransforms(const TransformStorage& Transforms)
+{
+	std::uint64_t Hash = 14695981039346656037ull;
+	for (const std::vector<float>* Component : {&Transforms.PositionX, &Transforms.PositionY, &Transforms.PositionZ,
+	                                            &Transforms.RotationX, &Transforms.RotationY, &Transforms.RotationZ,
+	                                            &Transforms.RotationW, &Transforms.ScaleX, &Transforms.ScaleY,
+	                                            &Transforms.ScaleZ})
+	{
+		const auto* Bytes = reinterpret_cast<const unsigned char*>(Component->data());
+		for (std::size_t I = 0; I < Component->size() * sizeof(float); I++)
+		{
+			Hash = (Hash ^ Bytes[I]) * 1099511628211ull;
+		}
+	}
+	return Hash;
+}
+
+void Benchmark::instanceScatter(const std::uint64_t Seed)
+{
+	constexpr std::size_t TransformCount = 10000000;
+
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	TransformStorage Transforms;
+
+	auto timeGenerate = [&](const unsigned int Threads)
+	{
+		Parallel::setThreadCount(Threads);
+		const auto Start = BenchmarkClock::now();
+		InstanceScatter::generateParallel(Settings, TransformCount, Transforms);
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		return Elapsed.count();
+	};
+
+	const double SerialMs = timeGenerate(1);
+	const std::uint64_t SerialHash = hashTransforms(Transforms);
+
+	Parallel::setThreadCount(0);
+	const unsigned int ThreadCount = Parallel::getThreadCount();
+	const double ParallelMs = timeGenerate(ThreadCount);
+	const std::uint64_t ParallelHash = hashTransforms(Transforms);
+
+	// Regenerate an arbitrary subrange in place, it must reproduce the same bits
+	const std::size_t SubBegin = TransformCount / 3 + 7;
+	const std::size_t SubEnd = SubBegin + TransformCount / 10;
+	InstanceScatter::generate(Settings, SubBegin, SubEnd, Transforms);
+	const std::uint64_t SubrangeHash = hashTransforms(Transforms);
+
+	std::cout << "Instance scatter (" << TransformCount << " transforms, seed " << Seed << ")\n";
+	std::cout << "  1 thread    : " << SerialMs << " ms (" << TransformCount / SerialMs / 1000.0
+		<< " M transforms/sec)\n";
+	std::cout << "  " << ThreadCount << " threads   : " << ParallelMs << " ms (" << TransformCount / ParallelMs / 1000.0
+		<< " M transforms/sec, " << SerialMs / ParallelMs << "x)\n";
+	std::cout << "  Checksum    : " << std::hex << SerialHash << std::dec << "\n";
+	std::cout << "  Deterministic across thread counts : " << (SerialHash == ParallelHash ? "yes" : "NO") << "\n";
+	std::cout << "  Deterministic for a regenerated subrange : " << (SerialHash == SubrangeHash ? "yes" : "NO") << "\n";
+}
+
+// Hidden window with the scene shaders and the instanced model, shared by the benchmarks that render
+struct BenchmarkScene
+{
+	GLFWwindow* Window = nullptr;
+	GLuint ShaderProgram = 0;
+	GLuint ImpostorProgram = 0;
+	Model LModel{};
+	Model MovingObjectModel{};
+};
+
+constexpr unsigned int BenchmarkWidth = 800;
+constexpr unsigned int BenchmarkHeight = 600;
+
+static bool openScene(BenchmarkScene& Scene)
+{
+	// The default framebuffer of a hidden window is still rendered to, so fill cost is included
+	if (!glfwInit())
+	{
+		std::cerr << "Failed to initialise GLFW" << std::endl;
+		return false;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	Scene.Window = glfwCreateWindow(BenchmarkWidth, BenchmarkHeight, "Benchmark", nullptr, nullptr);
+	if (!Scene.Window)
+	{
+		std::cerr << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(Scene.Window);
+	glfwSwapInterval(0);
+	if (glewInit() != GLEW_OK)
+	{
+		std::cerr << "Failed to initialise GLEW" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	GlState::invalidate();
+	GlState::setEnabled(GL_DEPTH_TEST, true);
+	GlState::setEnabled(GL_CULL_FACE, true);
+	GlState::cullFace(GL_BACK);
+	glViewport(0, 0, BenchmarkWidth, BenchmarkHeight);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	Scene.ShaderProgram = ShaderLoader::createProgram("resources/shaders/VertexShader.vert",
+	                                                  "resources/shaders/FragmentShader.frag");
+	Scene.ImpostorProgram = ShaderLoader::createProgram("resources/shaders/ImpostorVertexShader.vert",
+	                                                    "resources/shaders/ImpostorFragmentShader.frag");
+	constexpr ModelLoader LModelLoader;
+	Scene.LModel = LModelLoader.loadModel("resources/models/SciFiSpace/SM_Prop_Mine_01.obj",
+	                                      "resources/textures/PolygonSciFiSpace_Texture_01_A.png");
+	Scene.MovingObjectModel = LModelLoader.loadModel("resources/models/SciFiSpace/SM_Ship_Fighter_02.obj",
+	                                                 "resources/textures/PolygonAncientWorlds_Texture_01_A.png");
+	if (!Scene.ShaderProgram || !Scene.ImpostorProgram || Scene.LModel.Vao == 0 || Scene.MovingObjectModel.Vao == 0)
+	{
+		std::cerr << "Failed to load benchmark resources" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	std::cout << "  Renderer : " << glGetString(GL_RENDERER) << "\n";
+	return true;
+}
+
+static void closeScene(BenchmarkScene& Scene)
+{
+	glDeleteProgram(Scene.ShaderProgram);
+	glDeleteProgram(Scene.ImpostorProgram);
+	glfwDestroyWindow(Scene.Window);
+	glfwTerminate();
+}
+
+// Instance field from the scatter settings, uploaded and attached to the model like main.cpp does
+static void fillInstances(const ScatterSettings& Settings, const unsigned int Count, const Model& Model,
+                          InstancePool& Instances)
+{
+	TransformStorage Transforms;
+	InstanceScatter::generateParallel(Settings, Count, Transforms);
+	std::vector<glm::mat4> ModelMatrices(Count);
+	TransformComposer::composeParallel(Transforms, ModelMatrices.data());
+	for (const glm::mat4& ModelMatrix : ModelMatrices)
+	{
+		Instances.spawn(ModelMatrix);
+	}
+	Instances.attachToVao(Model.Vao, 3);
+	Instances.upload();
+}
+
+// Average milliseconds per frame of the instanced scene, waiting on the GPU so its work is counted
+static double timeFrames(Renderer& LRenderer, const BenchmarkScene& Scene, InstancePool& Instances)
+{
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 20;
+
+	double TotalMs = 0.0;
+	for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+	{
+		const auto Start = BenchmarkClock::now();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances);
+		glFinish();
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		if (Frame >= WarmupFrames)
+		{
+			TotalMs += Elapsed.count();
+		}
+	}
+	return TotalMs / TimedFrames;
+}
+
+void Benchmark::impostorRendering(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 100000;
+
+	std::cout << "Impostor rendering (" << InstanceCount << " instances, seed " << Seed << ", " << BenchmarkWidth
+		<< "x" << BenchmarkHeight << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	const auto BakeStart = BenchmarkClock::now();
+	ImpostorAtlas Atlas = ImpostorBaker::bake(Scene.LModel, Scene.ShaderProgram);
+	glFinish();
+	const std::chrono::duration<double, std::milli> BakeMs = BenchmarkClock::now() - BakeStart;
+	std::cout << "  Atlas bake : " << BakeMs.count() << " ms (" << Atlas.GridSize << "x" << Atlas.GridSize
+		<< " frames of " << Atlas.FrameResolution << " px)\n";
+
+	// A wide field so most of the visible instances are far from the camera
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+
+	// A fresh renderer per mode so both see the same camera and LOD history
+	auto measure = [&](const char* Name, const bool ImpostorsEnabled)
+	{
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setImpostors(Atlas, Scene.ImpostorProgram);
+		LRenderer.setImpostorsEnabled(ImpostorsEnabled);
+		const double FrameMs = timeFrames(LRenderer, Scene, Instances);
+
+		const RenderStats& Stats = LRenderer.getStats();
+		std::cout << "  " << Name << " : " << FrameMs << " ms/frame, " << Stats.Triangles << " triangles, "
+			<< Stats.DrawCalls << " draws, " << Stats.ImpostorInstances << " impostors of " << Stats.Instances
+			<< " visible\n";
+		return FrameMs;
+	};
+
+	const double MeshMs = measure("Mesh LODs only    ", false);
+	const double ImpostorMs = measure("Meshes + impostors", true);
+	std::cout << "  Speedup : " << MeshMs / ImpostorMs << "x\n";
+
+	Instances.releaseBuffer();
+	ImpostorBaker::release(Atlas);
+	closeScene(Scene);
+}
+
+void Benchmark::occlusionCulling(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 5000;
+
+	std::cout << "Occlusion culling (" << InstanceCount << " instances, seed " << Seed << ", " << BenchmarkWidth
+		<< "x" << BenchmarkHeight << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	// The default field, only denser, so the camera looks into a cloud that mostly hides itself
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+
+	auto measure = [&](const char* Name, const bool OcclusionEnabled)
+	{
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setMovingObjectOccluder(Scene.MovingObjectModel);
+		LRenderer.setOcclusionEnabled(OcclusionEnabled);
+		const double FrameMs = timeFrames(LRenderer, Scene, Instances);
+
+		const RenderStats& Stats = LRenderer.getStats();
+		std::cout << "  " << Name << " : " << FrameMs << " ms/frame, " << Stats.Triangles << " triangles, "
+			<< Stats.Instances << " instances drawn\n";
+		if (OcclusionEnabled)
+		{
+			const OcclusionStats& Occlusion = Stats.Occlusion;
+			std::cout << "    " << Occlusion.Occluders << " occluders, " << Occlusion.OccluderTriangles
+				<< " triangles rasterised in " << Occlusion.RasterMilliseconds << " ms, " << Occlusion.Occluded
+				<< " of " << Occlusion.Tested << " instances hidden in " << Occlusion.TestMilliseconds << " ms ("
+				<< Parallel::getThreadCount() << " threads)\n";
+		}
+		return std::make_pair(FrameMs, Stats.Triangles);
+	};
+
+	const auto [OffMs, OffTriangles] = measure("Occlusion off", false);
+	const auto [OnMs, OnTriangles] = measure("Occlusion on ", true);
+	std::cout << "  Triangles saved : " << OffTriangles - OnTriangles << ", frame time " << OffMs - OnMs
+		<< " ms lower\n";
+
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
+
+// Brute force answers for the BVH benchmark, the same box tests as the tree applies at its leaves
+static bool boxInFrustum(const glm::vec4* Planes, const BvhBounds& Box)
+{
+	for (int Plane = 0; Plane < 6; Plane++)
+	{
+		const glm::vec3 Normal(Planes[Plane]);
+		if (dot(Normal, mix(Box.Min, Box.Max, greaterThanEqual(Normal, glm::vec3(0.0f)))) + Planes[Plane].w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static float boxRayEntry(const glm::vec3& Origin, const glm::vec3& InverseDirection, const BvhBounds& Box)
+{
+	const glm::vec3 T0 = (Box.Min - Origin) * InverseDirection;
+	const glm::vec3 T1 = (Box.Max - Origin) * InverseDirection;
+	const glm::vec3 Near = glm::min(T0, T1);
+	const glm::vec3 Far = glm::max(T0, T1);
+	const float Entry = std::max(std::max(Near.x, Near.y), std::max(Near.z, 0.0f));
+	const float Exit = std::min(std::min(Far.x, Far.y), Far.z);
+	return Entry <= Exit ? Entry : std::numeric_limits<float>::infinity();
+}
+
+void Benchmark::instanceBvh(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 1000000;
+	constexpr int FrustumQueries = 200;
+	constexpr int RayQueries = 200000;
+	constexpr int SphereQueries = 200000;
+	constexpr int BruteForceQueries = 20; // Per query type, checked against the tree's answers
+	constexpr float QueryRadius = 2.0f;
+	constexpr float RayLength = 100.0f;
+	constexpr int DriftSteps = 10;
+
+	std::cout << "Instance BVH (" << InstanceCount << " instances, seed " << Seed << ", "
+		<< Parallel::getThreadCount() << " threads)\n";
+
+	// The impostor benchmark's wide field. Only the model's bounds matter, these are the mine's
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	TransformStorage Transforms;
+	InstanceScatter::generateParallel(Settings, InstanceCount, Transforms);
+	std::vector<glm::mat4> ModelMatrices(InstanceCount);
+	TransformComposer::composeParallel(Transforms, ModelMatrices.data());
+	InstancePool Instances(InstanceCount);
+	for (const glm::mat4& ModelMatrix : ModelMatrices)
+	{
+		Instances.spawn(ModelMatrix);
+	}
+	Model BoundsModel{};
+	BoundsModel.BoundsMin = glm::vec3(-66.4f, -70.2f, -66.7f);
+	BoundsModel.BoundsMax = glm::vec3(66.4f, 70.2f, 66.7f);
+
+	auto elapsedMs = [](const BenchmarkClock::time_point Start)
+	{
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		return Elapsed.count();
+	};
+
+	InstanceBvh Bvh;
+	auto Start = BenchmarkClock::now();
+	Bvh.build(Instances, BoundsModel);
+	const double BuildMs = elapsedMs(Start);
+	std::cout << "  Build   : " << BuildMs << " ms (" << InstanceCount / BuildMs / 1000.0 << " M instances/sec), "
+		<< Bvh.getNodes().size() << " nodes of " << sizeof(BvhNode) << " bytes, SAH cost " << Bvh.getBuildCost()
+		<< "\n";
+
+	// Every instance drifts along its own random velocity, so boxes spread out of their original nodes
+	std::mt19937 Gen(static_cast<std::mt19937::result_type>(Seed));
+	std::uniform_real_distribution<float> UnitDist(-1.0f, 1.0f);
+	std::vector<glm::vec3> Velocities(InstanceCount);
+	for (glm::vec3& Velocity : Velocities)
+	{
+		Velocity = glm::vec3(UnitDist(Gen), UnitDist(Gen), UnitDist(Gen)) * 0.5f;
+	}
+	auto drift = [&]
+	{
+		for (unsigned int I = 0; I < InstanceCount; I++)
+		{
+			ModelMatrices[I][3] += glm::vec4(Velocities[I], 0.0f);
+			Instances.setTransform(Instances.getHandle(I), ModelMatrices[I]);
+		}
+	};
+
+	double RefitMs = 0.0;
+	int Steps = 0;
+	while (Steps < DriftSteps && !Bvh.needsRebuild())
+	{
+		drift();
+		Start = BenchmarkClock::now();
+		Bvh.refit(Instances, BoundsModel);
+		RefitMs += elapsedMs(Start);
+		Steps++;
+	}
+	std::cout << "  Refit   : " << RefitMs / Steps << " ms average over " << Steps << " drift steps, SAH cost "
+		<< Bvh.getCost() << " (" << Bvh.getCost() / Bvh.getBuildCost() << "x build)"
+		<< (Bvh.needsRebuild() ? ", rebuild due" : "") << "\n";
+
+	// Keep refitting the old tree while the replacement builds, as a frame loop would
+	Start = BenchmarkClock::now();
+	Bvh.rebuildAsync(Instances, BoundsModel);
+	int RefitsDuringRebuild = 0;
+	while (!Bvh.finishRebuild())
+	{
+		Bvh.refit(Instances, BoundsModel);
+		RefitsDuringRebuild++;
+	}
+	const double RebuildMs = elapsedMs(Start);
+	Bvh.refit(Instances, BoundsModel);
+	std::cout << "  Rebuild : " << RebuildMs << " ms on a worker thread, " << RefitsDuringRebuild
+		<< " refits meanwhile, SAH cost back to " << Bvh.getCost() << "\n";
+
+	std::vector<BvhBounds> Bounds;
+	InstanceBvh::computeBounds(Instances, BoundsModel, Bounds);
+	std::vector<std::uint32_t> Results;
+	std::vector<std::uint32_t> Expected;
+	std::uniform_real_distribution<float> FieldDist(-100.0f, 100.0f);
+	auto randomPoint = [&]
+	{
+		return glm::vec3(FieldDist(Gen), FieldDist(Gen), FieldDist(Gen));
+	};
+	auto randomDirection = [&]
+	{
+		glm::vec3 Direction;
+		do
+		{
+			Direction = glm::vec3(UnitDist(Gen), UnitDist(Gen), UnitDist(Gen));
+		}
+		while (dot(Direction, Direction) < 0.01f || dot(Direction, Direction) > 1.0f);
+		return normalize(Direction);
+	};
+
+	// Frustum queries with the app's projection from random points in the field
+	const glm::mat4 Projection = glm::perspective(glm::radians(45.0f), static_cast<float>(BenchmarkWidth) /
+	                                              static_cast<float>(BenchmarkHeight), 0.1f, 100.0f);
+	std::vector<glm::mat4> Views(FrustumQueries);
+	for (glm::mat4& View : Views)
+	{
+		const glm::vec3 Eye = randomPoint();
+		View = Projection * lookAt(Eye, Eye + randomDirection(), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+	std::size_t FrustumHits = 0;
+	Start = BenchmarkClock::now();
+	for (const glm::mat4& View : Views)
+	{
+		Results.clear();
+		Bvh.queryFrustum(View, Results);
+		FrustumHits += Results.size();
+	}
+	const double FrustumMs = elapsedMs(Start) / FrustumQueries;
+
+	bool FrustumMatches = true;
+	double FrustumScanMs = 0.0;
+	for (int Query = 0; Query < BruteForceQueries; Query++)
+	{
+		Results.clear();
+		Bvh.queryFrustum(Views[Query], Results);
+		Start = BenchmarkClock::now();
+		const glm::mat4 Transposed = transpose(Views[Query]);
+		const glm::vec4 Planes[6] = {
+			Transposed[3] + Transposed[0], Transposed[3] - Transposed[0],
+			Transposed[3] + Transposed[1], Transposed[3] - Transposed[1],
+			Transposed[3] + Transposed[2], Transposed[3] - Transposed[2]
+		};
+		Expected.clear();
+		for (std::uint32_t I = 0; I < InstanceCount; I++)
+		{
+			if (boxInFrustum(Planes, Bounds[I]))
+			{
+				Expected.push_back(I);
+			}
+		}
+		FrustumScanMs += elapsedMs(Start);
+		std::sort(Results.begin(), Results.end());
+		FrustumMatches &= Results == Expected;
+	}
+	FrustumScanMs /= BruteForceQueries;
+	std::cout << "  Frustum : " << FrustumMs << " ms/query, " << FrustumHits / FrustumQueries
+		<< " instances each, brute force " << FrustumScanMs << " ms (" << FrustumScanMs / FrustumMs << "x), "
+		<< (FrustumMatches ? "matches" : "MISMATCH") << "\n";
+
+	// Nearest box hit along random rays through the field
+	std::vector<std::pair<glm::vec3, glm::vec3>> Rays(RayQueries);
+	for (auto& [Origin, Direction] : Rays)
+	{
+		Origin = randomPoint();
+		Direction = randomDirection();
+	}
+	std::size_t RayHits = 0;
+	Start = BenchmarkClock::now();
+	for (const auto& [Origin, Direction] : Rays)
+	{
+		RayHits += Bvh.raycast(Origin, Direction, RayLength).Index != InstanceBvh::NoHit;
+	}
+	const double RayMs = elapsedMs(Start);
+
+	bool RaysMatch = true;
+	double RayScanMs = 0.0;
+	for (int Query = 0; Query < BruteForceQueries; Query++)
+	{
+		const auto& [Origin, Direction] = Rays[Query];
+		Start = BenchmarkClock::now();
+		const glm::vec3 InverseDirection = 1.0f / Direction;
+		float Nearest = RayLength;
+		for (std::uint32_t I = 0; I < InstanceCount; I++)
+		{
+			Nearest = std::min(Nearest, boxRayEntry(Origin, InverseDirection, Bounds[I]));
+		}
+		RayScanMs += elapsedMs(Start);
+		RaysMatch &= Bvh.raycast(Origin, Direction, RayLength).Distance == Nearest;
+	}
+	RayScanMs /= BruteForceQueries;
+	std::cout << "  Ray     : " << RayQueries / RayMs / 1000.0 << " M rays/sec, " << RayHits * 100 / RayQueries
+		<< "% hit within " << RayLength << ", brute force " << RayScanMs << " ms/ray ("
+		<< RayScanMs / (RayMs / RayQueries) << "x), " << (RaysMatch ? "matches" : "MISMATCH") << "\n";
+
+	// Instances near random points, radius about two mine diameters
+	std::vector<glm::vec3> Centers(SphereQueries);
+	for (glm::vec3& Center : Centers)
+	{
+		Center = randomPoint();
+	}
+	std::size_t SphereHits = 0;
+	Start = BenchmarkClock::now();
+	for (const glm::vec3& Center : Centers)
+	{
+		Results.clear();
+		Bvh.querySphere(Center, QueryRadius, Results);
+		SphereHits += Results.size();
+	}
+	const double SphereMs = elapsedMs(Start);
+
+	bool SpheresMatch = true;
+	double SphereScanMs = 0.0;
+	for (int Query = 0; Query < BruteForceQueries; Query++)
+	{
+		Results.clear();
+		Bvh.querySphere(Centers[Query], QueryRadius, Results);
+		Start = BenchmarkClock::now();
+		Expected.clear();
+		for (std::uint32_t I = 0; I < InstanceCount; I++)
+		{
+			const glm::vec3 Offset = Centers[Query] - glm::clamp(Centers[Query], Bounds[I].Min, Bounds[I].Max);
+			if (dot(Offset, Offset) <= QueryRadius * QueryRadius)
+			{
+				Expected.push_back(I);
+			}
+		}
+		SphereScanMs += elapsedMs(Start);
+		std::sort(Results.begin(), Results.end());
+		SpheresMatch &= Results == Expected;
+	}
+	SphereScanMs /= BruteForceQueries;
+	std::cout << "  Sphere  : " << SphereQueries / SphereMs / 1000.0 << " M queries/sec, "
+		<< static_cast<double>(SphereHits) / SphereQueries << " instances each, brute force " << SphereScanMs
+		<< " ms/query (" << SphereScanMs / (SphereMs / SphereQueries) << "x), "
+		<< (SpheresMatch ? "matches" : "MISMATCH") << "\n";
+}
+
+void Benchmark::instancePicking(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 100000;
+	constexpr int PickCount = 10000;
+	constexpr int BruteForcePicks = 20;
+
+	std::cout << "Instance picking (" << InstanceCount << " instances, seed " << Seed << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	// The impostor benchmark's wide field, so rays cross open space as well as clusters
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+
+	// The moving object where the renderer draws it at startup
+	glm::mat4 MovingObjectMatrix = scale(glm::mat4(1.0f), glm::vec3(0.001f));
+	MovingObjectMatrix = rotate(MovingObjectMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	InstancePicker Picker;
+	auto Start = BenchmarkClock::now();
+	Picker.setModels(Scene.LModel, Scene.MovingObjectModel);
+	const std::chrono::duration<double, std::milli> MeshMs = BenchmarkClock::now() - Start;
+	Start = BenchmarkClock::now();
+	Picker.update(Instances, Scene.LModel);
+	const std::chrono::duration<double, std::milli> BuildMs = BenchmarkClock::now() - Start;
+	Start = BenchmarkClock::now();
+	Picker.update(Instances, Scene.LModel);
+	const std::chrono::duration<double, std::micro> IdleUs = BenchmarkClock::now() - Start;
+	std::cout << "  Mesh BVHs : " << MeshMs.count() << " ms (" << Scene.LModel.PickIndices.size() / 3 << " + "
+		<< Scene.MovingObjectModel.PickIndices.size() / 3 << " triangles)\n";
+	std::cout << "  Instance BVH : " << BuildMs.count() << " ms to build, " << IdleUs.count()
+		<< " us per frame while nothing moves\n";
+
+	// Cursor positions spread over the window from the app's starting camera
+	Camera LCamera(20.0f, 1.0f);
+	std::mt19937 Gen(static_cast<std::mt19937::result_type>(Seed));
+	std::uniform_real_distribution<double> XDist(0.0, BenchmarkWidth);
+	std::uniform_real_distribution<double> YDist(0.0, BenchmarkHeight);
+	std::vector<std::pair<glm::vec3, glm::vec3>> Rays(PickCount);
+	for (auto& [Origin, Direction] : Rays)
+	{
+		LCamera.getCursorRay(XDist(Gen), YDist(Gen), BenchmarkWidth, BenchmarkHeight, Origin, Direction);
+	}
+
+	std::vector<PickHit> Hits(PickCount);
+	double TotalUs = 0.0;
+	double WorstUs = 0.0;
+	int InstanceHits = 0;
+	int MovingObjectHits = 0;
+	for (int Pick = 0; Pick < PickCount; Pick++)
+	{
+		Hits[Pick] = Picker.pick(Rays[Pick].first, Rays[Pick].second, MovingObjectMatrix);
+		TotalUs += Hits[Pick].Microseconds;
+		WorstUs = std::max(WorstUs, Hits[Pick].Microseconds);
+		InstanceHits += Hits[Pick].Target == PickTarget::Instance;
+		MovingObjectHits += Hits[Pick].Target == PickTarget::MovingObject;
+	}
+	std::cout << "  Pick : " << TotalUs / PickCount << " us average, " << WorstUs << " us worst over " << PickCount
+		<< " cursor positions (" << InstanceHits << " instances, " << MovingObjectHits << " moving object, "
+		<< PickCount - InstanceHits - MovingObjectHits << " empty)\n";
+
+	// Reference answers from every instance's mesh, no instance BVH involved
+	MeshRaycaster InstanceMesh;
+	InstanceMesh.build(Scene.LModel);
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	bool Matches = true;
+	double BruteForceMs = 0.0;
+	for (int Pick = 0; Pick < BruteForcePicks; Pick++)
+	{
+		const auto& [Origin, Direction] = Rays[Pick];
+		Start = BenchmarkClock::now();
+		std::uint32_t Nearest = InstanceBvh::NoHit;
+		float NearestDistance = 100.0f;
+		for (std::uint32_t I = 0; I < InstanceCount; I++)
+		{
+			const glm::mat4 Inverse = inverse(Transforms[I]);
+			const float Distance = InstanceMesh.raycast(glm::vec3(Inverse * glm::vec4(Origin, 1.0f)),
+			                                            glm::vec3(Inverse * glm::vec4(Direction, 0.0f)),
+			                                            NearestDistance);
+			if (Distance >= 0.0f && Distance < NearestDistance)
+			{
+				Nearest = I;
+				NearestDistance = Distance;
+			}
+		}
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		BruteForceMs += Elapsed.count();
+		if (Hits[Pick].Target != PickTarget::MovingObject)
+		{
+			Matches &= Hits[Pick].Instance == Nearest;
+		}
+	}
+	std::cout << "  Brute force : " << BruteForceMs / BruteForcePicks << " ms per pick, "
+		<< (Matches ? "same instances picked" : "MISMATCH") << "\n";
+
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
+
+void Benchmark::collisionBroadphase(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 100000;
+	constexpr int QueryFrames = 2000;
+	constexpr int MoveFrames = 100;
+	constexpr unsigned int MovedPerFrame = InstanceCount / 100;
+	constexpr int BruteForceFrames = 50;
+
+	std::cout << "Collision broadphase (" << InstanceCount << " instances, seed " << Seed << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -50.0f;
+	Settings.MaxDisplacement = 50.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+
+	auto elapsedMs = [](const BenchmarkClock::time_point Start)
+	{
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		return Elapsed.count();
+	};
+
+	CollisionGrid Grid;
+	auto Start = BenchmarkClock::now();
+	Grid.sync(Instances, Scene.LModel);
+	const double InsertMs = elapsedMs(Start);
+	Start = BenchmarkClock::now();
+	Grid.sync(Instances, Scene.LModel);
+	const double IdleMs = elapsedMs(Start);
+	std::cout << "  Initial sync : " << InsertMs << " ms, " << IdleMs * 1000.0 << " us per frame while nothing moves\n";
+
+	// The moving object flies a straight line through the middle of the field
+	glm::mat4 ShipRotation = scale(glm::mat4(1.0f), glm::vec3(0.001f));
+	ShipRotation = rotate(ShipRotation, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	auto shipBox = [&](const int Frame)
+	{
+		const float T = static_cast<float>(Frame) / QueryFrames;
+		const glm::vec3 Position = glm::mix(glm::vec3(-50.0f, 1.0f, -20.0f), glm::vec3(50.0f, -1.0f, 20.0f), T);
+		return InstanceBvh::transformBounds(Scene.MovingObjectModel.BoundsMin, Scene.MovingObjectModel.BoundsMax,
+		                                    translate(glm::mat4(1.0f), Position) * ShipRotation);
+	};
+
+	double QueryMs = 0.0;
+	double WorstQueryMs = 0.0;
+	unsigned long long Candidates = 0;
+	unsigned long long Contacts = 0;
+	unsigned long long Events = 0;
+	for (int Frame = 0; Frame < QueryFrames; Frame++)
+	{
+		Grid.collide(shipBox(Frame));
+		const CollisionStats& Stats = Grid.getStats();
+		QueryMs += Stats.QueryMilliseconds;
+		WorstQueryMs = std::max(WorstQueryMs, Stats.QueryMilliseconds);
+		Candidates += Stats.Candidates;
+		Contacts += Stats.Contacts;
+		Events += Grid.getEvents().size();
+	}
+	const BvhBounds FirstBox = shipBox(0);
+	std::cout << "  Query : " << QueryMs / QueryFrames * 1000.0 << " us average, " << WorstQueryMs * 1000.0
+		<< " us worst, " << static_cast<double>(Candidates) / QueryFrames << " candidates and "
+		<< static_cast<double>(Contacts) / QueryFrames << " contacts per frame, " << Events << " events (box "
+		<< FirstBox.Max.x - FirstBox.Min.x << " x " << FirstBox.Max.y - FirstBox.Min.y << " x "
+		<< FirstBox.Max.z - FirstBox.Min.z << ")\n";
+
+	// The same contacts from testing every instance's sphere
+	bool Matches = true;
+	double BruteForceMs = 0.0;
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	for (int Sample = 0; Sample < BruteForceFrames; Sample++)
+	{
+		const int Frame = Sample * QueryFrames / BruteForceFrames;
+		const BvhBounds Box = shipBox(Frame);
+		Start = BenchmarkClock::now();
+		std::vector<std::uint32_t> Expected;
+		for (unsigned int I = 0; I < InstanceCount; I++)
+		{
+			glm::vec3 Center;
+			float Radius;
+			CollisionGrid::transformSphere(Scene.LModel, Transforms[I], Center, Radius);
+			const glm::vec3 Offset = Center - clamp(Center, Box.Min, Box.Max);
+			if (dot(Offset, Offset) <= Radius * Radius)
+			{
+				Expected.push_back(Instances.getHandle(I).Slot);
+			}
+		}
+		BruteForceMs += elapsedMs(Start);
+		std::sort(Expected.begin(), Expected.end());
+
+		Grid.collide(Box);
+		std::vector<std::uint32_t> Found;
+		for (const Contact& Hit : Grid.getContacts())
+		{
+			Found.push_back(Hit.Instance.Slot);
+		}
+		Matches &= Found == Expected;
+	}
+	std::cout << "  Brute force : " << BruteForceMs / BruteForceFrames << " ms per frame, "
+		<< (Matches ? "same contacts" : "MISMATCH") << "\n";
+
+	// A slice of the field drifts each frame and is reported to the grid by handle
+	std::mt19937 Gen(static_cast<std::mt19937::result_type>(Seed));
+	std::uniform_int_distribution<unsigned int> IndexDist(0, InstanceCount - 1);
+	std::uniform_real_distribution<float> StepDist(-0.2f, 0.2f);
+	double MoveMs = 0.0;
+	for (int Frame = 0; Frame < MoveFrames; Frame++)
+	{
+		for (unsigned int I = 0; I < MovedPerFrame; I++)
+		{
+			const InstanceHandle Handle = Instances.getHandle(IndexDist(Gen));
+			glm::mat4 Transform = *Instances.getTransform(Handle);
+			Transform[3] += glm::vec4(StepDist(Gen), StepDist(Gen), StepDist(Gen), 0.0f);
+			Instances.setTransform(Handle, Transform);
+
+			Start = BenchmarkClock::now();
+			glm::vec3 Center;
+			float Radius;
+			CollisionGrid::transformSphere(Scene.LModel, Transform, Center, Radius);
+			Grid.move(Handle, Center, Radius);
+			MoveMs += elapsedMs(Start);
+		}
+	}
+	std::cout << "  Incremental moves : " << MoveMs / MoveFrames << " ms per frame for " << MovedPerFrame
+		<< " moved instances\n";
+
+	// Without move calls the grid finds the changes itself by rescanning the pool
+	Start = BenchmarkClock::now();
+	Grid.sync(Instances, Scene.LModel);
+	std::cout << "  Rescan sync : " << elapsedMs(Start) << " ms after the pool changed\n";
+
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
+
+// FNV-1a over the agents' positions and velocities
+static std::uint64_t hashAgents(const FlockAgents& Agents)
+{
+	std::uint64_t Hash = 14695981039346656037ull;
+	for (const std::vector<float>* Component : {&Agents.PositionX, &Agents.PositionY, &Agents.PositionZ,
+	                                            &Agents.VelocityX, &Agents.VelocityY, &Agents.VelocityZ})
+	{
+		const auto* Bytes = reinterpret_cast<const unsigned char*>(Component->data());
+		for (std::size_t I = 0; I < Component->size() * sizeof(float); I++)
+		{
+			Hash = (Hash ^ Bytes[I]) * 1099511628211ull;
+		}
+	}
+	return Hash;
+}
+
+void Benchmark::swarmSimulation(const std::uint64_t Seed)
+{
+	constexpr unsigned int AgentCount = 50000;
+	constexpr unsigned int ObstacleCount = 25000;
+	constexpr int WarmupSteps = 10;
+	constexpr int TimedSteps = 100;
+	constexpr int DeterminismSteps = 20;
+	constexpr int KernelRepeats = 50;
+	constexpr float DeltaTime = 1.0f / 60.0f;
+	constexpr double FrameBudgetMs = 1000.0 / 60.0;
+
+	// 25 times the agents of the default app run in 25 times the volume, so neighbour counts match
+	FlockSettings Settings;
+	Settings.Seed = Seed;
+	Settings.BoundsRadius *= std::cbrt(25.0f);
+
+	// Obstacles at the scatter positions of a field widened the same way, as spheres a mine across
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	Scatter.MinDisplacement *= std::cbrt(25.0f);
+	Scatter.MaxDisplacement *= std::cbrt(25.0f);
+	TransformStorage ObstacleTransforms;
+	InstanceScatter::generateParallel(Scatter, ObstacleCount, ObstacleTransforms);
+	std::vector<glm::vec4> Obstacles(ObstacleCount);
+	for (unsigned int I = 0; I < ObstacleCount; I++)
+	{
+		Obstacles[I] = glm::vec4(ObstacleTransforms.PositionX[I], ObstacleTransforms.PositionY[I],
+		                         ObstacleTransforms.PositionZ[I], 0.5f);
+	}
+
+	Parallel::setThreadCount(0);
+	const unsigned int ThreadCount = Parallel::getThreadCount();
+	std::cout << "Swarm simulation (" << AgentCount << " agents, " << ObstacleCount << " obstacles, seed " << Seed
+		<< ", " << ThreadCount << " threads)\n";
+
+	FlockSimulation Swarm(Settings);
+	Swarm.spawn(AgentCount);
+	Swarm.setObstacles(Obstacles);
+	for (int Step = 0; Step < WarmupSteps; Step++)
+	{
+		Swarm.step(DeltaTime);
+	}
+
+	FlockStats Total{};
+	double WorstMs = 0.0;
+	double Neighbours = 0.0;
+	for (int Step = 0; Step < TimedSteps; Step++)
+	{
+		const auto Start = BenchmarkClock::now();
+		Swarm.step(DeltaTime);
+		const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+		WorstMs = std::max(WorstMs, Elapsed.count());
+		const FlockStats& Stats = Swarm.getStats();
+		Total.HashMilliseconds += Stats.HashMilliseconds;
+		Total.SteerMilliseconds += Stats.SteerMilliseconds;
+		Total.IntegrateMilliseconds += Stats.IntegrateMilliseconds;
+		Total.TransformMilliseconds += Stats.TransformMilliseconds;
+		Neighbours += Stats.Neighbours;
+	}
+	const double StepMs = (Total.HashMilliseconds + Total.SteerMilliseconds + Total.IntegrateMilliseconds +
+		Total.TransformMilliseconds) / TimedSteps;
+	std::cout << "  Step : " << StepMs << " ms average, " << WorstMs << " ms worst (" << AgentCount / StepMs / 1000.0
+		<< " M agents/sec, " << Neighbours / TimedSteps << " neighbours each)\n";
+	std::cout << "    Hash rebuild : " << Total.HashMilliseconds / TimedSteps << " ms\n";
+	std::cout << "    Steering     : " << Total.SteerMilliseconds / TimedSteps << " ms\n";
+	std::cout << "    Integration  : " << Total.IntegrateMilliseconds / TimedSteps << " ms\n";
+	std::cout << "    Transforms   : " << Total.TransformMilliseconds / TimedSteps << " ms\n";
+	std::cout << "  60 Hz budget : " << (StepMs <= FrameBudgetMs ? "met" : "MISSED") << " on " << ThreadCount
+		<< " threads (" << StepMs / FrameBudgetMs * 100.0 << "% of " << FrameBudgetMs << " ms)\n";
+
+	// Every kernel on the same state, compared with the output of the reference, the scalar kernel, timed first
+	const FlockAgents Initial = Swarm.getAgents();
+	FlockAgents Reference = Initial;
+	auto timeKernel = [&](const char* Name, auto&& Kernel, const bool IsReference)
+	{
+		FlockAgents Agents = Initial;
+		double Best = 1.0e30;
+		for (int Run = 0; Run < KernelRepeats; Run++)
+		{
+			Agents = Initial;
+			const auto Start = BenchmarkClock::now();
+			Kernel(Agents, 0, Agents.size(), DeltaTime, Settings.MinSpeed, Settings.MaxSpeed);
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			Best = std::min(Best, Elapsed.count());
+		}
+		if (IsReference)
+		{
+			Reference = Agents;
+		}
+		float MaxError = 0.0f;
+		for (std::size_t I = 0; I < Agents.size(); I++)
+		{
+			MaxError = std::max({MaxError, std::abs(Agents.PositionX[I] - Reference.PositionX[I]),
+			                     std::abs(Agents.PositionY[I] - Reference.PositionY[I]),
+			                     std::abs(Agents.PositionZ[I] - Reference.PositionZ[I]),
+			                     std::abs(Agents.VelocityX[I] - Reference.VelocityX[I]),
+			                     std::abs(Agents.VelocityY[I] - Reference.VelocityY[I]),
+			                     std::abs(Agents.VelocityZ[I] - Reference.VelocityZ[I])});
+		}
+		std::cout << "  Integrate " << Name << " : " << Best * 1000.0 << " us (max error " << MaxError << ")\n";
+	};
+	timeKernel("scalar          ", FlockSimulation::integrateScalar, true);
+#if SIMD_X86
+	timeKernel("SSE (4 wide)    ", FlockSimulation::integrateSse, false);
+	if (Simd::hasAvx2())
+	{
+		timeKernel("AVX2 (8 wide)   ", FlockSimulation::integrateAvx2, false);
+	}
+#endif
+	std::cout << "  Runtime kernel : " << FlockSimulation::getKernelName() << "\n";
+
+	// The hash sorts each cell, so the same seed flies the same way on any number of threads
+	auto runFlock = [&](const unsigned int Threads)
+	{
+		Parallel::setThreadCount(Threads);
+		FlockSimulation Flock(Settings);
+		Flock.spawn(AgentCount);
+		Flock.setObstacles(Obstacles);
+		for (int Step = 0; Step < DeterminismSteps; Step++)
+		{
+			Flock.step(DeltaTime);
+		}
+		return hashAgents(Flock.getAgents());
+	};
+	const std::uint64_t SerialHash = runFlock(1);
+	const std::uint64_t ThreadedHash = runFlock(std::max(ThreadCount, 4u));
+	Parallel::setThreadCount(0);
+	std::cout << "  Deterministic across thread counts : " << (SerialHash == ThreadedHash ? "yes" : "NO") << "\n";
+}
+
+void Benchmark::instanceAnimation(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 100000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 20;
+	constexpr int PickCount = 20;
+	constexpr float PickTime = 3.7f;
+
+	std::cout << "Instance animation (" << InstanceCount << " instances, seed " << Seed << ", " << BenchmarkWidth
+		<< "x" << BenchmarkHeight << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	// The impostor benchmark's wide field, everything in it spinning and bobbing
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	TransformStorage Transforms;
+	InstanceScatter::generateParallel(Settings, InstanceCount, Transforms);
+	std::vector<glm::mat4> Bases(InstanceCount);
+	TransformComposer::composeParallel(Transforms, Bases.data());
+	std::vector<InstanceAnimation> Animations;
+	InstanceScatter::generateAnimations(Settings, 0, InstanceCount, Animations);
+
+	// The same motion two ways, a static pool the CPU rewrites every frame and a pool the GPU animates
+	InstancePool CpuInstances(InstanceCount);
+	InstancePool GpuInstances(InstanceCount);
+	for (unsigned int I = 0; I < InstanceCount; I++)
+	{
+		CpuInstances.spawn(Bases[I]);
+		GpuInstances.spawn(Bases[I], Animations[I]);
+	}
+
+	struct AnimationResult
+	{
+		double FrameMs;
+		double PoseMs;
+		double CullMs;
+		double UploadBytes;
+	};
+	auto measure = [&](const char* Name, InstancePool& Instances, const bool PoseOnCpu)
+	{
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		Instances.attachToVao(Scene.LModel.Vao, 3);
+		Instances.upload();
+		FrameSnapshot Snapshot;
+		AnimationResult Result{};
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const auto Start = BenchmarkClock::now();
+			const auto Time = static_cast<float>(glfwGetTime());
+			Snapshot.AnimationTime = Time;
+			LRenderer.setFrame(Snapshot);
+			if (PoseOnCpu)
+			{
+				for (unsigned int I = 0; I < InstanceCount; I++)
+				{
+					Instances.setTransform(Instances.getHandle(I),
+					                       InstanceAnimator::evaluate(Bases[I], Animations[I], Time));
+				}
+			}
+			const auto PoseEnd = BenchmarkClock::now();
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances);
+			glFinish();
+			if (Frame >= WarmupFrames)
+			{
+				const std::chrono::duration<double, std::milli> FrameElapsed = BenchmarkClock::now() - Start;
+				const std::chrono::duration<double, std::milli> PoseElapsed = PoseEnd - Start;
+				Result.FrameMs += FrameElapsed.count() / TimedFrames;
+				Result.PoseMs += PoseElapsed.count() / TimedFrames;
+				Result.CullMs += LRenderer.getStats().Culling.Milliseconds / TimedFrames;
+			}
+		}
+
+		// Bytes sent per frame, the pool when the CPU moved it plus the per frame instance stream
+		const RenderStats& Stats = LRenderer.getStats();
+		unsigned int Streamed = Stats.ImpostorInstances;
+		for (const unsigned int LevelCount : Stats.LodInstances)
+		{
+			Streamed += LevelCount;
+		}
+		Result.UploadBytes = Streamed * (sizeof(glm::mat4) + (PoseOnCpu ? 0 : sizeof(InstanceAnimation)));
+		if (PoseOnCpu)
+		{
+			Result.UploadBytes += static_cast<double>(InstanceCount) * (sizeof(glm::mat4) +
+				sizeof(InstanceAnimation));
+		}
+		std::cout << "  " << Name << " : " << Result.FrameMs << " ms/frame (" << Result.PoseMs << " ms posing, "
+			<< Result.CullMs << " ms culling), " << Result.UploadBytes / (1024.0 * 1024.0) << " MB uploaded, "
+			<< Stats.Instances << " visible\n";
+		Instances.releaseBuffer();
+		return Result;
+	};
+
+	const AnimationResult Cpu = measure("Posed on the CPU    ", CpuInstances, true);
+	const AnimationResult Gpu = measure("Posed in the shader ", GpuInstances, false);
+	std::cout << "  Saved per frame : " << Cpu.FrameMs - Gpu.FrameMs << " ms, "
+		<< (Cpu.UploadBytes - Gpu.UploadBytes) / (1024.0 * 1024.0) << " MB (" << Cpu.PoseMs
+		<< " ms of CPU posing removed)\n";
+
+	// Culling the posed field against the same field left static shows what re-posing costs the culler
+	InstancePool StaticInstances(InstanceCount);
+	for (unsigned int I = 0; I < InstanceCount; I++)
+	{
+		StaticInstances.spawn(Bases[I]);
+	}
+	const Camera LCamera(20.0f, 1.0f);
+	const glm::mat4 ViewProjection = LCamera.getProjectionMatrix(static_cast<float>(BenchmarkWidth) /
+		static_cast<float>(BenchmarkHeight)) * LCamera.getViewMatrix();
+	const float ProjectionScale = BenchmarkHeight / (2.0f * std::tan(LCamera.getFieldOfView() * 0.5f));
+	auto timeCull = [&](const InstancePool& Instances)
+	{
+		InstanceCuller Culler;
+		double Best = 1.0e30;
+		for (int Run = 0; Run < 5; Run++)
+		{
+			Culler.cull(Instances, Scene.LModel, ViewProjection, LCamera.getPosition(), ProjectionScale, {},
+			            PickTime);
+			Best = std::min(Best, Culler.getStats().Milliseconds);
+		}
+		return Best;
+	};
+	const double StaticCullMs = timeCull(StaticInstances);
+	const double AnimatedCullMs = timeCull(GpuInstances);
+	std::cout << "  Cull : " << StaticCullMs << " ms static, " << AnimatedCullMs << " ms posed at " << PickTime
+		<< " s\n";
+
+	// Picks at one moment checked against every instance's mesh posed at that moment, and against the
+	// unposed field to show the motion is what decides the hits
+	InstancePicker Picker;
+	Picker.setModels(Scene.LModel, Scene.MovingObjectModel);
+	Picker.update(GpuInstances, Scene.LModel);
+	MeshRaycaster InstanceMesh;
+	InstanceMesh.build(Scene.LModel);
+	std::mt19937 Gen(static_cast<std::mt19937::result_type>(Seed));
+	std::uniform_real_distribution<double> XDist(0.0, BenchmarkWidth);
+	std::uniform_real_distribution<double> YDist(0.0, BenchmarkHeight);
+	const glm::mat4 Offscreen = translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0e4f, 0.0f));
+	auto bruteForce = [&](const glm::vec3& Origin, const glm::vec3& Direction, const bool Posed)
+	{
+		std::uint32_t Nearest = InstanceBvh::NoHit;
+		float NearestDistance = 100.0f;
+		for (std::uint32_t I = 0; I < InstanceCount; I++)
+		{
+			const glm::mat4 Inverse = inverse(Posed ? GpuInstances.getAnimatedTransform(I, PickTime) : Bases[I]);
+			const float Distance = InstanceMesh.raycast(glm::vec3(Inverse * glm::vec4(Origin, 1.0f)),
+			                                            glm::vec3(Inverse * glm::vec4(Direction, 0.0f)),
+			                                            NearestDistance);
+			if (Distance >= 0.0f && Distance < NearestDistance)
+			{
+				Nearest = I;
+				NearestDistance = Distance;
+			}
+		}
+		return Nearest;
+	};
+	int Matches = 0;
+	int DifferFromStatic = 0;
+	double PickUs = 0.0;
+	for (int Pick = 0; Pick < PickCount; Pick++)
+	{
+		glm::vec3 Origin, Direction;
+		LCamera.getCursorRay(XDist(Gen), YDist(Gen), BenchmarkWidth, BenchmarkHeight, Origin, Direction);
+		const PickHit Hit = Picker.pick(Origin, Direction, Offscreen, PickTime);
+		PickUs += Hit.Microseconds;
+		Matches += Hit.Instance == bruteForce(Origin, Direction, true);
+		DifferFromStatic += Hit.Instance != bruteForce(Origin, Direction, false);
+	}
+	std::cout << "  Pick at " << PickTime << " s : " << PickUs / PickCount << " us average, " << Matches << " of "
+		<< PickCount << " match the posed meshes, " << DifferFromStatic << " differ from the unposed field\n";
+
+	closeScene(Scene);
+}
+
+void Benchmark::fixedTimestep(const std::uint64_t Seed)
+{
+	constexpr double Duration = 10.0;
+	constexpr float CameraSpeed = 1.0f;
+	constexpr float CameraRadius = 20.0f;
+	constexpr float OldFrameDelta = 0.005f; // What renderScene used to step the camera by every frame
+	const double FrameRates[] = {24.0, 60.0, 144.0, 1000.0};
+
+	std::cout << "Fixed timestep (" << Duration << " s of held camera rotation, " << FrameClock::DefaultStep * 1000.0
+		<< " ms steps, seed " << Seed << ")\n";
+
+	CameraInput Held{};
+	Held.RotateClockwise = true;
+	std::mt19937_64 Gen(Seed);
+	glm::vec3 Reference(0.0f);
+	bool First = true;
+	bool Matches = true;
+	for (const double FrameRate : FrameRates)
+	{
+		for (const bool Jittered : {false, true})
+		{
+			// Jittered frames vary from half to one and a half times the nominal frame time
+			std::uniform_real_distribution<double> Jitter(Jittered ? 0.5 : 1.0, Jittered ? 1.5 : 1.0);
+			Camera LCamera(CameraRadius, CameraSpeed);
+			FrameClock Clock;
+			Clock.beginFrame(0.0);
+			double Now = 0.0;
+			int Frames = 0;
+			int Steps = 0;
+			float WorstError = 0.0f;
+			// Runs stop half a step past the end, clear of the step boundary whatever rounding the frame times
+			// accumulated
+			const double EndTime = Duration + FrameClock::DefaultStep * 0.5;
+			while (Now < EndTime)
+			{
+				Now = std::min(Now + Jitter(Gen) / FrameRate, EndTime);
+				const int FrameSteps = Clock.beginFrame(Now);
+				for (int Step = 0; Step < FrameSteps; Step++)
+				{
+					LCamera.update(Clock.getStep(), Held);
+				}
+				LCamera.interpolate(Clock.getAlpha());
+				Steps += FrameSteps;
+				Frames++;
+
+				// The drawn camera should sit where constant rotation puts it at the frame's render time
+				const auto Angle = static_cast<float>(CameraSpeed * std::max(Clock.getRenderTime(), 0.0));
+				const glm::vec3 Expected(CameraRadius * std::cos(Angle), 0.0f, CameraRadius * std::sin(Angle));
+				WorstError = std::max(WorstError, length(LCamera.getPosition() - Expected));
+			}
+
+			LCamera.interpolate(1.0f);
+			const glm::vec3 Final = LCamera.getPosition();
+			if (First)
+			{
+				Reference = Final;
+				First = false;
+			}
+			Matches &= Final == Reference;
+			const float OldAngle = CameraSpeed * OldFrameDelta * static_cast<float>(Frames);
+			std::cout << "  " << std::setw(4) << FrameRate << " fps" << (Jittered ? " jittered" : "         ") << " : "
+				<< Frames
+				<< " frames, " << Steps << " steps, final angle " << std::atan2(Final.z, Final.x) << " rad (per frame "
+				<< "stepping: " << std::remainder(OldAngle, 6.2831853f) << " rad), worst drawn error " << WorstError
+				<< "\n";
+		}
+	}
+	std::cout << "  Same final state at every frame rate : " << (Matches ? "yes" : "NO") << "\n";
+}
+
+static std::uint64_t hashSnapshot(const FrameSnapshot& Snapshot)
+{
+	std::uint64_t Hash = 14695981039346656037ull;
+	auto mixBytes = [&Hash](const void* Data, const std::size_t Size)
+	{
+		const auto* Bytes = static_cast<const unsigned char*>(Data);
+		for (std::size_t I = 0; I < Size; I++)
+		{
+			Hash = (Hash ^ Bytes[I]) * 1099511628211ull;
+		}
+	};
+	mixBytes(&Snapshot.ObjectPosition, sizeof(glm::vec3));
+	const glm::mat4 View = Snapshot.Viewpoint.getViewMatrix();
+	mixBytes(&View, sizeof(glm::mat4));
+	mixBytes(Snapshot.SwarmTransforms.data(), Snapshot.SwarmTransforms.size() * sizeof(glm::mat4));
+	return Hash;
+}
+
+void Benchmark::simulationPipeline(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr unsigned int AgentCount = 20000;
+	constexpr int WarmupFrames = 5;
+	constexpr int TimedFrames = 60;
+	const float Spread = std::cbrt(20.0f); // 20 times the default app's instances and ships in 20 times the volume
+
+	std::cout << "Simulation pipeline (" << InstanceCount << " instances, " << AgentCount << " ships, seed " << Seed
+		<< ", " << std::thread::hardware_concurrency() << " hardware threads)\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	Scatter.MinDisplacement *= Spread;
+	Scatter.MaxDisplacement *= Spread;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Scatter, InstanceCount, Scene.LModel, Instances);
+
+	// Held input that exercises every part of the step, the object flying into the field
+	SimulationInput Input{};
+	Input.Camera.RotateClockwise = true;
+	Input.Object = glm::vec3(0.0f, 0.0f, -1.0f);
+	Input.CollisionEnabled = true;
+	Input.SwarmRunning = true;
+
+	PipelineStats Results[2]{};
+	std::uint64_t Hashes[2]{};
+	for (const bool Threaded : {false, true})
+	{
+		FlockSettings Settings;
+		Settings.Seed = Seed;
+		Settings.BoundsRadius *= Spread;
+		FlockSimulation Swarm(Settings);
+		Swarm.spawn(AgentCount);
+		Swarm.setObstacles(Instances, Scene.LModel);
+
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setSwarmModel(Scene.MovingObjectModel);
+		Simulation World;
+		World.setInstances(Instances, Scene.LModel);
+		World.setMovingObject(Scene.MovingObjectModel);
+		World.setSwarm(Swarm);
+		SimulationThread Pipeline(World, Threaded);
+
+		// Frames are a fixed step apart on a made up clock, so both runs simulate exactly the same steps
+		PipelineStats& Average = Results[Threaded ? 1 : 0];
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const FrameSnapshot& Snapshot = Pipeline.acquire();
+			Pipeline.submit(Input, Frame * FrameClock::DefaultStep);
+			LRenderer.setFrame(Snapshot, Pipeline.getStats());
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances);
+			LRenderer.renderMovingObject(Scene.ShaderProgram, Scene.MovingObjectModel);
+			LRenderer.renderSwarm(Scene.ShaderProgram);
+			glFinish();
+
+			// Each frame's stats describe the one before it, which is warm from the first timed frame on
+			if (Frame >= WarmupFrames)
+			{
+				const PipelineStats& Stats = Pipeline.getStats();
+				Average.SimulationMilliseconds += Stats.SimulationMilliseconds / TimedFrames;
+				Average.RenderMilliseconds += Stats.RenderMilliseconds / TimedFrames;
+				Average.WaitMilliseconds += Stats.WaitMilliseconds / TimedFrames;
+				Average.FrameMilliseconds += Stats.FrameMilliseconds / TimedFrames;
+			}
+		}
+		Hashes[Threaded ? 1 : 0] = hashSnapshot(Pipeline.acquire());
+
+		std::cout << "  " << (Threaded ? "Threaded" : "Serial  ") << " : simulation " << Average.SimulationMilliseconds
+			<< " ms, render " << Average.RenderMilliseconds << " ms, waited " << Average.WaitMilliseconds
+			<< " ms, frame " << Average.FrameMilliseconds << " ms\n";
+	}
+
+	const double Sum = Results[1].SimulationMilliseconds + Results[1].RenderMilliseconds;
+	const double Max = std::max(Results[1].SimulationMilliseconds, Results[1].RenderMilliseconds);
+	std::cout << "  Threaded frame against sum of stages " << Sum << " ms and larger stage " << Max << " ms, "
+		<< Results[0].FrameMilliseconds / Results[1].FrameMilliseconds << "x the serial frame rate\n";
+	std::cout << "  Same final state threaded and serial : " << (Hashes[0] == Hashes[1] ? "yes" : "NO") << "\n";
+
+	closeScene(Scene);
+}
+
+void Benchmark::jobSystem()
+{
+	constexpr int EmptyJobs = 100000;
+	constexpr int BatchSize = 1000; // Well inside a deque so none of them run inline
+	constexpr int SpawnCount = 2000;
+	constexpr int LoopCalls = 2000;
+	constexpr std::size_t LoopCount = 65536;
+	constexpr std::size_t CoverageCount = 1000003; // Prime so no split lands on a round number
+	constexpr int ChainLength = 1000;
+	constexpr std::size_t ComputeCount = 1 << 21;
+	constexpr int ComputeRepeats = 3;
+
+	JobSystem::start(0);
+	const unsigned int CoreCount = JobSystem::getThreadCount();
+	std::cout << "Job system (" << CoreCount << " threads, " << JobSystem::DequeCapacity << " jobs per deque)\n";
+
+	// Scheduling overhead, empty jobs through submit and wait against a thread spawned and joined per task
+	JobSystem::resetStats();
+	auto Empty = [] {};
+	auto Start = BenchmarkClock::now();
+	for (int Batch = 0; Batch < EmptyJobs / BatchSize; Batch++)
+	{
+		JobCounter Counter;
+		for (int I = 0; I < BatchSize; I++)
+		{
+			JobSystem::submit(Counter, Empty);
+		}
+		JobSystem::wait(Counter);
+	}
+	std::chrono::duration<double, std::nano> Elapsed = BenchmarkClock::now() - Start;
+	const double JobNs = Elapsed.count() / EmptyJobs;
+	const JobSystemStats Stats = JobSystem::getStats();
+
+	Start = BenchmarkClock::now();
+	for (int I = 0; I < SpawnCount; I++)
+	{
+		std::thread Worker(Empty);
+		Worker.join();
+	}
+	Elapsed = BenchmarkClock::now() - Start;
+	const double SpawnNs = Elapsed.count() / SpawnCount;
+
+	std::cout << "  Empty job      : " << JobNs << " ns submit to done (" << Stats.Executed << " run, " << Stats.Stolen
+		<< " stolen over " << Stats.StealAttempts << " attempts, " << Stats.Inline << " inline)\n";
+	std::cout << "  Thread per task: " << SpawnNs << " ns (" << SpawnNs / JobNs << "x a job)\n";
+
+	// A loop with nothing in it is all splitting and waiting
+	Start = BenchmarkClock::now();
+	for (int Call = 0; Call < LoopCalls; Call++)
+	{
+		JobSystem::parallelFor(LoopCount, 1024, [](std::size_t, std::size_t) {});
+	}
+	Elapsed = BenchmarkClock::now() - Start;
+	std::cout << "  Empty loop     : " << Elapsed.count() / LoopCalls / 1000.0 << " us per parallelFor of " << LoopCount
+		<< " at grain 1024\n";
+
+	// Every index visited exactly once, with loops nested inside the jobs
+	std::vector<std::atomic<std::uint8_t>> Visits(CoverageCount);
+	std::atomic<std::size_t> NestedCalls{0};
+	JobSystem::parallelFor(CoverageCount, 97, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			Visits[I].fetch_add(1, std::memory_order_relaxed);
+		}
+		JobSystem::parallelFor(8, 1, [&](std::size_t, std::size_t)
+		{
+			NestedCalls.fetch_add(1, std::memory_order_relaxed);
+		});
+	});
+	const bool Covered = std::all_of(Visits.begin(), Visits.end(), [](const std::atomic<std::uint8_t>& Count)
+	{
+		return Count.load(std::memory_order_relaxed) == 1;
+	});
+	std::cout << "  Loop coverage  : " << (Covered ? "every index once" : "WRONG") << " over " << CoverageCount
+		<< " (" << NestedCalls.load() << " nested loop bodies)\n";
+
+	// Each job runs after the one before it, wherever it is picked up
+	std::vector<int> Order;
+	Order.reserve(ChainLength);
+	std::vector<JobCounter> Chain(ChainLength);
+	std::vector<std::function<void()>> Links(ChainLength);
+	for (int I = 0; I < ChainLength; I++)
+	{
+		Links[I] = [&Order, I] { Order.push_back(I); };
+		JobSystem::submit(Chain[I], Links[I], I > 0 ? &Chain[I - 1] : nullptr);
+	}
+	JobSystem::wait(Chain.back());
+	bool InOrder = Order.size() == ChainLength;
+	for (int I = 0; InOrder && I < ChainLength; I++)
+	{
+		InOrder = Order[I] == I;
+	}
+	std::cout << "  Dependencies   : " << ChainLength << " chained jobs " << (InOrder ? "ran in order" : "OUT OF ORDER")
+		<< "\n";
+
+	// Compute bound scaling, the same work on more threads each time
+	std::vector<float> Results(ComputeCount);
+	auto compute = [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			float Value = static_cast<float>(I) * 1.0e-3f;
+			for (int Iteration = 0; Iteration < 32; Iteration++)
+			{
+				Value = std::sqrt(Value * Value + 1.0f) * 0.999f;
+			}
+			Results[I] = Value;
+		}
+	};
+	std::vector<unsigned int> ThreadCounts;
+	for (unsigned int Threads = 1; Threads < CoreCount; Threads *= 2)
+	{
+		ThreadCounts.push_back(Threads);
+	}
+	ThreadCounts.push_back(CoreCount);
+
+	double SingleMs = 0.0;
+	double SingleSum = 0.0;
+	bool SameResults = true;
+	for (const unsigned int Threads : ThreadCounts)
+	{
+		JobSystem::start(Threads);
+		double Best = 1.0e30;
+		for (int Repeat = 0; Repeat < ComputeRepeats; Repeat++)
+		{
+			Start = BenchmarkClock::now();
+			JobSystem::parallelFor(ComputeCount, 4096, compute);
+			const std::chrono::duration<double, std::milli> Taken = BenchmarkClock::now() - Start;
+			Best = std::min(Best, Taken.count());
+		}
+		double Sum = 0.0;
+		for (const float Value : Results)
+		{
+			Sum += Value;
+		}
+		if (Threads == 1)
+		{
+			SingleMs = Best;
+			SingleSum = Sum;
+		}
+		SameResults = SameResults && Sum == SingleSum;
+		std::cout << "  " << std::setw(3) << Threads << " threads    : " << Best << " ms (" << SingleMs / Best
+			<< "x, " << SingleMs / Best / Threads * 100.0 << "% efficiency)\n";
+	}
+	JobSystem::start(0);
+	std::cout << "  Same results on every thread count : " << (SameResults ? "yes" : "NO") << "\n";
+}
+
+void Benchmark::frameGraph(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr unsigned int AgentCount = 20000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 20;
+	const float Spread = std::cbrt(20.0f); // As the pipeline benchmark
+
+	std::cout << "Frame graph (" << InstanceCount << " instances, " << AgentCount << " ships, seed " << Seed << ", "
+		<< JobSystem::getThreadCount() << " threads)\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	Scatter.MinDisplacement *= Spread;
+	Scatter.MaxDisplacement *= Spread;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Scatter, InstanceCount, Scene.LModel, Instances);
+
+	SimulationInput Input{};
+	Input.Camera.RotateClockwise = true;
+	Input.Object = glm::vec3(0.0f, 0.0f, -1.0f);
+	Input.CollisionEnabled = true;
+	Input.SwarmRunning = true;
+
+	double FrameMs[2]{};
+	std::uint64_t Hashes[2]{};
+	for (const bool Threaded : {false, true})
+	{
+		FlockSettings Settings;
+		Settings.Seed = Seed;
+		Settings.BoundsRadius *= Spread;
+		FlockSimulation Swarm(Settings);
+		Swarm.spawn(AgentCount);
+		Swarm.setObstacles(Instances, Scene.LModel);
+
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setSwarmModel(Scene.MovingObjectModel);
+		Simulation World;
+		World.setInstances(Instances, Scene.LModel);
+		World.setMovingObject(Scene.MovingObjectModel);
+		World.setSwarm(Swarm);
+
+		// The same graph main.cpp runs, less input and presenting
+		FrameSnapshot Snapshots[2];
+		PreparedScene Prepared[2];
+		int Drawing = 0;
+		int Frame = 0;
+		World.capture(1.0f, 0.0f, Snapshots[Drawing]);
+		LRenderer.prepareScene(Snapshots[Drawing], Scene.LModel, Instances, Prepared[Drawing]);
+
+		RenderQueue Queue;
+		const BucketId SceneBucket = Queue.addBucket("scene");
+		CommandBuffer SceneCommands;
+		CommandBuffer ObjectCommands;
+		CommandBuffer SwarmCommands;
+		FrameGraph Graph;
+		Graph.setThreaded(Threaded);
+		const TaskId Simulate = Graph.addTask("simulate", [&]
+		{
+			World.runFrame(Input, Frame * FrameClock::DefaultStep, Snapshots[1 - Drawing]);
+		});
+		Graph.addTask("cull", [&]
+		{
+			LRenderer.prepareScene(Snapshots[1 - Drawing], Scene.LModel, Instances, Prepared[1 - Drawing]);
+		}, {Simulate});
+		const TaskId Begin = Graph.addTask("begin", [&]
+		{
+			LRenderer.setFrame(Snapshots[Drawing]);
+			LRenderer.beginScene(Scene.LModel, Instances, Prepared[Drawing]);
+		}, {}, TaskAffinity::MainThread);
+		const TaskId RecordScene = Graph.addTask("record scene", [&]
+		{
+			SceneCommands.begin();
+			LRenderer.recordScene(SceneCommands, Scene.ShaderProgram, Scene.LModel, Instances, Prepared[Drawing]);
+			SceneCommands.end();
+		}, {Begin});
+		const TaskId RecordObject = Graph.addTask("record object", [&]
+		{
+			ObjectCommands.begin();
+			LRenderer.recordMovingObject(ObjectCommands, Scene.ShaderProgram, Scene.MovingObjectModel);
+			ObjectCommands.end();
+		}, {Begin});
+		const TaskId RecordSwarm = Graph.addTask("record swarm", [&]
+		{
+			SwarmCommands.begin();
+			LRenderer.recordSwarm(SwarmCommands, Scene.ShaderProgram);
+			SwarmCommands.end();
+		}, {Begin});
+		Graph.addTask("submit", [&]
+		{
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			Queue.clear();
+			LRenderer.execute(Queue, SceneBucket, SceneCommands);
+			LRenderer.execute(Queue, SceneBucket, ObjectCommands);
+			LRenderer.execute(Queue, SceneBucket, SwarmCommands);
+			LRenderer.submit(Queue);
+			glFinish();
+		}, {Begin, RecordScene, RecordObject, RecordSwarm}, TaskAffinity::MainThread);
+
+		std::vector<double> TaskMs(Graph.getTasks().size(), 0.0);
+		double CriticalMs = 0.0;
+		double IdleMs = 0.0;
+		for (; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			Graph.run();
+			Drawing = 1 - Drawing;
+			if (Frame >= WarmupFrames)
+			{
+				FrameMs[Threaded ? 1 : 0] += Graph.getFrameMilliseconds() / TimedFrames;
+				CriticalMs += Graph.getCriticalPathMilliseconds() / TimedFrames;
+				IdleMs += Graph.getIdleMilliseconds() / TimedFrames;
+				for (std::size_t Task = 0; Task < TaskMs.size(); Task++)
+				{
+					TaskMs[Task] += Graph.getTask(Task).Milliseconds / TimedFrames;
+				}
+			}
+		}
+		Hashes[Threaded ? 1 : 0] = hashSnapshot(Snapshots[Drawing]);
+
+		std::cout << "  " << (Threaded ? "Threaded" : "Serial  ") << " : frame " << FrameMs[Threaded ? 1 : 0]
+			<< " ms, critical path " << CriticalMs << " ms, caller idle " << IdleMs << " ms\n";
+		for (std::size_t Task = 0; Task < TaskMs.size(); Task++)
+		{
+			std::cout << "    " << std::left << std::setw(14) << Graph.getTask(Task).Name << std::right << ": "
+				<< TaskMs[Task] << " ms\n";
+		}
+		if (Threaded)
+		{
+			std::cout << "  Last frame:\n";
+			Graph.printTasks(std::cout);
+			Graph.printCriticalPath(std::cout);
+		}
+	}
+
+	std::cout << "  Threaded " << FrameMs[0] / FrameMs[1] << "x the serial frame rate\n";
+	std::cout << "  Same final state threaded and serial : " << (Hashes[0] == Hashes[1] ? "yes" : "NO") << "\n";
+
+	closeScene(Scene);
+}
+
+void Benchmark::renderQueue(const std::uint64_t Seed)
+{
+	constexpr unsigned int PacketCount = 100000;
+	constexpr int ProgramCount = 4;
+	constexpr int TextureCount = 16;
+	constexpr int VaoCount = 16;
+	constexpr int WarmupFrames = 1;
+	constexpr int TimedFrames = 5;
+
+	std::cout << "Render queue (" << PacketCount << " packets over " << ProgramCount << " programs, " << TextureCount
+		<< " textures and " << VaoCount << " VAOs, seed " << Seed << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	// Every packet is one degenerate triangle from a VAO with no attributes, so the frame is all submission
+	std::vector<GLuint> Programs;
+	for (int I = 0; I < ProgramCount; I++)
+	{
+		Programs.push_back(ShaderLoader::createProgram("resources/shaders/VertexShader.vert",
+		                                               "resources/shaders/FragmentShader.frag"));
+	}
+	std::vector<GLuint> Textures(TextureCount);
+	glCreateTextures(GL_TEXTURE_2D, TextureCount, Textures.data());
+	for (int I = 0; I < TextureCount; I++)
+	{
+		const std::vector<std::uint32_t> Texels(16, 0xff000000u | static_cast<std::uint32_t>(I * 0x0f0f0f));
+		glTextureStorage2D(Textures[I], 1, GL_RGBA8, 4, 4);
+		glTextureSubImage2D(Textures[I], 0, 0, 0, 4, 4, GL_RGBA, GL_UNSIGNED_BYTE, Texels.data());
+		glTextureParameteri(Textures[I], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	}
+	std::vector<GLuint> Vaos(VaoCount);
+	glCreateVertexArrays(VaoCount, Vaos.data());
+
+	// One uniform set per program and texture pairing, the way materials would have them
+	struct BenchmarkPacket
+	{
+		int Program;
+		int Texture;
+		int Vao;
+		float Depth;
+	};
+	std::mt19937 Gen(static_cast<std::mt19937::result_type>(Seed));
+	std::uniform_int_distribution<int> ProgramDist(0, ProgramCount - 1);
+	std::uniform_int_distribution<int> TextureDist(0, TextureCount - 1);
+	std::uniform_int_distribution<int> VaoDist(0, VaoCount - 1);
+	std::uniform_real_distribution<float> DepthDist(0.0f, 1.0f);
+	std::vector<BenchmarkPacket> Packets(PacketCount);
+	for (BenchmarkPacket& Packet : Packets)
+	{
+		Packet = {ProgramDist(Gen), TextureDist(Gen), VaoDist(Gen), DepthDist(Gen)};
+	}
+
+	RenderQueue Queue;
+	const BucketId Bucket = Queue.addBucket("benchmark");
+	auto fillQueue = [&]
+	{
+		Queue.clear();
+		for (int Program = 0; Program < ProgramCount; Program++)
+		{
+			for (int Texture = 0; Texture < TextureCount; Texture++)
+			{
+				const float Time = static_cast<float>(Program * TextureCount + Texture);
+				Queue.addUniforms([Time](const GLuint Target)
+				{
+					glUniformMatrix4fv(glGetUniformLocation(Target, "mvp"), 1, GL_FALSE,
+					                   value_ptr(glm::mat4(1.0f)));
+					glUniform1f(glGetUniformLocation(Target, "time"), Time);
+				});
+			}
+		}
+		for (const BenchmarkPacket& Packet : Packets)
+		{
+			const GLuint Program = Programs[Packet.Program];
+			const GLuint Texture = Textures[Packet.Texture];
+			const GLuint Vao = Vaos[Packet.Vao];
+			const auto Uniforms = static_cast<std::uint32_t>(Packet.Program * TextureCount + Packet.Texture);
+			Queue.push(Bucket, RenderQueue::makeKey(RenderPass::Opaque, Program, Texture, Vao, Packet.Depth),
+			           {Program, Texture, Vao, 0, 0, GL_TRIANGLES, false, 3, 0, 0, 0, Uniforms});
+		}
+	};
+
+	for (const bool Sorted : {false, true})
+	{
+		double PushMs = 0.0;
+		double FrameMs = 0.0;
+		RenderQueueStats Stats{};
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const auto Start = BenchmarkClock::now();
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			fillQueue();
+			const std::chrono::duration<double, std::milli> Pushed = BenchmarkClock::now() - Start;
+			if (Sorted)
+			{
+				Queue.sort();
+			}
+			Queue.submit();
+			glFinish();
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			if (Frame >= WarmupFrames)
+			{
+				PushMs += Pushed.count() / TimedFrames;
+				FrameMs += Elapsed.count() / TimedFrames;
+				Stats.SortMilliseconds += Queue.getStats().SortMilliseconds / TimedFrames;
+				Stats.SubmitMilliseconds += Queue.getStats().SubmitMilliseconds / TimedFrames;
+			}
+		}
+		const RenderQueueStats& Last = Queue.getStats();
+		std::cout << "  " << (Sorted ? "Sorted  " : "Unsorted") << " : push " << PushMs << " ms, sort "
+			<< Stats.SortMilliseconds << " ms, submit " << Stats.SubmitMilliseconds << " ms, frame with GPU "
+			<< FrameMs << " ms\n";
+		std::cout << "    " << Last.Draws << " draws, " << Last.StateChanges << " state changes (" << Last.ProgramBinds
+			<< " programs, " << Last.TextureBinds << " textures, " << Last.VaoBinds << " VAOs, " << Last.UniformSets
+			<< " uniform sets)\n";
+	}
+
+	// The radix sort against std::stable_sort on the same keys, which must agree on order as both are stable
+	fillQueue();
+	std::vector<RenderQueue::Entry> Expected = Queue.getEntries(Bucket);
+	auto Start = BenchmarkClock::now();
+	std::stable_sort(Expected.begin(), Expected.end(),
+	                 [](const RenderQueue::Entry& A, const RenderQueue::Entry& B) { return A.Key < B.Key; });
+	const std::chrono::duration<double, std::milli> StableMs = BenchmarkClock::now() - Start;
+	std::vector<RenderQueue::Entry> Entries = Queue.getEntries(Bucket);
+	std::vector<RenderQueue::Entry> Scratch;
+	Start = BenchmarkClock::now();
+	RenderQueue::radixSort(Entries, Scratch);
+	const std::chrono::duration<double, std::milli> RadixMs = BenchmarkClock::now() - Start;
+	bool SameOrder = Entries.size() == Expected.size();
+	for (std::size_t I = 0; SameOrder && I < Entries.size(); I++)
+	{
+		SameOrder = Entries[I].Key == Expected[I].Key && Entries[I].Packet == Expected[I].Packet;
+	}
+	std::cout << "  Radix sort " << RadixMs.count() << " ms against std::stable_sort " << StableMs.count()
+		<< " ms, same order : " << (SameOrder ? "yes" : "NO") << "\n";
+
+	GlState::deleteVertexArrays(VaoCount, Vaos.data());
+	GlState::deleteTextures(TextureCount, Textures.data());
+	for (const GLuint Program : Programs)
+	{
+		glDeleteProgram(Program);
+	}
+	closeScene(Scene);
+}
+
+void Benchmark::stateFiltering(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr int ViewCount = 8; // Separate submissions a frame, the way shadow cascades or split views would make
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 20;
+
+	std::cout << "GL state filtering (" << InstanceCount << " instances, " << ViewCount << " views, seed " << Seed
+		<< ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ImpostorAtlas Atlas = ImpostorBaker::bake(Scene.LModel, Scene.ShaderProgram);
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+
+	constexpr const char* CallNames[] = {
+		"programs", "VAOs", "textures", "buffers", "enables", "blend funcs", "depth funcs", "depth masks",
+		"cull faces", "polygon modes"
+	};
+	std::uint64_t Hashes[2]{};
+	double SubmitMs[2]{};
+	for (const bool Filtering : {false, true})
+	{
+		GlState::setFilteringEnabled(Filtering);
+		GlState::invalidate();
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setImpostors(Atlas, Scene.ImpostorProgram);
+		const FrameSnapshot Snapshot;
+		LRenderer.setFrame(Snapshot);
+		PreparedScene Prepared;
+		LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared);
+
+		double FrameMs = 0.0;
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			GlState::resetStats();
+			const auto Start = BenchmarkClock::now();
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			for (int View = 0; View < ViewCount; View++)
+			{
+				// Each a submission of its own, so what one leaves bound is what the next starts with
+				GlState::polygonMode(GL_FILL);
+				GlState::setEnabled(GL_DEPTH_TEST, true);
+				GlState::setEnabled(GL_CULL_FACE, true);
+				LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances, Prepared);
+				LRenderer.renderMovingObject(Scene.ShaderProgram, Scene.MovingObjectModel);
+			}
+			const std::chrono::duration<double, std::milli> Submitted = BenchmarkClock::now() - Start;
+			glFinish();
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			if (Frame >= WarmupFrames)
+			{
+				SubmitMs[Filtering ? 1 : 0] += Submitted.count() / TimedFrames;
+				FrameMs += Elapsed.count() / TimedFrames;
+			}
+		}
+
+		std::vector<std::uint8_t> Pixels(static_cast<std::size_t>(BenchmarkWidth) * BenchmarkHeight * 4);
+		glReadPixels(0, 0, BenchmarkWidth, BenchmarkHeight, GL_RGBA, GL_UNSIGNED_BYTE, Pixels.data());
+		std::uint64_t Hash = 1469598103934665603ull;
+		for (const std::uint8_t Byte : Pixels)
+		{
+			Hash = (Hash ^ Byte) * 1099511628211ull;
+		}
+		Hashes[Filtering ? 1 : 0] = Hash;
+
+		const GlStateStats& Stats = GlState::getStats();
+		std::cout << "  " << (Filtering ? "Filtered  " : "Unfiltered") << " : submit " << SubmitMs[Filtering ? 1 : 0]
+			<< " ms, frame with GPU " << FrameMs << " ms, " << Stats.TotalIssued << " calls issued, "
+			<< Stats.TotalFiltered << " filtered\n";
+		for (int Call = 0; Call < static_cast<int>(GlStateCall::Count); Call++)
+		{
+			if (Stats.Issued[Call] + Stats.Filtered[Call] > 0)
+			{
+				std::cout << "    " << std::left << std::setw(13) << CallNames[Call] << std::right << ": "
+					<< Stats.Issued[Call] << " issued, " << Stats.Filtered[Call] << " filtered\n";
+			}
+		}
+	}
+	GlState::setFilteringEnabled(true);
+
+	std::cout << "  Filtered submission " << SubmitMs[0] / SubmitMs[1] << "x as fast\n";
+	std::cout << "  Same image filtered and unfiltered : " << (Hashes[0] == Hashes[1] ? "yes" : "NO") << "\n";
+
+	Instances.releaseBuffer();
+	ImpostorBaker::release(Atlas);
+	closeScene(Scene);
+}
+
+void Benchmark::commandRecording(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr unsigned int AgentCount = 20000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 20;
+	const float Spread = std::cbrt(20.0f); // As the pipeline benchmark
+
+	std::cout << "Command recording (" << InstanceCount << " instances, " << AgentCount << " ships, seed " << Seed
+		<< ", " << JobSystem::getThreadCount() << " threads)\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ImpostorAtlas Atlas = ImpostorBaker::bake(Scene.LModel, Scene.ShaderProgram);
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	Scatter.MinDisplacement *= Spread;
+	Scatter.MaxDisplacement *= Spread;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Scatter, InstanceCount, Scene.LModel, Instances);
+
+	FlockSettings Settings;
+	Settings.Seed = Seed;
+	Settings.BoundsRadius *= Spread;
+	FlockSimulation Swarm(Settings);
+	Swarm.spawn(AgentCount);
+	Swarm.setObstacles(Instances, Scene.LModel);
+
+	SimulationInput Input{};
+	Input.Object = glm::vec3(0.0f, 0.0f, -1.0f);
+	Input.SwarmRunning = true;
+	Simulation World;
+	World.setInstances(Instances, Scene.LModel);
+	World.setMovingObject(Scene.MovingObjectModel);
+	World.setSwarm(Swarm);
+	FrameSnapshot Snapshot;
+	for (int Frame = 0; Frame < 2; Frame++)
+	{
+		World.runFrame(Input, Frame * FrameClock::DefaultStep, Snapshot);
+	}
+
+	std::uint64_t Hashes[2]{};
+	double FrameMs[2]{};
+	for (const bool Parallel : {false, true})
+	{
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setImpostors(Atlas, Scene.ImpostorProgram);
+		LRenderer.setSwarmModel(Scene.MovingObjectModel);
+		LRenderer.setFrame(Snapshot);
+		PreparedScene Prepared;
+		LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared);
+
+		RenderQueue Queue;
+		const BucketId SceneBucket = Queue.addBucket("scene");
+		CommandBuffer Buffers[3];
+		auto recordScene = [&]
+		{
+			Buffers[0].begin();
+			LRenderer.recordScene(Buffers[0], Scene.ShaderProgram, Scene.LModel, Instances, Prepared);
+			Buffers[0].end();
+		};
+		auto recordObject = [&]
+		{
+			Buffers[1].begin();
+			LRenderer.recordMovingObject(Buffers[1], Scene.ShaderProgram, Scene.MovingObjectModel);
+			Buffers[1].end();
+		};
+		auto recordSwarm = [&]
+		{
+			Buffers[2].begin();
+			LRenderer.recordSwarm(Buffers[2], Scene.ShaderProgram);
+			Buffers[2].end();
+		};
+
+		CommandStats Commands{};
+		double RecordWallMs = 0.0;
+		double SubmitMs = 0.0;
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const auto Start = BenchmarkClock::now();
+			LRenderer.beginScene(Scene.LModel, Instances, Prepared);
+			const auto Recording = BenchmarkClock::now();
+			if (Parallel)
+			{
+				JobCounter Counter;
+				JobSystem::submit(Counter, recordScene);
+				JobSystem::submit(Counter, recordObject);
+				JobSystem::submit(Counter, recordSwarm);
+				JobSystem::wait(Counter);
+			}
+			else
+			{
+				recordScene();
+				recordObject();
+				recordSwarm();
+			}
+			const std::chrono::duration<double, std::milli> Recorded = BenchmarkClock::now() - Recording;
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			Queue.clear();
+			for (const CommandBuffer& Buffer : Buffers)
+			{
+				LRenderer.execute(Queue, SceneBucket, Buffer);
+			}
+			const auto Submitting = BenchmarkClock::now();
+			LRenderer.submit(Queue);
+			const std::chrono::duration<double, std::milli> Submitted = BenchmarkClock::now() - Submitting;
+			glFinish();
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			if (Frame >= WarmupFrames)
+			{
+				const CommandStats& Last = LRenderer.getStats().Commands;
+				Commands.Packets = Last.Packets;
+				Commands.Instances = Last.Instances;
+				Commands.RecordMilliseconds += Last.RecordMilliseconds / TimedFrames;
+				Commands.ExecuteMilliseconds += Last.ExecuteMilliseconds / TimedFrames;
+				Commands.WaitMilliseconds += Last.WaitMilliseconds / TimedFrames;
+				RecordWallMs += Recorded.count() / TimedFrames;
+				SubmitMs += Submitted.count() / TimedFrames;
+				FrameMs[Parallel ? 1 : 0] += Elapsed.count() / TimedFrames;
+			}
+		}
+
+		std::vector<std::uint8_t> Pixels(static_cast<std::size_t>(BenchmarkWidth) * BenchmarkHeight * 4);
+		glReadPixels(0, 0, BenchmarkWidth, BenchmarkHeight, GL_RGBA, GL_UNSIGNED_BYTE, Pixels.data());
+		std::uint64_t Hash = 1469598103934665603ull;
+		for (const std::uint8_t Byte : Pixels)
+		{
+			Hash = (Hash ^ Byte) * 1099511628211ull;
+		}
+		Hashes[Parallel ? 1 : 0] = Hash;
+
+		std::cout << "  " << (Parallel ? "Workers  " : "GL thread") << " : record " << RecordWallMs << " ms ("
+			<< Commands.RecordMilliseconds << " ms summed over buffers), execute " << Commands.ExecuteMilliseconds
+			<< " ms (" << Commands.WaitMilliseconds << " ms waiting on the GPU), sort and submit " << SubmitMs
+			<< " ms, frame with GPU " << FrameMs[Parallel ? 1 : 0] << " ms\n";
+		std::cout << "    " << Commands.Packets << " packets, " << Commands.Instances
+			<< " instances copied into the stream\n";
+	}
+
+	std::cout << "  Recording on workers " << FrameMs[0] / FrameMs[1] << "x the GL thread frame rate\n";
+	std::cout << "  Same image either way : " << (Hashes[0] == Hashes[1] ? "yes" : "NO") << "\n";
+
+	Instances.releaseBuffer();
+	ImpostorBaker::release(Atlas);
+	closeScene(Scene);
+}
+
+void Benchmark::frameProfiler(const std::uint64_t Seed)
+{
+	constexpr int ScopeCount = 1000000;
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 60;
+
+	// Outside any frame, so only the CPU half runs and nothing is kept
+	std::cout << "Frame profiler (" << ScopeCount << " scopes, " << InstanceCount << " instances, seed " << Seed
+		<< ")\n";
+	for (const bool Enabled : {false, true})
+	{
+		Profiler::setEnabled(Enabled);
+		const auto Start = BenchmarkClock::now();
+		for (int I = 0; I < ScopeCount; I++)
+		{
+			const ProfileScope Scope("benchmark scope");
+		}
+		const std::chrono::duration<double, std::nano> Elapsed = BenchmarkClock::now() - Start;
+		std::cout << "  Scope " << (Enabled ? "on " : "off") << " : " << Elapsed.count() / ScopeCount << " ns\n";
+	}
+
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+	Profiler::reset();
+
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+	Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+	const FrameSnapshot Snapshot;
+	LRenderer.setFrame(Snapshot);
+
+	// No glFinish between frames, so the GPU runs behind the way it would presenting, and reading back a frame's
+	// timings must never wait for it
+	double FrameMs[2]{};
+	double BeginMs = 0.0;
+	double WorstBeginMs = 0.0;
+	for (const bool Enabled : {false, true})
+	{
+		Profiler::setEnabled(Enabled);
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const auto Start = BenchmarkClock::now();
+			Profiler::beginFrame();
+			const std::chrono::duration<double, std::milli> Begun = BenchmarkClock::now() - Start;
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances);
+			LRenderer.renderMovingObject(Scene.ShaderProgram, Scene.MovingObjectModel);
+			Profiler::endFrame();
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			if (Frame >= WarmupFrames)
+			{
+				FrameMs[Enabled ? 1 : 0] += Elapsed.count() / TimedFrames;
+				if (Enabled)
+				{
+					BeginMs += Begun.count() / TimedFrames;
+					WorstBeginMs = std::max(WorstBeginMs, Begun.count());
+				}
+			}
+		}
+		glFinish();
+	}
+
+	const ProfilerStats Stats = Profiler::getStats();
+	std::cout << "  Frame with the profiler off " << FrameMs[0] << " ms, on " << FrameMs[1] << " ms\n";
+	std::cout << "  Beginning a frame, reading back the GPU timings of " << Profiler::FrameLatency
+		<< " frames before : " << BeginMs << " ms on average, " << WorstBeginMs << " ms at worst\n";
+	std::cout << "  " << Stats.Frames << " frames, " << Stats.GpuFramesRead << " read back from the GPU, "
+		<< Stats.GpuFramesDropped << " dropped as not yet available, " << Stats.Queries << " queries\n";
+	Profiler::printReport(std::cout);
+	Profiler::reset();
+
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
+
+void Benchmark::traceRecording(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 30;
+	constexpr const char* TraceFile = "benchmark_trace.json";
+
+	std::cout << "Trace recording (" << InstanceCount << " instances, seed " << Seed << ", "
+		<< JobSystem::getThreadCount() << " threads)\n";
+	TraceRecorder::setThreadName("main");
+	for (const bool Recording : {false, true})
+	{
+		if (Recording)
+		{
+			TraceRecorder::start();
+		}
+		const auto Start = BenchmarkClock::now();
+		for (std::size_t I = 0; I < TraceRecorder::EventsPerThread; I++)
+		{
+			TraceRecorder::record(TraceCategory::Scope, "benchmark event", I, I + 1);
+		}
+		const std::chrono::duration<double, std::nano> Elapsed = BenchmarkClock::now() - Start;
+		std::cout << "  Event " << (Recording ? "recording    " : "not recording") << " : "
+			<< Elapsed.count() / static_cast<double>(TraceRecorder::EventsPerThread) << " ns\n";
+		TraceRecorder::stop();
+	}
+
+	// Recording from before the assets load through the recorded frames, starting drops the events above
+	TraceRecorder::start();
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		TraceRecorder::stop();
+		return;
+	}
+
+	ScatterSettings Settings;
+	Settings.Seed = Seed;
+	Settings.MinDisplacement = -100.0f;
+	Settings.MaxDisplacement = 100.0f;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Settings, InstanceCount, Scene.LModel, Instances);
+	Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+	const FrameSnapshot Snapshot;
+	LRenderer.setFrame(Snapshot);
+
+	// Culling on a worker, with its parallel loops, while the GL thread draws the scene it prepared last frame
+	PreparedScene Prepared[2];
+	int Drawing = 0;
+	LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared[Drawing]);
+	FrameGraph Graph;
+	Graph.addTask("cull", [&]
+	{
+		LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared[1 - Drawing]);
+	});
+	Graph.addTask("draw", [&]
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		LRenderer.renderScene(Scene.ShaderProgram, Scene.LModel, Instances, Prepared[Drawing]);
+		LRenderer.renderMovingObject(Scene.ShaderProgram, Scene.MovingObjectModel);
+		glFinish();
+	}, {}, TaskAffinity::MainThread);
+
+	double FrameMs[2]{};
+	double FlushMs = 0.0;
+	for (const bool Recording : {true, false})
+	{
+		if (!Recording)
+		{
+			TraceRecorder::stop();
+		}
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const auto Start = BenchmarkClock::now();
+			Profiler::beginFrame();
+			Graph.run();
+			Profiler::endFrame();
+			Drawing = 1 - Drawing;
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+			if (Frame >= WarmupFrames)
+			{
+				FrameMs[Recording ? 1 : 0] += Elapsed.count() / TimedFrames;
+			}
+		}
+	}
+	const auto FlushStart = BenchmarkClock::now();
+	const bool Written = TraceRecorder::flush(TraceFile);
+	FlushMs = std::chrono::duration<double, std::milli>(BenchmarkClock::now() - FlushStart).count();
+	const TraceStats Stats = TraceRecorder::getStats();
+
+	std::cout << "  Frame not recording " << FrameMs[0] << " ms, recording " << FrameMs[1] << " ms\n";
+	std::cout << "  " << (Written ? "Wrote " : "FAILED to write ") << Stats.Written << " events from "
+		<< Stats.Threads << " threads to " << TraceFile << " in " << FlushMs << " ms, " << Stats.Dropped
+		<< " dropped\n";
+
+	// Read back, every category should have turned up
+	std::ifstream In(TraceFile);
+	const std::string Json((std::istreambuf_iterator<char>(In)), std::istreambuf_iterator<char>());
+	std::cout << "  Events by category :";
+	for (const char* Category : {"scope", "task", "job", "gpu", "asset"})
+	{
+		const std::string Needle = std::string(R"("cat":")") + Category + "\"";
+		std::size_t Count = 0;
+		for (std::size_t At = Json.find(Needle); At != std::string::npos; At = Json.find(Needle, At + 1))
+		{
+			Count++;
+		}
+		std::cout << " " << Category << " " << Count;
+	}
+	std::cout << ", " << Json.size() / 1024 << " KiB\n";
+
+	Profiler::reset();
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
+
+void Benchmark::nullBackend(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 20000;
+	constexpr unsigned int AgentCount = 20000;
+	constexpr int WarmupFrames = 3;
+	constexpr int TimedFrames = 30;
+	constexpr int StageCount = 6;
+	constexpr const char* StageNames[StageCount] = {"simulate", "cull", "begin", "record", "execute", "submit"};
+	const float Spread = std::cbrt(20.0f); // As the pipeline benchmark
+
+	std::cout << "Render backends (" << InstanceCount << " instances, " << AgentCount << " ships, seed " << Seed
+		<< ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ImpostorAtlas Atlas = ImpostorBaker::bake(Scene.LModel, Scene.ShaderProgram);
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	Scatter.MinDisplacement *= Spread;
+	Scatter.MaxDisplacement *= Spread;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Scatter, InstanceCount, Scene.LModel, Instances);
+
+	SimulationInput Input{};
+	Input.Camera.RotateClockwise = true;
+	Input.Object = glm::vec3(0.0f, 0.0f, -1.0f);
+	Input.SwarmRunning = true;
+
+	constexpr const char* CaptureFile = "benchmark_backend.gltrace"; // Only counted, removed after
+
+	NullBackend Null;
+	BackendStats Handed[2]{};
+	bool GlCallsCounted = false;
+	std::uint64_t GlCalls = 0; // Every frame of the null backend's pass, caught by a capture
+	double CpuMs[2]{};
+	for (const bool UseNull : {false, true})
+	{
+		// Each pass simulates the same frames from the same start
+		FlockSettings Settings;
+		Settings.Seed = Seed;
+		Settings.BoundsRadius *= Spread;
+		FlockSimulation Swarm(Settings);
+		Swarm.spawn(AgentCount);
+		Swarm.setObstacles(Instances, Scene.LModel);
+		Simulation World;
+		World.setInstances(Instances, Scene.LModel);
+		World.setMovingObject(Scene.MovingObjectModel);
+		World.setSwarm(Swarm);
+
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setImpostors(Atlas, Scene.ImpostorProgram);
+		LRenderer.setSwarmModel(Scene.MovingObjectModel);
+		if (UseNull)
+		{
+			LRenderer.setBackend(Null);
+		}
+		RenderBackend& Backend = LRenderer.getBackend();
+
+		FrameSnapshot Snapshot;
+		PreparedScene Prepared;
+		RenderQueue Queue;
+		const BucketId SceneBucket = Queue.addBucket("scene");
+		CommandBuffer Buffers[3];
+		double StageMs[StageCount]{};
+		double FrameMs = 0.0;
+
+		// Capture swaps every GL entry point the app calls, so any call made under the null backend is counted,
+		// whether or not it goes through GlState
+		if (UseNull)
+		{
+			GlCallsCounted = GlCapture::start(CaptureFile, BenchmarkWidth, BenchmarkHeight);
+		}
+		for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+		{
+			const bool Timed = Frame >= WarmupFrames;
+			auto Lap = BenchmarkClock::now();
+			const auto Start = Lap;
+			auto time = [&](const int Stage)
+			{
+				const auto Now = BenchmarkClock::now();
+				if (Timed)
+				{
+					StageMs[Stage] += std::chrono::duration<double, std::milli>(Now - Lap).count() / TimedFrames;
+				}
+				Lap = Now;
+			};
+
+			GlState::resetStats();
+			World.runFrame(Input, (Frame + 1) * FrameClock::DefaultStep, Snapshot);
+			LRenderer.setFrame(Snapshot);
+			time(0);
+			LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared);
+			time(1);
+			LRenderer.beginScene(Scene.LModel, Instances, Prepared);
+			time(2);
+			Buffers[0].begin();
+			LRenderer.recordScene(Buffers[0], Scene.ShaderProgram, Scene.LModel, Instances, Prepared);
+			Buffers[0].end();
+			Buffers[1].begin();
+			LRenderer.recordMovingObject(Buffers[1], Scene.ShaderProgram, Scene.MovingObjectModel);
+			Buffers[1].end();
+			Buffers[2].begin();
+			LRenderer.recordSwarm(Buffers[2], Scene.ShaderProgram);
+			Buffers[2].end();
+			time(3);
+			Backend.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			Queue.clear();
+			for (const CommandBuffer& Buffer : Buffers)
+			{
+				LRenderer.execute(Queue, SceneBucket, Buffer);
+			}
+			time(4);
+			LRenderer.submit(Queue);
+			time(5);
+			const std::chrono::duration<double, std::milli> Cpu = BenchmarkClock::now() - Start;
+			if (!UseNull)
+			{
+				glFinish();
+			}
+			const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+
+			if (Timed)
+			{
+				const BackendStats& Stats = LRenderer.getStats().Backend;
+				BackendStats& Total = Handed[UseNull ? 1 : 0];
+				Total.Draws += Stats.Draws;
+				Total.Elements += Stats.Elements;
+				Total.UniformSets += Stats.UniformSets;
+				Total.Invalid += Stats.Invalid;
+				CpuMs[UseNull ? 1 : 0] += Cpu.count() / TimedFrames;
+				FrameMs += Elapsed.count() / TimedFrames;
+			}
+		}
+		if (UseNull && GlCallsCounted)
+		{
+			GlCalls = GlCapture::getStats().Calls;
+			GlCapture::stop();
+			std::remove(CaptureFile);
+		}
+
+		const double Cpu = CpuMs[UseNull ? 1 : 0];
+		std::cout << "  " << std::left << std::setw(4) << Backend.getName() << std::right << " :";
+		for (int Stage = 0; Stage < StageCount; Stage++)
+		{
+			std::cout << " " << StageNames[Stage] << " " << StageMs[Stage] << " ms"
+				<< (Stage + 1 < StageCount ? "," : "");
+		}
+		std::cout << "\n       CPU " << Cpu << " ms a frame, at most " << 1000.0 / Cpu << " fps";
+		if (!UseNull)
+		{
+			std::cout << ", frame with GPU " << FrameMs << " ms";
+		}
+		std::cout << "\n";
+	}
+
+	std::cout << "  Driver share of the CPU frame : " << (CpuMs[0] - CpuMs[1]) / CpuMs[0] * 100.0 << "%\n";
+	std::cout << "  Draws handed to each backend : " << Handed[0].Draws << " and " << Handed[1].Draws << ", "
+		<< Handed[0].Elements << " and " << Handed[1].Elements << " elements\n";
+	std::cout << "  Same draws either way : " << (Handed[0].Draws == Handed[1].Draws &&
+		Handed[0].Elements == Handed[1].Elements && Handed[0].UniformSets == Handed[1].UniformSets ? "yes" : "NO")
+		<< "\n";
+	std::cout << "  Invalid commands in the null backend : " << Handed[1].Invalid << "\n";
+	std::cout << "  GL calls while drawing with the null backend : ";
+	if (GlCallsCounted)
+	{
+		std::cout << GlCalls << "\n";
+	}
+	else
+	{
+		std::cout << "not counted, the capture couldn't start\n";
+	}
+
+	Instances.releaseBuffer();
+	ImpostorBaker::release(Atlas);
+	closeScene(Scene);
+}
+
+// A quad of the moving object's, drawn with Renderer::getMovingObjectMatrix(Position), through the world space
+// corners given counter clockwise
+static Model makeQuad(const GLuint Texture, const glm::vec3 (&Corners)[4], const glm::vec3& Position)
+{
+	const glm::mat4 ToModel = inverse(Renderer::getMovingObjectMatrix(Position));
+	const glm::vec2 TexCoords[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+	std::vector<float> Vertices;
+	for (int Corner = 0; Corner < 4; Corner++)
+	{
+		const glm::vec3 Local = ToModel * glm::vec4(Corners[Corner], 1.0f);
+		Vertices.insert(Vertices.end(), {Local.x, Local.y, Local.z, TexCoords[Corner].x, TexCoords[Corner].y});
+	}
+	const std::vector<unsigned int> Indices = {0, 1, 2, 0, 2, 3};
+
+	Model Quad{};
+	Quad.Texture = Texture;
+	Quad.IndexCount = static_cast<int>(Indices.size());
+	glCreateVertexArrays(1, &Quad.Vao);
+	glCreateBuffers(1, &Quad.Vbo);
+	glCreateBuffers(1, &Quad.Ebo);
+	glNamedBufferData(Quad.Vbo, static_cast<GLsizeiptr>(Vertices.size() * sizeof(float)), Vertices.data(),
+	                  GL_STATIC_DRAW);
+	glNamedBufferData(Quad.Ebo, static_cast<GLsizeiptr>(Indices.size() * sizeof(unsigned int)), Indices.data(),
+	                  GL_STATIC_DRAW);
+	glVertexArrayVertexBuffer(Quad.Vao, 0, Quad.Vbo, 0, 5 * sizeof(float));
+	glVertexArrayElementBuffer(Quad.Vao, Quad.Ebo);
+	glEnableVertexArrayAttrib(Quad.Vao, 0);
+	glVertexArrayAttribFormat(Quad.Vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(Quad.Vao, 0, 0);
+	glEnableVertexArrayAttrib(Quad.Vao, 1);
+	glVertexArrayAttribFormat(Quad.Vao, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+	glVertexArrayAttribBinding(Quad.Vao, 1, 0);
+	return Quad;
+}
+
+void Benchmark::softwareRasteriser(const std::uint64_t Seed)
+{
+	constexpr unsigned int InstanceCount = 1000; // As the app
+	constexpr unsigned int AgentCount = 2000;
+	constexpr int SettleFrames = 60; // Simulated before the frame every configuration draws
+	constexpr int WarmupFrames = 2;
+	constexpr int TimedFrames = 10;
+	constexpr unsigned int TileSizes[] = {8, 16, 32, 64};
+	constexpr int ChannelTolerance = 48; // Nearest texels against GL's filtering
+	constexpr const char* ImageFile = "benchmark_software.ppm";
+	constexpr double NearAgreementRequired = 99.5; // Percent, edges aside
+
+	Parallel::setThreadCount(0);
+	const unsigned int CoreCount = Parallel::getThreadCount();
+	std::cout << "Software rasteriser (" << InstanceCount << " instances, " << AgentCount << " ships, seed " << Seed
+		<< ", " << BenchmarkWidth << "x" << BenchmarkHeight << ", " << CoreCount << " threads, AVX2 "
+		<< (Simd::hasAvx2() ? "on" : "unavailable") << ")\n";
+	BenchmarkScene Scene;
+	if (!openScene(Scene))
+	{
+		return;
+	}
+
+	ScatterSettings Scatter;
+	Scatter.Seed = Seed;
+	InstancePool Instances(InstanceCount);
+	fillInstances(Scatter, InstanceCount, Scene.LModel, Instances);
+	FlockSettings Settings;
+	Settings.Seed = Seed;
+	FlockSimulation Swarm(Settings);
+	Swarm.spawn(AgentCount);
+	Swarm.setObstacles(Instances, Scene.LModel);
+	Simulation World;
+	World.setInstances(Instances, Scene.LModel);
+	World.setMovingObject(Scene.MovingObjectModel);
+	World.setSwarm(Swarm);
+
+	// One frame drawn over and over, so every configuration has the same image to agree on
+	SimulationInput Input{};
+	Input.Camera.RotateClockwise = true;
+	Input.SwarmRunning = true;
+	FrameSnapshot Snapshot;
+	for (int Frame = 0; Frame < SettleFrames; Frame++)
+	{
+		World.runFrame(Input, (Frame + 1) * FrameClock::DefaultStep, Snapshot);
+	}
+
+	SoftwareBackend Software(BenchmarkWidth, BenchmarkHeight);
+	Software.addModel(Scene.LModel);
+	Software.addModel(Scene.MovingObjectModel);
+	Software.addInstancePool(Instances);
+	{
+		// Impostors only draw on GL, so neither backend draws them
+		Renderer LRenderer(BenchmarkWidth, BenchmarkHeight, Scene.Window);
+		LRenderer.setSwarmModel(Scene.MovingObjectModel);
+		LRenderer.setImpostorsEnabled(false);
+		PreparedScene Prepared;
+		RenderQueue Queue;
+		const BucketId SceneBucket = Queue.addBucket("scene");
+		CommandBuffer Buffers[3];
+
+		// Milliseconds from the clear to the frame being finished, averaged over the timed frames
+		auto timeFrames = [&]
+		{
+			double Total = 0.0;
+			for (int Frame = 0; Frame < WarmupFrames + TimedFrames; Frame++)
+			{
+				LRenderer.setFrame(Snapshot);
+				LRenderer.prepareScene(Snapshot, Scene.LModel, Instances, Prepared);
+				LRenderer.beginScene(Scene.LModel, Instances, Prepared);
+				for (CommandBuffer& Buffer : Buffers)
+				{
+					Buffer.begin();
+				}
+				LRenderer.recordScene(Buffers[0], Scene.ShaderProgram, Scene.LModel, Instances, Prepared);
+				LRenderer.recordMovingObject(Buffers[1], Scene.ShaderProgram, Scene.MovingObjectModel);
+				LRenderer.recordSwarm(Buffers[2], Scene.ShaderProgram);
+				for (CommandBuffer& Buffer : Buffers)
+				{
+					Buffer.end();
+				}
+
+				const auto Start = BenchmarkClock::now();
+				LRenderer.getBackend().clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				Queue.clear();
+				for (const CommandBuffer& Buffer : Buffers)
+				{
+					LRenderer.execute(Queue, SceneBucket, Buffer);
+				}
+				LRenderer.submit(Queue);
+				if (&LRenderer.getBackend() == &GlBackend::get())
+				{
+					glFinish();
+				}
+				const std::chrono::duration<double, std::milli> Elapsed = BenchmarkClock::now() - Start;
+				if (Frame >= WarmupFrames)
+				{
+					Total += Elapsed.count();
+				}
+			}
+			return Total / TimedFrames;
+		};
+		auto hashImage = [](const std::vector<std::uint32_t>& Pixels)
+		{
+			std::uint64_t Hash = 1469598103934665603ull;
+			for (const std::uint32_t Pixel : Pixels)
+			{
+				Hash = (Hash ^ Pixel) * 1099511628211ull;
+			}
+			return Hash;
+		};
+
+		const double GlMs = timeFrames();
+		std::vector<std::uint32_t> GlPixels(static_cast<std::size_t>(BenchmarkWidth) * BenchmarkHeight);
+		glReadPixels(0, 0, BenchmarkWidth, BenchmarkHeight, GL_RGBA, GL_UNSIGNED_BYTE, GlPixels.data());
+		std::cout << "  GL       : " << GlMs << " ms a frame with GPU (" << glGetString(GL_RENDERER) << ")\n";
+
+		LRenderer.setBackend(Software);
+		std::vector<unsigned int> ThreadCounts;
+		for (unsigned int Threads = 1; Threads < CoreCount; Threads *= 2)
+		{
+			ThreadCounts.push_back(Threads);
+		}
+		ThreadCounts.push_back(CoreCount);
+
+		std::vector<std::uint32_t> Pixels;
+		std::uint64_t FirstHash = 0;
+		bool SameImage = true;
+		double BestMs = 1.0e30;
+		unsigned int BestTile = 0;
+		for (const unsigned int TileSize : TileSizes)
+		{
+			Software.setTileSize(TileSize);
+			double SingleMs = 0.0;
+			for (const unsigned int Threads : ThreadCounts)
+			{
+				Parallel::setThreadCount(Threads);
+				const double Ms = timeFrames();
+				const SoftwareStats& Stats = Software.getRasterStats();
+				Software.readPixels(Pixels);
+				const std::uint64_t Hash = hashImage(Pixels);
+				if (FirstHash == 0)
+				{
+					FirstHash = Hash;
+				}
+				SameImage = SameImage && Hash == FirstHash;
+				if (Threads == 1)
+				{
+					SingleMs = Ms;
+				}
+				if (Threads == CoreCount && Ms < BestMs)
+				{
+					BestMs = Ms;
+					BestTile = TileSize;
+				}
+				std::cout << "  Tile " << std::setw(2) << TileSize << ", " << std::setw(2) << Threads << " threads : "
+					<< Ms << " ms (" << 1000.0 / Ms << " fps, " << SingleMs / Ms << "x), geometry "
+					<< Stats.GeometryMilliseconds << " ms, raster " << Stats.RasterMilliseconds << " ms, "
+					<< Stats.BinEntries << " binned\n";
+			}
+		}
+
+		// A pixel at a time on the fastest tile size, against eight
+		Software.setTileSize(BestTile);
+		Software.setAvx2Enabled(false);
+		const double ScalarMs = timeFrames();
+		const double ScalarRasterMs = Software.getRasterStats().RasterMilliseconds;
+		Software.setAvx2Enabled(true);
+		const double SimdMs = timeFrames();
+		const SoftwareStats& Stats = Software.getRasterStats();
+		std::cout << "  Scalar at tile " << BestTile << " : " << ScalarMs << " ms, raster " << ScalarRasterMs
+			<< " ms, AVX2 raster " << Stats.RasterMilliseconds << " ms ("
+			<< ScalarRasterMs / std::max(Stats.RasterMilliseconds, 1.0e-6) << "x), frame " << ScalarMs / SimdMs
+			<< "x\n";
+		std::cout << "  Triangles : " << Stats.Triangles << " read, " << Stats.Rasterised
+			<< " rasterised after culling and clipping, " << Stats.Chunks << " geometry chunks\n";
+		std::cout << "  Backend : " << LRenderer.getStats().Backend.Draws << " draws, "
+			<< LRenderer.getStats().Backend.Skipped << " skipped, " << LRenderer.getStats().Backend.Invalid
+			<< " invalid\n";
+		std::cout << "  Same image for every tile size and thread count : " << (SameImage ? "yes" : "NO") << "\n";
+
+		Software.readPixels(Pixels);
+		std::size_t Agreeing = 0;
+		for (std::size_t I = 0; I < Pixels.size(); I++)
+		{
+			int Difference = 0;
+			for (int Channel = 0; Channel < 3; Channel++)
+			{
+				Difference = std::max(Difference, std::abs(static_cast<int>((Pixels[I] >> (Channel * 8)) & 0xff) -
+					                      static_cast<int>((GlPixels[I] >> (Channel * 8)) & 0xff)));
+			}
+			Agreeing += Difference <= ChannelTolerance ? 1 : 0;
+		}
+		std::cout << "  Pixels within " << ChannelTolerance << " of GL on every channel : "
+			<< 100.0 * static_cast<double>(Agreeing) / static_cast<double>(Pixels.size()) << "%\n";
+		if (SoftwareBackend::writeImage(ImageFile, Pixels, BenchmarkWidth, BenchmarkHeight))
+		{
+			std::cout << "  Image written to " << ImageFile << "\n";
+		}
+
+		// A strip of floor to the camera's right reaching a little behind it. Behind the camera its corners have x
+		// above -w, so only their near plane outcode sends its triangles to be clipped rather than projected
+		FrameSnapshot Near = Snapshot;
+		const glm::mat4 View = Near.Viewpoint.getViewMatrix();
+		const glm::vec3 Right(View[0][0], View[1][0], View[2][0]);
+		const glm::vec3 Up(View[0][1], View[1][1], View[2][1]);
+		const glm::vec3 Forward(-View[0][2], -View[1][2], -View[2][2]);
+		const glm::vec3 Below = Near.Viewpoint.getPosition() - Up * 0.5f;
+		const glm::vec3 Corners[4] = {Below + Right * 1.0f - Forward, Below + Right * 5.0f - Forward,
+		                              Below + Right * 5.0f + Forward * 20.0f, Below + Right * 1.0f + Forward * 20.0f};
+		Near.ObjectPosition = Near.Viewpoint.getPosition();
+		const Model Floor = makeQuad(Scene.MovingObjectModel.Texture, Corners, Near.ObjectPosition);
+		Software.addModel(Floor);
+		auto drawNear = [&](std::vector<std::uint32_t>& Drawn)
+		{
+			LRenderer.setFrame(Near);
+			Buffers[1].begin();
+			LRenderer.recordMovingObject(Buffers[1], Scene.ShaderProgram, Floor);
+			Buffers[1].end();
+			LRenderer.getBackend().clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			Queue.clear();
+			LRenderer.execute(Queue, SceneBucket, Buffers[1]);
+			LRenderer.submit(Queue);
+			Drawn.resize(static_cast<std::size_t>(BenchmarkWidth) * BenchmarkHeight);
+			if (&LRenderer.getBackend() == &GlBackend::get())
+			{
+				glReadPixels(0, 0, BenchmarkWidth, BenchmarkHeight, GL_RGBA, GL_UNSIGNED_BYTE, Drawn.data());
+			}
+			else
+			{
+				Software.readPixels(Drawn);
+			}
+		};
+		drawNear(Pixels);
+		LRenderer.setBackend(GlBackend::get());
+		drawNear(GlPixels);
+		// Texels are nearest against GL's filtering, so only what is covered is compared
+		std::size_t Covered = 0;
+		std::size_t SameCoverage = 0;
+		for (std::size_t I = 0; I < Pixels.size(); I++)
+		{
+			const bool GlCovered = (GlPixels[I] & 0xffffff) != 0;
+			Covered += GlCovered ? 1 : 0;
+			SameCoverage += GlCovered == ((Pixels[I] & 0xffffff) != 0) ? 1 : 0;
+		}
+		const double NearAgreement = 100.0 * static_cast<double>(SameCoverage) / static_cast<double>(Pixels.size());
+		std::cout << "  Crossing the near plane : " << 100.0 * static_cast<double>(Covered) /
+			static_cast<double>(Pixels.size()) << "% covered by GL, " << NearAgreement
+			<< "% of pixels covered the same, "
+			<< (NearAgreement >= NearAgreementRequired ? "clipped as GL clips" : "NOT AS GL") << "\n";
+		glDeleteVertexArrays(1, &Floor.Vao);
+		glDeleteBuffers(1, &Floor.Vbo);
+		glDeleteBuffers(1, &Floor.Ebo);
+		Parallel::setThreadCount(0);
+	}
+
+	Instances.releaseBuffer();
+	closeScene(Scene);
+}
@@ -14,11 +14,13 @@ Mail : ayoub.ahmad@mds.ac.nz
 
 #include "Camera.h"
 
+constexpr float FieldOfView = 45.0f; // Vertical, in degrees
+
 Camera::Camera(const float Radius, const float Speed)
-	: MRadius(Radius), MSpeed(Speed), MAngle(0.0f), MAutomatic(false), MShiftMultiplier(2.0f),
-	  MTarget(0.0f, 0.0f, 0.0f), MUp(0.0f, 1.0f, 0.0f)
+	: MRadius(Radius), MSpeed(Speed), MAngle(0.0f), MPreviousRadius(Radius), MPreviousAngle(0.0f), MAutomatic(false),
+	  MShiftMultiplier(2.0f), MTarget(0.0f, 0.0f, 0.0f), MUp(0.0f, 1.0f, 0.0f)
 {
-	updatePosition();
+	updatePosition(MRadius, MAngle);
 	updateViewMatrix();
 }
 
@@ -27,47 +29,59 @@ void Camera::toggleMode()
 	MAutomatic = !MAutomatic;
 }
 
-void Camera::update(const float DeltaTime)
+void Camera::update(const float DeltaTime, const CameraInput& Input)
 {
+	MPreviousRadius = MRadius;
+	MPreviousAngle = MAngle;
+	MShiftMultiplier = Input.Fast ? 2.0f : 1.0f;
+
 	if (MAutomatic)
 	{
 		const float ReducedSpeed = MSpeed * 0.1f; // Camera speed adjustment
 		MAngle += ReducedSpeed * DeltaTime * MShiftMultiplier;
-		updatePosition();
-		updateViewMatrix();
 	}
-}
-
-void Camera::processInput(GLFWwindow* Window, const float DeltaTime)
-{
-	MShiftMultiplier = glfwGetKey(Window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? 2.0f : 1.0f;
 
 	// Rotation clockwise around origin with Y-axis on X and Z axis plane
-	if (glfwGetKey(Window, GLFW_KEY_LEFT) == GLFW_PRESS)
+	if (Input.RotateClockwise)
 	{
 		MAngle += MSpeed * DeltaTime * MShiftMultiplier;
 	}
 	// Rotation anti-clockwise around origin with Y-axis on X and Z axis plane
-	if (glfwGetKey(Window, GLFW_KEY_RIGHT) == GLFW_PRESS)
+	if (Input.RotateAntiClockwise)
 	{
 		MAngle -= MSpeed * DeltaTime * MShiftMultiplier;
 	}
 	// Shorten radius (closer distance to world origin)
-	if (glfwGetKey(Window, GLFW_KEY_UP) == GLFW_PRESS)
+	if (Input.MoveCloser)
 	{
 		MRadius -= MSpeed * DeltaTime * MShiftMultiplier * 5.0f;
 		if (MRadius < 1.0f) MRadius = 1.0f; // Prevent the radius from going negative or too close
 	}
 	// Lengthen radius (longer distance to world origin)
-	if (glfwGetKey(Window, GLFW_KEY_DOWN) == GLFW_PRESS)
+	if (Input.MoveAway)
 	{
 		MRadius += MSpeed * DeltaTime * MShiftMultiplier * 5.0f;
 	}
+}
 
-	updatePosition();
+void Camera::interpolate(const float Alpha)
+{
+	updatePosition(MPreviousRadius + (MRadius - MPreviousRadius) * Alpha,
+	               MPreviousAngle + (MAngle - MPreviousAngle) * Alpha);
 	updateViewMatrix();
 }
 
+CameraInput Camera::sampleInput(GLFWwindow* Window)
+{
+	CameraInput Input{};
+	Input.RotateClockwise = glfwGetKey(Window, GLFW_KEY_LEFT) == GLFW_PRESS;
+	Input.RotateAntiClockwise = glfwGetKey(Window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+	Input.MoveCloser = glfwGetKey(Window, GLFW_KEY_UP) == GLFW_PRESS;
+	Input.MoveAway = glfwGetKey(Window, GLFW_KEY_DOWN) == GLFW_PRESS;
+	Input.Fast = glfwGetKey(Window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+	return Input;
+}
+
 glm::mat4 Camera::getViewMatrix() const
 {
 	return MViewMatrix;
@@ -75,7 +89,32 @@ glm::mat4 Camera::getViewMatrix() const
 
 glm::mat4 Camera::getProjectionMatrix(const float AspectRatio) const
 {
-	return glm::perspective(glm::radians(45.0f), AspectRatio, 0.1f, 100.0f); // FOV is 45 degrees
+	return glm::perspective(glm::radians(FieldOfView), AspectRatio, NearPlane, FarPlane); // FOV is 45 degrees
+}
+
+glm::vec3 Camera::getPosition() const
+{
+	return MPosition;
+}
+
+float Camera::getFieldOfView() const
+{
+	return glm::radians(FieldOfView);
+}
+
+void Camera::getCursorRay(const double CursorX, const double CursorY, const int WindowWidth, const int WindowHeight,
+                          glm::vec3& Origin, glm::vec3& Direction) const
+{
+	// Window coordinates run down from the top left, normalised device coordinates up from the centre
+	const float X = static_cast<float>(2.0 * CursorX / WindowWidth - 1.0);
+	const float Y = static_cast<float>(1.0 - 2.0 * CursorY / WindowHeight);
+	const glm::mat4 InverseViewProjection = inverse(
+		getProjectionMatrix(static_cast<float>(WindowWidth) / static_cast<float>(WindowHeight)) * MViewMatrix);
+
+	const glm::vec4 Near = InverseViewProjection * glm::vec4(X, Y, -1.0f, 1.0f);
+	const glm::vec4 Far = InverseViewProjection * glm::vec4(X, Y, 1.0f, 1.0f);
+	Origin = glm::vec3(Near) / Near.w;
+	Direction = normalize(glm::vec3(Far) / Far.w - Origin);
 }
 
 void Camera::updateViewMatrix()
@@ -83,7 +122,7 @@ void Camera::updateViewMatrix()
 	MViewMatrix = lookAt(MPosition, MTarget, MUp);
 }
 
-void Camera::updatePosition()
+void Camera::updatePosition(const float Radius, const float Angle)
 {
-	MPosition = glm::vec3(MRadius * cos(MAngle), 0.0f, MRadius * sin(MAngle));
+	MPosition = glm::vec3(Radius * cos(Angle), 0.0f, Radius * sin(Angle));
 }
@@ -0,0 +1,294 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : CollisionGrid.cpp
+Description : Implementations for the uniform hash grid broadphase and
+			  the sphere against box narrowphase
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "CollisionGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+constexpr int CellBits = 21; // Per axis in a cell key, so the grid spans about two million cells each way
+constexpr std::uint64_t CellMask = (1ull << CellBits) - 1;
+
+// Contacts are kept sorted by slot so consecutive frames can be diffed into events
+static bool contactLess(const Contact& Left, const Contact& Right)
+{
+	return Left.Instance.Slot < Right.Instance.Slot ||
+		(Left.Instance.Slot == Right.Instance.Slot && Left.Instance.Generation < Right.Instance.Generation);
+}
+
+CollisionGrid::CollisionGrid(const float CellSize)
+	: MCellSize(CellSize), MMaxRadius(0.0f), MRevision(0), MSyncStamp(0)
+{
+}
+
+void CollisionGrid::insert(const InstanceHandle Handle, const glm::vec3& Center, const float Radius)
+{
+	if (Handle.Slot >= MEntries.size())
+	{
+		MEntries.resize(Handle.Slot + 1, Entry{});
+	}
+	Entry& Target = MEntries[Handle.Slot];
+	if (Target.Present)
+	{
+		unlink(Handle.Slot);
+	}
+	Target.Center = Center;
+	Target.Radius = Radius;
+	Target.Generation = Handle.Generation;
+	Target.SyncStamp = MSyncStamp;
+	MMaxRadius = std::max(MMaxRadius, Radius);
+	link(Handle.Slot);
+}
+
+void CollisionGrid::move(const InstanceHandle Handle, const glm::vec3& Center, const float Radius)
+{
+	if (Handle.Slot >= MEntries.size() || !MEntries[Handle.Slot].Present ||
+		MEntries[Handle.Slot].Generation != Handle.Generation)
+	{
+		insert(Handle, Center, Radius);
+		return;
+	}
+
+	Entry& Target = MEntries[Handle.Slot];
+	Target.Center = Center;
+	Target.Radius = Radius;
+	MMaxRadius = std::max(MMaxRadius, Radius);
+	if (cellKey(cellOf(Center)) != Target.Cell)
+	{
+		unlink(Handle.Slot);
+		link(Handle.Slot);
+		MStats.Moved++;
+	}
+}
+
+void CollisionGrid::remove(const InstanceHandle Handle)
+{
+	if (Handle.Slot < MEntries.size() && MEntries[Handle.Slot].Present &&
+		MEntries[Handle.Slot].Generation == Handle.Generation)
+	{
+		unlink(Handle.Slot);
+	}
+}
+
+void CollisionGrid::sync(const InstancePool& Instances, const Model& Model)
+{
+	if (Instances.getRevision() == MRevision && MStats.Instances == Instances.getCount())
+	{
+		return;
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+	MSyncStamp++;
+	MStats.Moved = 0;
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+	for (unsigned int I = 0; I < Instances.getCount(); I++)
+	{
+		const InstanceHandle Handle = Instances.getHandle(I);
+		glm::vec3 Center;
+		float Radius;
+		if (InstanceAnimator::isAnimated(Animations[I]))
+		{
+			// Animated instances collide as the sphere swept by their motion, so the grid stays static
+			InstanceAnimator::sweptSphere(Model, Transforms[I], Animations[I], Center, Radius);
+		}
+		else
+		{
+			transformSphere(Model, Transforms[I], Center, Radius);
+		}
+		move(Handle, Center, Radius);
+		MEntries[Handle.Slot].SyncStamp = MSyncStamp;
+	}
+
+	// Anything this sync didn't reach has been despawned
+	for (std::uint32_t Slot = 0; Slot < MEntries.size(); Slot++)
+	{
+		if (MEntries[Slot].Present && MEntries[Slot].SyncStamp != MSyncStamp)
+		{
+			unlink(Slot);
+		}
+	}
+
+	MRevision = Instances.getRevision();
+	MStats.Instances = Instances.getCount();
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.SyncMilliseconds = Elapsed.count();
+}
+
+void CollisionGrid::collide(const BvhBounds& Box)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	MPreviousContacts.swap(MContacts);
+	MContacts.clear();
+	MEvents.clear();
+	MStats.CellsVisited = 0;
+	MStats.Candidates = 0;
+
+	// Spheres are filed under the cell holding their centre, so any that reach the box are centred within
+	// the largest radius of it
+	const glm::ivec3 MinCell = cellOf(Box.Min - MMaxRadius);
+	const glm::ivec3 MaxCell = cellOf(Box.Max + MMaxRadius);
+	for (int Z = MinCell.z; Z <= MaxCell.z; Z++)
+	{
+		for (int Y = MinCell.y; Y <= MaxCell.y; Y++)
+		{
+			for (int X = MinCell.x; X <= MaxCell.x; X++)
+			{
+				MStats.CellsVisited++;
+				const auto Cell = MCells.find(cellKey({X, Y, Z}));
+				if (Cell == MCells.end())
+				{
+					continue;
+				}
+
+				for (const std::uint32_t Slot : Cell->second)
+				{
+					MStats.Candidates++;
+					const Entry& Candidate = MEntries[Slot];
+					const glm::vec3 Closest = clamp(Candidate.Center, Box.Min, Box.Max);
+					const glm::vec3 Offset = Candidate.Center - Closest;
+					const float DistanceSq = dot(Offset, Offset);
+					if (DistanceSq > Candidate.Radius * Candidate.Radius)
+					{
+						continue;
+					}
+
+					Contact Hit{{Slot, Candidate.Generation}, glm::vec3(0.0f), 0.0f};
+					if (DistanceSq > 0.0f)
+					{
+						const float Distance = std::sqrt(DistanceSq);
+						Hit.Normal = Offset / Distance;
+						Hit.Depth = Candidate.Radius - Distance;
+					}
+					else
+					{
+						// Centre inside the box, push out through the nearest face
+						const glm::vec3 ToMin = Candidate.Center - Box.Min;
+						const glm::vec3 ToMax = Box.Max - Candidate.Center;
+						float Nearest = ToMin.x;
+						Hit.Normal = glm::vec3(-1.0f, 0.0f, 0.0f);
+						for (int Axis = 0; Axis < 3; Axis++)
+						{
+							if (ToMin[Axis] < Nearest)
+							{
+								Nearest = ToMin[Axis];
+								Hit.Normal = glm::vec3(0.0f);
+								Hit.Normal[Axis] = -1.0f;
+							}
+							if (ToMax[Axis] < Nearest)
+							{
+								Nearest = ToMax[Axis];
+								Hit.Normal = glm::vec3(0.0f);
+								Hit.Normal[Axis] = 1.0f;
+							}
+						}
+						Hit.Depth = Nearest + Candidate.Radius;
+					}
+					MContacts.push_back(Hit);
+				}
+			}
+		}
+	}
+	std::sort(MContacts.begin(), MContacts.end(), contactLess);
+
+	// Both lists are sorted, walk them together for contacts that started or ended
+	std::size_t Current = 0;
+	std::size_t Previous = 0;
+	while (Current < MContacts.size() || Previous < MPreviousContacts.size())
+	{
+		if (Previous == MPreviousContacts.size() ||
+			(Current < MContacts.size() && contactLess(MContacts[Current], MPreviousContacts[Previous])))
+		{
+			MEvents.push_back({ContactEventType::Begin, MContacts[Current++].Instance});
+		}
+		else if (Current == MContacts.size() || contactLess(MPreviousContacts[Previous], MContacts[Current]))
+		{
+			MEvents.push_back({ContactEventType::End, MPreviousContacts[Previous++].Instance});
+		}
+		else
+		{
+			Current++;
+			Previous++;
+		}
+	}
+
+	MStats.Contacts = static_cast<unsigned int>(MContacts.size());
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.QueryMilliseconds = Elapsed.count();
+}
+
+const std::vector<Contact>& CollisionGrid::getContacts() const
+{
+	return MContacts;
+}
+
+const std::vector<ContactEvent>& CollisionGrid::getEvents() const
+{
+	return MEvents;
+}
+
+const CollisionStats& CollisionGrid::getStats() const
+{
+	return MStats;
+}
+
+void CollisionGrid::transformSphere(const Model& Model, const glm::mat4& Transform, glm::vec3& Center, float& Radius)
+{
+	Center = glm::vec3(Transform * glm::vec4(Model.BoundsCenter, 1.0f));
+	const float Scale = std::max(std::max(length(glm::vec3(Transform[0])), length(glm::vec3(Transform[1]))),
+	                             length(glm::vec3(Transform[2])));
+	Radius = Model.BoundsRadius * Scale;
+}
+
+glm::ivec3 CollisionGrid::cellOf(const glm::vec3& Position) const
+{
+	return glm::ivec3(floor(Position / MCellSize));
+}
+
+std::uint64_t CollisionGrid::cellKey(const glm::ivec3& Cell)
+{
+	const std::uint64_t X = static_cast<std::uint64_t>(Cell.x) & CellMask;
+	const std::uint64_t Y = static_cast<std::uint64_t>(Cell.y) & CellMask;
+	const std::uint64_t Z = static_cast<std::uint64_t>(Cell.z) & CellMask;
+	return X | (Y << CellBits) | (Z << (2 * CellBits));
+}
+
+void CollisionGrid::unlink(const std::uint32_t Slot)
+{
+	// Swap-remove from the cell's list and fix up the entry that moved into the hole
+	Entry& Target = MEntries[Slot];
+	const auto Cell = MCells.find(Target.Cell);
+	std::vector<std::uint32_t>& Slots = Cell->second;
+	const std::uint32_t Last = Slots.back();
+	Slots[Target.CellIndex] = Last;
+	MEntries[Last].CellIndex = Target.CellIndex;
+	Slots.pop_back();
+	if (Slots.empty())
+	{
+		MCells.erase(Cell);
+	}
+	Target.Present = false;
+}
+
+void CollisionGrid::link(const std::uint32_t Slot)
+{
+	Entry& Target = MEntries[Slot];
+	Target.Cell = cellKey(cellOf(Target.Center));
+	std::vector<std::uint32_t>& Slots = MCells[Target.Cell];
+	Target.CellIndex = static_cast<std::uint32_t>(Slots.size());
+	Slots.push_back(Slot);
+	Target.Present = true;
+}
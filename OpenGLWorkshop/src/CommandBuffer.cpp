@@ -0,0 +1,122 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : CommandBuffer.cpp
+Description : Implementations for draw commands recorded on any thread
+			  and replayed into a render queue by the GL thread
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "CommandBuffer.h"
+
+#include <utility>
+
+void CommandBuffer::begin()
+{
+	MDraws.clear();
+	MUniforms.clear();
+	MTransforms.clear();
+	MAnimations.clear();
+	MRecordMilliseconds = 0.0;
+	MStart = std::chrono::steady_clock::now();
+}
+
+void CommandBuffer::end()
+{
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - MStart;
+	MRecordMilliseconds = Elapsed.count();
+}
+
+std::uint32_t CommandBuffer::addUniforms(RenderQueue::UniformSetter Setter,
+                                         const std::optional<SceneUniforms>& Scene)
+{
+	MUniforms.push_back({std::move(Setter), Scene});
+	return static_cast<std::uint32_t>(MUniforms.size() - 1);
+}
+
+std::uint32_t CommandBuffer::addInstances(const glm::mat4* Transforms, const InstanceAnimation* Animations,
+                                          const std::size_t Count)
+{
+	const std::size_t First = MTransforms.size();
+	MTransforms.insert(MTransforms.end(), Transforms, Transforms + Count);
+
+	// Animations stay index for index with the transforms once any instance has one
+	if (Animations != nullptr || !MAnimations.empty())
+	{
+		MAnimations.resize(First);
+		if (Animations != nullptr)
+		{
+			MAnimations.insert(MAnimations.end(), Animations, Animations + Count);
+		}
+		else
+		{
+			MAnimations.resize(First + Count);
+		}
+	}
+	return static_cast<std::uint32_t>(First);
+}
+
+void CommandBuffer::push(const std::uint64_t Key, const DrawPacket& Packet)
+{
+	MDraws.push_back({Key, Packet});
+}
+
+void CommandBuffer::replay(RenderQueue& Queue, const BucketId Bucket, const GLuint TransformBuffer,
+                           const GLuint AnimationBuffer, const GLuint BaseInstance) const
+{
+	// The queue numbers uniform sets in the order they're added, so this buffer's keep their order after its first
+	std::uint32_t FirstUniforms = 0;
+	for (std::size_t I = 0; I < MUniforms.size(); I++)
+	{
+		const std::uint32_t Index = Queue.addUniforms(MUniforms[I].Setter, MUniforms[I].Scene);
+		if (I == 0)
+		{
+			FirstUniforms = Index;
+		}
+	}
+
+	for (const RecordedDraw& Draw : MDraws)
+	{
+		DrawPacket Packet = Draw.Packet;
+		if (Packet.Uniforms != RenderQueue::NoUniforms)
+		{
+			Packet.Uniforms += FirstUniforms;
+		}
+		if (Packet.InstanceBuffer == RecordedInstances)
+		{
+			Packet.InstanceBuffer = TransformBuffer;
+			Packet.BaseInstance += BaseInstance;
+		}
+		if (Packet.AnimationBuffer == RecordedInstances)
+		{
+			Packet.AnimationBuffer = AnimationBuffer;
+		}
+		Queue.push(Bucket, Draw.Key, Packet);
+	}
+}
+
+const std::vector<RecordedDraw>& CommandBuffer::getDraws() const
+{
+	return MDraws;
+}
+
+const std::vector<glm::mat4>& CommandBuffer::getTransforms() const
+{
+	return MTransforms;
+}
+
+const std::vector<InstanceAnimation>& CommandBuffer::getAnimations() const
+{
+	return MAnimations;
+}
+
+double CommandBuffer::getRecordMilliseconds() const
+{
+	return MRecordMilliseconds;
+}
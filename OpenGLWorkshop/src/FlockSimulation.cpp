@@ -0,0 +1,484 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FlockSimulation.cpp
+Description : Implementations for the flock's steering, its SoA SIMD
+			  integration kernels and the ship transforms
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "FlockSimulation.h"
+#include "CollisionGrid.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+constexpr std::size_t SteerGrain = 1024; // Agents per task, each one walks up to 27 hash cells
+constexpr std::size_t IntegrateGrain = 16384; // Whole blocks of eight
+
+std::size_t FlockAgents::size() const
+{
+	return PositionX.size();
+}
+
+void FlockAgents::resize(const std::size_t Count)
+{
+	for (std::vector<float>* Component : {&PositionX, &PositionY, &PositionZ, &VelocityX, &VelocityY, &VelocityZ,
+	                                      &AccelerationX, &AccelerationY, &AccelerationZ})
+	{
+		Component->resize(Count, 0.0f);
+	}
+}
+
+FlockSimulation::FlockSimulation(const FlockSettings& Settings)
+	: MSettings(Settings), MAgentHash(Settings.NeighbourRadius),
+	  MObstacleRevision(std::numeric_limits<std::uint64_t>::max())
+{
+}
+
+void FlockSimulation::spawn(const unsigned int Count)
+{
+	std::mt19937_64 Gen(MSettings.Seed);
+	std::uniform_real_distribution<float> UnitDist(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> SpeedDist(MSettings.MinSpeed, MSettings.MaxSpeed);
+
+	// Rejection sampled so agents fill the bounding sphere evenly
+	auto randomInSphere = [&]
+	{
+		glm::vec3 Point;
+		do
+		{
+			Point = glm::vec3(UnitDist(Gen), UnitDist(Gen), UnitDist(Gen));
+		}
+		while (dot(Point, Point) > 1.0f || dot(Point, Point) < 1.0e-4f);
+		return Point;
+	};
+
+	const std::size_t First = MAgents.size();
+	MAgents.resize(First + Count);
+	for (std::size_t I = First; I < MAgents.size(); I++)
+	{
+		const glm::vec3 Position = randomInSphere() * MSettings.BoundsRadius;
+		const glm::vec3 Velocity = normalize(randomInSphere()) * SpeedDist(Gen);
+		MAgents.PositionX[I] = Position.x;
+		MAgents.PositionY[I] = Position.y;
+		MAgents.PositionZ[I] = Position.z;
+		MAgents.VelocityX[I] = Velocity.x;
+		MAgents.VelocityY[I] = Velocity.y;
+		MAgents.VelocityZ[I] = Velocity.z;
+	}
+	MTransforms.resize(MAgents.size());
+	writeTransforms(First, MAgents.size());
+	MPreviousPositions.resize(MAgents.size());
+	for (std::size_t I = First; I < MAgents.size(); I++)
+	{
+		MPreviousPositions[I] = glm::vec3(MTransforms[I][3]);
+	}
+	MStats.Agents = static_cast<unsigned int>(MAgents.size());
+}
+
+void FlockSimulation::setObstacles(const InstancePool& Instances, const Model& Model)
+{
+	if (Instances.getRevision() == MObstacleRevision && MObstacles.size() == Instances.getCount())
+	{
+		return;
+	}
+
+	// Animated instances are avoided as the whole sphere they sweep
+	std::vector<glm::vec4> Spheres(Instances.getCount());
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+	for (unsigned int I = 0; I < Instances.getCount(); I++)
+	{
+		glm::vec3 Center;
+		float Radius;
+		if (InstanceAnimator::isAnimated(Animations[I]))
+		{
+			InstanceAnimator::sweptSphere(Model, Transforms[I], Animations[I], Center, Radius);
+		}
+		else
+		{
+			CollisionGrid::transformSphere(Model, Transforms[I], Center, Radius);
+		}
+		Spheres[I] = glm::vec4(Center, Radius);
+	}
+	setObstacles(Spheres);
+	MObstacleRevision = Instances.getRevision();
+}
+
+void FlockSimulation::setObstacles(const std::vector<glm::vec4>& Spheres)
+{
+	std::vector<float> X(Spheres.size());
+	std::vector<float> Y(Spheres.size());
+	std::vector<float> Z(Spheres.size());
+	float MaxRadius = 0.0f;
+	for (std::size_t I = 0; I < Spheres.size(); I++)
+	{
+		X[I] = Spheres[I].x;
+		Y[I] = Spheres[I].y;
+		Z[I] = Spheres[I].z;
+		MaxRadius = std::max(MaxRadius, Spheres[I].w);
+	}
+
+	// An agent feels any sphere whose margin it's inside, the centre of which is at most this far away
+	MObstacleHash.setCellSize(std::max(MaxRadius + MSettings.AvoidanceMargin, 1.0e-3f));
+	MObstacleHash.build(X.data(), Y.data(), Z.data(), Spheres.size());
+	MObstacles.resize(Spheres.size());
+	const std::vector<std::uint32_t>& Sorted = MObstacleHash.getSorted();
+	for (std::size_t Slot = 0; Slot < Sorted.size(); Slot++)
+	{
+		MObstacles[Slot] = Spheres[Sorted[Slot]];
+	}
+	MStats.Obstacles = static_cast<unsigned int>(Spheres.size());
+}
+
+void FlockSimulation::step(const float DeltaTime)
+{
+	const std::size_t Count = MAgents.size();
+	auto elapsedMs = [](const std::chrono::steady_clock::time_point Start)
+	{
+		const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+		return Elapsed.count();
+	};
+
+	auto Start = std::chrono::steady_clock::now();
+	MAgentHash.setCellSize(MSettings.NeighbourRadius);
+	MAgentHash.build(MAgents.PositionX.data(), MAgents.PositionY.data(), MAgents.PositionZ.data(), Count);
+	MNeighbours.resize(Count);
+	const std::vector<std::uint32_t>& Sorted = MAgentHash.getSorted();
+	Parallel::forRange(Count, IntegrateGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t Slot = Begin; Slot < End; Slot++)
+		{
+			const std::uint32_t I = Sorted[Slot];
+			MNeighbours[Slot] = {{MAgents.PositionX[I], MAgents.PositionY[I], MAgents.PositionZ[I]}, I,
+			                     {MAgents.VelocityX[I], MAgents.VelocityY[I], MAgents.VelocityZ[I]}, 0.0f};
+		}
+	});
+	MStats.HashMilliseconds = elapsedMs(Start);
+
+	// Steering only reads the gathered state, integration waits for every agent's acceleration
+	Start = std::chrono::steady_clock::now();
+	std::atomic<unsigned long long> Neighbours{0};
+	Parallel::forRange(Count, SteerGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		unsigned long long RangeNeighbours = 0;
+		steer(Begin, End, RangeNeighbours);
+		Neighbours.fetch_add(RangeNeighbours, std::memory_order_relaxed);
+	});
+	MStats.SteerMilliseconds = elapsedMs(Start);
+	MStats.Neighbours = Count > 0 ? static_cast<double>(Neighbours.load()) / static_cast<double>(Count) : 0.0;
+
+	// Split on whole blocks of eight, so an agent takes the same kernel path whatever the thread count. The
+	// AVX2 kernel may fuse multiplies into adds, which changes the last bit against the narrower kernels
+	Start = std::chrono::steady_clock::now();
+	const std::size_t BlockCount = (Count + 7) / 8;
+	MPreviousPositions.resize(Count);
+	Parallel::forRange(BlockCount, IntegrateGrain / 8, [&](const std::size_t Begin, const std::size_t End)
+	{
+		const std::size_t EndAgent = std::min(End * 8, Count);
+		for (std::size_t I = Begin * 8; I < EndAgent; I++)
+		{
+			MPreviousPositions[I] = glm::vec3(MAgents.PositionX[I], MAgents.PositionY[I], MAgents.PositionZ[I]);
+		}
+		integrate(MAgents, Begin * 8, EndAgent, DeltaTime, MSettings.MinSpeed, MSettings.MaxSpeed);
+	});
+	MStats.IntegrateMilliseconds = elapsedMs(Start);
+
+	Start = std::chrono::steady_clock::now();
+	MTransforms.resize(Count);
+	Parallel::forRange(Count, IntegrateGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		writeTransforms(Begin, End);
+	});
+	MStats.TransformMilliseconds = elapsedMs(Start);
+	MStats.Agents = static_cast<unsigned int>(Count);
+}
+
+void FlockSimulation::interpolate(const float Alpha)
+{
+	// Headings stay at the latest step, a step's turn is too small to see
+	Parallel::forRange(MTransforms.size(), IntegrateGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			const glm::vec3 Current(MAgents.PositionX[I], MAgents.PositionY[I], MAgents.PositionZ[I]);
+			MTransforms[I][3] = glm::vec4(mix(MPreviousPositions[I], Current, Alpha), 1.0f);
+		}
+	});
+}
+
+void FlockSimulation::steer(const std::size_t BeginSlot, const std::size_t EndSlot, unsigned long long& Neighbours)
+{
+	const float NeighbourRadiusSq = MSettings.NeighbourRadius * MSettings.NeighbourRadius;
+	const float SeparationRadiusSq = MSettings.SeparationRadius * MSettings.SeparationRadius;
+
+	// Agents are taken in hash order too, consecutive ones mostly walk the same cells
+	for (std::size_t AgentSlot = BeginSlot; AgentSlot < EndSlot; AgentSlot++)
+	{
+		const Neighbour& Agent = MNeighbours[AgentSlot];
+		const glm::vec3 Position = Agent.Position;
+
+		glm::vec3 Separation(0.0f);
+		glm::vec3 VelocitySum(0.0f);
+		glm::vec3 PositionSum(0.0f);
+		unsigned int Count = 0;
+		MAgentHash.forEachNear(Position, [&](const std::uint32_t Slot)
+		{
+			const Neighbour& Other = MNeighbours[Slot];
+			if (Other.Index == Agent.Index || Count >= MSettings.MaxNeighbours)
+			{
+				return;
+			}
+			const glm::vec3 Offset = Other.Position - Position;
+			const float DistanceSq = dot(Offset, Offset);
+			if (DistanceSq >= NeighbourRadiusSq)
+			{
+				return;
+			}
+			Count++;
+			VelocitySum += Other.Velocity;
+			PositionSum += Other.Position;
+
+			// Inverse distance push, strongest when nearly touching
+			if (DistanceSq < SeparationRadiusSq && DistanceSq > 1.0e-8f)
+			{
+				Separation -= Offset / DistanceSq;
+			}
+		});
+		Neighbours += Count;
+
+		glm::vec3 Steering = Separation * MSettings.SeparationWeight;
+		if (Count > 0)
+		{
+			const float InverseCount = 1.0f / static_cast<float>(Count);
+			Steering += (VelocitySum * InverseCount - Agent.Velocity) * MSettings.AlignmentWeight;
+			Steering += (PositionSum * InverseCount - Position) * MSettings.CohesionWeight;
+		}
+
+		// Push out of each obstacle's margin, harder the deeper in
+		MObstacleHash.forEachNear(Position, [&](const std::uint32_t Slot)
+		{
+			const glm::vec4& Sphere = MObstacles[Slot];
+			const glm::vec3 Away = Position - glm::vec3(Sphere);
+			const float Reach = Sphere.w + MSettings.AvoidanceMargin;
+			const float DistanceSq = dot(Away, Away);
+			if (DistanceSq >= Reach * Reach || DistanceSq < 1.0e-8f)
+			{
+				return;
+			}
+			const float Distance = std::sqrt(DistanceSq);
+			Steering += Away / Distance * ((Reach - Distance) / MSettings.AvoidanceMargin * MSettings.AvoidanceWeight);
+		});
+
+		const float Radius = length(Position);
+		if (Radius > MSettings.BoundsRadius)
+		{
+			Steering -= Position / Radius * ((Radius - MSettings.BoundsRadius) * MSettings.BoundsWeight);
+		}
+
+		const float Magnitude = length(Steering);
+		if (Magnitude > MSettings.MaxAcceleration)
+		{
+			Steering *= MSettings.MaxAcceleration / Magnitude;
+		}
+		MAgents.AccelerationX[Agent.Index] = Steering.x;
+		MAgents.AccelerationY[Agent.Index] = Steering.y;
+		MAgents.AccelerationZ[Agent.Index] = Steering.z;
+	}
+}
+
+void FlockSimulation::writeTransforms(const std::size_t Begin, const std::size_t End)
+{
+	const float Scale = MSettings.ShipScale;
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		glm::vec3 Forward(MAgents.VelocityX[I], MAgents.VelocityY[I], MAgents.VelocityZ[I]);
+		const float Speed = length(Forward);
+		Forward = Speed > 1.0e-6f ? Forward / Speed : glm::vec3(0.0f, 0.0f, 1.0f);
+
+		// Banking is ignored, the ship stays as upright as its heading allows
+		glm::vec3 Up = glm::vec3(0.0f, 1.0f, 0.0f) - Forward * Forward.y;
+		const float UpLength = length(Up);
+		Up = UpLength > 1.0e-4f ? Up / UpLength : glm::vec3(1.0f, 0.0f, 0.0f);
+
+		// The ship's nose is model -X, the same mapping as the moving object's turn to face +Z
+		const glm::vec3 Side = -Forward;
+		glm::mat4& Transform = MTransforms[I];
+		Transform[0] = glm::vec4(Side * Scale, 0.0f);
+		Transform[1] = glm::vec4(Up * Scale, 0.0f);
+		Transform[2] = glm::vec4(cross(Side, Up) * Scale, 0.0f);
+		Transform[3] = glm::vec4(MAgents.PositionX[I], MAgents.PositionY[I], MAgents.PositionZ[I], 1.0f);
+	}
+}
+
+std::size_t FlockSimulation::getCount() const
+{
+	return MAgents.size();
+}
+
+const FlockAgents& FlockSimulation::getAgents() const
+{
+	return MAgents;
+}
+
+const std::vector<glm::mat4>& FlockSimulation::getTransforms() const
+{
+	return MTransforms;
+}
+
+const FlockStats& FlockSimulation::getStats() const
+{
+	return MStats;
+}
+
+FlockSettings& FlockSimulation::getSettings()
+{
+	return MSettings;
+}
+
+void FlockSimulation::integrate(FlockAgents& Agents, const std::size_t Begin, const std::size_t End,
+                                const float DeltaTime, const float MinSpeed, const float MaxSpeed)
+{
+#if SIMD_X86
+	if (Simd::hasAvx2())
+	{
+		integrateAvx2(Agents, Begin, End, DeltaTime, MinSpeed, MaxSpeed);
+	}
+	else
+	{
+		integrateSse(Agents, Begin, End, DeltaTime, MinSpeed, MaxSpeed);
+	}
+#else
+	integrateScalar(Agents, Begin, End, DeltaTime, MinSpeed, MaxSpeed);
+#endif
+}
+
+void FlockSimulation::integrateScalar(FlockAgents& Agents, const std::size_t Begin, const std::size_t End,
+                                      const float DeltaTime, const float MinSpeed, const float MaxSpeed)
+{
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		const float Vx = Agents.VelocityX[I] + Agents.AccelerationX[I] * DeltaTime;
+		const float Vy = Agents.VelocityY[I] + Agents.AccelerationY[I] * DeltaTime;
+		const float Vz = Agents.VelocityZ[I] + Agents.AccelerationZ[I] * DeltaTime;
+
+		// Branch free clamp, the SIMD kernels below do the same per lane
+		const float Speed = std::sqrt(Vx * Vx + Vy * Vy + Vz * Vz);
+		const float Rescale = std::min(std::max(Speed, MinSpeed), MaxSpeed) / std::max(Speed, 1.0e-6f);
+		Agents.VelocityX[I] = Vx * Rescale;
+		Agents.VelocityY[I] = Vy * Rescale;
+		Agents.VelocityZ[I] = Vz * Rescale;
+		Agents.PositionX[I] += Agents.VelocityX[I] * DeltaTime;
+		Agents.PositionY[I] += Agents.VelocityY[I] * DeltaTime;
+		Agents.PositionZ[I] += Agents.VelocityZ[I] * DeltaTime;
+	}
+}
+
+void FlockSimulation::integrateSse(FlockAgents& Agents, const std::size_t Begin, const std::size_t End,
+                                   const float DeltaTime, const float MinSpeed, const float MaxSpeed)
+{
+	std::size_t I = Begin;
+#if SIMD_X86
+	const __m128 Dt = _mm_set1_ps(DeltaTime);
+	const __m128 Min = _mm_set1_ps(MinSpeed);
+	const __m128 Max = _mm_set1_ps(MaxSpeed);
+	const __m128 Epsilon = _mm_set1_ps(1.0e-6f);
+
+	// Four agents per iteration, one lane each
+	for (; I + 4 <= End; I += 4)
+	{
+		const __m128 Vx = _mm_add_ps(_mm_loadu_ps(&Agents.VelocityX[I]),
+		                             _mm_mul_ps(_mm_loadu_ps(&Agents.AccelerationX[I]), Dt));
+		const __m128 Vy = _mm_add_ps(_mm_loadu_ps(&Agents.VelocityY[I]),
+		                             _mm_mul_ps(_mm_loadu_ps(&Agents.AccelerationY[I]), Dt));
+		const __m128 Vz = _mm_add_ps(_mm_loadu_ps(&Agents.VelocityZ[I]),
+		                             _mm_mul_ps(_mm_loadu_ps(&Agents.AccelerationZ[I]), Dt));
+		const __m128 Speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Vx, Vx), _mm_mul_ps(Vy, Vy)),
+		                                            _mm_mul_ps(Vz, Vz)));
+		const __m128 Rescale = _mm_div_ps(_mm_min_ps(_mm_max_ps(Speed, Min), Max), _mm_max_ps(Speed, Epsilon));
+		const __m128 Nx = _mm_mul_ps(Vx, Rescale);
+		const __m128 Ny = _mm_mul_ps(Vy, Rescale);
+		const __m128 Nz = _mm_mul_ps(Vz, Rescale);
+		_mm_storeu_ps(&Agents.VelocityX[I], Nx);
+		_mm_storeu_ps(&Agents.VelocityY[I], Ny);
+		_mm_storeu_ps(&Agents.VelocityZ[I], Nz);
+		_mm_storeu_ps(&Agents.PositionX[I], _mm_add_ps(_mm_loadu_ps(&Agents.PositionX[I]), _mm_mul_ps(Nx, Dt)));
+		_mm_storeu_ps(&Agents.PositionY[I], _mm_add_ps(_mm_loadu_ps(&Agents.PositionY[I]), _mm_mul_ps(Ny, Dt)));
+		_mm_storeu_ps(&Agents.PositionZ[I], _mm_add_ps(_mm_loadu_ps(&Agents.PositionZ[I]), _mm_mul_ps(Nz, Dt)));
+	}
+#endif
+	integrateScalar(Agents, I, End, DeltaTime, MinSpeed, MaxSpeed);
+}
+
+#if SIMD_X86
+SIMD_TARGET_AVX2 static std::size_t integrateAvx2Block(FlockAgents& Agents, std::size_t I, const std::size_t End,
+                                                       const float DeltaTime, const float MinSpeed,
+                                                       const float MaxSpeed)
+{
+	const __m256 Dt = _mm256_set1_ps(DeltaTime);
+	const __m256 Min = _mm256_set1_ps(MinSpeed);
+	const __m256 Max = _mm256_set1_ps(MaxSpeed);
+	const __m256 Epsilon = _mm256_set1_ps(1.0e-6f);
+
+	// Eight agents per iteration, one lane each
+	for (; I + 8 <= End; I += 8)
+	{
+		const __m256 Vx = _mm256_add_ps(_mm256_loadu_ps(&Agents.VelocityX[I]),
+		                                _mm256_mul_ps(_mm256_loadu_ps(&Agents.AccelerationX[I]), Dt));
+		const __m256 Vy = _mm256_add_ps(_mm256_loadu_ps(&Agents.VelocityY[I]),
+		                                _mm256_mul_ps(_mm256_loadu_ps(&Agents.AccelerationY[I]), Dt));
+		const __m256 Vz = _mm256_add_ps(_mm256_loadu_ps(&Agents.VelocityZ[I]),
+		                                _mm256_mul_ps(_mm256_loadu_ps(&Agents.AccelerationZ[I]), Dt));
+		const __m256 Speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(Vx, Vx), _mm256_mul_ps(Vy, Vy)),
+		                                                  _mm256_mul_ps(Vz, Vz)));
+		const __m256 Rescale = _mm256_div_ps(_mm256_min_ps(_mm256_max_ps(Speed, Min), Max),
+		                                     _mm256_max_ps(Speed, Epsilon));
+		const __m256 Nx = _mm256_mul_ps(Vx, Rescale);
+		const __m256 Ny = _mm256_mul_ps(Vy, Rescale);
+		const __m256 Nz = _mm256_mul_ps(Vz, Rescale);
+		_mm256_storeu_ps(&Agents.VelocityX[I], Nx);
+		_mm256_storeu_ps(&Agents.VelocityY[I], Ny);
+		_mm256_storeu_ps(&Agents.VelocityZ[I], Nz);
+		_mm256_storeu_ps(&Agents.PositionX[I],
+		                 _mm256_add_ps(_mm256_loadu_ps(&Agents.PositionX[I]), _mm256_mul_ps(Nx, Dt)));
+		_mm256_storeu_ps(&Agents.PositionY[I],
+		                 _mm256_add_ps(_mm256_loadu_ps(&Agents.PositionY[I]), _mm256_mul_ps(Ny, Dt)));
+		_mm256_storeu_ps(&Agents.PositionZ[I],
+		                 _mm256_add_ps(_mm256_loadu_ps(&Agents.PositionZ[I]), _mm256_mul_ps(Nz, Dt)));
+	}
+	return I;
+}
+#endif
+
+void FlockSimulation::integrateAvx2(FlockAgents& Agents, const std::size_t Begin, const std::size_t End,
+                                    const float DeltaTime, const float MinSpeed, const float MaxSpeed)
+{
+#if SIMD_X86
+	const std::size_t I = integrateAvx2Block(Agents, Begin, End, DeltaTime, MinSpeed, MaxSpeed);
+	integrateSse(Agents, I, End, DeltaTime, MinSpeed, MaxSpeed);
+#else
+	integrateScalar(Agents, Begin, End, DeltaTime, MinSpeed, MaxSpeed);
+#endif
+}
+
+const char* FlockSimulation::getKernelName()
+{
+#if SIMD_X86
+	return Simd::hasAvx2() ? "AVX2 (8 wide)" : "SSE (4 wide)";
+#else
+	return "Scalar";
+#endif
+}
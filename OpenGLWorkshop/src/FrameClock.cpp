@@ -0,0 +1,79 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FrameClock.cpp
+Description : Implementations for the fixed step accumulator
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "FrameClock.h"
+
+#include <algorithm>
+
+FrameClock::FrameClock(const double StepSeconds, const int MaxSteps)
+	: MStep(StepSeconds), MMaxSteps(std::max(MaxSteps, 1)), MStarted(false), MLastTime(0.0), MAccumulator(0.0),
+	  MFrameSeconds(0.0), MSimulationTime(0.0), MDroppedSeconds(0.0), MSteps(0)
+{
+}
+
+int FrameClock::beginFrame(const double Now)
+{
+	MFrameSeconds = MStarted ? std::max(Now - MLastTime, 0.0) : 0.0;
+	MStarted = true;
+	MLastTime = Now;
+	MAccumulator += MFrameSeconds;
+
+	MSteps = static_cast<int>(MAccumulator / MStep);
+	if (MSteps > MMaxSteps)
+	{
+		// A stall such as a window drag, catching up fully would only make the next frame slower still
+		MDroppedSeconds += MAccumulator - MMaxSteps * MStep;
+		MAccumulator = MMaxSteps * MStep;
+		MSteps = MMaxSteps;
+	}
+	MAccumulator -= MSteps * MStep;
+	MSimulationTime += MSteps * MStep;
+	return MSteps;
+}
+
+float FrameClock::getStep() const
+{
+	return static_cast<float>(MStep);
+}
+
+float FrameClock::getAlpha() const
+{
+	return static_cast<float>(std::clamp(MAccumulator / MStep, 0.0, 1.0));
+}
+
+int FrameClock::getSteps() const
+{
+	return MSteps;
+}
+
+double FrameClock::getFrameSeconds() const
+{
+	return MFrameSeconds;
+}
+
+double FrameClock::getSimulationTime() const
+{
+	return MSimulationTime;
+}
+
+double FrameClock::getRenderTime() const
+{
+	// The blend runs a step behind the latest state, from the previous one towards it
+	return MSimulationTime - MStep + MAccumulator;
+}
+
+double FrameClock::getDroppedSeconds() const
+{
+	return MDroppedSeconds;
+}
@@ -0,0 +1,267 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : FrameGraph.cpp
+Description : Implementations for declaring a frame as a graph of tasks
+			  with dependencies, run across the job system's threads
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "TraceRecorder.h"
+
+FrameGraph::FrameGraph()
+	: MThreaded(true), MMainThreadTasks(0), MMainDone(0), MFrameMilliseconds(0.0), MIdleMilliseconds(0.0)
+{
+}
+
+TaskId FrameGraph::addTask(std::string Name, std::function<void()> Body,
+                           const std::initializer_list<TaskId> Dependencies, const TaskAffinity Affinity)
+{
+	const TaskId Id = MTasks.size();
+	MTasks.push_back({std::move(Name), std::move(Body), Affinity, Dependencies, {}, 0.0, 0.0, false});
+	MPending.emplace_back(0);
+	for (const TaskId Dependency : Dependencies)
+	{
+		MTasks[Dependency].Successors.push_back(Id);
+	}
+	if (Affinity == TaskAffinity::MainThread)
+	{
+		MMainThreadTasks++;
+	}
+	return Id;
+}
+
+void FrameGraph::run()
+{
+	MStart = std::chrono::steady_clock::now();
+	MMainThread = std::this_thread::get_id();
+	MIdleMilliseconds = 0.0;
+	for (FrameTask& Task : MTasks)
+	{
+		Task.RanOnMainThread = false;
+	}
+
+	if (!MThreaded)
+	{
+		for (TaskId Task = 0; Task < MTasks.size(); Task++)
+		{
+			execute(Task);
+		}
+		const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - MStart;
+		MFrameMilliseconds = Elapsed.count();
+		return;
+	}
+
+	MMainReady.clear();
+	MMainDone.store(0, std::memory_order_relaxed);
+	for (TaskId Task = 0; Task < MTasks.size(); Task++)
+	{
+		MPending[Task].store(static_cast<int>(MTasks[Task].Dependencies.size()), std::memory_order_relaxed);
+	}
+	for (TaskId Task = 0; Task < MTasks.size(); Task++)
+	{
+		if (MTasks[Task].Dependencies.empty())
+		{
+			release(Task);
+		}
+	}
+
+	// Main thread tasks in the order they were added whenever several are ready, queued jobs otherwise
+	while (MMainDone.load(std::memory_order_acquire) < MMainThreadTasks)
+	{
+		TaskId Ready = MTasks.size();
+		{
+			std::lock_guard<std::mutex> Lock(MReadyMutex);
+			const auto First = std::min_element(MMainReady.begin(), MMainReady.end());
+			if (First != MMainReady.end())
+			{
+				Ready = *First;
+				MMainReady.erase(First);
+			}
+		}
+		if (Ready != MTasks.size())
+		{
+			execute(Ready);
+			continue;
+		}
+		if (!JobSystem::tryRunJob())
+		{
+			std::this_thread::yield();
+		}
+	}
+	JobSystem::wait(MWorkers);
+
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - MStart;
+	MFrameMilliseconds = Elapsed.count();
+	MIdleMilliseconds = MFrameMilliseconds;
+	for (const FrameTask& Task : MTasks)
+	{
+		if (Task.RanOnMainThread)
+		{
+			MIdleMilliseconds -= Task.Milliseconds;
+		}
+	}
+	MIdleMilliseconds = std::max(MIdleMilliseconds, 0.0);
+}
+
+void FrameGraph::setThreaded(const bool Threaded)
+{
+	MThreaded = Threaded;
+}
+
+bool FrameGraph::isThreaded() const
+{
+	return MThreaded;
+}
+
+const std::deque<FrameTask>& FrameGraph::getTasks() const
+{
+	return MTasks;
+}
+
+const FrameTask& FrameGraph::getTask(const TaskId Task) const
+{
+	return MTasks[Task];
+}
+
+double FrameGraph::getFrameMilliseconds() const
+{
+	return MFrameMilliseconds;
+}
+
+double FrameGraph::getIdleMilliseconds() const
+{
+	return MIdleMilliseconds;
+}
+
+std::vector<TaskId> FrameGraph::getCriticalPath() const
+{
+	// Dependencies always come first, so one pass in order finds the longest chain ending at each task
+	std::vector<double> Longest(MTasks.size(), 0.0);
+	std::vector<TaskId> Previous(MTasks.size(), MTasks.size());
+	TaskId Last = MTasks.size();
+	for (TaskId Task = 0; Task < MTasks.size(); Task++)
+	{
+		for (const TaskId Dependency : MTasks[Task].Dependencies)
+		{
+			if (Previous[Task] == MTasks.size() || Longest[Dependency] > Longest[Previous[Task]])
+			{
+				Previous[Task] = Dependency;
+			}
+		}
+		Longest[Task] = MTasks[Task].Milliseconds;
+		if (Previous[Task] != MTasks.size())
+		{
+			Longest[Task] += Longest[Previous[Task]];
+		}
+		if (Last == MTasks.size() || Longest[Task] > Longest[Last])
+		{
+			Last = Task;
+		}
+	}
+
+	std::vector<TaskId> Path;
+	for (TaskId Task = Last; Task != MTasks.size(); Task = Previous[Task])
+	{
+		Path.push_back(Task);
+	}
+	std::reverse(Path.begin(), Path.end());
+	return Path;
+}
+
+double FrameGraph::getCriticalPathMilliseconds() const
+{
+	double Total = 0.0;
+	for (const TaskId Task : getCriticalPath())
+	{
+		Total += MTasks[Task].Milliseconds;
+	}
+	return Total;
+}
+
+void FrameGraph::printTasks(std::ostream& Out) const
+{
+	Out << "Frame graph (" << MTasks.size() << " tasks, " << (MThreaded ? "threaded" : "serial") << ", "
+		<< MFrameMilliseconds << " ms, caller idle " << MIdleMilliseconds << " ms)\n";
+	for (const FrameTask& Task : MTasks)
+	{
+		Out << "  " << std::left << std::setw(14) << Task.Name << std::right
+			<< (Task.Affinity == TaskAffinity::MainThread ? " main only" : " any      ")
+			<< (Task.RanOnMainThread ? " ran on main  " : " ran on worker") << " start " << std::setw(8)
+			<< Task.StartMilliseconds << " ms, took " << std::setw(8) << Task.Milliseconds << " ms";
+		if (!Task.Dependencies.empty())
+		{
+			Out << ", after";
+			for (const TaskId Dependency : Task.Dependencies)
+			{
+				Out << " " << MTasks[Dependency].Name;
+			}
+		}
+		Out << "\n";
+	}
+}
+
+void FrameGraph::printCriticalPath(std::ostream& Out) const
+{
+	Out << "Critical path " << getCriticalPathMilliseconds() << " of " << MFrameMilliseconds << " ms:";
+	const std::vector<TaskId> Path = getCriticalPath();
+	for (std::size_t I = 0; I < Path.size(); I++)
+	{
+		Out << (I == 0 ? " " : " > ") << MTasks[Path[I]].Name << " " << MTasks[Path[I]].Milliseconds;
+	}
+	Out << "\n";
+}
+
+void FrameGraph::release(const TaskId Task)
+{
+	if (MTasks[Task].Affinity == TaskAffinity::MainThread)
+	{
+		std::lock_guard<std::mutex> Lock(MReadyMutex);
+		MMainReady.push_back(Task);
+		return;
+	}
+
+	JobSystem::submit({[](const Job& Work)
+	{
+		static_cast<FrameGraph*>(Work.Data)->execute(Work.Begin);
+	}, this, Task, Task + 1, 0, &MWorkers, nullptr});
+}
+
+void FrameGraph::execute(const TaskId Task)
+{
+	FrameTask& Entry = MTasks[Task];
+	const auto Start = std::chrono::steady_clock::now();
+	Entry.Body();
+	const auto End = std::chrono::steady_clock::now();
+	Entry.StartMilliseconds = std::chrono::duration<double, std::milli>(Start - MStart).count();
+	Entry.Milliseconds = std::chrono::duration<double, std::milli>(End - Start).count();
+	Entry.RanOnMainThread = std::this_thread::get_id() == MMainThread;
+	TraceRecorder::record(TraceCategory::Task, Entry.Name.c_str(), TraceRecorder::toNanoseconds(Start),
+	                      TraceRecorder::toNanoseconds(End));
+
+	if (MThreaded)
+	{
+		for (const TaskId Successor : Entry.Successors)
+		{
+			if (MPending[Successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				release(Successor);
+			}
+		}
+	}
+	if (Entry.Affinity == TaskAffinity::MainThread)
+	{
+		MMainDone.fetch_add(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,1147 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlCapture.cpp
+Description : Implementations for recording every GL call with the contents
+			  it passes into a binary trace, for replaying offline
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#define GL_CORE_DIRECT // The pointers are defined here, starting at the driver's own functions
+#include "GlCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+namespace GlCore
+{
+	decltype(&::glBlendFunc) BlendFunc = ::glBlendFunc;
+	decltype(&::glClear) Clear = ::glClear;
+	decltype(&::glClearColor) ClearColor = ::glClearColor;
+	decltype(&::glCullFace) CullFace = ::glCullFace;
+	decltype(&::glDeleteTextures) DeleteTextures = ::glDeleteTextures;
+	decltype(&::glDepthFunc) DepthFunc = ::glDepthFunc;
+	decltype(&::glDepthMask) DepthMask = ::glDepthMask;
+	decltype(&::glDisable) Disable = ::glDisable;
+	decltype(&::glDrawArrays) DrawArrays = ::glDrawArrays;
+	decltype(&::glDrawElements) DrawElements = ::glDrawElements;
+	decltype(&::glEnable) Enable = ::glEnable;
+	decltype(&::glFinish) Finish = ::glFinish;
+	decltype(&::glGetError) GetError = ::glGetError;
+	decltype(&::glGetFloatv) GetFloatv = ::glGetFloatv;
+	decltype(&::glGetIntegerv) GetIntegerv = ::glGetIntegerv;
+	decltype(&::glPolygonMode) PolygonMode = ::glPolygonMode;
+	decltype(&::glReadPixels) ReadPixels = ::glReadPixels;
+	decltype(&::glViewport) Viewport = ::glViewport;
+}
+
+namespace
+{
+	constexpr std::size_t FlushBytes = 1 << 20; // Written out in pieces of about this much
+	constexpr std::size_t UnpackAlignment = 4; // GL's default, which the app never changes
+
+	constexpr const char* CallNames[] = {
+		"glAttachShader", "glBindBuffer", "glBindFramebuffer", "glBindRenderbuffer", "glBindTextureUnit",
+		"glBindVertexArray", "glBlendFunc", "glBlitNamedFramebuffer", "glCheckFramebufferStatus",
+		"glCheckNamedFramebufferStatus", "glClear", "glClearColor", "glClearNamedFramebufferfv", "glClientWaitSync",
+		"glCompileShader", "glCopyNamedBufferSubData", "glCreateBuffers", "glCreateFramebuffers", "glCreateProgram",
+		"glCreateQueries", "glCreateRenderbuffers", "glCreateShader", "glCreateTextures", "glCreateVertexArrays",
+		"glCullFace", "glDeleteBuffers", "glDeleteFramebuffers", "glDeleteProgram", "glDeleteQueries",
+		"glDeleteRenderbuffers", "glDeleteShader", "glDeleteSync", "glDeleteTextures", "glDeleteVertexArrays",
+		"glDepthFunc", "glDepthMask", "glDisable", "glDisableVertexArrayAttrib", "glDrawArrays",
+		"glDrawArraysInstancedBaseInstance", "glDrawElements", "glDrawElementsInstancedBaseInstance", "glEnable",
+		"glEnableVertexArrayAttrib", "glFenceSync", "glFinish", "glFramebufferRenderbuffer",
+		"glFramebufferTexture2D", "glGenFramebuffers", "glGenRenderbuffers", "glGenerateTextureMipmap",
+		"glGetError", "glGetFloatv", "glGetInteger64v", "glGetIntegerv", "glGetNamedBufferParameteriv",
+		"glGetNamedBufferSubData", "glGetProgramInfoLog", "glGetProgramiv", "glGetQueryObjectiv",
+		"glGetQueryObjectui64v", "glGetShaderInfoLog", "glGetShaderiv", "glGetTextureImage",
+		"glGetTextureLevelParameteriv", "glGetUniformLocation", "glLinkProgram", "glMapNamedBufferRange",
+		"glNamedBufferData", "glNamedBufferStorage", "glNamedBufferSubData", "glNamedFramebufferRenderbuffer",
+		"glNamedFramebufferTexture", "glNamedRenderbufferStorage", "glPolygonMode", "glQueryCounter",
+		"glReadPixels", "glRenderbufferStorage", "glShaderSource", "glTextureParameteri", "glTextureStorage2D",
+		"glTextureSubImage2D", "glUniform1f", "glUniform1i", "glUniform2fv", "glUniform3fv", "glUniform4fv",
+		"glUniformMatrix4fv", "glUseProgram", "glVertexArrayAttribBinding", "glVertexArrayAttribFormat",
+		"glVertexArrayBindingDivisor", "glVertexArrayElementBuffer", "glVertexArrayVertexBuffer", "glViewport",
+		"mapped write", "end frame"
+	};
+	static_assert(sizeof(CallNames) / sizeof(CallNames[0]) == static_cast<std::size_t>(GlCall::Count));
+
+	// Memory a buffer was mapped to while capturing
+	struct MappedRange
+	{
+		GLuint Buffer;
+		std::uint64_t Offset; // Of the memory's start, into the buffer
+		const unsigned char* Memory;
+		std::size_t Size;
+	};
+
+	// The functions swapped out while capturing, which the hooks standing in for them call
+	struct DriverFunctions
+	{
+		PFNGLATTACHSHADERPROC AttachShader;
+		PFNGLBINDBUFFERPROC BindBuffer;
+		PFNGLBINDFRAMEBUFFERPROC BindFramebuffer;
+		PFNGLBINDRENDERBUFFERPROC BindRenderbuffer;
+		PFNGLBINDTEXTUREUNITPROC BindTextureUnit;
+		PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+		decltype(GlCore::BlendFunc) BlendFunc;
+		PFNGLBLITNAMEDFRAMEBUFFERPROC BlitNamedFramebuffer;
+		PFNGLCHECKFRAMEBUFFERSTATUSPROC CheckFramebufferStatus;
+		PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC CheckNamedFramebufferStatus;
+		decltype(GlCore::Clear) Clear;
+		decltype(GlCore::ClearColor) ClearColor;
+		PFNGLCLEARNAMEDFRAMEBUFFERFVPROC ClearNamedFramebufferfv;
+		PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+		PFNGLCOMPILESHADERPROC CompileShader;
+		PFNGLCOPYNAMEDBUFFERSUBDATAPROC CopyNamedBufferSubData;
+		PFNGLCREATEBUFFERSPROC CreateBuffers;
+		PFNGLCREATEFRAMEBUFFERSPROC CreateFramebuffers;
+		PFNGLCREATEPROGRAMPROC CreateProgram;
+		PFNGLCREATEQUERIESPROC CreateQueries;
+		PFNGLCREATERENDERBUFFERSPROC CreateRenderbuffers;
+		PFNGLCREATESHADERPROC CreateShader;
+		PFNGLCREATETEXTURESPROC CreateTextures;
+		PFNGLCREATEVERTEXARRAYSPROC CreateVertexArrays;
+		decltype(GlCore::CullFace) CullFace;
+		PFNGLDELETEBUFFERSPROC DeleteBuffers;
+		PFNGLDELETEFRAMEBUFFERSPROC DeleteFramebuffers;
+		PFNGLDELETEPROGRAMPROC DeleteProgram;
+		PFNGLDELETEQUERIESPROC DeleteQueries;
+		PFNGLDELETERENDERBUFFERSPROC DeleteRenderbuffers;
+		PFNGLDELETESHADERPROC DeleteShader;
+		PFNGLDELETESYNCPROC DeleteSync;
+		decltype(GlCore::DeleteTextures) DeleteTextures;
+		PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
+		decltype(GlCore::DepthFunc) DepthFunc;
+		decltype(GlCore::DepthMask) DepthMask;
+		decltype(GlCore::Disable) Disable;
+		PFNGLDISABLEVERTEXARRAYATTRIBPROC DisableVertexArrayAttrib;
+		decltype(GlCore::DrawArrays) DrawArrays;
+		PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC DrawArraysInstancedBaseInstance;
+		decltype(GlCore::DrawElements) DrawElements;
+		PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC DrawElementsInstancedBaseInstance;
+		decltype(GlCore::Enable) Enable;
+		PFNGLENABLEVERTEXARRAYATTRIBPROC EnableVertexArrayAttrib;
+		PFNGLFENCESYNCPROC FenceSync;
+		decltype(GlCore::Finish) Finish;
+		PFNGLFRAMEBUFFERRENDERBUFFERPROC FramebufferRenderbuffer;
+		PFNGLFRAMEBUFFERTEXTURE2DPROC FramebufferTexture2D;
+		PFNGLGENFRAMEBUFFERSPROC GenFramebuffers;
+		PFNGLGENRENDERBUFFERSPROC GenRenderbuffers;
+		PFNGLGENERATETEXTUREMIPMAPPROC GenerateTextureMipmap;
+		decltype(GlCore::GetError) GetError;
+		decltype(GlCore::GetFloatv) GetFloatv;
+		PFNGLGETINTEGER64VPROC GetInteger64v;
+		decltype(GlCore::GetIntegerv) GetIntegerv;
+		PFNGLGETNAMEDBUFFERPARAMETERIVPROC GetNamedBufferParameteriv;
+		PFNGLGETNAMEDBUFFERSUBDATAPROC GetNamedBufferSubData;
+		PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+		PFNGLGETPROGRAMIVPROC GetProgramiv;
+		PFNGLGETQUERYOBJECTIVPROC GetQueryObjectiv;
+		PFNGLGETQUERYOBJECTUI64VPROC GetQueryObjectui64v;
+		PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+		PFNGLGETSHADERIVPROC GetShaderiv;
+		PFNGLGETTEXTUREIMAGEPROC GetTextureImage;
+		PFNGLGETTEXTURELEVELPARAMETERIVPROC GetTextureLevelParameteriv;
+		PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+		PFNGLLINKPROGRAMPROC LinkProgram;
+		PFNGLMAPNAMEDBUFFERRANGEPROC MapNamedBufferRange;
+		PFNGLNAMEDBUFFERDATAPROC NamedBufferData;
+		PFNGLNAMEDBUFFERSTORAGEPROC NamedBufferStorage;
+		PFNGLNAMEDBUFFERSUBDATAPROC NamedBufferSubData;
+		PFNGLNAMEDFRAMEBUFFERRENDERBUFFERPROC NamedFramebufferRenderbuffer;
+		PFNGLNAMEDFRAMEBUFFERTEXTUREPROC NamedFramebufferTexture;
+		PFNGLNAMEDRENDERBUFFERSTORAGEPROC NamedRenderbufferStorage;
+		decltype(GlCore::PolygonMode) PolygonMode;
+		PFNGLQUERYCOUNTERPROC QueryCounter;
+		decltype(GlCore::ReadPixels) ReadPixels;
+		PFNGLRENDERBUFFERSTORAGEPROC RenderbufferStorage;
+		PFNGLSHADERSOURCEPROC ShaderSource;
+		PFNGLTEXTUREPARAMETERIPROC TextureParameteri;
+		PFNGLTEXTURESTORAGE2DPROC TextureStorage2D;
+		PFNGLTEXTURESUBIMAGE2DPROC TextureSubImage2D;
+		PFNGLUNIFORM1FPROC Uniform1f;
+		PFNGLUNIFORM1IPROC Uniform1i;
+		PFNGLUNIFORM2FVPROC Uniform2fv;
+		PFNGLUNIFORM3FVPROC Uniform3fv;
+		PFNGLUNIFORM4FVPROC Uniform4fv;
+		PFNGLUNIFORMMATRIX4FVPROC UniformMatrix4fv;
+		PFNGLUSEPROGRAMPROC UseProgram;
+		PFNGLVERTEXARRAYATTRIBBINDINGPROC VertexArrayAttribBinding;
+		PFNGLVERTEXARRAYATTRIBFORMATPROC VertexArrayAttribFormat;
+		PFNGLVERTEXARRAYBINDINGDIVISORPROC VertexArrayBindingDivisor;
+		PFNGLVERTEXARRAYELEMENTBUFFERPROC VertexArrayElementBuffer;
+		PFNGLVERTEXARRAYVERTEXBUFFERPROC VertexArrayVertexBuffer;
+		decltype(GlCore::Viewport) Viewport;
+	};
+
+	DriverFunctions GDriver{};
+	std::ofstream GFile;
+	std::vector<unsigned char> GPending; // Recorded and not yet written out
+	std::vector<MappedRange> GMappings;
+	GlCaptureStats GStats{};
+	bool GRecording = false;
+
+	template <typename Value>
+	void put(const Value& Written)
+	{
+		static_assert(std::is_trivially_copyable_v<Value>);
+		const auto* Bytes = reinterpret_cast<const unsigned char*>(&Written);
+		GPending.insert(GPending.end(), Bytes, Bytes + sizeof(Value));
+	}
+
+	void putContents(const void* Data, const std::size_t Size)
+	{
+		put(static_cast<std::uint64_t>(Size));
+		const auto* Bytes = static_cast<const unsigned char*>(Data);
+		GPending.insert(GPending.end(), Bytes, Bytes + Size);
+		GStats.ContentBytes += Size;
+	}
+
+	void putNames(const GLsizei Count, const GLuint* Names)
+	{
+		put(Count);
+		for (GLsizei I = 0; I < Count; I++)
+		{
+			put(Names[I]);
+		}
+	}
+
+	void writePending()
+	{
+		GFile.write(reinterpret_cast<const char*>(GPending.data()), static_cast<std::streamsize>(GPending.size()));
+		GStats.Bytes += GPending.size();
+		GPending.clear();
+	}
+
+	// Starts the record of a call with the arguments every call of it has, anything else follows
+	template <typename... Values>
+	void record(const GlCall Call, const Values&... Arguments)
+	{
+		if (GPending.size() >= FlushBytes)
+		{
+			writePending();
+		}
+		put(static_cast<std::uint8_t>(Call));
+		(put(Arguments), ...);
+		if (Call != GlCall::MappedWrite && Call != GlCall::EndFrame)
+		{
+			GStats.Calls++;
+		}
+	}
+
+	std::int64_t toInt64(const GLintptr Value)
+	{
+		return static_cast<std::int64_t>(Value);
+	}
+
+	std::uint64_t toHandle(const GLsync Sync)
+	{
+		return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(Sync));
+	}
+
+	// Bytes GL reads from an upload of a Width by Height image, each row starting aligned as GL unpacks them
+	std::size_t imageBytes(const GLsizei Width, const GLsizei Height, const GLenum Format, const GLenum Type)
+	{
+		if (Width <= 0 || Height <= 0)
+		{
+			return 0;
+		}
+		const std::size_t Components = Format == GL_RED || Format == GL_DEPTH_COMPONENT ? 1
+			: Format == GL_RG ? 2 : Format == GL_RGB || Format == GL_BGR ? 3 : 4;
+		const std::size_t ComponentBytes = Type == GL_FLOAT || Type == GL_UNSIGNED_INT || Type == GL_INT ? 4
+			: Type == GL_UNSIGNED_SHORT || Type == GL_SHORT || Type == GL_HALF_FLOAT ? 2 : 1;
+		const std::size_t RowBytes = static_cast<std::size_t>(Width) * Components * ComponentBytes;
+		const std::size_t Stride = (RowBytes + UnpackAlignment - 1) / UnpackAlignment * UnpackAlignment;
+		return Stride * static_cast<std::size_t>(Height - 1) + RowBytes;
+	}
+
+	void GLAPIENTRY captureAttachShader(const GLuint Program, const GLuint Shader)
+	{
+		GDriver.AttachShader(Program, Shader);
+		record(GlCall::AttachShader, Program, Shader);
+	}
+
+	void GLAPIENTRY captureBindBuffer(const GLenum Target, const GLuint Buffer)
+	{
+		GDriver.BindBuffer(Target, Buffer);
+		record(GlCall::BindBuffer, Target, Buffer);
+	}
+
+	void GLAPIENTRY captureBindFramebuffer(const GLenum Target, const GLuint Framebuffer)
+	{
+		GDriver.BindFramebuffer(Target, Framebuffer);
+		record(GlCall::BindFramebuffer, Target, Framebuffer);
+	}
+
+	void GLAPIENTRY captureBindRenderbuffer(const GLenum Target, const GLuint Renderbuffer)
+	{
+		GDriver.BindRenderbuffer(Target, Renderbuffer);
+		record(GlCall::BindRenderbuffer, Target, Renderbuffer);
+	}
+
+	void GLAPIENTRY captureBindTextureUnit(const GLuint Unit, const GLuint Texture)
+	{
+		GDriver.BindTextureUnit(Unit, Texture);
+		record(GlCall::BindTextureUnit, Unit, Texture);
+	}
+
+	void GLAPIENTRY captureBindVertexArray(const GLuint Vao)
+	{
+		GDriver.BindVertexArray(Vao);
+		record(GlCall::BindVertexArray, Vao);
+	}
+
+	void GLAPIENTRY captureBlendFunc(const GLenum Source, const GLenum Destination)
+	{
+		GDriver.BlendFunc(Source, Destination);
+		record(GlCall::BlendFunc, Source, Destination);
+	}
+
+	void GLAPIENTRY captureBlitNamedFramebuffer(const GLuint Read, const GLuint Draw, const GLint SourceX0,
+	                                            const GLint SourceY0, const GLint SourceX1, const GLint SourceY1,
+	                                            const GLint DestinationX0, const GLint DestinationY0,
+	                                            const GLint DestinationX1, const GLint DestinationY1,
+	                                            const GLbitfield Mask, const GLenum Filter)
+	{
+		GDriver.BlitNamedFramebuffer(Read, Draw, SourceX0, SourceY0, SourceX1, SourceY1, DestinationX0,
+		                             DestinationY0, DestinationX1, DestinationY1, Mask, Filter);
+		record(GlCall::BlitNamedFramebuffer, Read, Draw, SourceX0, SourceY0, SourceX1, SourceY1, DestinationX0,
+		       DestinationY0, DestinationX1, DestinationY1, Mask, Filter);
+	}
+
+	GLenum GLAPIENTRY captureCheckFramebufferStatus(const GLenum Target)
+	{
+		const GLenum Status = GDriver.CheckFramebufferStatus(Target);
+		record(GlCall::CheckFramebufferStatus, Target);
+		return Status;
+	}
+
+	GLenum GLAPIENTRY captureCheckNamedFramebufferStatus(const GLuint Framebuffer, const GLenum Target)
+	{
+		const GLenum Status = GDriver.CheckNamedFramebufferStatus(Framebuffer, Target);
+		record(GlCall::CheckNamedFramebufferStatus, Framebuffer, Target);
+		return Status;
+	}
+
+	void GLAPIENTRY captureClear(const GLbitfield Mask)
+	{
+		GDriver.Clear(Mask);
+		record(GlCall::Clear, Mask);
+	}
+
+	void GLAPIENTRY captureClearColor(const GLfloat Red, const GLfloat Green, const GLfloat Blue, const GLfloat Alpha)
+	{
+		GDriver.ClearColor(Red, Green, Blue, Alpha);
+		record(GlCall::ClearColor, Red, Green, Blue, Alpha);
+	}
+
+	void GLAPIENTRY captureClearNamedFramebufferfv(const GLuint Framebuffer, const GLenum Buffer,
+	                                               const GLint DrawBuffer, GLfloat* Value)
+	{
+		GDriver.ClearNamedFramebufferfv(Framebuffer, Buffer, DrawBuffer, Value);
+		GLfloat Values[4]{}; // Depth reads only the first
+		std::memcpy(Values, Value, (Buffer == GL_COLOR ? 4 : 1) * sizeof(GLfloat));
+		record(GlCall::ClearNamedFramebufferfv, Framebuffer, Buffer, DrawBuffer, Values);
+	}
+
+	GLenum GLAPIENTRY captureClientWaitSync(const GLsync Sync, const GLbitfield Flags, const GLuint64 Timeout)
+	{
+		const GLenum Result = GDriver.ClientWaitSync(Sync, Flags, Timeout);
+		record(GlCall::ClientWaitSync, toHandle(Sync), Flags, Timeout);
+		return Result;
+	}
+
+	void GLAPIENTRY captureCompileShader(const GLuint Shader)
+	{
+		GDriver.CompileShader(Shader);
+		record(GlCall::CompileShader, Shader);
+	}
+
+	void GLAPIENTRY captureCopyNamedBufferSubData(const GLuint Read, const GLuint Write, const GLintptr ReadOffset,
+	                                              const GLintptr WriteOffset, const GLsizeiptr Size)
+	{
+		GDriver.CopyNamedBufferSubData(Read, Write, ReadOffset, WriteOffset, Size);
+		record(GlCall::CopyNamedBufferSubData, Read, Write, toInt64(ReadOffset), toInt64(WriteOffset), toInt64(Size));
+	}
+
+	void GLAPIENTRY captureCreateBuffers(const GLsizei Count, GLuint* Buffers)
+	{
+		GDriver.CreateBuffers(Count, Buffers);
+		record(GlCall::CreateBuffers);
+		putNames(Count, Buffers);
+	}
+
+	void GLAPIENTRY captureCreateFramebuffers(const GLsizei Count, GLuint* Framebuffers)
+	{
+		GDriver.CreateFramebuffers(Count, Framebuffers);
+		record(GlCall::CreateFramebuffers);
+		putNames(Count, Framebuffers);
+	}
+
+	GLuint GLAPIENTRY captureCreateProgram()
+	{
+		const GLuint Program = GDriver.CreateProgram();
+		record(GlCall::CreateProgram, Program);
+		return Program;
+	}
+
+	void GLAPIENTRY captureCreateQueries(const GLenum Target, const GLsizei Count, GLuint* Queries)
+	{
+		GDriver.CreateQueries(Target, Count, Queries);
+		record(GlCall::CreateQueries, Target);
+		putNames(Count, Queries);
+	}
+
+	void GLAPIENTRY captureCreateRenderbuffers(const GLsizei Count, GLuint* Renderbuffers)
+	{
+		GDriver.CreateRenderbuffers(Count, Renderbuffers);
+		record(GlCall::CreateRenderbuffers);
+		putNames(Count, Renderbuffers);
+	}
+
+	GLuint GLAPIENTRY captureCreateShader(const GLenum Type)
+	{
+		const GLuint Shader = GDriver.CreateShader(Type);
+		record(GlCall::CreateShader, Type, Shader);
+		return Shader;
+	}
+
+	void GLAPIENTRY captureCreateTextures(const GLenum Target, const GLsizei Count, GLuint* Textures)
+	{
+		GDriver.CreateTextures(Target, Count, Textures);
+		record(GlCall::CreateTextures, Target);
+		putNames(Count, Textures);
+	}
+
+	void GLAPIENTRY captureCreateVertexArrays(const GLsizei Count, GLuint* Vaos)
+	{
+		GDriver.CreateVertexArrays(Count, Vaos);
+		record(GlCall::CreateVertexArrays);
+		putNames(Count, Vaos);
+	}
+
+	void GLAPIENTRY captureCullFace(const GLenum Face)
+	{
+		GDriver.CullFace(Face);
+		record(GlCall::CullFace, Face);
+	}
+
+	void GLAPIENTRY captureDeleteBuffers(const GLsizei Count, const GLuint* Buffers)
+	{
+		GDriver.DeleteBuffers(Count, Buffers);
+		record(GlCall::DeleteBuffers);
+		putNames(Count, Buffers);
+
+		// Deleting a buffer unmaps it
+		const GLuint* End = Buffers + Count;
+		GMappings.erase(std::remove_if(GMappings.begin(), GMappings.end(), [Buffers, End](const MappedRange& Range)
+		{
+			return std::find(Buffers, End, Range.Buffer) != End;
+		}), GMappings.end());
+	}
+
+	void GLAPIENTRY captureDeleteFramebuffers(const GLsizei Count, const GLuint* Framebuffers)
+	{
+		GDriver.DeleteFramebuffers(Count, Framebuffers);
+		record(GlCall::DeleteFramebuffers);
+		putNames(Count, Framebuffers);
+	}
+
+	void GLAPIENTRY captureDeleteProgram(const GLuint Program)
+	{
+		GDriver.DeleteProgram(Program);
+		record(GlCall::DeleteProgram, Program);
+	}
+
+	void GLAPIENTRY captureDeleteQueries(const GLsizei Count, const GLuint* Queries)
+	{
+		GDriver.DeleteQueries(Count, Queries);
+		record(GlCall::DeleteQueries);
+		putNames(Count, Queries);
+	}
+
+	void GLAPIENTRY captureDeleteRenderbuffers(const GLsizei Count, const GLuint* Renderbuffers)
+	{
+		GDriver.DeleteRenderbuffers(Count, Renderbuffers);
+		record(GlCall::DeleteRenderbuffers);
+		putNames(Count, Renderbuffers);
+	}
+
+	void GLAPIENTRY captureDeleteShader(const GLuint Shader)
+	{
+		GDriver.DeleteShader(Shader);
+		record(GlCall::DeleteShader, Shader);
+	}
+
+	void GLAPIENTRY captureDeleteSync(const GLsync Sync)
+	{
+		GDriver.DeleteSync(Sync);
+		record(GlCall::DeleteSync, toHandle(Sync));
+	}
+
+	void GLAPIENTRY captureDeleteTextures(const GLsizei Count, const GLuint* Textures)
+	{
+		GDriver.DeleteTextures(Count, Textures);
+		record(GlCall::DeleteTextures);
+		putNames(Count, Textures);
+	}
+
+	void GLAPIENTRY captureDeleteVertexArrays(const GLsizei Count, const GLuint* Vaos)
+	{
+		GDriver.DeleteVertexArrays(Count, Vaos);
+		record(GlCall::DeleteVertexArrays);
+		putNames(Count, Vaos);
+	}
+
+	void GLAPIENTRY captureDepthFunc(const GLenum Function)
+	{
+		GDriver.DepthFunc(Function);
+		record(GlCall::DepthFunc, Function);
+	}
+
+	void GLAPIENTRY captureDepthMask(const GLboolean Write)
+	{
+		GDriver.DepthMask(Write);
+		record(GlCall::DepthMask, Write);
+	}
+
+	void GLAPIENTRY captureDisable(const GLenum Capability)
+	{
+		GDriver.Disable(Capability);
+		record(GlCall::Disable, Capability);
+	}
+
+	void GLAPIENTRY captureDisableVertexArrayAttrib(const GLuint Vao, const GLuint Index)
+	{
+		GDriver.DisableVertexArrayAttrib(Vao, Index);
+		record(GlCall::DisableVertexArrayAttrib, Vao, Index);
+	}
+
+	void GLAPIENTRY captureDrawArrays(const GLenum Mode, const GLint First, const GLsizei Count)
+	{
+		GDriver.DrawArrays(Mode, First, Count);
+		record(GlCall::DrawArrays, Mode, First, Count);
+	}
+
+	void GLAPIENTRY captureDrawArraysInstancedBaseInstance(const GLenum Mode, const GLint First, const GLsizei Count,
+	                                                       const GLsizei InstanceCount, const GLuint BaseInstance)
+	{
+		GDriver.DrawArraysInstancedBaseInstance(Mode, First, Count, InstanceCount, BaseInstance);
+		record(GlCall::DrawArraysInstancedBaseInstance, Mode, First, Count, InstanceCount, BaseInstance);
+	}
+
+	// Indices are always an offset into the VAO's element buffer, the core profile has no client arrays
+	void GLAPIENTRY captureDrawElements(const GLenum Mode, const GLsizei Count, const GLenum Type,
+	                                    const void* Indices)
+	{
+		GDriver.DrawElements(Mode, Count, Type, Indices);
+		record(GlCall::DrawElements, Mode, Count, Type, static_cast<std::uint64_t>(
+			       reinterpret_cast<std::uintptr_t>(Indices)));
+	}
+
+	void GLAPIENTRY captureDrawElementsInstancedBaseInstance(const GLenum Mode, const GLsizei Count,
+	                                                         const GLenum Type, const void* Indices,
+	                                                         const GLsizei InstanceCount, const GLuint BaseInstance)
+	{
+		GDriver.DrawElementsInstancedBaseInstance(Mode, Count, Type, Indices, InstanceCount, BaseInstance);
+		record(GlCall::DrawElementsInstancedBaseInstance, Mode, Count, Type,
+		       static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(Indices)), InstanceCount, BaseInstance);
+	}
+
+	void GLAPIENTRY captureEnable(const GLenum Capability)
+	{
+		GDriver.Enable(Capability);
+		record(GlCall::Enable, Capability);
+	}
+
+	void GLAPIENTRY captureEnableVertexArrayAttrib(const GLuint Vao, const GLuint Index)
+	{
+		GDriver.EnableVertexArrayAttrib(Vao, Index);
+		record(GlCall::EnableVertexArrayAttrib, Vao, Index);
+	}
+
+	GLsync GLAPIENTRY captureFenceSync(const GLenum Condition, const GLbitfield Flags)
+	{
+		const GLsync Sync = GDriver.FenceSync(Condition, Flags);
+		record(GlCall::FenceSync, Condition, Flags, toHandle(Sync));
+		return Sync;
+	}
+
+	void GLAPIENTRY captureFinish()
+	{
+		GDriver.Finish();
+		record(GlCall::Finish);
+	}
+
+	void GLAPIENTRY captureFramebufferRenderbuffer(const GLenum Target, const GLenum Attachment,
+	                                               const GLenum RenderbufferTarget, const GLuint Renderbuffer)
+	{
+		GDriver.FramebufferRenderbuffer(Target, Attachment, RenderbufferTarget, Renderbuffer);
+		record(GlCall::FramebufferRenderbuffer, Target, Attachment, RenderbufferTarget, Renderbuffer);
+	}
+
+	void GLAPIENTRY captureFramebufferTexture2D(const GLenum Target, const GLenum Attachment,
+	                                            const GLenum TextureTarget, const GLuint Texture, const GLint Level)
+	{
+		GDriver.FramebufferTexture2D(Target, Attachment, TextureTarget, Texture, Level);
+		record(GlCall::FramebufferTexture2D, Target, Attachment, TextureTarget, Texture, Level);
+	}
+
+	void GLAPIENTRY captureGenFramebuffers(const GLsizei Count, GLuint* Framebuffers)
+	{
+		GDriver.GenFramebuffers(Count, Framebuffers);
+		record(GlCall::GenFramebuffers);
+		putNames(Count, Framebuffers);
+	}
+
+	void GLAPIENTRY captureGenRenderbuffers(const GLsizei Count, GLuint* Renderbuffers)
+	{
+		GDriver.GenRenderbuffers(Count, Renderbuffers);
+		record(GlCall::GenRenderbuffers);
+		putNames(Count, Renderbuffers);
+	}
+
+	void GLAPIENTRY captureGenerateTextureMipmap(const GLuint Texture)
+	{
+		GDriver.GenerateTextureMipmap(Texture);
+		record(GlCall::GenerateTextureMipmap, Texture);
+	}
+
+	// Queries are recorded for the time they take, what they returned isn't needed to replay
+	GLenum GLAPIENTRY captureGetError()
+	{
+		const GLenum Error = GDriver.GetError();
+		record(GlCall::GetError);
+		return Error;
+	}
+
+	void GLAPIENTRY captureGetFloatv(const GLenum Name, GLfloat* Values)
+	{
+		GDriver.GetFloatv(Name, Values);
+		record(GlCall::GetFloatv, Name);
+	}
+
+	void GLAPIENTRY captureGetInteger64v(const GLenum Name, GLint64* Values)
+	{
+		GDriver.GetInteger64v(Name, Values);
+		record(GlCall::GetInteger64v, Name);
+	}
+
+	void GLAPIENTRY captureGetIntegerv(const GLenum Name, GLint* Values)
+	{
+		GDriver.GetIntegerv(Name, Values);
+		record(GlCall::GetIntegerv, Name);
+	}
+
+	void GLAPIENTRY captureGetNamedBufferParameteriv(const GLuint Buffer, const GLenum Name, GLint* Values)
+	{
+		GDriver.GetNamedBufferParameteriv(Buffer, Name, Values);
+		record(GlCall::GetNamedBufferParameteriv, Buffer, Name);
+	}
+
+	void GLAPIENTRY captureGetNamedBufferSubData(const GLuint Buffer, const GLintptr Offset, const GLsizeiptr Size,
+	                                             void* Data)
+	{
+		GDriver.GetNamedBufferSubData(Buffer, Offset, Size, Data);
+		record(GlCall::GetNamedBufferSubData, Buffer, toInt64(Offset), toInt64(Size));
+	}
+
+	void GLAPIENTRY captureGetProgramInfoLog(const GLuint Program, const GLsizei Size, GLsizei* Length, GLchar* Log)
+	{
+		GDriver.GetProgramInfoLog(Program, Size, Length, Log);
+		record(GlCall::GetProgramInfoLog, Program, Size);
+	}
+
+	void GLAPIENTRY captureGetProgramiv(const GLuint Program, const GLenum Name, GLint* Values)
+	{
+		GDriver.GetProgramiv(Program, Name, Values);
+		record(GlCall::GetProgramiv, Program, Name);
+	}
+
+	void GLAPIENTRY captureGetQueryObjectiv(const GLuint Query, const GLenum Name, GLint* Values)
+	{
+		GDriver.GetQueryObjectiv(Query, Name, Values);
+		record(GlCall::GetQueryObjectiv, Query, Name);
+	}
+
+	void GLAPIENTRY captureGetQueryObjectui64v(const GLuint Query, const GLenum Name, GLuint64* Values)
+	{
+		GDriver.GetQueryObjectui64v(Query, Name, Values);
+		record(GlCall::GetQueryObjectui64v, Query, Name);
+	}
+
+	void GLAPIENTRY captureGetShaderInfoLog(const GLuint Shader, const GLsizei Size, GLsizei* Length, GLchar* Log)
+	{
+		GDriver.GetShaderInfoLog(Shader, Size, Length, Log);
+		record(GlCall::GetShaderInfoLog, Shader, Size);
+	}
+
+	void GLAPIENTRY captureGetShaderiv(const GLuint Shader, const GLenum Name, GLint* Values)
+	{
+		GDriver.GetShaderiv(Shader, Name, Values);
+		record(GlCall::GetShaderiv, Shader, Name);
+	}
+
+	void GLAPIENTRY captureGetTextureImage(const GLuint Texture, const GLint Level, const GLenum Format,
+	                                       const GLenum Type, const GLsizei Size, void* Pixels)
+	{
+		GDriver.GetTextureImage(Texture, Level, Format, Type, Size, Pixels);
+		record(GlCall::GetTextureImage, Texture, Level, Format, Type, Size);
+	}
+
+	void GLAPIENTRY captureGetTextureLevelParameteriv(const GLuint Texture, const GLint Level, const GLenum Name,
+	                                                  GLint* Values)
+	{
+		GDriver.GetTextureLevelParameteriv(Texture, Level, Name, Values);
+		record(GlCall::GetTextureLevelParameteriv, Texture, Level, Name);
+	}
+
+	// Locations can differ between drivers, so a replay looks the name up again and maps the recorded location
+	GLint GLAPIENTRY captureGetUniformLocation(const GLuint Program, const GLchar* Name)
+	{
+		const GLint Location = GDriver.GetUniformLocation(Program, Name);
+		record(GlCall::GetUniformLocation, Program);
+		putContents(Name, std::strlen(Name));
+		put(Location);
+		return Location;
+	}
+
+	void GLAPIENTRY captureLinkProgram(const GLuint Program)
+	{
+		GDriver.LinkProgram(Program);
+		record(GlCall::LinkProgram, Program);
+	}
+
+	void* GLAPIENTRY captureMapNamedBufferRange(const GLuint Buffer, const GLintptr Offset, const GLsizeiptr Length,
+	                                            const GLbitfield Access)
+	{
+		void* Memory = GDriver.MapNamedBufferRange(Buffer, Offset, Length, Access);
+		record(GlCall::MapNamedBufferRange, Buffer, toInt64(Offset), toInt64(Length), Access);
+		if (Memory != nullptr)
+		{
+			GMappings.push_back({Buffer, static_cast<std::uint64_t>(Offset), static_cast<const unsigned char*>(Memory),
+			                     static_cast<std::size_t>(Length)});
+		}
+		return Memory;
+	}
+
+	// Contents are left empty when there are none to copy
+	void GLAPIENTRY captureNamedBufferData(const GLuint Buffer, const GLsizeiptr Size, const void* Data,
+	                                       const GLenum Usage)
+	{
+		GDriver.NamedBufferData(Buffer, Size, Data, Usage);
+		record(GlCall::NamedBufferData, Buffer, toInt64(Size), Usage);
+		putContents(Data, Data != nullptr ? static_cast<std::size_t>(Size) : 0);
+	}
+
+	void GLAPIENTRY captureNamedBufferStorage(const GLuint Buffer, const GLsizeiptr Size, const void* Data,
+	                                          const GLbitfield Flags)
+	{
+		GDriver.NamedBufferStorage(Buffer, Size, Data, Flags);
+		record(GlCall::NamedBufferStorage, Buffer, toInt64(Size), Flags);
+		putContents(Data, Data != nullptr ? static_cast<std::size_t>(Size) : 0);
+	}
+
+	void GLAPIENTRY captureNamedBufferSubData(const GLuint Buffer, const GLintptr Offset, const GLsizeiptr Size,
+	                                          const void* Data)
+	{
+		GDriver.NamedBufferSubData(Buffer, Offset, Size, Data);
+		record(GlCall::NamedBufferSubData, Buffer, toInt64(Offset));
+		putContents(Data, static_cast<std::size_t>(Size));
+	}
+
+	void GLAPIENTRY captureNamedFramebufferRenderbuffer(const GLuint Framebuffer, const GLenum Attachment,
+	                                                    const GLenum RenderbufferTarget, const GLuint Renderbuffer)
+	{
+		GDriver.NamedFramebufferRenderbuffer(Framebuffer, Attachment, RenderbufferTarget, Renderbuffer);
+		record(GlCall::NamedFramebufferRenderbuffer, Framebuffer, Attachment, RenderbufferTarget, Renderbuffer);
+	}
+
+	void GLAPIENTRY captureNamedFramebufferTexture(const GLuint Framebuffer, const GLenum Attachment,
+	                                               const GLuint Texture, const GLint Level)
+	{
+		GDriver.NamedFramebufferTexture(Framebuffer, Attachment, Texture, Level);
+		record(GlCall::NamedFramebufferTexture, Framebuffer, Attachment, Texture, Level);
+	}
+
+	void GLAPIENTRY captureNamedRenderbufferStorage(const GLuint Renderbuffer, const GLenum Format,
+	                                                const GLsizei Width, const GLsizei Height)
+	{
+		GDriver.NamedRenderbufferStorage(Renderbuffer, Format, Width, Height);
+		record(GlCall::NamedRenderbufferStorage, Renderbuffer, Format, Width, Height);
+	}
+
+	void GLAPIENTRY capturePolygonMode(const GLenum Face, const GLenum Mode)
+	{
+		GDriver.PolygonMode(Face, Mode);
+		record(GlCall::PolygonMode, Face, Mode);
+	}
+
+	void GLAPIENTRY captureQueryCounter(const GLuint Query, const GLenum Target)
+	{
+		GDriver.QueryCounter(Query, Target);
+		record(GlCall::QueryCounter, Query, Target);
+	}
+
+	void GLAPIENTRY captureReadPixels(const GLint X, const GLint Y, const GLsizei Width, const GLsizei Height,
+	                                  const GLenum Format, const GLenum Type, void* Pixels)
+	{
+		GDriver.ReadPixels(X, Y, Width, Height, Format, Type, Pixels);
+		record(GlCall::ReadPixels, X, Y, Width, Height, Format, Type);
+	}
+
+	void GLAPIENTRY captureRenderbufferStorage(const GLenum Target, const GLenum Format, const GLsizei Width,
+	                                           const GLsizei Height)
+	{
+		GDriver.RenderbufferStorage(Target, Format, Width, Height);
+		record(GlCall::RenderbufferStorage, Target, Format, Width, Height);
+	}
+
+	// Each string's contents in turn, a length below 0 or none at all meaning it ends at its terminator
+	void GLAPIENTRY captureShaderSource(const GLuint Shader, const GLsizei Count, const GLchar* const* Strings,
+	                                    const GLint* Lengths)
+	{
+		GDriver.ShaderSource(Shader, Count, Strings, Lengths);
+		record(GlCall::ShaderSource, Shader, Count);
+		for (GLsizei I = 0; I < Count; I++)
+		{
+			const bool Terminated = Lengths == nullptr || Lengths[I] < 0;
+			putContents(Strings[I], Terminated ? std::strlen(Strings[I]) : static_cast<std::size_t>(Lengths[I]));
+		}
+	}
+
+	void GLAPIENTRY captureTextureParameteri(const GLuint Texture, const GLenum Name, const GLint Value)
+	{
+		GDriver.TextureParameteri(Texture, Name, Value);
+		record(GlCall::TextureParameteri, Texture, Name, Value);
+	}
+
+	void GLAPIENTRY captureTextureStorage2D(const GLuint Texture, const GLsizei Levels, const GLenum Format,
+	                                        const GLsizei Width, const GLsizei Height)
+	{
+		GDriver.TextureStorage2D(Texture, Levels, Format, Width, Height);
+		record(GlCall::TextureStorage2D, Texture, Levels, Format, Width, Height);
+	}
+
+	void GLAPIENTRY captureTextureSubImage2D(const GLuint Texture, const GLint Level, const GLint X, const GLint Y,
+	                                         const GLsizei Width, const GLsizei Height, const GLenum Format,
+	                                         const GLenum Type, const void* Pixels)
+	{
+		GDriver.TextureSubImage2D(Texture, Level, X, Y, Width, Height, Format, Type, Pixels);
+		record(GlCall::TextureSubImage2D, Texture, Level, X, Y, Width, Height, Format, Type);
+		putContents(Pixels, Pixels != nullptr ? imageBytes(Width, Height, Format, Type) : 0);
+	}
+
+	void GLAPIENTRY captureUniform1f(const GLint Location, const GLfloat Value)
+	{
+		GDriver.Uniform1f(Location, Value);
+		record(GlCall::Uniform1f, Location, Value);
+	}
+
+	void GLAPIENTRY captureUniform1i(const GLint Location, const GLint Value)
+	{
+		GDriver.Uniform1i(Location, Value);
+		record(GlCall::Uniform1i, Location, Value);
+	}
+
+	void GLAPIENTRY captureUniform2fv(const GLint Location, const GLsizei Count, const GLfloat* Values)
+	{
+		GDriver.Uniform2fv(Location, Count, Values);
+		record(GlCall::Uniform2fv, Location, Count);
+		putContents(Values, static_cast<std::size_t>(Count) * 2 * sizeof(GLfloat));
+	}
+
+	void GLAPIENTRY captureUniform3fv(const GLint Location, const GLsizei Count, const GLfloat* Values)
+	{
+		GDriver.Uniform3fv(Location, Count, Values);
+		record(GlCall::Uniform3fv, Location, Count);
+		putContents(Values, static_cast<std::size_t>(Count) * 3 * sizeof(GLfloat));
+	}
+
+	void GLAPIENTRY captureUniform4fv(const GLint Location, const GLsizei Count, const GLfloat* Values)
+	{
+		GDriver.Uniform4fv(Location, Count, Values);
+		record(GlCall::Uniform4fv, Location, Count);
+		putContents(Values, static_cast<std::size_t>(Count) * 4 * sizeof(GLfloat));
+	}
+
+	void GLAPIENTRY captureUniformMatrix4fv(const GLint Location, const GLsizei Count, const GLboolean Transpose,
+	                                        const GLfloat* Values)
+	{
+		GDriver.UniformMatrix4fv(Location, Count, Transpose, Values);
+		record(GlCall::UniformMatrix4fv, Location, Count, Transpose);
+		putContents(Values, static_cast<std::size_t>(Count) * 16 * sizeof(GLfloat));
+	}
+
+	void GLAPIENTRY captureUseProgram(const GLuint Program)
+	{
+		GDriver.UseProgram(Program);
+		record(GlCall::UseProgram, Program);
+	}
+
+	void GLAPIENTRY captureVertexArrayAttribBinding(const GLuint Vao, const GLuint Attribute, const GLuint Binding)
+	{
+		GDriver.VertexArrayAttribBinding(Vao, Attribute, Binding);
+		record(GlCall::VertexArrayAttribBinding, Vao, Attribute, Binding);
+	}
+
+	void GLAPIENTRY captureVertexArrayAttribFormat(const GLuint Vao, const GLuint Attribute, const GLint Size,
+	                                               const GLenum Type, const GLboolean Normalised,
+	                                               const GLuint RelativeOffset)
+	{
+		GDriver.VertexArrayAttribFormat(Vao, Attribute, Size, Type, Normalised, RelativeOffset);
+		record(GlCall::VertexArrayAttribFormat, Vao, Attribute, Size, Type, Normalised, RelativeOffset);
+	}
+
+	void GLAPIENTRY captureVertexArrayBindingDivisor(const GLuint Vao, const GLuint Binding, const GLuint Divisor)
+	{
+		GDriver.VertexArrayBindingDivisor(Vao, Binding, Divisor);
+		record(GlCall::VertexArrayBindingDivisor, Vao, Binding, Divisor);
+	}
+
+	void GLAPIENTRY captureVertexArrayElementBuffer(const GLuint Vao, const GLuint Buffer)
+	{
+		GDriver.VertexArrayElementBuffer(Vao, Buffer);
+		record(GlCall::VertexArrayElementBuffer, Vao, Buffer);
+	}
+
+	void GLAPIENTRY captureVertexArrayVertexBuffer(const GLuint Vao, const GLuint Binding, const GLuint Buffer,
+	                                               const GLintptr Offset, const GLsizei Stride)
+	{
+		GDriver.VertexArrayVertexBuffer(Vao, Binding, Buffer, Offset, Stride);
+		record(GlCall::VertexArrayVertexBuffer, Vao, Binding, Buffer, toInt64(Offset), Stride);
+	}
+
+	void GLAPIENTRY captureViewport(const GLint X, const GLint Y, const GLsizei Width, const GLsizei Height)
+	{
+		GDriver.Viewport(X, Y, Width, Height);
+		record(GlCall::Viewport, X, Y, Width, Height);
+	}
+
+	// Puts the hook where calls go, keeping the driver's function, or puts that back
+	template <typename Function>
+	void hook(Function& Slot, Function& Driver, const Function Hook, const bool Install)
+	{
+		if (Install)
+		{
+			Driver = Slot;
+			Slot = Hook;
+		}
+		else
+		{
+			Slot = Driver;
+		}
+	}
+
+	void hookAll(const bool Install)
+	{
+		hook(__glewAttachShader, GDriver.AttachShader, captureAttachShader, Install);
+		hook(__glewBindBuffer, GDriver.BindBuffer, captureBindBuffer, Install);
+		hook(__glewBindFramebuffer, GDriver.BindFramebuffer, captureBindFramebuffer, Install);
+		hook(__glewBindRenderbuffer, GDriver.BindRenderbuffer, captureBindRenderbuffer, Install);
+		hook(__glewBindTextureUnit, GDriver.BindTextureUnit, captureBindTextureUnit, Install);
+		hook(__glewBindVertexArray, GDriver.BindVertexArray, captureBindVertexArray, Install);
+		hook(GlCore::BlendFunc, GDriver.BlendFunc, captureBlendFunc, Install);
+		hook(__glewBlitNamedFramebuffer, GDriver.BlitNamedFramebuffer, captureBlitNamedFramebuffer, Install);
+		hook(__glewCheckFramebufferStatus, GDriver.CheckFramebufferStatus, captureCheckFramebufferStatus, Install);
+		hook(__glewCheckNamedFramebufferStatus, GDriver.CheckNamedFramebufferStatus,
+		     captureCheckNamedFramebufferStatus, Install);
+		hook(GlCore::Clear, GDriver.Clear, captureClear, Install);
+		hook(GlCore::ClearColor, GDriver.ClearColor, captureClearColor, Install);
+		hook(__glewClearNamedFramebufferfv, GDriver.ClearNamedFramebufferfv, captureClearNamedFramebufferfv, Install);
+		hook(__glewClientWaitSync, GDriver.ClientWaitSync, captureClientWaitSync, Install);
+		hook(__glewCompileShader, GDriver.CompileShader, captureCompileShader, Install);
+		hook(__glewCopyNamedBufferSubData, GDriver.CopyNamedBufferSubData, captureCopyNamedBufferSubData, Install);
+		hook(__glewCreateBuffers, GDriver.CreateBuffers, captureCreateBuffers, Install);
+		hook(__glewCreateFramebuffers, GDriver.CreateFramebuffers, captureCreateFramebuffers, Install);
+		hook(__glewCreateProgram, GDriver.CreateProgram, captureCreateProgram, Install);
+		hook(__glewCreateQueries, GDriver.CreateQueries, captureCreateQueries, Install);
+		hook(__glewCreateRenderbuffers, GDriver.CreateRenderbuffers, captureCreateRenderbuffers, Install);
+		hook(__glewCreateShader, GDriver.CreateShader, captureCreateShader, Install);
+		hook(__glewCreateTextures, GDriver.CreateTextures, captureCreateTextures, Install);
+		hook(__glewCreateVertexArrays, GDriver.CreateVertexArrays, captureCreateVertexArrays, Install);
+		hook(GlCore::CullFace, GDriver.CullFace, captureCullFace, Install);
+		hook(__glewDeleteBuffers, GDriver.DeleteBuffers, captureDeleteBuffers, Install);
+		hook(__glewDeleteFramebuffers, GDriver.DeleteFramebuffers, captureDeleteFramebuffers, Install);
+		hook(__glewDeleteProgram, GDriver.DeleteProgram, captureDeleteProgram, Install);
+		hook(__glewDeleteQueries, GDriver.DeleteQueries, captureDeleteQueries, Install);
+		hook(__glewDeleteRenderbuffers, GDriver.DeleteRenderbuffers, captureDeleteRenderbuffers, Install);
+		hook(__glewDeleteShader, GDriver.DeleteShader, captureDeleteShader, Install);
+		hook(__glewDeleteSync, GDriver.DeleteSync, captureDeleteSync, Install);
+		hook(GlCore::DeleteTextures, GDriver.DeleteTextures, captureDeleteTextures, Install);
+		hook(__glewDeleteVertexArrays, GDriver.DeleteVertexArrays, captureDeleteVertexArrays, Install);
+		hook(GlCore::DepthFunc, GDriver.DepthFunc, captureDepthFunc, Install);
+		hook(GlCore::DepthMask, GDriver.DepthMask, captureDepthMask, Install);
+		hook(GlCore::Disable, GDriver.Disable, captureDisable, Install);
+		hook(__glewDisableVertexArrayAttrib, GDriver.DisableVertexArrayAttrib, captureDisableVertexArrayAttrib,
+		     Install);
+		hook(GlCore::DrawArrays, GDriver.DrawArrays, captureDrawArrays, Install);
+		hook(__glewDrawArraysInstancedBaseInstance, GDriver.DrawArraysInstancedBaseInstance,
+		     captureDrawArraysInstancedBaseInstance, Install);
+		hook(GlCore::DrawElements, GDriver.DrawElements, captureDrawElements, Install);
+		hook(__glewDrawElementsInstancedBaseInstance, GDriver.DrawElementsInstancedBaseInstance,
+		     captureDrawElementsInstancedBaseInstance, Install);
+		hook(GlCore::Enable, GDriver.Enable, captureEnable, Install);
+		hook(__glewEnableVertexArrayAttrib, GDriver.EnableVertexArrayAttrib, captureEnableVertexArrayAttrib, Install);
+		hook(__glewFenceSync, GDriver.FenceSync, captureFenceSync, Install);
+		hook(GlCore::Finish, GDriver.Finish, captureFinish, Install);
+		hook(__glewFramebufferRenderbuffer, GDriver.FramebufferRenderbuffer, captureFramebufferRenderbuffer,
+		     Install);
+		hook(__glewFramebufferTexture2D, GDriver.FramebufferTexture2D, captureFramebufferTexture2D, Install);
+		hook(__glewGenFramebuffers, GDriver.GenFramebuffers, captureGenFramebuffers, Install);
+		hook(__glewGenRenderbuffers, GDriver.GenRenderbuffers, captureGenRenderbuffers, Install);
+		hook(__glewGenerateTextureMipmap, GDriver.GenerateTextureMipmap, captureGenerateTextureMipmap, Install);
+		hook(GlCore::GetError, GDriver.GetError, captureGetError, Install);
+		hook(GlCore::GetFloatv, GDriver.GetFloatv, captureGetFloatv, Install);
+		hook(__glewGetInteger64v, GDriver.GetInteger64v, captureGetInteger64v, Install);
+		hook(GlCore::GetIntegerv, GDriver.GetIntegerv, captureGetIntegerv, Install);
+		hook(__glewGetNamedBufferParameteriv, GDriver.GetNamedBufferParameteriv, captureGetNamedBufferParameteriv,
+		     Install);
+		hook(__glewGetNamedBufferSubData, GDriver.GetNamedBufferSubData, captureGetNamedBufferSubData, Install);
+		hook(__glewGetProgramInfoLog, GDriver.GetProgramInfoLog, captureGetProgramInfoLog, Install);
+		hook(__glewGetProgramiv, GDriver.GetProgramiv, captureGetProgramiv, Install);
+		hook(__glewGetQueryObjectiv, GDriver.GetQueryObjectiv, captureGetQueryObjectiv, Install);
+		hook(__glewGetQueryObjectui64v, GDriver.GetQueryObjectui64v, captureGetQueryObjectui64v, Install);
+		hook(__glewGetShaderInfoLog, GDriver.GetShaderInfoLog, captureGetShaderInfoLog, Install);
+		hook(__glewGetShaderiv, GDriver.GetShaderiv, captureGetShaderiv, Install);
+		hook(__glewGetTextureImage, GDriver.GetTextureImage, captureGetTextureImage, Install);
+		hook(__glewGetTextureLevelParameteriv, GDriver.GetTextureLevelParameteriv,
+		     captureGetTextureLevelParameteriv, Install);
+		hook(__glewGetUniformLocation, GDriver.GetUniformLocation, captureGetUniformLocation, Install);
+		hook(__glewLinkProgram, GDriver.LinkProgram, captureLinkProgram, Install);
+		hook(__glewMapNamedBufferRange, GDriver.MapNamedBufferRange, captureMapNamedBufferRange, Install);
+		hook(__glewNamedBufferData, GDriver.NamedBufferData, captureNamedBufferData, Install);
+		hook(__glewNamedBufferStorage, GDriver.NamedBufferStorage, captureNamedBufferStorage, Install);
+		hook(__glewNamedBufferSubData, GDriver.NamedBufferSubData, captureNamedBufferSubData, Install);
+		hook(__glewNamedFramebufferRenderbuffer, GDriver.NamedFramebufferRenderbuffer,
+		     captureNamedFramebufferRenderbuffer, Install);
+		hook(__glewNamedFramebufferTexture, GDriver.NamedFramebufferTexture, captureNamedFramebufferTexture,
+		     Install);
+		hook(__glewNamedRenderbufferStorage, GDriver.NamedRenderbufferStorage, captureNamedRenderbufferStorage,
+		     Install);
+		hook(GlCore::PolygonMode, GDriver.PolygonMode, capturePolygonMode, Install);
+		hook(__glewQueryCounter, GDriver.QueryCounter, captureQueryCounter, Install);
+		hook(GlCore::ReadPixels, GDriver.ReadPixels, captureReadPixels, Install);
+		hook(__glewRenderbufferStorage, GDriver.RenderbufferStorage, captureRenderbufferStorage, Install);
+		hook(__glewShaderSource, GDriver.ShaderSource, captureShaderSource, Install);
+		hook(__glewTextureParameteri, GDriver.TextureParameteri, captureTextureParameteri, Install);
+		hook(__glewTextureStorage2D, GDriver.TextureStorage2D, captureTextureStorage2D, Install);
+		hook(__glewTextureSubImage2D, GDriver.TextureSubImage2D, captureTextureSubImage2D, Install);
+		hook(__glewUniform1f, GDriver.Uniform1f, captureUniform1f, Install);
+		hook(__glewUniform1i, GDriver.Uniform1i, captureUniform1i, Install);
+		hook(__glewUniform2fv, GDriver.Uniform2fv, captureUniform2fv, Install);
+		hook(__glewUniform3fv, GDriver.Uniform3fv, captureUniform3fv, Install);
+		hook(__glewUniform4fv, GDriver.Uniform4fv, captureUniform4fv, Install);
+		hook(__glewUniformMatrix4fv, GDriver.UniformMatrix4fv, captureUniformMatrix4fv, Install);
+		hook(__glewUseProgram, GDriver.UseProgram, captureUseProgram, Install);
+		hook(__glewVertexArrayAttribBinding, GDriver.VertexArrayAttribBinding, captureVertexArrayAttribBinding,
+		     Install);
+		hook(__glewVertexArrayAttribFormat, GDriver.VertexArrayAttribFormat, captureVertexArrayAttribFormat,
+		     Install);
+		hook(__glewVertexArrayBindingDivisor, GDriver.VertexArrayBindingDivisor, captureVertexArrayBindingDivisor,
+		     Install);
+		hook(__glewVertexArrayElementBuffer, GDriver.VertexArrayElementBuffer, captureVertexArrayElementBuffer,
+		     Install);
+		hook(__glewVertexArrayVertexBuffer, GDriver.VertexArrayVertexBuffer, captureVertexArrayVertexBuffer,
+		     Install);
+		hook(GlCore::Viewport, GDriver.Viewport, captureViewport, Install);
+	}
+}
+
+bool GlCapture::start(const char* Path, const unsigned int Width, const unsigned int Height)
+{
+	if (GRecording)
+	{
+		return false;
+	}
+	GFile.open(Path, std::ios::binary | std::ios::trunc);
+	if (!GFile)
+	{
+		std::cerr << "Failed to open capture file: " << Path << std::endl;
+		return false;
+	}
+
+	GStats = {};
+	GPending.clear();
+	GMappings.clear();
+	put(Magic);
+	put(Version);
+	put(static_cast<std::uint32_t>(Width));
+	put(static_cast<std::uint32_t>(Height));
+	hookAll(true);
+	GRecording = true;
+	return true;
+}
+
+bool GlCapture::stop()
+{
+	if (!GRecording)
+	{
+		return false;
+	}
+	hookAll(false);
+	GRecording = false;
+	GMappings.clear();
+	writePending();
+	GFile.close();
+	if (!GFile)
+	{
+		std::cerr << "Failed to write the capture file" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool GlCapture::isRecording()
+{
+	return GRecording;
+}
+
+void GlCapture::endFrame()
+{
+	if (GRecording)
+	{
+		record(GlCall::EndFrame);
+		GStats.Frames++;
+	}
+}
+
+void GlCapture::recordMappedWrite(const void* Destination, const void* Source, const std::size_t Size)
+{
+	if (!GRecording)
+	{
+		return;
+	}
+	const auto* Address = static_cast<const unsigned char*>(Destination);
+	for (const MappedRange& Range : GMappings)
+	{
+		if (Address >= Range.Memory && Address + Size <= Range.Memory + Range.Size)
+		{
+			const auto Offset = Range.Offset + static_cast<std::uint64_t>(Address - Range.Memory);
+			record(GlCall::MappedWrite, Range.Buffer, Offset);
+			putContents(Source, Size);
+			return;
+		}
+	}
+}
+
+const GlCaptureStats& GlCapture::getStats()
+{
+	return GStats;
+}
+
+const char* GlCapture::getCallName(const GlCall Call)
+{
+	return Call < GlCall::Count ? CallNames[static_cast<int>(Call)] : "unknown";
+}
@@ -0,0 +1,1172 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlReplay.cpp
+Description : Implementations for running a recorded GL trace again off screen,
+			  timing every call and frame
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "GlReplay.h"
+
+#include <glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "SoftwareBackend.h"
+
+namespace
+{
+	using ReplayClock = std::chrono::steady_clock;
+	using NameMap = std::unordered_map<GLuint, GLuint>; // Recorded names to the replay's
+
+	constexpr std::size_t ReadbackBytesPerPixel = 16; // Enough for any format the app reads back
+
+	double millisecondsSince(const ReplayClock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(ReplayClock::now() - Start).count();
+	}
+
+	// The trace's bytes in order. Reading past the end reads zeroes and marks the trace as failed
+	class TraceReader
+	{
+	public:
+		explicit TraceReader(const std::vector<unsigned char>& Data) : MData(Data)
+		{
+		}
+
+		template <typename Value>
+		Value read()
+		{
+			static_assert(std::is_trivially_copyable_v<Value>);
+			Value Result{};
+			if (MFailed || MData.size() - MPosition < sizeof(Value))
+			{
+				MFailed = true;
+				return Result;
+			}
+			std::memcpy(&Result, MData.data() + MPosition, sizeof(Value));
+			MPosition += sizeof(Value);
+			return Result;
+		}
+
+		// Null when empty
+		const unsigned char* readContents(std::size_t& Size)
+		{
+			const auto Length = read<std::uint64_t>();
+			if (MFailed || MData.size() - MPosition < Length)
+			{
+				MFailed = true;
+				Size = 0;
+				return nullptr;
+			}
+			Size = static_cast<std::size_t>(Length);
+			const unsigned char* Contents = Size > 0 ? MData.data() + MPosition : nullptr;
+			MPosition += Size;
+			return Contents;
+		}
+
+		void readNames(std::vector<GLuint>& Names)
+		{
+			const auto Count = read<GLsizei>();
+			Names.clear();
+			if (Count < 0 || MData.size() - MPosition < static_cast<std::size_t>(Count) * sizeof(GLuint))
+			{
+				MFailed = true;
+				return;
+			}
+			for (GLsizei I = 0; I < Count; I++)
+			{
+				Names.push_back(read<GLuint>());
+			}
+		}
+
+		[[nodiscard]] bool isAtEnd() const
+		{
+			return MPosition >= MData.size();
+		}
+
+		[[nodiscard]] bool hasFailed() const
+		{
+			return MFailed;
+		}
+
+		[[nodiscard]] std::size_t getPosition() const
+		{
+			return MPosition;
+		}
+
+	private:
+		const std::vector<unsigned char>& MData;
+		std::size_t MPosition = 0;
+		bool MFailed = false;
+	};
+
+	// Memory the replay mapped a buffer to, and where in the buffer it starts
+	struct MappedMemory
+	{
+		std::uint64_t Offset;
+		unsigned char* Memory;
+		std::size_t Size;
+	};
+
+	struct ReplayState
+	{
+		NameMap Buffers;
+		NameMap Textures;
+		NameMap Vaos;
+		NameMap Programs; // Shaders too, GL names them together
+		NameMap Framebuffers; // Recorded 0 is the framebuffer standing in for the window's
+		NameMap Renderbuffers;
+		NameMap Queries;
+		std::unordered_map<std::uint64_t, GLsync> Syncs;
+		std::unordered_map<std::uint64_t, GLint> Locations; // By recorded program then location
+		std::unordered_map<GLuint, MappedMemory> Mappings; // By recorded buffer
+		GLuint Program = 0; // Recorded name of the one in use, which uniform locations belong to
+		std::vector<GLuint> Recorded; // Scratch for names read
+		std::vector<GLuint> Names; // And the replay's for them
+		std::vector<float> Floats; // Uniforms, aligned again
+		std::vector<unsigned char> Readback; // Where queries and reads land, never looked at
+	};
+
+	struct CallTiming
+	{
+		std::uint64_t Count;
+		double TotalMilliseconds;
+		double MaxMilliseconds;
+	};
+
+	GLuint find(const NameMap& Names, const GLuint Recorded)
+	{
+		const auto It = Names.find(Recorded);
+		return It != Names.end() ? It->second : 0;
+	}
+
+	std::uint64_t locationKey(const GLuint Program, const GLint Location)
+	{
+		return static_cast<std::uint64_t>(Program) << 32 | static_cast<std::uint32_t>(Location);
+	}
+
+	// As looked up by the replay for the program in use, or as recorded if it never was
+	GLint findLocation(const ReplayState& State, const GLint Recorded)
+	{
+		const auto It = State.Locations.find(locationKey(State.Program, Recorded));
+		return It != State.Locations.end() ? It->second : Recorded;
+	}
+
+	GLsync findSync(const ReplayState& State, const std::uint64_t Recorded)
+	{
+		const auto It = State.Syncs.find(Recorded);
+		return It != State.Syncs.end() ? It->second : nullptr;
+	}
+
+	void* readback(ReplayState& State, const std::size_t Size)
+	{
+		if (State.Readback.size() < Size)
+		{
+			State.Readback.resize(Size);
+		}
+		return State.Readback.data();
+	}
+
+	const GLfloat* readFloats(TraceReader& Reader, ReplayState& State)
+	{
+		std::size_t Size = 0;
+		const unsigned char* Contents = Reader.readContents(Size);
+		State.Floats.resize(Size / sizeof(GLfloat));
+		if (Size > 0)
+		{
+			std::memcpy(State.Floats.data(), Contents, State.Floats.size() * sizeof(GLfloat));
+		}
+		return State.Floats.data();
+	}
+
+	// Names made as they were recorded, paired with the replay's own made by Create
+	template <typename Create>
+	void createNames(TraceReader& Reader, ReplayState& State, NameMap& Names, Create&& create)
+	{
+		Reader.readNames(State.Recorded);
+		State.Names.resize(State.Recorded.size());
+		if (State.Recorded.empty())
+		{
+			return;
+		}
+		create(static_cast<GLsizei>(State.Recorded.size()), State.Names.data());
+		for (std::size_t I = 0; I < State.Recorded.size(); I++)
+		{
+			Names[State.Recorded[I]] = State.Names[I];
+		}
+	}
+
+	template <typename Delete>
+	void deleteNames(TraceReader& Reader, ReplayState& State, NameMap& Names, Delete&& remove)
+	{
+		Reader.readNames(State.Recorded);
+		State.Names.clear();
+		for (const GLuint Recorded : State.Recorded)
+		{
+			State.Names.push_back(find(Names, Recorded));
+			Names.erase(Recorded);
+		}
+		if (!State.Names.empty())
+		{
+			remove(static_cast<GLsizei>(State.Names.size()), State.Names.data());
+		}
+	}
+
+	// Arguments are read into locals first, as the order a call's arguments are evaluated in isn't defined.
+	// Returns false for a call the replay doesn't know
+	bool replayCall(const GlCall Call, TraceReader& Reader, ReplayState& State)
+	{
+		switch (Call)
+		{
+		case GlCall::AttachShader:
+			{
+				const auto Program = Reader.read<GLuint>();
+				const auto Shader = Reader.read<GLuint>();
+				glAttachShader(find(State.Programs, Program), find(State.Programs, Shader));
+				return true;
+			}
+		case GlCall::BindBuffer:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Buffer = Reader.read<GLuint>();
+				glBindBuffer(Target, find(State.Buffers, Buffer));
+				return true;
+			}
+		case GlCall::BindFramebuffer:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Framebuffer = Reader.read<GLuint>();
+				glBindFramebuffer(Target, find(State.Framebuffers, Framebuffer));
+				return true;
+			}
+		case GlCall::BindRenderbuffer:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Renderbuffer = Reader.read<GLuint>();
+				glBindRenderbuffer(Target, find(State.Renderbuffers, Renderbuffer));
+				return true;
+			}
+		case GlCall::BindTextureUnit:
+			{
+				const auto Unit = Reader.read<GLuint>();
+				const auto Texture = Reader.read<GLuint>();
+				glBindTextureUnit(Unit, find(State.Textures, Texture));
+				return true;
+			}
+		case GlCall::BindVertexArray:
+			glBindVertexArray(find(State.Vaos, Reader.read<GLuint>()));
+			return true;
+		case GlCall::BlendFunc:
+			{
+				const auto Source = Reader.read<GLenum>();
+				const auto Destination = Reader.read<GLenum>();
+				glBlendFunc(Source, Destination);
+				return true;
+			}
+		case GlCall::BlitNamedFramebuffer:
+			{
+				const auto Read = Reader.read<GLuint>();
+				const auto Draw = Reader.read<GLuint>();
+				GLint Corners[8];
+				for (GLint& Corner : Corners)
+				{
+					Corner = Reader.read<GLint>();
+				}
+				const auto Mask = Reader.read<GLbitfield>();
+				const auto Filter = Reader.read<GLenum>();
+				glBlitNamedFramebuffer(find(State.Framebuffers, Read), find(State.Framebuffers, Draw), Corners[0],
+				                       Corners[1], Corners[2], Corners[3], Corners[4], Corners[5], Corners[6],
+				                       Corners[7], Mask, Filter);
+				return true;
+			}
+		case GlCall::CheckFramebufferStatus:
+			glCheckFramebufferStatus(Reader.read<GLenum>());
+			return true;
+		case GlCall::CheckNamedFramebufferStatus:
+			{
+				const auto Framebuffer = Reader.read<GLuint>();
+				const auto Target = Reader.read<GLenum>();
+				glCheckNamedFramebufferStatus(find(State.Framebuffers, Framebuffer), Target);
+				return true;
+			}
+		case GlCall::Clear:
+			glClear(Reader.read<GLbitfield>());
+			return true;
+		case GlCall::ClearColor:
+			{
+				GLfloat Colour[4];
+				for (GLfloat& Component : Colour)
+				{
+					Component = Reader.read<GLfloat>();
+				}
+				glClearColor(Colour[0], Colour[1], Colour[2], Colour[3]);
+				return true;
+			}
+		case GlCall::ClearNamedFramebufferfv:
+			{
+				const auto Framebuffer = Reader.read<GLuint>();
+				const auto Buffer = Reader.read<GLenum>();
+				const auto DrawBuffer = Reader.read<GLint>();
+				GLfloat Values[4];
+				for (GLfloat& Value : Values)
+				{
+					Value = Reader.read<GLfloat>();
+				}
+				glClearNamedFramebufferfv(find(State.Framebuffers, Framebuffer), Buffer, DrawBuffer, Values);
+				return true;
+			}
+		case GlCall::ClientWaitSync:
+			{
+				// The app only goes on once its fence has signalled, however many waits that took while recording,
+				// so the first wait here lasts until it has and the rest find it signalled
+				const auto Sync = Reader.read<std::uint64_t>();
+				GLbitfield Flags = Reader.read<GLbitfield>();
+				const auto Timeout = Reader.read<GLuint64>();
+				if (const GLsync Fence = findSync(State, Sync))
+				{
+					while (glClientWaitSync(Fence, Flags, Timeout) == GL_TIMEOUT_EXPIRED)
+					{
+						Flags = 0;
+					}
+				}
+				return true;
+			}
+		case GlCall::CompileShader:
+			glCompileShader(find(State.Programs, Reader.read<GLuint>()));
+			return true;
+		case GlCall::CopyNamedBufferSubData:
+			{
+				const auto Read = Reader.read<GLuint>();
+				const auto Write = Reader.read<GLuint>();
+				const auto ReadOffset = Reader.read<std::int64_t>();
+				const auto WriteOffset = Reader.read<std::int64_t>();
+				const auto Size = Reader.read<std::int64_t>();
+				glCopyNamedBufferSubData(find(State.Buffers, Read), find(State.Buffers, Write),
+				                         static_cast<GLintptr>(ReadOffset), static_cast<GLintptr>(WriteOffset),
+				                         static_cast<GLsizeiptr>(Size));
+				return true;
+			}
+		case GlCall::CreateBuffers:
+			createNames(Reader, State, State.Buffers, [](const GLsizei Count, GLuint* Names)
+			{
+				glCreateBuffers(Count, Names);
+			});
+			return true;
+		case GlCall::CreateFramebuffers:
+			createNames(Reader, State, State.Framebuffers, [](const GLsizei Count, GLuint* Names)
+			{
+				glCreateFramebuffers(Count, Names);
+			});
+			return true;
+		case GlCall::CreateProgram:
+			State.Programs[Reader.read<GLuint>()] = glCreateProgram();
+			return true;
+		case GlCall::CreateQueries:
+			{
+				const auto Target = Reader.read<GLenum>();
+				createNames(Reader, State, State.Queries, [Target](const GLsizei Count, GLuint* Names)
+				{
+					glCreateQueries(Target, Count, Names);
+				});
+				return true;
+			}
+		case GlCall::CreateRenderbuffers:
+			createNames(Reader, State, State.Renderbuffers, [](const GLsizei Count, GLuint* Names)
+			{
+				glCreateRenderbuffers(Count, Names);
+			});
+			return true;
+		case GlCall::CreateShader:
+			{
+				const auto Type = Reader.read<GLenum>();
+				const auto Shader = Reader.read<GLuint>();
+				State.Programs[Shader] = glCreateShader(Type);
+				return true;
+			}
+		case GlCall::CreateTextures:
+			{
+				const auto Target = Reader.read<GLenum>();
+				createNames(Reader, State, State.Textures, [Target](const GLsizei Count, GLuint* Names)
+				{
+					glCreateTextures(Target, Count, Names);
+				});
+				return true;
+			}
+		case GlCall::CreateVertexArrays:
+			createNames(Reader, State, State.Vaos, [](const GLsizei Count, GLuint* Names)
+			{
+				glCreateVertexArrays(Count, Names);
+			});
+			return true;
+		case GlCall::CullFace:
+			glCullFace(Reader.read<GLenum>());
+			return true;
+		case GlCall::DeleteBuffers:
+			deleteNames(Reader, State, State.Buffers, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteBuffers(Count, Names);
+			});
+			for (const GLuint Recorded : State.Recorded)
+			{
+				State.Mappings.erase(Recorded);
+			}
+			return true;
+		case GlCall::DeleteFramebuffers:
+			deleteNames(Reader, State, State.Framebuffers, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteFramebuffers(Count, Names);
+			});
+			return true;
+		case GlCall::DeleteProgram:
+			{
+				const auto Program = Reader.read<GLuint>();
+				glDeleteProgram(find(State.Programs, Program));
+				State.Programs.erase(Program);
+				return true;
+			}
+		case GlCall::DeleteQueries:
+			deleteNames(Reader, State, State.Queries, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteQueries(Count, Names);
+			});
+			return true;
+		case GlCall::DeleteRenderbuffers:
+			deleteNames(Reader, State, State.Renderbuffers, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteRenderbuffers(Count, Names);
+			});
+			return true;
+		case GlCall::DeleteShader:
+			{
+				const auto Shader = Reader.read<GLuint>();
+				glDeleteShader(find(State.Programs, Shader));
+				State.Programs.erase(Shader);
+				return true;
+			}
+		case GlCall::DeleteSync:
+			{
+				const auto Sync = Reader.read<std::uint64_t>();
+				if (const GLsync Fence = findSync(State, Sync))
+				{
+					glDeleteSync(Fence);
+					State.Syncs.erase(Sync);
+				}
+				return true;
+			}
+		case GlCall::DeleteTextures:
+			deleteNames(Reader, State, State.Textures, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteTextures(Count, Names);
+			});
+			return true;
+		case GlCall::DeleteVertexArrays:
+			deleteNames(Reader, State, State.Vaos, [](const GLsizei Count, const GLuint* Names)
+			{
+				glDeleteVertexArrays(Count, Names);
+			});
+			return true;
+		case GlCall::DepthFunc:
+			glDepthFunc(Reader.read<GLenum>());
+			return true;
+		case GlCall::DepthMask:
+			glDepthMask(Reader.read<GLboolean>());
+			return true;
+		case GlCall::Disable:
+			glDisable(Reader.read<GLenum>());
+			return true;
+		case GlCall::DisableVertexArrayAttrib:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Index = Reader.read<GLuint>();
+				glDisableVertexArrayAttrib(find(State.Vaos, Vao), Index);
+				return true;
+			}
+		case GlCall::DrawArrays:
+			{
+				const auto Mode = Reader.read<GLenum>();
+				const auto First = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				glDrawArrays(Mode, First, Count);
+				return true;
+			}
+		case GlCall::DrawArraysInstancedBaseInstance:
+			{
+				const auto Mode = Reader.read<GLenum>();
+				const auto First = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				const auto InstanceCount = Reader.read<GLsizei>();
+				const auto BaseInstance = Reader.read<GLuint>();
+				glDrawArraysInstancedBaseInstance(Mode, First, Count, InstanceCount, BaseInstance);
+				return true;
+			}
+		case GlCall::DrawElements:
+			{
+				const auto Mode = Reader.read<GLenum>();
+				const auto Count = Reader.read<GLsizei>();
+				const auto Type = Reader.read<GLenum>();
+				const auto Offset = Reader.read<std::uint64_t>();
+				glDrawElements(Mode, Count, Type, reinterpret_cast<const void*>(static_cast<std::uintptr_t>(Offset)));
+				return true;
+			}
+		case GlCall::DrawElementsInstancedBaseInstance:
+			{
+				const auto Mode = Reader.read<GLenum>();
+				const auto Count = Reader.read<GLsizei>();
+				const auto Type = Reader.read<GLenum>();
+				const auto Offset = Reader.read<std::uint64_t>();
+				const auto InstanceCount = Reader.read<GLsizei>();
+				const auto BaseInstance = Reader.read<GLuint>();
+				glDrawElementsInstancedBaseInstance(Mode, Count, Type,
+				                                    reinterpret_cast<const void*>(static_cast<std::uintptr_t>(Offset)),
+				                                    InstanceCount, BaseInstance);
+				return true;
+			}
+		case GlCall::Enable:
+			glEnable(Reader.read<GLenum>());
+			return true;
+		case GlCall::EnableVertexArrayAttrib:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Index = Reader.read<GLuint>();
+				glEnableVertexArrayAttrib(find(State.Vaos, Vao), Index);
+				return true;
+			}
+		case GlCall::FenceSync:
+			{
+				const auto Condition = Reader.read<GLenum>();
+				const auto Flags = Reader.read<GLbitfield>();
+				const auto Sync = Reader.read<std::uint64_t>();
+				State.Syncs[Sync] = glFenceSync(Condition, Flags);
+				return true;
+			}
+		case GlCall::Finish:
+			glFinish();
+			return true;
+		case GlCall::FramebufferRenderbuffer:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Attachment = Reader.read<GLenum>();
+				const auto RenderbufferTarget = Reader.read<GLenum>();
+				const auto Renderbuffer = Reader.read<GLuint>();
+				glFramebufferRenderbuffer(Target, Attachment, RenderbufferTarget,
+				                          find(State.Renderbuffers, Renderbuffer));
+				return true;
+			}
+		case GlCall::FramebufferTexture2D:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Attachment = Reader.read<GLenum>();
+				const auto TextureTarget = Reader.read<GLenum>();
+				const auto Texture = Reader.read<GLuint>();
+				const auto Level = Reader.read<GLint>();
+				glFramebufferTexture2D(Target, Attachment, TextureTarget, find(State.Textures, Texture), Level);
+				return true;
+			}
+		case GlCall::GenFramebuffers:
+			createNames(Reader, State, State.Framebuffers, [](const GLsizei Count, GLuint* Names)
+			{
+				glGenFramebuffers(Count, Names);
+			});
+			return true;
+		case GlCall::GenRenderbuffers:
+			createNames(Reader, State, State.Renderbuffers, [](const GLsizei Count, GLuint* Names)
+			{
+				glGenRenderbuffers(Count, Names);
+			});
+			return true;
+		case GlCall::GenerateTextureMipmap:
+			glGenerateTextureMipmap(find(State.Textures, Reader.read<GLuint>()));
+			return true;
+		case GlCall::GetError:
+			glGetError();
+			return true;
+		case GlCall::GetFloatv:
+			glGetFloatv(Reader.read<GLenum>(), static_cast<GLfloat*>(readback(State, 16 * sizeof(GLfloat))));
+			return true;
+		case GlCall::GetInteger64v:
+			glGetInteger64v(Reader.read<GLenum>(), static_cast<GLint64*>(readback(State, 16 * sizeof(GLint64))));
+			return true;
+		case GlCall::GetIntegerv:
+			glGetIntegerv(Reader.read<GLenum>(), static_cast<GLint*>(readback(State, 16 * sizeof(GLint))));
+			return true;
+		case GlCall::GetNamedBufferParameteriv:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				glGetNamedBufferParameteriv(find(State.Buffers, Buffer), Name,
+				                            static_cast<GLint*>(readback(State, sizeof(GLint))));
+				return true;
+			}
+		case GlCall::GetNamedBufferSubData:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Offset = Reader.read<std::int64_t>();
+				const auto Size = Reader.read<std::int64_t>();
+				glGetNamedBufferSubData(find(State.Buffers, Buffer), static_cast<GLintptr>(Offset),
+				                        static_cast<GLsizeiptr>(Size), readback(State, static_cast<std::size_t>(Size)));
+				return true;
+			}
+		case GlCall::GetProgramInfoLog:
+			{
+				const auto Program = Reader.read<GLuint>();
+				const auto Size = Reader.read<GLsizei>();
+				glGetProgramInfoLog(find(State.Programs, Program), Size, nullptr,
+				                    static_cast<GLchar*>(readback(State, static_cast<std::size_t>(Size))));
+				return true;
+			}
+		case GlCall::GetProgramiv:
+			{
+				const auto Program = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				glGetProgramiv(find(State.Programs, Program), Name,
+				               static_cast<GLint*>(readback(State, sizeof(GLint))));
+				return true;
+			}
+		case GlCall::GetQueryObjectiv:
+			{
+				const auto Query = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				glGetQueryObjectiv(find(State.Queries, Query), Name,
+				                   static_cast<GLint*>(readback(State, sizeof(GLint))));
+				return true;
+			}
+		case GlCall::GetQueryObjectui64v:
+			{
+				// Only read once the app found it available, which it may not be yet here. Waiting would stall the
+				// frame the way the app never did
+				const auto Query = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				const GLenum Read = Name == GL_QUERY_RESULT ? GL_QUERY_RESULT_NO_WAIT : Name;
+				glGetQueryObjectui64v(find(State.Queries, Query), Read,
+				                      static_cast<GLuint64*>(readback(State, sizeof(GLuint64))));
+				return true;
+			}
+		case GlCall::GetShaderInfoLog:
+			{
+				const auto Shader = Reader.read<GLuint>();
+				const auto Size = Reader.read<GLsizei>();
+				glGetShaderInfoLog(find(State.Programs, Shader), Size, nullptr,
+				                   static_cast<GLchar*>(readback(State, static_cast<std::size_t>(Size))));
+				return true;
+			}
+		case GlCall::GetShaderiv:
+			{
+				const auto Shader = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				glGetShaderiv(find(State.Programs, Shader), Name, static_cast<GLint*>(readback(State, sizeof(GLint))));
+				return true;
+			}
+		case GlCall::GetTextureImage:
+			{
+				const auto Texture = Reader.read<GLuint>();
+				const auto Level = Reader.read<GLint>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Type = Reader.read<GLenum>();
+				const auto Size = Reader.read<GLsizei>();
+				glGetTextureImage(find(State.Textures, Texture), Level, Format, Type, Size,
+				                  readback(State, static_cast<std::size_t>(Size)));
+				return true;
+			}
+		case GlCall::GetTextureLevelParameteriv:
+			{
+				const auto Texture = Reader.read<GLuint>();
+				const auto Level = Reader.read<GLint>();
+				const auto Name = Reader.read<GLenum>();
+				glGetTextureLevelParameteriv(find(State.Textures, Texture), Level, Name,
+				                             static_cast<GLint*>(readback(State, sizeof(GLint))));
+				return true;
+			}
+		case GlCall::GetUniformLocation:
+			{
+				const auto Program = Reader.read<GLuint>();
+				std::size_t Size = 0;
+				const unsigned char* Contents = Reader.readContents(Size);
+				const std::string Name(reinterpret_cast<const char*>(Contents), Size);
+				const auto Location = Reader.read<GLint>();
+				State.Locations[locationKey(Program, Location)] = glGetUniformLocation(find(State.Programs, Program),
+				                                                                      Name.c_str());
+				return true;
+			}
+		case GlCall::LinkProgram:
+			glLinkProgram(find(State.Programs, Reader.read<GLuint>()));
+			return true;
+		case GlCall::MapNamedBufferRange:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Offset = Reader.read<std::int64_t>();
+				const auto Length = Reader.read<std::int64_t>();
+				const auto Access = Reader.read<GLbitfield>();
+				void* Memory = glMapNamedBufferRange(find(State.Buffers, Buffer), static_cast<GLintptr>(Offset),
+				                                     static_cast<GLsizeiptr>(Length), Access);
+				if (Memory != nullptr)
+				{
+					State.Mappings[Buffer] = {static_cast<std::uint64_t>(Offset), static_cast<unsigned char*>(Memory),
+					                          static_cast<std::size_t>(Length)};
+				}
+				return true;
+			}
+		case GlCall::NamedBufferData:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Size = Reader.read<std::int64_t>();
+				const auto Usage = Reader.read<GLenum>();
+				std::size_t ContentSize = 0;
+				const unsigned char* Contents = Reader.readContents(ContentSize);
+				glNamedBufferData(find(State.Buffers, Buffer), static_cast<GLsizeiptr>(Size), Contents, Usage);
+				return true;
+			}
+		case GlCall::NamedBufferStorage:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Size = Reader.read<std::int64_t>();
+				const auto Flags = Reader.read<GLbitfield>();
+				std::size_t ContentSize = 0;
+				const unsigned char* Contents = Reader.readContents(ContentSize);
+				glNamedBufferStorage(find(State.Buffers, Buffer), static_cast<GLsizeiptr>(Size), Contents, Flags);
+				return true;
+			}
+		case GlCall::NamedBufferSubData:
+			{
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Offset = Reader.read<std::int64_t>();
+				std::size_t Size = 0;
+				const unsigned char* Contents = Reader.readContents(Size);
+				glNamedBufferSubData(find(State.Buffers, Buffer), static_cast<GLintptr>(Offset),
+				                     static_cast<GLsizeiptr>(Size), Contents);
+				return true;
+			}
+		case GlCall::NamedFramebufferRenderbuffer:
+			{
+				const auto Framebuffer = Reader.read<GLuint>();
+				const auto Attachment = Reader.read<GLenum>();
+				const auto RenderbufferTarget = Reader.read<GLenum>();
+				const auto Renderbuffer = Reader.read<GLuint>();
+				glNamedFramebufferRenderbuffer(find(State.Framebuffers, Framebuffer), Attachment, RenderbufferTarget,
+				                               find(State.Renderbuffers, Renderbuffer));
+				return true;
+			}
+		case GlCall::NamedFramebufferTexture:
+			{
+				const auto Framebuffer = Reader.read<GLuint>();
+				const auto Attachment = Reader.read<GLenum>();
+				const auto Texture = Reader.read<GLuint>();
+				const auto Level = Reader.read<GLint>();
+				glNamedFramebufferTexture(find(State.Framebuffers, Framebuffer), Attachment,
+				                          find(State.Textures, Texture), Level);
+				return true;
+			}
+		case GlCall::NamedRenderbufferStorage:
+			{
+				const auto Renderbuffer = Reader.read<GLuint>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				glNamedRenderbufferStorage(find(State.Renderbuffers, Renderbuffer), Format, Width, Height);
+				return true;
+			}
+		case GlCall::PolygonMode:
+			{
+				const auto Face = Reader.read<GLenum>();
+				const auto Mode = Reader.read<GLenum>();
+				glPolygonMode(Face, Mode);
+				return true;
+			}
+		case GlCall::QueryCounter:
+			{
+				const auto Query = Reader.read<GLuint>();
+				const auto Target = Reader.read<GLenum>();
+				glQueryCounter(find(State.Queries, Query), Target);
+				return true;
+			}
+		case GlCall::ReadPixels:
+			{
+				const auto X = Reader.read<GLint>();
+				const auto Y = Reader.read<GLint>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Type = Reader.read<GLenum>();
+				const std::size_t Pixels = static_cast<std::size_t>(std::max(Width, 0)) * std::max(Height, 0);
+				glReadPixels(X, Y, Width, Height, Format, Type, readback(State, Pixels * ReadbackBytesPerPixel));
+				return true;
+			}
+		case GlCall::RenderbufferStorage:
+			{
+				const auto Target = Reader.read<GLenum>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				glRenderbufferStorage(Target, Format, Width, Height);
+				return true;
+			}
+		case GlCall::ShaderSource:
+			{
+				const auto Shader = Reader.read<GLuint>();
+				const auto Count = std::max(Reader.read<GLsizei>(), 0);
+				std::vector<const GLchar*> Strings;
+				std::vector<GLint> Lengths;
+				for (GLsizei I = 0; I < Count && !Reader.hasFailed(); I++)
+				{
+					std::size_t Size = 0;
+					const unsigned char* Contents = Reader.readContents(Size);
+					Strings.push_back(Contents != nullptr ? reinterpret_cast<const GLchar*>(Contents) : "");
+					Lengths.push_back(static_cast<GLint>(Size));
+				}
+				glShaderSource(find(State.Programs, Shader), static_cast<GLsizei>(Strings.size()), Strings.data(),
+				               Lengths.data());
+				return true;
+			}
+		case GlCall::TextureParameteri:
+			{
+				const auto Texture = Reader.read<GLuint>();
+				const auto Name = Reader.read<GLenum>();
+				const auto Value = Reader.read<GLint>();
+				glTextureParameteri(find(State.Textures, Texture), Name, Value);
+				return true;
+			}
+		case GlCall::TextureStorage2D:
+			{
+				const auto Texture = Reader.read<GLuint>();
+				const auto Levels = Reader.read<GLsizei>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				glTextureStorage2D(find(State.Textures, Texture), Levels, Format, Width, Height);
+				return true;
+			}
+		case GlCall::TextureSubImage2D:
+			{
+				const auto Texture = Reader.read<GLuint>();
+				const auto Level = Reader.read<GLint>();
+				const auto X = Reader.read<GLint>();
+				const auto Y = Reader.read<GLint>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				const auto Format = Reader.read<GLenum>();
+				const auto Type = Reader.read<GLenum>();
+				std::size_t Size = 0;
+				const unsigned char* Contents = Reader.readContents(Size);
+				glTextureSubImage2D(find(State.Textures, Texture), Level, X, Y, Width, Height, Format, Type, Contents);
+				return true;
+			}
+		case GlCall::Uniform1f:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Value = Reader.read<GLfloat>();
+				glUniform1f(findLocation(State, Location), Value);
+				return true;
+			}
+		case GlCall::Uniform1i:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Value = Reader.read<GLint>();
+				glUniform1i(findLocation(State, Location), Value);
+				return true;
+			}
+		case GlCall::Uniform2fv:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				const GLfloat* Values = readFloats(Reader, State);
+				glUniform2fv(findLocation(State, Location), std::min(Count, static_cast<GLsizei>(
+					                 State.Floats.size() / 2)), Values);
+				return true;
+			}
+		case GlCall::Uniform3fv:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				const GLfloat* Values = readFloats(Reader, State);
+				glUniform3fv(findLocation(State, Location), std::min(Count, static_cast<GLsizei>(
+					                 State.Floats.size() / 3)), Values);
+				return true;
+			}
+		case GlCall::Uniform4fv:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				const GLfloat* Values = readFloats(Reader, State);
+				glUniform4fv(findLocation(State, Location), std::min(Count, static_cast<GLsizei>(
+					                 State.Floats.size() / 4)), Values);
+				return true;
+			}
+		case GlCall::UniformMatrix4fv:
+			{
+				const auto Location = Reader.read<GLint>();
+				const auto Count = Reader.read<GLsizei>();
+				const auto Transpose = Reader.read<GLboolean>();
+				const GLfloat* Values = readFloats(Reader, State);
+				glUniformMatrix4fv(findLocation(State, Location), std::min(Count, static_cast<GLsizei>(
+					                       State.Floats.size() / 16)), Transpose, Values);
+				return true;
+			}
+		case GlCall::UseProgram:
+			State.Program = Reader.read<GLuint>();
+			glUseProgram(find(State.Programs, State.Program));
+			return true;
+		case GlCall::VertexArrayAttribBinding:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Attribute = Reader.read<GLuint>();
+				const auto Binding = Reader.read<GLuint>();
+				glVertexArrayAttribBinding(find(State.Vaos, Vao), Attribute, Binding);
+				return true;
+			}
+		case GlCall::VertexArrayAttribFormat:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Attribute = Reader.read<GLuint>();
+				const auto Size = Reader.read<GLint>();
+				const auto Type = Reader.read<GLenum>();
+				const auto Normalised = Reader.read<GLboolean>();
+				const auto RelativeOffset = Reader.read<GLuint>();
+				glVertexArrayAttribFormat(find(State.Vaos, Vao), Attribute, Size, Type, Normalised, RelativeOffset);
+				return true;
+			}
+		case GlCall::VertexArrayBindingDivisor:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Binding = Reader.read<GLuint>();
+				const auto Divisor = Reader.read<GLuint>();
+				glVertexArrayBindingDivisor(find(State.Vaos, Vao), Binding, Divisor);
+				return true;
+			}
+		case GlCall::VertexArrayElementBuffer:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Buffer = Reader.read<GLuint>();
+				glVertexArrayElementBuffer(find(State.Vaos, Vao), find(State.Buffers, Buffer));
+				return true;
+			}
+		case GlCall::VertexArrayVertexBuffer:
+			{
+				const auto Vao = Reader.read<GLuint>();
+				const auto Binding = Reader.read<GLuint>();
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Offset = Reader.read<std::int64_t>();
+				const auto Stride = Reader.read<GLsizei>();
+				glVertexArrayVertexBuffer(find(State.Vaos, Vao), Binding, find(State.Buffers, Buffer),
+				                          static_cast<GLintptr>(Offset), Stride);
+				return true;
+			}
+		case GlCall::Viewport:
+			{
+				const auto X = Reader.read<GLint>();
+				const auto Y = Reader.read<GLint>();
+				const auto Width = Reader.read<GLsizei>();
+				const auto Height = Reader.read<GLsizei>();
+				glViewport(X, Y, Width, Height);
+				return true;
+			}
+		case GlCall::MappedWrite:
+			{
+				// Into the replay's own mapping of the buffer, dropped if it falls outside
+				const auto Buffer = Reader.read<GLuint>();
+				const auto Offset = Reader.read<std::uint64_t>();
+				std::size_t Size = 0;
+				const unsigned char* Contents = Reader.readContents(Size);
+				const auto It = State.Mappings.find(Buffer);
+				if (It != State.Mappings.end() && Size > 0 && Offset >= It->second.Offset
+					&& Offset - It->second.Offset + Size <= It->second.Size)
+				{
+					std::memcpy(It->second.Memory + (Offset - It->second.Offset), Contents, Size);
+				}
+				return true;
+			}
+		default:
+			return false;
+		}
+	}
+}
+
+int GlReplay::run(const ReplaySettings& Settings)
+{
+	// Read whole, so the disk never shows in the timings
+	auto Start = ReplayClock::now();
+	std::ifstream TraceFile(Settings.TracePath, std::ios::binary);
+	if (!TraceFile)
+	{
+		std::cerr << "Failed to open trace: " << Settings.TracePath << std::endl;
+		return -1;
+	}
+	const std::vector<unsigned char> Trace((std::istreambuf_iterator<char>(TraceFile)),
+	                                       std::istreambuf_iterator<char>());
+	const double ReadMs = millisecondsSince(Start);
+
+	TraceReader Reader(Trace);
+	const auto Magic = Reader.read<std::uint32_t>();
+	const auto Version = Reader.read<std::uint32_t>();
+	const auto Width = Reader.read<std::uint32_t>();
+	const auto Height = Reader.read<std::uint32_t>();
+	if (Reader.hasFailed() || Magic != GlCapture::Magic || Version != GlCapture::Version)
+	{
+		std::cerr << "Not a GL trace of version " << GlCapture::Version << ": " << Settings.TracePath << std::endl;
+		return -1;
+	}
+
+	GLFWwindow* Window = nullptr;
+	if (!HeadlessHarness::openContext(Settings.Context, Window))
+	{
+		return -1;
+	}
+
+	// Standing in for the window's framebuffer, at the size it was while recording
+	GLuint Target = 0;
+	GLuint Renderbuffers[2]{};
+	glCreateRenderbuffers(2, Renderbuffers);
+	glNamedRenderbufferStorage(Renderbuffers[0], GL_RGBA8, static_cast<GLsizei>(Width), static_cast<GLsizei>(Height));
+	glNamedRenderbufferStorage(Renderbuffers[1], GL_DEPTH24_STENCIL8, static_cast<GLsizei>(Width),
+	                           static_cast<GLsizei>(Height));
+	glCreateFramebuffers(1, &Target);
+	glNamedFramebufferRenderbuffer(Target, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, Renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(Target, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, Renderbuffers[1]);
+	if (glCheckNamedFramebufferStatus(Target, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Failed to create the replay's framebuffer" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, Target);
+	glViewport(0, 0, static_cast<GLsizei>(Width), static_cast<GLsizei>(Height));
+
+	ReplayState State;
+	State.Framebuffers[0] = Target;
+	CallTiming Timings[static_cast<int>(GlCall::Count)]{};
+	std::uint64_t Calls = 0;
+	std::vector<double> FrameMs;
+	std::vector<double> CpuMs;
+	double LoadMs = 0.0;
+	bool Loaded = false;
+	bool Corrupt = false;
+	auto FrameStart = ReplayClock::now();
+	while (!Reader.isAtEnd())
+	{
+		const std::size_t Position = Reader.getPosition();
+		const auto Call = static_cast<GlCall>(Reader.read<std::uint8_t>());
+		if (Call == GlCall::EndFrame)
+		{
+			// Waiting on the GPU, so a frame's time covers its own drawing
+			const double Cpu = millisecondsSince(FrameStart);
+			glFinish();
+			const double Frame = millisecondsSince(FrameStart);
+			if (Loaded)
+			{
+				CpuMs.push_back(Cpu);
+				FrameMs.push_back(Frame);
+			}
+			else
+			{
+				LoadMs = Frame;
+				Loaded = true;
+			}
+			FrameStart = ReplayClock::now();
+			continue;
+		}
+
+		const auto CallStart = ReplayClock::now();
+		if (!replayCall(Call, Reader, State) || Reader.hasFailed())
+		{
+			std::cerr << "Trace is corrupt at byte " << Position << ", replayed up to there" << std::endl;
+			Corrupt = true;
+			break;
+		}
+		const double Milliseconds = millisecondsSince(CallStart);
+		CallTiming& Timing = Timings[static_cast<int>(Call)];
+		Timing.Count++;
+		Timing.TotalMilliseconds += Milliseconds;
+		Timing.MaxMilliseconds = std::max(Timing.MaxMilliseconds, Milliseconds);
+		if (Call != GlCall::MappedWrite)
+		{
+			Calls++;
+		}
+	}
+	glFinish();
+
+	// Whatever the trace left bound to read from, the window's stand in for the app's own traces
+	std::vector<std::uint32_t> Pixels(static_cast<std::size_t>(Width) * Height);
+	glReadPixels(0, 0, static_cast<GLsizei>(Width), static_cast<GLsizei>(Height), GL_RGBA, GL_UNSIGNED_BYTE,
+	             Pixels.data());
+	if (Settings.ImagePath != nullptr)
+	{
+		SoftwareBackend::writeImage(Settings.ImagePath, Pixels, Width, Height);
+	}
+
+	std::ofstream File;
+	if (Settings.OutputPath != nullptr)
+	{
+		File.open(Settings.OutputPath);
+		if (!File)
+		{
+			std::cerr << "Failed to open " << Settings.OutputPath << std::endl;
+		}
+	}
+	std::ostream& Out = File.is_open() ? static_cast<std::ostream&>(File) : std::cout;
+	char Hash[17];
+	std::snprintf(Hash, sizeof(Hash), "%016llx", static_cast<unsigned long long>(HeadlessHarness::hashImage(Pixels)));
+	Out << "{\n";
+	Out << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n";
+	Out << "  \"gl_version\": \"" << glGetString(GL_VERSION) << "\",\n";
+	Out << "  \"trace\": \"" << Settings.TracePath << "\",\n";
+	Out << "  \"trace_bytes\": " << Trace.size() << ",\n";
+	Out << "  \"width\": " << Width << ",\n";
+	Out << "  \"height\": " << Height << ",\n";
+	Out << "  \"frames\": " << FrameMs.size() << ",\n";
+	Out << "  \"calls\": " << Calls << ",\n";
+	Out << "  \"load_ms\": {\"read\": " << ReadMs << ", \"replay\": " << LoadMs << "},\n";
+	HeadlessHarness::writeDistribution(Out, "frame_ms", FrameMs);
+	HeadlessHarness::writeDistribution(Out, "cpu_ms", CpuMs);
+
+	Out << "  \"frame_list\": [";
+	for (std::size_t Frame = 0; Frame < FrameMs.size(); Frame++)
+	{
+		Out << (Frame > 0 ? ", " : "") << "{\"cpu_ms\": " << CpuMs[Frame] << ", \"frame_ms\": " << FrameMs[Frame]
+			<< "}";
+	}
+	Out << "],\n";
+
+	// Costliest first, over the loading and every frame
+	std::vector<GlCall> Replayed;
+	for (int Call = 0; Call < static_cast<int>(GlCall::Count); Call++)
+	{
+		if (Timings[Call].Count > 0)
+		{
+			Replayed.push_back(static_cast<GlCall>(Call));
+		}
+	}
+	std::sort(Replayed.begin(), Replayed.end(), [&Timings](const GlCall A, const GlCall B)
+	{
+		return Timings[static_cast<int>(A)].TotalMilliseconds > Timings[static_cast<int>(B)].TotalMilliseconds;
+	});
+	Out << "  \"call_ms\": [\n";
+	for (std::size_t I = 0; I < Replayed.size(); I++)
+	{
+		const CallTiming& Timing = Timings[static_cast<int>(Replayed[I])];
+		Out << "    {\"call\": \"" << GlCapture::getCallName(Replayed[I]) << "\", \"count\": " << Timing.Count
+			<< ", \"total_ms\": " << Timing.TotalMilliseconds << ", \"mean_us\": "
+			<< Timing.TotalMilliseconds * 1000.0 / static_cast<double>(Timing.Count) << ", \"max_us\": "
+			<< Timing.MaxMilliseconds * 1000.0 << "}" << (I + 1 < Replayed.size() ? ",\n" : "\n");
+	}
+	Out << "  ],\n";
+	Out << "  \"image_hash\": \"" << Hash << "\"\n";
+	Out << "}\n";
+
+	glfwTerminate();
+	return Corrupt ? -1 : 0;
+}
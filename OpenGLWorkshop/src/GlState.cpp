@@ -0,0 +1,295 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : GlState.cpp
+Description : Implementations for a cache of bound GL state that drops
+			  calls which would change nothing, with counters
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "GlState.h"
+
+#include "GlCapture.h"
+
+namespace
+{
+	constexpr GLuint Unknown = ~0u; // No GL name or enum takes this value
+	constexpr GLenum BufferTargets[] = {
+		GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+		GL_DISPATCH_INDIRECT_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_QUERY_BUFFER,
+		GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER
+	};
+	constexpr int BufferTargetCount = sizeof(BufferTargets) / sizeof(BufferTargets[0]);
+	constexpr GLenum Capabilities[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE};
+	constexpr int CapabilityCount = sizeof(Capabilities) / sizeof(Capabilities[0]);
+
+	struct CachedState
+	{
+		GLuint Program;
+		GLuint Vao;
+		GLuint Textures[GlState::TextureUnits];
+		GLuint Buffers[BufferTargetCount];
+		GLuint Capabilities[CapabilityCount]; // GL_TRUE, GL_FALSE or Unknown
+		GLenum BlendSource;
+		GLenum BlendDestination;
+		GLenum DepthFunction;
+		GLuint DepthWrite;
+		GLenum CullFace;
+		GLenum PolygonMode;
+	};
+
+	CachedState unknownState()
+	{
+		CachedState State{};
+		State.Program = Unknown;
+		State.Vao = Unknown;
+		for (GLuint& Texture : State.Textures)
+		{
+			Texture = Unknown;
+		}
+		for (GLuint& Buffer : State.Buffers)
+		{
+			Buffer = Unknown;
+		}
+		for (GLuint& Capability : State.Capabilities)
+		{
+			Capability = Unknown;
+		}
+		State.BlendSource = Unknown;
+		State.BlendDestination = Unknown;
+		State.DepthFunction = Unknown;
+		State.DepthWrite = Unknown;
+		State.CullFace = Unknown;
+		State.PolygonMode = Unknown;
+		return State;
+	}
+
+	CachedState GCache = unknownState();
+	GlStateStats GStats{};
+	bool GFiltering = true;
+
+	// Records the call and says whether it has to reach GL, updating the cached value when it does
+	template <typename T>
+	bool change(const GlStateCall Call, T& Cached, const T Value)
+	{
+		const auto Index = static_cast<int>(Call);
+		if (GFiltering && Cached == Value)
+		{
+			GStats.Filtered[Index]++;
+			GStats.TotalFiltered++;
+			return false;
+		}
+		Cached = Value;
+		GStats.Issued[Index]++;
+		GStats.TotalIssued++;
+		return true;
+	}
+
+	// Calls the cache has no slot for always reach GL
+	void issue(const GlStateCall Call)
+	{
+		GStats.Issued[static_cast<int>(Call)]++;
+		GStats.TotalIssued++;
+	}
+
+	int findBufferTarget(const GLenum Target)
+	{
+		for (int I = 0; I < BufferTargetCount; I++)
+		{
+			if (BufferTargets[I] == Target)
+			{
+				return I;
+			}
+		}
+		return -1;
+	}
+
+	int findCapability(const GLenum Capability)
+	{
+		for (int I = 0; I < CapabilityCount; I++)
+		{
+			if (Capabilities[I] == Capability)
+			{
+				return I;
+			}
+		}
+		return -1;
+	}
+
+	// GL reverts a binding of a deleted object to 0, the cache follows
+	void forget(GLuint* Bindings, const int Count, const GLsizei NameCount, const GLuint* Names)
+	{
+		for (int I = 0; I < Count; I++)
+		{
+			for (GLsizei Name = 0; Name < NameCount; Name++)
+			{
+				if (Bindings[I] == Names[Name] && Names[Name] != 0)
+				{
+					Bindings[I] = 0;
+				}
+			}
+		}
+	}
+}
+
+void GlState::useProgram(const GLuint Program)
+{
+	if (change(GlStateCall::Program, GCache.Program, Program))
+	{
+		glUseProgram(Program);
+	}
+}
+
+void GlState::bindVertexArray(const GLuint Vao)
+{
+	if (change(GlStateCall::VertexArray, GCache.Vao, Vao))
+	{
+		glBindVertexArray(Vao);
+	}
+}
+
+void GlState::bindTexture(const GLuint Unit, const GLuint Texture)
+{
+	if (Unit >= TextureUnits)
+	{
+		issue(GlStateCall::Texture);
+		glBindTextureUnit(Unit, Texture);
+		return;
+	}
+	if (change(GlStateCall::Texture, GCache.Textures[Unit], Texture))
+	{
+		glBindTextureUnit(Unit, Texture);
+	}
+}
+
+void GlState::bindBuffer(const GLenum Target, const GLuint Buffer)
+{
+	const int Slot = findBufferTarget(Target);
+	if (Slot < 0)
+	{
+		issue(GlStateCall::Buffer);
+		glBindBuffer(Target, Buffer);
+		return;
+	}
+	if (change(GlStateCall::Buffer, GCache.Buffers[Slot], Buffer))
+	{
+		glBindBuffer(Target, Buffer);
+	}
+}
+
+void GlState::setEnabled(const GLenum Capability, const bool Enabled)
+{
+	const int Slot = findCapability(Capability);
+	if (Slot < 0)
+	{
+		issue(GlStateCall::Capability);
+	}
+	else if (!change(GlStateCall::Capability, GCache.Capabilities[Slot], Enabled ? GLuint{GL_TRUE} : GL_FALSE))
+	{
+		return;
+	}
+
+	if (Enabled)
+	{
+		glEnable(Capability);
+	}
+	else
+	{
+		glDisable(Capability);
+	}
+}
+
+void GlState::blendFunc(const GLenum Source, const GLenum Destination)
+{
+	if (GFiltering && GCache.BlendSource == Source && GCache.BlendDestination == Destination)
+	{
+		GStats.Filtered[static_cast<int>(GlStateCall::BlendFunc)]++;
+		GStats.TotalFiltered++;
+		return;
+	}
+	GCache.BlendSource = Source;
+	GCache.BlendDestination = Destination;
+	issue(GlStateCall::BlendFunc);
+	glBlendFunc(Source, Destination);
+}
+
+void GlState::depthFunc(const GLenum Function)
+{
+	if (change(GlStateCall::DepthFunc, GCache.DepthFunction, Function))
+	{
+		glDepthFunc(Function);
+	}
+}
+
+void GlState::depthMask(const bool Write)
+{
+	if (change(GlStateCall::DepthMask, GCache.DepthWrite, Write ? GLuint{GL_TRUE} : GL_FALSE))
+	{
+		glDepthMask(Write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GlState::cullFace(const GLenum Face)
+{
+	if (change(GlStateCall::CullFace, GCache.CullFace, Face))
+	{
+		glCullFace(Face);
+	}
+}
+
+void GlState::polygonMode(const GLenum Mode)
+{
+	if (change(GlStateCall::PolygonMode, GCache.PolygonMode, Mode))
+	{
+		glPolygonMode(GL_FRONT_AND_BACK, Mode);
+	}
+}
+
+void GlState::deleteVertexArrays(const GLsizei Count, const GLuint* VertexArrays)
+{
+	forget(&GCache.Vao, 1, Count, VertexArrays);
+	glDeleteVertexArrays(Count, VertexArrays);
+}
+
+void GlState::deleteTextures(const GLsizei Count, const GLuint* Textures)
+{
+	forget(GCache.Textures, TextureUnits, Count, Textures);
+	glDeleteTextures(Count, Textures);
+}
+
+void GlState::deleteBuffers(const GLsizei Count, const GLuint* Buffers)
+{
+	forget(GCache.Buffers, BufferTargetCount, Count, Buffers);
+	glDeleteBuffers(Count, Buffers);
+}
+
+void GlState::invalidate()
+{
+	GCache = unknownState();
+}
+
+void GlState::setFilteringEnabled(const bool Enabled)
+{
+	GFiltering = Enabled;
+}
+
+bool GlState::isFilteringEnabled()
+{
+	return GFiltering;
+}
+
+const GlStateStats& GlState::getStats()
+{
+	return GStats;
+}
+
+void GlState::resetStats()
+{
+	GStats = {};
+}
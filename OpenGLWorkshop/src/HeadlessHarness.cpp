@@ -0,0 +1,460 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : HeadlessHarness.cpp
+Description : Implementations for a scripted run of the scene rendered off
+			  screen, reported as JSON
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "HeadlessHarness.h"
+
+#include <glew.h>
+#include <glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Renderer.h"
+#include "ShaderLoader.h"
+#include "ModelLoader.h"
+#include "ImpostorBaker.h"
+#include "InstancePool.h"
+#include "InstanceScatter.h"
+#include "TransformStorage.h"
+#include "FlockSimulation.h"
+#include "Simulation.h"
+#include "FrameClock.h"
+#include "RenderQueue.h"
+#include "CommandBuffer.h"
+#include "GlState.h"
+#include "RenderBackend.h"
+#include "SoftwareBackend.h"
+#include "GlCapture.h"
+
+namespace
+{
+	using HarnessClock = std::chrono::steady_clock;
+
+	// Of the app's frame, in the order it runs them
+	constexpr int StageCount = 6;
+	constexpr const char* StageNames[StageCount] = {"simulate", "cull", "begin", "record", "execute", "submit"};
+
+	double millisecondsSince(const HarnessClock::time_point Start)
+	{
+		return std::chrono::duration<double, std::milli>(HarnessClock::now() - Start).count();
+	}
+
+	struct Distribution
+	{
+		double Mean;
+		double P50;
+		double P90;
+		double P99;
+		double Max;
+	};
+
+	// Nearest rank percentiles
+	Distribution distribute(std::vector<double> Values)
+	{
+		Distribution Result{};
+		if (Values.empty())
+		{
+			return Result;
+		}
+		std::sort(Values.begin(), Values.end());
+		auto rank = [&Values](const double Percentile)
+		{
+			const auto Rank = static_cast<std::size_t>(Percentile * static_cast<double>(Values.size()) + 0.999999);
+			return Values[std::clamp<std::size_t>(Rank, 1, Values.size()) - 1];
+		};
+		double Sum = 0.0;
+		for (const double Value : Values)
+		{
+			Sum += Value;
+		}
+		Result.Mean = Sum / static_cast<double>(Values.size());
+		Result.P50 = rank(0.5);
+		Result.P90 = rank(0.9);
+		Result.P99 = rank(0.99);
+		Result.Max = Values.back();
+		return Result;
+	}
+
+	// Orbits, closes in while turning back, pulls out and orbits fast, in quarters of the run. The moving object
+	// traces a square a second a side
+	SimulationInput scriptedInput(const unsigned int Frame, const unsigned int Frames)
+	{
+		const float Progress = static_cast<float>(Frame) / static_cast<float>(Frames);
+		SimulationInput Input{};
+		Input.Camera.RotateClockwise = Progress < 0.25f || Progress >= 0.75f;
+		Input.Camera.RotateAntiClockwise = Progress >= 0.25f && Progress < 0.75f;
+		Input.Camera.MoveCloser = Progress >= 0.25f && Progress < 0.5f;
+		Input.Camera.MoveAway = Progress >= 0.5f && Progress < 0.75f;
+		Input.Camera.Fast = Progress >= 0.75f;
+
+		const unsigned int Side = Frame / 60 % 4;
+		Input.Object = glm::vec3(Side == 0 ? 1.0f : Side == 2 ? -1.0f : 0.0f, 0.0f,
+		                         Side == 1 ? 1.0f : Side == 3 ? -1.0f : 0.0f);
+		Input.CollisionEnabled = true;
+		Input.SwarmRunning = true;
+		return Input;
+	}
+}
+
+int HeadlessHarness::run(const HeadlessSettings& Settings)
+{
+	auto Start = HarnessClock::now();
+	GLFWwindow* Window = nullptr;
+	if (!openContext(Settings.Context, Window))
+	{
+		return -1;
+	}
+	const double ContextMs = millisecondsSince(Start);
+
+	// From the first call, as a replay only has the objects made while capturing
+	if (Settings.CapturePath != nullptr && !GlCapture::start(Settings.CapturePath, Settings.Width, Settings.Height))
+	{
+		glfwTerminate();
+		return -1;
+	}
+	GlState::invalidate();
+	GlState::setEnabled(GL_DEPTH_TEST, true);
+	GlState::setEnabled(GL_CULL_FACE, true);
+	GlState::cullFace(GL_BACK);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+	GLuint Framebuffer = 0;
+	GLuint Renderbuffers[2]{};
+	glCreateRenderbuffers(2, Renderbuffers);
+	glNamedRenderbufferStorage(Renderbuffers[0], GL_RGBA8, static_cast<GLsizei>(Settings.Width),
+	                           static_cast<GLsizei>(Settings.Height));
+	glNamedRenderbufferStorage(Renderbuffers[1], GL_DEPTH_COMPONENT24, static_cast<GLsizei>(Settings.Width),
+	                           static_cast<GLsizei>(Settings.Height));
+	glCreateFramebuffers(1, &Framebuffer);
+	glNamedFramebufferRenderbuffer(Framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, Renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(Framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, Renderbuffers[1]);
+	if (glCheckNamedFramebufferStatus(Framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Failed to create the headless framebuffer" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
+	// Loading, timed by stage the way the app loads
+	Start = HarnessClock::now();
+	const GLuint ShaderProgram = ShaderLoader::createProgram("resources/shaders/VertexShader.vert",
+	                                                         "resources/shaders/FragmentShader.frag");
+	const GLuint ImpostorProgram = ShaderLoader::createProgram("resources/shaders/ImpostorVertexShader.vert",
+	                                                           "resources/shaders/ImpostorFragmentShader.frag");
+	const double ShadersMs = millisecondsSince(Start);
+
+	Start = HarnessClock::now();
+	constexpr ModelLoader LModelLoader;
+	const Model LModel = LModelLoader.loadModel("resources/models/SciFiSpace/SM_Prop_Mine_01.obj",
+	                                            "resources/textures/PolygonSciFiSpace_Texture_01_A.png");
+	const Model MovingObjectModel = LModelLoader.loadModel("resources/models/SciFiSpace/SM_Ship_Fighter_02.obj",
+	                                                       "resources/textures/PolygonAncientWorlds_Texture_01_A.png");
+	const double ModelsMs = millisecondsSince(Start);
+	if (!ShaderProgram || !ImpostorProgram || LModel.Vao == 0 || MovingObjectModel.Vao == 0)
+	{
+		std::cerr << "Failed to load the scene's resources" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+
+	Start = HarnessClock::now();
+	ImpostorAtlas Atlas = ImpostorBaker::bake(LModel, ShaderProgram);
+	const double ImpostorsMs = millisecondsSince(Start);
+
+	Start = HarnessClock::now();
+	ScatterSettings Scatter;
+	Scatter.Seed = Settings.Seed;
+	TransformStorage InstanceTransforms;
+	InstanceScatter::generateParallel(Scatter, Settings.InstanceCount, InstanceTransforms);
+	std::vector<glm::mat4> ModelMatrices(Settings.InstanceCount);
+	TransformComposer::composeParallel(InstanceTransforms, ModelMatrices.data());
+	std::vector<InstanceAnimation> Animations(Settings.InstanceCount);
+	if (Settings.Animate)
+	{
+		InstanceScatter::generateAnimations(Scatter, 0, Settings.InstanceCount, Animations);
+	}
+	InstancePool Instances(Settings.InstanceCount);
+	for (unsigned int I = 0; I < Settings.InstanceCount; I++)
+	{
+		Instances.spawn(ModelMatrices[I], Animations[I]);
+	}
+	Instances.attachToVao(LModel.Vao, 3);
+	Instances.upload();
+
+	FlockSettings SwarmSettings;
+	SwarmSettings.Seed = Settings.Seed;
+	FlockSimulation Swarm(SwarmSettings);
+	Swarm.spawn(Settings.SwarmCount);
+	Swarm.setObstacles(Instances, LModel);
+	const double InstancesMs = millisecondsSince(Start);
+
+	std::vector<double> FrameMs;
+	std::vector<double> CpuMs;
+	std::vector<double> DrawCalls;
+	std::vector<double> Triangles;
+	double StageMs[StageCount]{};
+	unsigned int InvalidCommands = 0;
+	std::uint64_t ImageHash = 0;
+	std::vector<std::uint32_t> Pixels;
+	NullBackend Null;
+	SoftwareBackend Software(Settings.Width, Settings.Height);
+	{
+		auto LRenderer = std::make_unique<Renderer>(Settings.Width, Settings.Height, Window);
+		LRenderer->setImpostors(Atlas, ImpostorProgram);
+		LRenderer->setMovingObjectOccluder(MovingObjectModel);
+		LRenderer->setSwarmModel(MovingObjectModel);
+		if (Settings.Backend == HeadlessBackend::Null)
+		{
+			LRenderer->setBackend(Null);
+		}
+		else if (Settings.Backend == HeadlessBackend::Software)
+		{
+			// Impostors are drawn by their own shader, which only GL runs
+			Software.addModel(LModel);
+			Software.addModel(MovingObjectModel);
+			Software.addInstancePool(Instances);
+			LRenderer->setBackend(Software);
+			LRenderer->setImpostorsEnabled(false);
+		}
+		RenderBackend& Backend = LRenderer->getBackend();
+
+		Simulation World;
+		World.setInstances(Instances, LModel);
+		World.setMovingObject(MovingObjectModel);
+		World.setSwarm(Swarm);
+
+		// The app's frame in the order its graph runs it, all on this thread
+		FrameSnapshot Snapshot;
+		PreparedScene Prepared;
+		RenderQueue Queue;
+		const BucketId SceneBucket = Queue.addBucket("scene");
+		CommandBuffer Buffers[3];
+		FrameMs.reserve(Settings.Frames);
+		glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+		glViewport(0, 0, static_cast<GLsizei>(Settings.Width), static_cast<GLsizei>(Settings.Height));
+		GlCapture::endFrame(); // Loading, recorded as a frame of its own
+		for (unsigned int Frame = 0; Frame < Settings.Frames; Frame++)
+		{
+			const auto FrameStart = HarnessClock::now();
+			auto Lap = FrameStart;
+			auto time = [&Lap, &StageMs](const int Stage)
+			{
+				const auto Now = HarnessClock::now();
+				StageMs[Stage] += std::chrono::duration<double, std::milli>(Now - Lap).count();
+				Lap = Now;
+			};
+
+			GlState::resetStats();
+			World.runFrame(scriptedInput(Frame, Settings.Frames), (Frame + 1) * FrameClock::DefaultStep, Snapshot);
+			LRenderer->setFrame(Snapshot);
+			time(0);
+			LRenderer->prepareScene(Snapshot, LModel, Instances, Prepared);
+			time(1);
+			LRenderer->beginScene(LModel, Instances, Prepared);
+			time(2);
+			for (CommandBuffer& Buffer : Buffers)
+			{
+				Buffer.begin();
+			}
+			LRenderer->recordScene(Buffers[0], ShaderProgram, LModel, Instances, Prepared);
+			LRenderer->recordMovingObject(Buffers[1], ShaderProgram, MovingObjectModel);
+			LRenderer->recordSwarm(Buffers[2], ShaderProgram);
+			for (CommandBuffer& Buffer : Buffers)
+			{
+				Buffer.end();
+			}
+			time(3);
+
+			Backend.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			Queue.clear();
+			for (const CommandBuffer& Buffer : Buffers)
+			{
+				LRenderer->execute(Queue, SceneBucket, Buffer);
+			}
+			time(4);
+			LRenderer->submit(Queue);
+			time(5);
+			CpuMs.push_back(millisecondsSince(FrameStart));
+
+			// Waiting on the GPU each frame, so a frame's time covers its own drawing
+			if (Settings.Backend == HeadlessBackend::Gl)
+			{
+				glFinish();
+			}
+			FrameMs.push_back(millisecondsSince(FrameStart));
+			GlCapture::endFrame();
+			DrawCalls.push_back(LRenderer->getStats().DrawCalls);
+			Triangles.push_back(static_cast<double>(LRenderer->getStats().Triangles));
+			InvalidCommands += LRenderer->getStats().Backend.Invalid;
+		}
+
+		GlCapture::stop();
+		if (Settings.Backend == HeadlessBackend::Gl)
+		{
+			Pixels.resize(static_cast<std::size_t>(Settings.Width) * Settings.Height);
+			glReadPixels(0, 0, static_cast<GLsizei>(Settings.Width), static_cast<GLsizei>(Settings.Height), GL_RGBA,
+			             GL_UNSIGNED_BYTE, Pixels.data());
+		}
+		else if (Settings.Backend == HeadlessBackend::Software)
+		{
+			Software.readPixels(Pixels);
+		}
+		ImageHash = hashImage(Pixels);
+		if (Settings.ImagePath != nullptr && !Pixels.empty())
+		{
+			SoftwareBackend::writeImage(Settings.ImagePath, Pixels, Settings.Width, Settings.Height);
+		}
+	}
+
+	std::ofstream File;
+	if (Settings.OutputPath != nullptr)
+	{
+		File.open(Settings.OutputPath);
+		if (!File)
+		{
+			std::cerr << "Failed to open " << Settings.OutputPath << std::endl;
+		}
+	}
+	std::ostream& Out = File.is_open() ? static_cast<std::ostream&>(File) : std::cout;
+	char Hash[17];
+	std::snprintf(Hash, sizeof(Hash), "%016llx", static_cast<unsigned long long>(ImageHash));
+	Out << "{\n";
+	Out << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n";
+	Out << "  \"gl_version\": \"" << glGetString(GL_VERSION) << "\",\n";
+	Out << "  \"seed\": " << Settings.Seed << ",\n";
+	Out << "  \"frames\": " << Settings.Frames << ",\n";
+	Out << "  \"width\": " << Settings.Width << ",\n";
+	Out << "  \"height\": " << Settings.Height << ",\n";
+	Out << "  \"instances\": " << Settings.InstanceCount << ",\n";
+	Out << "  \"swarm\": " << Settings.SwarmCount << ",\n";
+	const char* BackendName = Settings.Backend == HeadlessBackend::Null ? Null.getName()
+		: Settings.Backend == HeadlessBackend::Software ? Software.getName() : GlBackend::get().getName();
+	Out << "  \"backend\": \"" << BackendName << "\",\n";
+	Out << "  \"load_ms\": {\"context\": " << ContextMs << ", \"shaders\": " << ShadersMs << ", \"models\": "
+		<< ModelsMs << ", \"impostors\": " << ImpostorsMs << ", \"instances\": " << InstancesMs << ", \"total\": "
+		<< ContextMs + ShadersMs + ModelsMs + ImpostorsMs + InstancesMs << "},\n";
+	writeDistribution(Out, "frame_ms", FrameMs);
+	writeDistribution(Out, "cpu_ms", CpuMs);
+	writeDistribution(Out, "draw_calls", DrawCalls);
+	writeDistribution(Out, "triangles", Triangles);
+
+	// Per frame averages
+	Out << "  \"stage_ms\": {";
+	for (int Stage = 0; Stage < StageCount; Stage++)
+	{
+		Out << (Stage > 0 ? ", \"" : "\"") << StageNames[Stage] << "\": "
+			<< StageMs[Stage] / std::max(Settings.Frames, 1u);
+	}
+	Out << "},\n";
+
+	// The frame can go no faster than the thread producing it
+	const double CpuMean = distribute(CpuMs).Mean;
+	Out << "  \"fps_upper_bound\": " << (CpuMean > 0.0 ? 1000.0 / CpuMean : 0.0) << ",\n";
+	Out << "  \"invalid_commands\": " << InvalidCommands << ",\n";
+	if (Settings.CapturePath == nullptr)
+	{
+		Out << "  \"capture\": null,\n";
+	}
+	else
+	{
+		// Recording adds to the CPU side of every frame above
+		const GlCaptureStats& Capture = GlCapture::getStats();
+		Out << "  \"capture\": {\"path\": \"" << Settings.CapturePath << "\", \"frames\": " << Capture.Frames
+			<< ", \"calls\": " << Capture.Calls << ", \"bytes\": " << Capture.Bytes << ", \"content_bytes\": "
+			<< Capture.ContentBytes << "},\n";
+	}
+	if (Pixels.empty())
+	{
+		Out << "  \"image_hash\": null\n"; // Nothing was drawn
+	}
+	else
+	{
+		Out << "  \"image_hash\": \"" << Hash << "\"\n";
+	}
+	Out << "}\n";
+
+	Instances.releaseBuffer();
+	ImpostorBaker::release(Atlas);
+	glDeleteProgram(ShaderProgram);
+	glDeleteProgram(ImpostorProgram);
+	glDeleteFramebuffers(1, &Framebuffer);
+	glDeleteRenderbuffers(2, Renderbuffers);
+	glfwTerminate();
+	return 0;
+}
+
+bool HeadlessHarness::openContext(const HeadlessContext Context, GLFWwindow*& Window)
+{
+	if (!glfwInit())
+	{
+		std::cerr << "Failed to initialise GLFW" << std::endl;
+		return false;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	if (Context == HeadlessContext::Egl)
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+	}
+	else if (Context == HeadlessContext::OsMesa)
+	{
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+	}
+
+	// Everything draws into the framebuffer object, the window's own framebuffer only has to exist
+	Window = glfwCreateWindow(1, 1, "Headless", nullptr, nullptr);
+	if (!Window)
+	{
+		std::cerr << "Failed to create a hidden GLFW window" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	glfwMakeContextCurrent(Window);
+	glfwSwapInterval(0);
+	if (glewInit() != GLEW_OK)
+	{
+		std::cerr << "Failed to initialise GLEW" << std::endl;
+		glfwTerminate();
+		return false;
+	}
+	return true;
+}
+
+std::uint64_t HeadlessHarness::hashImage(const std::vector<std::uint32_t>& Pixels)
+{
+	std::uint64_t Hash = 1469598103934665603ull;
+	for (const std::uint32_t Pixel : Pixels)
+	{
+		for (int Byte = 0; Byte < 4; Byte++)
+		{
+			Hash = (Hash ^ ((Pixel >> (Byte * 8)) & 0xff)) * 1099511628211ull;
+		}
+	}
+	return Hash;
+}
+
+void HeadlessHarness::writeDistribution(std::ostream& Out, const char* Name, const std::vector<double>& Values)
+{
+	const Distribution Result = distribute(Values);
+	Out << "  \"" << Name << "\": {\"mean\": " << Result.Mean << ", \"p50\": " << Result.P50 << ", \"p90\": "
+		<< Result.P90 << ", \"p99\": " << Result.P99 << ", \"max\": " << Result.Max << "},\n";
+}
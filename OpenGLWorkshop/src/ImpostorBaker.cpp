@@ -0,0 +1,192 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : ImpostorBaker.cpp
+Description : Implementations for baking octahedral impostor atlases
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "ImpostorBaker.h"
+
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "GlState.h"
+#include "Profiler.h"
+#include "GlCapture.h"
+
+// Lowest mip level keeps frames at least this many texels wide so they don't bleed into their neighbours
+constexpr int MinFrameMipResolution = 16;
+
+// Sign that treats zero as positive so points on the fold lines map to one side
+static glm::vec2 signNotZero(const glm::vec2& Value)
+{
+	return {Value.x >= 0.0f ? 1.0f : -1.0f, Value.y >= 0.0f ? 1.0f : -1.0f};
+}
+
+ImpostorAtlas ImpostorBaker::bake(const Model& Model, const GLuint ShaderProgram, const int GridSize,
+                                  const int FrameResolution)
+{
+	const ProfileScope Scope("bake impostors", true);
+	ImpostorAtlas Atlas{};
+	Atlas.GridSize = std::max(GridSize, 2);
+	Atlas.FrameResolution = FrameResolution;
+	Atlas.Center = Model.BoundsCenter;
+	Atlas.Radius = Model.BoundsRadius;
+
+	// Save the state the bake overwrites
+	GLint PreviousFramebuffer = 0;
+	GLint PreviousViewport[4];
+	GLfloat PreviousClearColor[4];
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, PreviousClearColor);
+
+	const int AtlasSize = Atlas.GridSize * FrameResolution;
+	int MipLevels = 1;
+	while ((FrameResolution >> MipLevels) >= MinFrameMipResolution)
+	{
+		MipLevels++;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &Atlas.Texture);
+	glTextureStorage2D(Atlas.Texture, MipLevels, GL_RGBA8, AtlasSize, AtlasSize);
+	glTextureParameteri(Atlas.Texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(Atlas.Texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(Atlas.Texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(Atlas.Texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	GLuint DepthBuffer;
+	glGenRenderbuffers(1, &DepthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, AtlasSize, AtlasSize);
+
+	GLuint Framebuffer;
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Atlas.Texture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cerr << "Impostor framebuffer is incomplete" << std::endl;
+	}
+
+	// Zero alpha marks texels the model doesn't cover
+	glViewport(0, 0, AtlasSize, AtlasSize);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	GlState::useProgram(ShaderProgram);
+	GlState::bindTexture(0, Model.Texture);
+	glUniform1i(glGetUniformLocation(ShaderProgram, "instanced"), GL_FALSE);
+	const GLint MvpLocation = glGetUniformLocation(ShaderProgram, "mvp");
+
+	// Orthographic frames sized to the bounding sphere so a quad of the same size lines up with the mesh
+	const float Radius = Atlas.Radius;
+	const glm::mat4 Projection = glm::ortho(-Radius, Radius, -Radius, Radius, Radius, 3.0f * Radius);
+	GlState::bindVertexArray(Model.Vao);
+	for (int Y = 0; Y < Atlas.GridSize; Y++)
+	{
+		for (int X = 0; X < Atlas.GridSize; X++)
+		{
+			const glm::vec2 Coordinate = glm::vec2(X, Y) / static_cast<float>(Atlas.GridSize - 1);
+			const glm::vec3 Direction = octahedralDirection(Coordinate);
+			const glm::mat4 View = lookAt(Atlas.Center + Direction * (2.0f * Radius), Atlas.Center,
+			                              frameUp(Direction));
+			const glm::mat4 Mvp = Projection * View;
+			glUniformMatrix4fv(MvpLocation, 1, GL_FALSE, value_ptr(Mvp));
+			glViewport(X * FrameResolution, Y * FrameResolution, FrameResolution, FrameResolution);
+			glDrawElements(GL_TRIANGLES, Model.IndexCount, GL_UNSIGNED_INT, nullptr);
+		}
+	}
+
+	glGenerateTextureMipmap(Atlas.Texture);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, PreviousFramebuffer);
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+	glClearColor(PreviousClearColor[0], PreviousClearColor[1], PreviousClearColor[2], PreviousClearColor[3]);
+	glDeleteFramebuffers(1, &Framebuffer);
+	glDeleteRenderbuffers(1, &DepthBuffer);
+
+	// Corners of a unit quad as a triangle strip, counter clockwise when facing the camera
+	constexpr float QuadCorners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+	glCreateVertexArrays(1, &Atlas.QuadVao);
+	glCreateBuffers(1, &Atlas.QuadVbo);
+	glNamedBufferData(Atlas.QuadVbo, sizeof(QuadCorners), QuadCorners, GL_STATIC_DRAW);
+	glVertexArrayVertexBuffer(Atlas.QuadVao, 0, Atlas.QuadVbo, 0, 2 * sizeof(float));
+	glEnableVertexArrayAttrib(Atlas.QuadVao, 0);
+	glVertexArrayAttribFormat(Atlas.QuadVao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(Atlas.QuadVao, 0, 0);
+
+	// Instance matrix format only, the renderer binds whichever buffer holds this frame's impostors
+	for (GLuint I = 0; I < 4; I++)
+	{
+		glEnableVertexArrayAttrib(Atlas.QuadVao, 3 + I);
+		glVertexArrayAttribFormat(Atlas.QuadVao, 3 + I, 4, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(Atlas.QuadVao, 3 + I, 3 + I);
+		glVertexArrayBindingDivisor(Atlas.QuadVao, 3 + I, 1);
+	}
+
+	// Animation attributes stay disabled until the renderer has an animation stream to bind
+	for (GLuint I = 0; I < 2; I++)
+	{
+		glVertexArrayAttribFormat(Atlas.QuadVao, 7 + I, 4, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(Atlas.QuadVao, 7 + I, 7 + I);
+		glVertexArrayBindingDivisor(Atlas.QuadVao, 7 + I, 1);
+	}
+
+	return Atlas;
+}
+
+void ImpostorBaker::release(ImpostorAtlas& Atlas)
+{
+	if (Atlas.Texture != 0)
+	{
+		GlState::deleteTextures(1, &Atlas.Texture);
+	}
+	if (Atlas.QuadVao != 0)
+	{
+		GlState::deleteVertexArrays(1, &Atlas.QuadVao);
+		GlState::deleteBuffers(1, &Atlas.QuadVbo);
+	}
+	Atlas = {};
+}
+
+glm::vec3 ImpostorBaker::octahedralDirection(const glm::vec2& Coordinate)
+{
+	const glm::vec2 Point = Coordinate * 2.0f - 1.0f;
+	glm::vec3 Direction(Point.x, 1.0f - std::abs(Point.x) - std::abs(Point.y), Point.y);
+	if (Direction.y < 0.0f)
+	{
+		const glm::vec2 Folded = (1.0f - abs(glm::vec2(Direction.z, Direction.x))) * signNotZero(
+			glm::vec2(Direction.x, Direction.z));
+		Direction.x = Folded.x;
+		Direction.z = Folded.y;
+	}
+	return normalize(Direction);
+}
+
+glm::vec2 ImpostorBaker::octahedralCoordinate(const glm::vec3& Direction)
+{
+	const glm::vec3 Projected = Direction / (std::abs(Direction.x) + std::abs(Direction.y) + std::abs(Direction.z));
+	glm::vec2 Point(Projected.x, Projected.z);
+	if (Projected.y < 0.0f)
+	{
+		Point = (1.0f - abs(glm::vec2(Point.y, Point.x))) * signNotZero(Point);
+	}
+	return Point * 0.5f + 0.5f;
+}
+
+glm::vec3 ImpostorBaker::frameUp(const glm::vec3& Direction)
+{
+	// World up unless looking straight down or up the Y axis
+	return std::abs(Direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
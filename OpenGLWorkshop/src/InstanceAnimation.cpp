@@ -0,0 +1,72 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceAnimation.cpp
+Description : Implementations for evaluating and bounding instance
+			  motion on the CPU
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstanceAnimation.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool InstanceAnimator::isAnimated(const InstanceAnimation& Animation)
+{
+	return Animation.Spin.w != 0.0f || Animation.Bob.x != 0.0f;
+}
+
+glm::mat4 InstanceAnimator::evaluate(const glm::mat4& Base, const InstanceAnimation& Animation, const float Time)
+{
+	// Rodrigues' rotation, written out the way the shader builds it
+	const glm::vec3 Axis(Animation.Spin);
+	const float Angle = Animation.Spin.w * Time;
+	const float Cos = std::cos(Angle);
+	const float Sin = std::sin(Angle);
+	const glm::mat3 Skew(0.0f, Axis.z, -Axis.y, -Axis.z, 0.0f, Axis.x, Axis.y, -Axis.x, 0.0f);
+	const glm::mat3 Spin = glm::mat3(Cos) + (1.0f - Cos) * outerProduct(Axis, Axis) + Sin * Skew;
+
+	glm::mat4 Posed = Base * glm::mat4(Spin);
+	Posed[3].y += Animation.Bob.x * std::sin(Animation.Bob.y * Time + Animation.Bob.z);
+	return Posed;
+}
+
+glm::vec3 InstanceAnimator::evaluatePoint(const glm::mat4& Base, const InstanceAnimation& Animation, const float Time,
+                                          const glm::vec3& Point)
+{
+	// Rodrigues' rotation applied to the point directly
+	const glm::vec3 Axis(Animation.Spin);
+	const float Angle = Animation.Spin.w * Time;
+	const float Cos = std::cos(Angle);
+	const glm::vec3 Spun = Point * Cos + cross(Axis, Point) * std::sin(Angle) + Axis * dot(Axis, Point) * (1.0f - Cos);
+
+	glm::vec3 Posed(Base * glm::vec4(Spun, 1.0f));
+	Posed.y += Animation.Bob.x * std::sin(Animation.Bob.y * Time + Animation.Bob.z);
+	return Posed;
+}
+
+void InstanceAnimator::sweptSphere(const Model& Model, const glm::mat4& Base, const InstanceAnimation& Animation,
+                                   glm::vec3& Center, float& Radius)
+{
+	const float Scale = std::max(std::max(length(glm::vec3(Base[0])), length(glm::vec3(Base[1]))),
+	                             length(glm::vec3(Base[2])));
+	glm::vec3 LocalCenter = Model.BoundsCenter;
+	float LocalRadius = Model.BoundsRadius;
+	if (Animation.Spin.w != 0.0f)
+	{
+		// The bounds centre circles the axis, a sphere on the axis at its height covers the whole circle
+		const glm::vec3 Axis(Animation.Spin);
+		const glm::vec3 OnAxis = Axis * dot(LocalCenter, Axis);
+		LocalRadius += length(LocalCenter - OnAxis);
+		LocalCenter = OnAxis;
+	}
+	Center = glm::vec3(Base * glm::vec4(LocalCenter, 1.0f));
+	Radius = LocalRadius * Scale + std::abs(Animation.Bob.x);
+}
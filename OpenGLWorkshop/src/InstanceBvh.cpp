@@ -0,0 +1,650 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceBvh.cpp
+Description : Implementations for the instance bounding volume hierarchy.
+			  Built with binned SAH, refit in place and rebuilt on a
+			  worker thread once refits have degraded it
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstanceBvh.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+constexpr std::size_t BoundsGrain = 16384;
+constexpr std::uint32_t ParallelBinThreshold = 65536; // Nodes this large bin their primitives across threads
+constexpr std::uint32_t MaxLeafFallback = 16; // Leaves may grow this large when no split beats them
+constexpr float TraversalCost = 1.0f; // Relative to one primitive test
+constexpr int MaxStackDepth = 128;
+constexpr std::uint32_t MaxDepth = MaxStackDepth - 2; // Deeper nodes become leaves so traversal stacks never overflow
+
+static float surfaceArea(const glm::vec3& Min, const glm::vec3& Max)
+{
+	const glm::vec3 Extent = glm::max(Max - Min, glm::vec3(0.0f));
+	return 2.0f * (Extent.x * Extent.y + Extent.y * Extent.z + Extent.z * Extent.x);
+}
+
+// Entry distance of the ray into the box, or infinity when it misses within MaxDistance
+static float intersectBox(const glm::vec3& Origin, const glm::vec3& InverseDirection, const float MaxDistance,
+                          const glm::vec3& Min, const glm::vec3& Max)
+{
+	const glm::vec3 T0 = (Min - Origin) * InverseDirection;
+	const glm::vec3 T1 = (Max - Origin) * InverseDirection;
+	const glm::vec3 Near = glm::min(T0, T1);
+	const glm::vec3 Far = glm::max(T0, T1);
+	const float Entry = std::max(std::max(Near.x, Near.y), std::max(Near.z, 0.0f));
+	const float Exit = std::min(std::min(Far.x, Far.y), std::min(Far.z, MaxDistance));
+	return Entry <= Exit ? Entry : std::numeric_limits<float>::infinity();
+}
+
+constexpr int OutsideFrustum = -1;
+constexpr int IntersectsFrustum = 0;
+constexpr int InsideFrustum = 1;
+
+static int classifyBox(const glm::vec4* Planes, const glm::vec3& Min, const glm::vec3& Max)
+{
+	// The corner farthest along each plane normal decides outside, the nearest one decides fully inside
+	int Result = InsideFrustum;
+	for (int Plane = 0; Plane < 6; Plane++)
+	{
+		const glm::vec3 Normal(Planes[Plane]);
+		const glm::bvec3 Facing = greaterThanEqual(Normal, glm::vec3(0.0f));
+		if (dot(Normal, mix(Min, Max, Facing)) + Planes[Plane].w < 0.0f)
+		{
+			return OutsideFrustum;
+		}
+		if (dot(Normal, mix(Max, Min, Facing)) + Planes[Plane].w < 0.0f)
+		{
+			Result = IntersectsFrustum;
+		}
+	}
+	return Result;
+}
+
+static bool overlapsSphere(const glm::vec3& Min, const glm::vec3& Max, const glm::vec3& Center, const float RadiusSq)
+{
+	const glm::vec3 Offset = Center - glm::clamp(Center, Min, Max);
+	return dot(Offset, Offset) <= RadiusSq;
+}
+
+InstanceBvh::~InstanceBvh()
+{
+	// The worker reads its own snapshot, but it must not outlive the tree it's building for
+	if (MPendingTree.valid())
+	{
+		MPendingTree.wait();
+	}
+}
+
+BvhBounds InstanceBvh::transformBounds(const glm::vec3& Min, const glm::vec3& Max, const glm::mat4& Transform)
+{
+	// Arvo's method, the world extent along each axis is the absolute matrix applied to the local extent
+	const glm::vec3 LocalExtent = (Max - Min) * 0.5f;
+	const glm::vec3 Center = glm::vec3(Transform * glm::vec4((Min + Max) * 0.5f, 1.0f));
+	const glm::vec3 Extent = abs(glm::vec3(Transform[0])) * LocalExtent.x +
+		abs(glm::vec3(Transform[1])) * LocalExtent.y + abs(glm::vec3(Transform[2])) * LocalExtent.z;
+	return {Center - Extent, Center + Extent};
+}
+
+void InstanceBvh::computeBounds(const InstancePool& Instances, const Model& Model, std::vector<BvhBounds>& Bounds)
+{
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+	Bounds.resize(Transforms.size());
+
+	Parallel::forRange(Transforms.size(), BoundsGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			if (InstanceAnimator::isAnimated(Animations[I]))
+			{
+				// Boxes the whole motion, so the tree only changes when the base transforms do
+				glm::vec3 Center;
+				float Radius;
+				InstanceAnimator::sweptSphere(Model, Transforms[I], Animations[I], Center, Radius);
+				Bounds[I] = {Center - Radius, Center + Radius};
+				continue;
+			}
+			Bounds[I] = transformBounds(Model.BoundsMin, Model.BoundsMax, Transforms[I]);
+		}
+	});
+}
+
+void InstanceBvh::build(const InstancePool& Instances, const Model& Model)
+{
+	computeBounds(Instances, Model, MBounds);
+	build(MBounds);
+}
+
+void InstanceBvh::build(const std::vector<BvhBounds>& Bounds)
+{
+	MTree = buildTree(Bounds);
+	MBuildCost = MTree.Cost;
+}
+
+void InstanceBvh::refit(const InstancePool& Instances, const Model& Model)
+{
+	computeBounds(Instances, Model, MBounds);
+	if (MBounds.size() != MTree.Indices.size())
+	{
+		// The dense indices moved, a refit can't follow them
+		build(MBounds);
+		return;
+	}
+
+	for (std::size_t I = 0; I < MTree.Indices.size(); I++)
+	{
+		MTree.Bounds[I] = MBounds[MTree.Indices[I]];
+	}
+
+	// Children always come after their parent, so a reverse sweep sees them first
+	for (std::size_t I = MTree.Nodes.size(); I-- > 0;)
+	{
+		BvhNode& Node = MTree.Nodes[I];
+		if (Node.Count > 0)
+		{
+			Node.Min = glm::vec3(std::numeric_limits<float>::max());
+			Node.Max = glm::vec3(std::numeric_limits<float>::lowest());
+			for (std::uint32_t P = Node.LeftOrFirst; P < Node.LeftOrFirst + Node.Count; P++)
+			{
+				Node.Min = glm::min(Node.Min, MTree.Bounds[P].Min);
+				Node.Max = glm::max(Node.Max, MTree.Bounds[P].Max);
+			}
+		}
+		else
+		{
+			const BvhNode& Left = MTree.Nodes[I + 1];
+			const BvhNode& Right = MTree.Nodes[Node.LeftOrFirst];
+			Node.Min = glm::min(Left.Min, Right.Min);
+			Node.Max = glm::max(Left.Max, Right.Max);
+		}
+	}
+	MTree.Cost = computeCost(MTree.Nodes);
+}
+
+bool InstanceBvh::needsRebuild() const
+{
+	return MTree.Cost > MBuildCost * RebuildThreshold;
+}
+
+void InstanceBvh::rebuildAsync(const InstancePool& Instances, const Model& Model)
+{
+	if (isRebuilding())
+	{
+		return;
+	}
+
+	std::vector<BvhBounds> Snapshot;
+	computeBounds(Instances, Model, Snapshot);
+	MPendingTree = std::async(std::launch::async, [Bounds = std::move(Snapshot)]
+	{
+		return buildTree(Bounds);
+	});
+}
+
+bool InstanceBvh::finishRebuild()
+{
+	if (!isRebuilding() || MPendingTree.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return false;
+	}
+
+	// Built from positions a few frames old, the caller's next refit catches it up
+	MTree = MPendingTree.get();
+	MBuildCost = MTree.Cost;
+	return true;
+}
+
+bool InstanceBvh::isRebuilding() const
+{
+	return MPendingTree.valid();
+}
+
+void InstanceBvh::queryFrustum(const glm::mat4& ViewProjection, std::vector<std::uint32_t>& Out) const
+{
+	if (MTree.Nodes.empty())
+	{
+		return;
+	}
+
+	// Gribb-Hartmann plane extraction, the same planes InstanceCuller tests against
+	const glm::mat4 Transposed = transpose(ViewProjection);
+	const glm::vec4 Planes[6] = {
+		Transposed[3] + Transposed[0], Transposed[3] - Transposed[0],
+		Transposed[3] + Transposed[1], Transposed[3] - Transposed[1],
+		Transposed[3] + Transposed[2], Transposed[3] - Transposed[2]
+	};
+
+	std::uint32_t Stack[MaxStackDepth];
+	int StackSize = 0;
+	Stack[StackSize++] = 0;
+	while (StackSize > 0)
+	{
+		const std::uint32_t NodeIndex = Stack[--StackSize];
+		const BvhNode& Node = MTree.Nodes[NodeIndex];
+
+		const int Classification = classifyBox(Planes, Node.Min, Node.Max);
+		if (Classification == OutsideFrustum)
+		{
+			continue;
+		}
+
+		if (Classification == InsideFrustum)
+		{
+			// A subtree's primitives are contiguous, from its leftmost leaf to the end of its rightmost one
+			std::uint32_t First = NodeIndex;
+			while (MTree.Nodes[First].Count == 0)
+			{
+				First++;
+			}
+			std::uint32_t Last = NodeIndex;
+			while (MTree.Nodes[Last].Count == 0)
+			{
+				Last = MTree.Nodes[Last].LeftOrFirst;
+			}
+			const std::uint32_t Begin = MTree.Nodes[First].LeftOrFirst;
+			const std::uint32_t End = MTree.Nodes[Last].LeftOrFirst + MTree.Nodes[Last].Count;
+			Out.insert(Out.end(), MTree.Indices.begin() + Begin, MTree.Indices.begin() + End);
+			continue;
+		}
+
+		if (Node.Count > 0)
+		{
+			for (std::uint32_t P = Node.LeftOrFirst; P < Node.LeftOrFirst + Node.Count; P++)
+			{
+				if (classifyBox(Planes, MTree.Bounds[P].Min, MTree.Bounds[P].Max) != OutsideFrustum)
+				{
+					Out.push_back(MTree.Indices[P]);
+				}
+			}
+			continue;
+		}
+
+		Stack[StackSize++] = Node.LeftOrFirst;
+		Stack[StackSize++] = NodeIndex + 1;
+	}
+}
+
+void InstanceBvh::querySphere(const glm::vec3& Center, const float Radius, std::vector<std::uint32_t>& Out) const
+{
+	if (MTree.Nodes.empty())
+	{
+		return;
+	}
+
+	const float RadiusSq = Radius * Radius;
+	std::uint32_t Stack[MaxStackDepth];
+	int StackSize = 0;
+	Stack[StackSize++] = 0;
+	while (StackSize > 0)
+	{
+		const std::uint32_t NodeIndex = Stack[--StackSize];
+		const BvhNode& Node = MTree.Nodes[NodeIndex];
+		if (!overlapsSphere(Node.Min, Node.Max, Center, RadiusSq))
+		{
+			continue;
+		}
+
+		if (Node.Count > 0)
+		{
+			for (std::uint32_t P = Node.LeftOrFirst; P < Node.LeftOrFirst + Node.Count; P++)
+			{
+				if (overlapsSphere(MTree.Bounds[P].Min, MTree.Bounds[P].Max, Center, RadiusSq))
+				{
+					Out.push_back(MTree.Indices[P]);
+				}
+			}
+			continue;
+		}
+
+		Stack[StackSize++] = Node.LeftOrFirst;
+		Stack[StackSize++] = NodeIndex + 1;
+	}
+}
+
+BvhRayHit InstanceBvh::raycast(const glm::vec3& Origin, const glm::vec3& Direction, const float MaxDistance,
+                               const RayTest& Test) const
+{
+	BvhRayHit Hit{NoHit, MaxDistance};
+	if (MTree.Nodes.empty())
+	{
+		return Hit;
+	}
+
+	// Division by a zero component gives an infinity, which the slab test handles
+	const glm::vec3 InverseDirection = 1.0f / Direction;
+	if (intersectBox(Origin, InverseDirection, Hit.Distance, MTree.Nodes[0].Min, MTree.Nodes[0].Max) ==
+		std::numeric_limits<float>::infinity())
+	{
+		return Hit;
+	}
+
+	std::pair<std::uint32_t, float> Stack[MaxStackDepth];
+	int StackSize = 0;
+	Stack[StackSize++] = {0, 0.0f};
+	while (StackSize > 0)
+	{
+		const auto [NodeIndex, Entry] = Stack[--StackSize];
+		if (Entry > Hit.Distance)
+		{
+			continue;
+		}
+		const BvhNode& Node = MTree.Nodes[NodeIndex];
+
+		if (Node.Count > 0)
+		{
+			for (std::uint32_t P = Node.LeftOrFirst; P < Node.LeftOrFirst + Node.Count; P++)
+			{
+				const float BoxDistance = intersectBox(Origin, InverseDirection, Hit.Distance, MTree.Bounds[P].Min,
+				                                       MTree.Bounds[P].Max);
+				if (BoxDistance > Hit.Distance)
+				{
+					continue;
+				}
+				const float Distance = Test ? Test(MTree.Indices[P]) : BoxDistance;
+				if (Distance >= 0.0f && Distance < Hit.Distance)
+				{
+					Hit = {MTree.Indices[P], Distance};
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so it can shorten the ray before the farther one is tested
+		const std::uint32_t LeftIndex = NodeIndex + 1;
+		const std::uint32_t RightIndex = Node.LeftOrFirst;
+		float LeftEntry = intersectBox(Origin, InverseDirection, Hit.Distance, MTree.Nodes[LeftIndex].Min,
+		                               MTree.Nodes[LeftIndex].Max);
+		float RightEntry = intersectBox(Origin, InverseDirection, Hit.Distance, MTree.Nodes[RightIndex].Min,
+		                                MTree.Nodes[RightIndex].Max);
+		std::uint32_t Near = LeftIndex;
+		std::uint32_t Far = RightIndex;
+		if (RightEntry < LeftEntry)
+		{
+			std::swap(Near, Far);
+			std::swap(LeftEntry, RightEntry);
+		}
+		if (RightEntry != std::numeric_limits<float>::infinity())
+		{
+			Stack[StackSize++] = {Far, RightEntry};
+		}
+		if (LeftEntry != std::numeric_limits<float>::infinity())
+		{
+			Stack[StackSize++] = {Near, LeftEntry};
+		}
+	}
+	return Hit;
+}
+
+const std::vector<BvhNode>& InstanceBvh::getNodes() const
+{
+	return MTree.Nodes;
+}
+
+std::size_t InstanceBvh::getPrimitiveCount() const
+{
+	return MTree.Indices.size();
+}
+
+float InstanceBvh::getCost() const
+{
+	return MTree.Cost;
+}
+
+float InstanceBvh::getBuildCost() const
+{
+	return MBuildCost;
+}
+
+InstanceBvh::Tree InstanceBvh::buildTree(const std::vector<BvhBounds>& Bounds)
+{
+	Tree Result;
+	const auto Count = static_cast<std::uint32_t>(Bounds.size());
+	if (Count == 0)
+	{
+		return Result;
+	}
+
+	// Primitives are partitioned by value rather than through an index array, so every pass over a node
+	// reads memory in order
+	std::vector<BuildPrimitive> Primitives(Count);
+	BvhBounds RootBounds = {
+		glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())
+	};
+	BvhBounds RootCentroids = RootBounds;
+	for (std::uint32_t I = 0; I < Count; I++)
+	{
+		const glm::vec3 Centroid = (Bounds[I].Min + Bounds[I].Max) * 0.5f;
+		Primitives[I] = {Bounds[I].Min, I, Bounds[I].Max, Centroid};
+		RootBounds = {glm::min(RootBounds.Min, Bounds[I].Min), glm::max(RootBounds.Max, Bounds[I].Max)};
+		RootCentroids = {glm::min(RootCentroids.Min, Centroid), glm::max(RootCentroids.Max, Centroid)};
+	}
+
+	Result.Nodes.reserve(2 * static_cast<std::size_t>(Count) - 1);
+	Result.Nodes.push_back({});
+	buildNode(Result, Primitives, 0, 0, Count, RootBounds, RootCentroids, 0);
+	Result.Nodes.shrink_to_fit();
+
+	Result.Indices.resize(Count);
+	Result.Bounds.resize(Count);
+	for (std::uint32_t I = 0; I < Count; I++)
+	{
+		Result.Indices[I] = Primitives[I].Index;
+		Result.Bounds[I] = {Primitives[I].Min, Primitives[I].Max};
+	}
+	Result.Cost = computeCost(Result.Nodes);
+	return Result;
+}
+
+void InstanceBvh::buildNode(Tree& Result, std::vector<BuildPrimitive>& Primitives, const std::uint32_t NodeIndex,
+                            const std::uint32_t First, const std::uint32_t Count, const BvhBounds& NodeBounds,
+                            const BvhBounds& CentroidBounds, const std::uint32_t Depth)
+{
+	struct Bin
+	{
+		glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 Max = glm::vec3(std::numeric_limits<float>::lowest());
+		std::uint32_t Count = 0;
+	};
+	struct BinSet
+	{
+		Bin Axes[3][BinCount];
+	};
+	BuildPrimitive* const Range = Primitives.data() + First;
+	const glm::vec3 NodeMin = NodeBounds.Min;
+	const glm::vec3 NodeMax = NodeBounds.Max;
+	const glm::vec3 CentroidMin = CentroidBounds.Min;
+	const glm::vec3 CentroidMax = CentroidBounds.Max;
+
+	auto makeLeaf = [&]
+	{
+		Result.Nodes[NodeIndex] = {NodeMin, First, NodeMax, Count};
+	};
+	const glm::vec3 CentroidExtent = CentroidMax - CentroidMin;
+	if (Count <= MaxLeafSize || Depth >= MaxDepth ||
+		std::max(std::max(CentroidExtent.x, CentroidExtent.y), CentroidExtent.z) <= 0.0f)
+	{
+		makeLeaf();
+		return;
+	}
+
+	// Bin every primitive on all three axes at once. Large nodes fill per thread bins and merge them
+	BinSet Bins;
+	const glm::vec3 BinScale = glm::vec3(static_cast<float>(BinCount)) /
+		glm::max(CentroidExtent, glm::vec3(1.0e-20f));
+	auto binRange = [&](const std::size_t Begin, const std::size_t End, BinSet& Target)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			const BuildPrimitive& Primitive = Range[I];
+			const glm::vec3 Slot = (Primitive.Centroid - CentroidMin) * BinScale;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				Bin& Entry = Target.Axes[Axis][std::min(static_cast<int>(Slot[Axis]), BinCount - 1)];
+				Entry.Min = glm::min(Entry.Min, Primitive.Min);
+				Entry.Max = glm::max(Entry.Max, Primitive.Max);
+				Entry.Count++;
+			}
+		}
+	};
+	if (Count >= ParallelBinThreshold && Parallel::getThreadCount() > 1)
+	{
+		const std::size_t ChunkCount = Parallel::getThreadCount();
+		std::vector<BinSet> ChunkBins(ChunkCount);
+		Parallel::forRange(ChunkCount, 1, [&](const std::size_t Begin, const std::size_t End)
+		{
+			for (std::size_t Chunk = Begin; Chunk < End; Chunk++)
+			{
+				binRange(Count * Chunk / ChunkCount, Count * (Chunk + 1) / ChunkCount, ChunkBins[Chunk]);
+			}
+		});
+		for (const auto& Chunk : ChunkBins)
+		{
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				for (int B = 0; B < BinCount; B++)
+				{
+					Bin& Entry = Bins.Axes[Axis][B];
+					Entry.Min = glm::min(Entry.Min, Chunk.Axes[Axis][B].Min);
+					Entry.Max = glm::max(Entry.Max, Chunk.Axes[Axis][B].Max);
+					Entry.Count += Chunk.Axes[Axis][B].Count;
+				}
+			}
+		}
+	}
+	else
+	{
+		binRange(0, Count, Bins);
+	}
+
+	// Sweep each axis from both ends for the split plane with the lowest surface area heuristic cost
+	int BestAxis = -1;
+	int BestSplit = 0;
+	float BestCost = std::numeric_limits<float>::max();
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		if (CentroidExtent[Axis] <= 0.0f)
+		{
+			continue;
+		}
+		float RightArea[BinCount];
+		std::uint32_t RightCount[BinCount];
+		glm::vec3 Min(std::numeric_limits<float>::max());
+		glm::vec3 Max(std::numeric_limits<float>::lowest());
+		std::uint32_t Sum = 0;
+		for (int B = BinCount - 1; B > 0; B--)
+		{
+			Min = glm::min(Min, Bins.Axes[Axis][B].Min);
+			Max = glm::max(Max, Bins.Axes[Axis][B].Max);
+			Sum += Bins.Axes[Axis][B].Count;
+			RightArea[B] = surfaceArea(Min, Max);
+			RightCount[B] = Sum;
+		}
+		Min = glm::vec3(std::numeric_limits<float>::max());
+		Max = glm::vec3(std::numeric_limits<float>::lowest());
+		Sum = 0;
+		for (int B = 1; B < BinCount; B++)
+		{
+			Min = glm::min(Min, Bins.Axes[Axis][B - 1].Min);
+			Max = glm::max(Max, Bins.Axes[Axis][B - 1].Max);
+			Sum += Bins.Axes[Axis][B - 1].Count;
+			if (Sum == 0 || RightCount[B] == 0)
+			{
+				continue;
+			}
+			const float Cost = surfaceArea(Min, Max) * static_cast<float>(Sum) + RightArea[B] *
+				static_cast<float>(RightCount[B]);
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestAxis = Axis;
+				BestSplit = B;
+			}
+		}
+	}
+
+	const float LeafCost = static_cast<float>(Count);
+	const float SplitCost = TraversalCost + BestCost / surfaceArea(NodeMin, NodeMax);
+	if (BestAxis < 0 || (SplitCost >= LeafCost && Count <= MaxLeafFallback))
+	{
+		makeLeaf();
+		return;
+	}
+
+	// Partition in place, gathering both children's bounds on the way so they never need a pass of their own
+	const float Scale = BinScale[BestAxis];
+	const float Origin = CentroidMin[BestAxis];
+	auto isLeft = [&](const BuildPrimitive& Primitive)
+	{
+		return std::min(static_cast<int>((Primitive.Centroid[BestAxis] - Origin) * Scale), BinCount - 1) < BestSplit;
+	};
+	BvhBounds ChildBounds[2];
+	BvhBounds ChildCentroids[2];
+	for (int Child = 0; Child < 2; Child++)
+	{
+		ChildBounds[Child] = ChildCentroids[Child] = {
+			glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())
+		};
+	}
+	auto include = [&](const int Child, const BuildPrimitive& Primitive)
+	{
+		ChildBounds[Child].Min = glm::min(ChildBounds[Child].Min, Primitive.Min);
+		ChildBounds[Child].Max = glm::max(ChildBounds[Child].Max, Primitive.Max);
+		ChildCentroids[Child].Min = glm::min(ChildCentroids[Child].Min, Primitive.Centroid);
+		ChildCentroids[Child].Max = glm::max(ChildCentroids[Child].Max, Primitive.Centroid);
+	};
+	std::uint32_t LeftCount = 0;
+	std::uint32_t RightBegin = Count;
+	while (LeftCount < RightBegin)
+	{
+		if (isLeft(Range[LeftCount]))
+		{
+			include(0, Range[LeftCount]);
+			LeftCount++;
+		}
+		else
+		{
+			include(1, Range[LeftCount]);
+			std::swap(Range[LeftCount], Range[--RightBegin]);
+		}
+	}
+
+	// Left child directly after this node, the right one after the whole left subtree
+	const auto LeftIndex = static_cast<std::uint32_t>(Result.Nodes.size());
+	Result.Nodes.push_back({});
+	buildNode(Result, Primitives, LeftIndex, First, LeftCount, ChildBounds[0], ChildCentroids[0], Depth + 1);
+	const auto RightIndex = static_cast<std::uint32_t>(Result.Nodes.size());
+	Result.Nodes.push_back({});
+	buildNode(Result, Primitives, RightIndex, First + LeftCount, Count - LeftCount, ChildBounds[1], ChildCentroids[1],
+	          Depth + 1);
+
+	Result.Nodes[NodeIndex] = {NodeMin, RightIndex, NodeMax, 0};
+}
+
+float InstanceBvh::computeCost(const std::vector<BvhNode>& Nodes)
+{
+	if (Nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	// Expected cost of a random ray through the root: every node it enters plus every primitive it tests
+	double Cost = 0.0;
+	for (const BvhNode& Node : Nodes)
+	{
+		const double Area = surfaceArea(Node.Min, Node.Max);
+		Cost += Node.Count > 0 ? Area * Node.Count : Area * TraversalCost;
+	}
+	return static_cast<float>(Cost / std::max(surfaceArea(Nodes[0].Min, Nodes[0].Max), 1.0e-20f));
+}
@@ -0,0 +1,346 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceCuller.cpp
+Description : Implementations for per instance frustum and screen-size
+			  contribution culling. Both tests share one SIMD pass
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstanceCuller.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+constexpr float CoversScreen = 1.0e6f; // Diameter reported when the camera is inside the sphere
+constexpr std::size_t GatherGrain = 4096; // Instances per task when posing the spheres
+
+void InstanceCuller::cull(const InstancePool& Instances, const Model& Model, const glm::mat4& ViewProjection,
+                          const glm::vec3& CameraPosition, const float ProjectionScale, const CullSettings& Settings,
+                          const float Time)
+{
+	const auto Start = std::chrono::steady_clock::now();
+
+	gatherSpheres(Instances, Model, Time);
+
+	// Gribb-Hartmann plane extraction, normalised so plane distances are in world units
+	const glm::mat4 Transposed = transpose(ViewProjection);
+	glm::vec4 Planes[6] = {
+		Transposed[3] + Transposed[0], Transposed[3] - Transposed[0],
+		Transposed[3] + Transposed[1], Transposed[3] - Transposed[1],
+		Transposed[3] + Transposed[2], Transposed[3] - Transposed[2]
+	};
+	for (glm::vec4& Plane : Planes)
+	{
+		Plane /= glm::length(glm::vec3(Plane));
+	}
+
+	const std::size_t Count = MRadius.size();
+	MVisible.resize(Count);
+	MPixelDiameters.resize(Count);
+	MStats = {};
+	MStats.Tested = static_cast<unsigned int>(Count);
+
+#if SIMD_X86
+	if (Simd::hasAvx2())
+	{
+		testAvx2(0, Count, Planes, CameraPosition, ProjectionScale, Settings);
+	}
+	else
+	{
+		testSse(0, Count, Planes, CameraPosition, ProjectionScale, Settings);
+	}
+#else
+	testScalar(0, Count, Planes, CameraPosition, ProjectionScale, Settings);
+#endif
+
+	MVisible.resize(MStats.Visible);
+	MPixelDiameters.resize(MStats.Visible);
+
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.Milliseconds = Elapsed.count();
+}
+
+const std::vector<std::uint32_t>& InstanceCuller::getVisible() const
+{
+	return MVisible;
+}
+
+const std::vector<float>& InstanceCuller::getPixelDiameters() const
+{
+	return MPixelDiameters;
+}
+
+const CullStats& InstanceCuller::getStats() const
+{
+	return MStats;
+}
+
+float InstanceCuller::projectedDiameter(const float Radius, const float Distance, const float ProjectionScale)
+{
+	// Inside the sphere it covers the screen
+	if (Distance <= Radius)
+	{
+		return CoversScreen;
+	}
+	return 2.0f * Radius * ProjectionScale / Distance;
+}
+
+void InstanceCuller::gatherSpheres(const InstancePool& Instances, const Model& Model, const float Time)
+{
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const std::size_t Count = Transforms.size();
+	MCenterX.resize(Count);
+	MCenterY.resize(Count);
+	MCenterZ.resize(Count);
+	MRadius.resize(Count);
+
+	const glm::vec4 LocalCenter(Model.BoundsCenter, 1.0f);
+	const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+	const bool Animated = Instances.hasAnimations();
+	Parallel::forRange(Count, GatherGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			// Spinning leaves the radius alone, animated instances only need their centre posed at Time
+			const glm::mat4& Transform = Transforms[I];
+			glm::vec3 Center(Transform * LocalCenter);
+			if (Animated)
+			{
+				Center = InstanceAnimator::evaluatePoint(Transform, Animations[I], Time, Model.BoundsCenter);
+			}
+
+			// Radius scaled by the largest axis scale keeps the sphere conservative under non-uniform scale
+			const float ScaleSquared = std::max({
+				dot(glm::vec3(Transform[0]), glm::vec3(Transform[0])),
+				dot(glm::vec3(Transform[1]), glm::vec3(Transform[1])),
+				dot(glm::vec3(Transform[2]), glm::vec3(Transform[2]))
+			});
+			MCenterX[I] = Center.x;
+			MCenterY[I] = Center.y;
+			MCenterZ[I] = Center.z;
+			MRadius[I] = Model.BoundsRadius * std::sqrt(ScaleSquared);
+		}
+	});
+}
+
+void InstanceCuller::testScalar(const std::size_t Begin, const std::size_t End, const glm::vec4* Planes,
+                                const glm::vec3& CameraPosition, const float ProjectionScale,
+                                const CullSettings& Settings)
+{
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		const glm::vec3 Center(MCenterX[I], MCenterY[I], MCenterZ[I]);
+		const float Radius = MRadius[I];
+
+		bool InFrustum = true;
+		if (Settings.FrustumCulling)
+		{
+			for (int Plane = 0; Plane < 6; Plane++)
+			{
+				InFrustum &= dot(glm::vec3(Planes[Plane]), Center) + Planes[Plane].w > -Radius;
+			}
+		}
+		const float Diameter = projectedDiameter(Radius, glm::length(Center - CameraPosition), ProjectionScale);
+		const bool LargeEnough = !Settings.ContributionCulling || Diameter >= Settings.MinPixelDiameter;
+
+		if (!InFrustum)
+		{
+			MStats.FrustumCulled++;
+		}
+		else if (!LargeEnough)
+		{
+			MStats.ContributionCulled++;
+		}
+		else
+		{
+			MVisible[MStats.Visible] = static_cast<std::uint32_t>(I);
+			MPixelDiameters[MStats.Visible] = Diameter;
+			MStats.Visible++;
+		}
+	}
+}
+
+void InstanceCuller::testSse(const std::size_t Begin, const std::size_t End, const glm::vec4* Planes,
+                             const glm::vec3& CameraPosition, const float ProjectionScale,
+                             const CullSettings& Settings)
+{
+	std::size_t I = Begin;
+#if SIMD_X86
+	const __m128 CameraX = _mm_set1_ps(CameraPosition.x);
+	const __m128 CameraY = _mm_set1_ps(CameraPosition.y);
+	const __m128 CameraZ = _mm_set1_ps(CameraPosition.z);
+	const __m128 DiameterScale = _mm_set1_ps(2.0f * ProjectionScale);
+	const __m128 MinDiameter = _mm_set1_ps(Settings.ContributionCulling ? Settings.MinPixelDiameter : -1.0f);
+	const __m128 Huge = _mm_set1_ps(CoversScreen);
+	const __m128 AllSet = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+	for (; I + 4 <= End; I += 4)
+	{
+		const __m128 Cx = _mm_loadu_ps(&MCenterX[I]);
+		const __m128 Cy = _mm_loadu_ps(&MCenterY[I]);
+		const __m128 Cz = _mm_loadu_ps(&MCenterZ[I]);
+		const __m128 Radius = _mm_loadu_ps(&MRadius[I]);
+		const __m128 NegativeRadius = _mm_sub_ps(_mm_setzero_ps(), Radius);
+
+		__m128 InFrustum = AllSet;
+		if (Settings.FrustumCulling)
+		{
+			for (int Plane = 0; Plane < 6; Plane++)
+			{
+				const __m128 Distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(Planes[Plane].x), Cx), _mm_mul_ps(_mm_set1_ps(Planes[Plane].y), Cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(Planes[Plane].z), Cz), _mm_set1_ps(Planes[Plane].w)));
+				InFrustum = _mm_and_ps(InFrustum, _mm_cmpgt_ps(Distance, NegativeRadius));
+			}
+		}
+
+		// Projected diameter 2 r s / d, camera inside the sphere counts as covering the screen
+		const __m128 Dx = _mm_sub_ps(Cx, CameraX);
+		const __m128 Dy = _mm_sub_ps(Cy, CameraY);
+		const __m128 Dz = _mm_sub_ps(Cz, CameraZ);
+		const __m128 Distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Dx, Dx), _mm_mul_ps(Dy, Dy)),
+		                                               _mm_mul_ps(Dz, Dz)));
+		const __m128 Inside = _mm_cmple_ps(Distance, Radius);
+		const __m128 Projected = _mm_div_ps(_mm_mul_ps(DiameterScale, Radius), Distance);
+		const __m128 Diameter = _mm_or_ps(_mm_and_ps(Inside, Huge), _mm_andnot_ps(Inside, Projected));
+		const __m128 LargeEnough = _mm_cmpge_ps(Diameter, MinDiameter);
+
+		const int FrustumMask = _mm_movemask_ps(InFrustum);
+		const int VisibleMask = _mm_movemask_ps(_mm_and_ps(InFrustum, LargeEnough));
+		MStats.FrustumCulled += 4 - std::popcount(static_cast<unsigned int>(FrustumMask));
+		MStats.ContributionCulled += std::popcount(static_cast<unsigned int>(FrustumMask & ~VisibleMask));
+
+		if (VisibleMask != 0)
+		{
+			alignas(16) float Diameters[4];
+			_mm_store_ps(Diameters, Diameter);
+			for (int Lane = 0; Lane < 4; Lane++)
+			{
+				if (VisibleMask & (1 << Lane))
+				{
+					MVisible[MStats.Visible] = static_cast<std::uint32_t>(I + Lane);
+					MPixelDiameters[MStats.Visible] = Diameters[Lane];
+					MStats.Visible++;
+				}
+			}
+		}
+	}
+#endif
+	testScalar(I, End, Planes, CameraPosition, ProjectionScale, Settings);
+}
+
+#if SIMD_X86
+struct CullBlockResult
+{
+	std::size_t Next;
+	unsigned int FrustumCulled;
+	unsigned int ContributionCulled;
+	unsigned int Visible;
+};
+
+SIMD_TARGET_AVX2 static CullBlockResult cullAvx2Block(const float* CenterX, const float* CenterY,
+                                                      const float* CenterZ, const float* Radii, std::size_t I,
+                                                      const std::size_t End, const glm::vec4* Planes,
+                                                      const glm::vec3& CameraPosition, const float ProjectionScale,
+                                                      const CullSettings& Settings, std::uint32_t* Visible,
+                                                      float* PixelDiameters, unsigned int VisibleCount)
+{
+	CullBlockResult Result{I, 0, 0, VisibleCount};
+	const __m256 CameraX = _mm256_set1_ps(CameraPosition.x);
+	const __m256 CameraY = _mm256_set1_ps(CameraPosition.y);
+	const __m256 CameraZ = _mm256_set1_ps(CameraPosition.z);
+	const __m256 DiameterScale = _mm256_set1_ps(2.0f * ProjectionScale);
+	const __m256 MinDiameter = _mm256_set1_ps(Settings.ContributionCulling ? Settings.MinPixelDiameter : -1.0f);
+	const __m256 Huge = _mm256_set1_ps(CoversScreen);
+	const __m256 AllSet = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	__m256 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+	for (int Plane = 0; Plane < 6; Plane++)
+	{
+		PlaneX[Plane] = _mm256_set1_ps(Planes[Plane].x);
+		PlaneY[Plane] = _mm256_set1_ps(Planes[Plane].y);
+		PlaneZ[Plane] = _mm256_set1_ps(Planes[Plane].z);
+		PlaneW[Plane] = _mm256_set1_ps(Planes[Plane].w);
+	}
+
+	for (; I + 8 <= End; I += 8)
+	{
+		const __m256 Cx = _mm256_loadu_ps(CenterX + I);
+		const __m256 Cy = _mm256_loadu_ps(CenterY + I);
+		const __m256 Cz = _mm256_loadu_ps(CenterZ + I);
+		const __m256 Radius = _mm256_loadu_ps(Radii + I);
+		const __m256 NegativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), Radius);
+
+		__m256 InFrustum = AllSet;
+		if (Settings.FrustumCulling)
+		{
+			for (int Plane = 0; Plane < 6; Plane++)
+			{
+				const __m256 Distance = _mm256_fmadd_ps(PlaneX[Plane], Cx, _mm256_fmadd_ps(
+					                                        PlaneY[Plane], Cy,
+					                                        _mm256_fmadd_ps(PlaneZ[Plane], Cz, PlaneW[Plane])));
+				InFrustum = _mm256_and_ps(InFrustum, _mm256_cmp_ps(Distance, NegativeRadius, _CMP_GT_OQ));
+			}
+		}
+
+		const __m256 Dx = _mm256_sub_ps(Cx, CameraX);
+		const __m256 Dy = _mm256_sub_ps(Cy, CameraY);
+		const __m256 Dz = _mm256_sub_ps(Cz, CameraZ);
+		const __m256 Distance = _mm256_sqrt_ps(_mm256_fmadd_ps(Dx, Dx, _mm256_fmadd_ps(Dy, Dy, _mm256_mul_ps(Dz, Dz))));
+		const __m256 Inside = _mm256_cmp_ps(Distance, Radius, _CMP_LE_OQ);
+		const __m256 Projected = _mm256_div_ps(_mm256_mul_ps(DiameterScale, Radius), Distance);
+		const __m256 Diameter = _mm256_blendv_ps(Projected, Huge, Inside);
+		const __m256 LargeEnough = _mm256_cmp_ps(Diameter, MinDiameter, _CMP_GE_OQ);
+
+		const int FrustumMask = _mm256_movemask_ps(InFrustum);
+		const int VisibleMask = _mm256_movemask_ps(_mm256_and_ps(InFrustum, LargeEnough));
+		Result.FrustumCulled += 8 - std::popcount(static_cast<unsigned int>(FrustumMask));
+		Result.ContributionCulled += std::popcount(static_cast<unsigned int>(FrustumMask & ~VisibleMask));
+
+		if (VisibleMask != 0)
+		{
+			alignas(32) float Diameters[8];
+			_mm256_store_ps(Diameters, Diameter);
+			for (int Lane = 0; Lane < 8; Lane++)
+			{
+				if (VisibleMask & (1 << Lane))
+				{
+					Visible[Result.Visible] = static_cast<std::uint32_t>(I + Lane);
+					PixelDiameters[Result.Visible] = Diameters[Lane];
+					Result.Visible++;
+				}
+			}
+		}
+	}
+	Result.Next = I;
+	return Result;
+}
+#endif
+
+void InstanceCuller::testAvx2(const std::size_t Begin, const std::size_t End, const glm::vec4* Planes,
+                              const glm::vec3& CameraPosition, const float ProjectionScale,
+                              const CullSettings& Settings)
+{
+#if SIMD_X86
+	const CullBlockResult Result = cullAvx2Block(MCenterX.data(), MCenterY.data(), MCenterZ.data(), MRadius.data(),
+	                                             Begin, End, Planes, CameraPosition, ProjectionScale, Settings,
+	                                             MVisible.data(), MPixelDiameters.data(), MStats.Visible);
+	MStats.FrustumCulled += Result.FrustumCulled;
+	MStats.ContributionCulled += Result.ContributionCulled;
+	MStats.Visible = Result.Visible;
+	testSse(Result.Next, End, Planes, CameraPosition, ProjectionScale, Settings);
+#else
+	testScalar(Begin, End, Planes, CameraPosition, ProjectionScale, Settings);
+#endif
+}
@@ -0,0 +1,177 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstancePicker.cpp
+Description : Implementations for CPU ray picking. Rays go through the
+			  instance BVH, then into each candidate's model space
+			  where a triangle BVH gives the exact hit
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstancePicker.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+constexpr float PickDistance = 100.0f; // The camera's far plane, nothing beyond it is on screen
+
+void MeshRaycaster::build(const Model& Model)
+{
+	const std::size_t TriangleCount = Model.PickIndices.size() / 3;
+	MVertices.resize(TriangleCount * 3);
+	std::vector<BvhBounds> Bounds(TriangleCount);
+	for (std::size_t Triangle = 0; Triangle < TriangleCount; Triangle++)
+	{
+		glm::vec3 Min(std::numeric_limits<float>::max());
+		glm::vec3 Max(std::numeric_limits<float>::lowest());
+		for (std::size_t Corner = 0; Corner < 3; Corner++)
+		{
+			const glm::vec3& Vertex = Model.PickVertices[Model.PickIndices[Triangle * 3 + Corner]];
+			MVertices[Triangle * 3 + Corner] = Vertex;
+			Min = glm::min(Min, Vertex);
+			Max = glm::max(Max, Vertex);
+		}
+		Bounds[Triangle] = {Min, Max};
+	}
+
+	// The instance BVH works on any set of boxes, here its primitives are triangles
+	MTriangles.build(Bounds);
+}
+
+float MeshRaycaster::raycast(const glm::vec3& Origin, const glm::vec3& Direction, const float MaxDistance) const
+{
+	const BvhRayHit Hit = MTriangles.raycast(Origin, Direction, MaxDistance, [&](const std::uint32_t Triangle)
+	{
+		return intersectTriangle(Origin, Direction, Triangle);
+	});
+	return Hit.Index == InstanceBvh::NoHit ? -1.0f : Hit.Distance;
+}
+
+bool MeshRaycaster::isBuilt() const
+{
+	return MTriangles.getPrimitiveCount() > 0;
+}
+
+float MeshRaycaster::intersectTriangle(const glm::vec3& Origin, const glm::vec3& Direction,
+                                       const std::uint32_t Triangle) const
+{
+	// Moller-Trumbore, double sided so a ray starting inside a model still hits its far wall
+	const glm::vec3& A = MVertices[Triangle * 3];
+	const glm::vec3 EdgeB = MVertices[Triangle * 3 + 1] - A;
+	const glm::vec3 EdgeC = MVertices[Triangle * 3 + 2] - A;
+	const glm::vec3 P = cross(Direction, EdgeC);
+	const float Determinant = dot(EdgeB, P);
+	if (std::abs(Determinant) < 1.0e-12f)
+	{
+		return -1.0f;
+	}
+
+	const float InverseDeterminant = 1.0f / Determinant;
+	const glm::vec3 ToOrigin = Origin - A;
+	const float U = dot(ToOrigin, P) * InverseDeterminant;
+	if (U < 0.0f || U > 1.0f)
+	{
+		return -1.0f;
+	}
+	const glm::vec3 Q = cross(ToOrigin, EdgeB);
+	const float V = dot(Direction, Q) * InverseDeterminant;
+	if (V < 0.0f || U + V > 1.0f)
+	{
+		return -1.0f;
+	}
+	return dot(EdgeC, Q) * InverseDeterminant;
+}
+
+void InstancePicker::setModels(const Model& InstanceModel, const Model& MovingObjectModel)
+{
+	MInstanceMesh.build(InstanceModel);
+	MMovingObjectMesh.build(MovingObjectModel);
+}
+
+void InstancePicker::update(const InstancePool& Instances, const Model& InstanceModel)
+{
+	MInstances = &Instances;
+
+	// A replacement tree was built from older positions, bring it up to date below
+	const bool Swapped = MInstanceBvh.finishRebuild();
+	if (!Swapped && Instances.getRevision() == MRevision &&
+		MInstanceBvh.getPrimitiveCount() == Instances.getCount())
+	{
+		return;
+	}
+
+	MInstanceBvh.refit(Instances, InstanceModel);
+	if (MInstanceBvh.needsRebuild())
+	{
+		MInstanceBvh.rebuildAsync(Instances, InstanceModel);
+	}
+	MRevision = Instances.getRevision();
+}
+
+PickHit InstancePicker::pick(const glm::vec3& Origin, const glm::vec3& Direction,
+                             const glm::mat4& MovingObjectMatrix, const float Time) const
+{
+	const auto Start = std::chrono::steady_clock::now();
+	PickHit Hit{PickTarget::None, InstanceBvh::NoHit, InvalidInstanceHandle, PickDistance, glm::vec3(0.0f), 0.0};
+
+	// Model space rays keep the world direction's length, so distances along them are world distances
+	auto castLocal = [&](const MeshRaycaster& Mesh, const glm::mat4& Transform, const float MaxDistance)
+	{
+		const glm::mat4 Inverse = inverse(Transform);
+		const glm::vec3 LocalOrigin(Inverse * glm::vec4(Origin, 1.0f));
+		const glm::vec3 LocalDirection(Inverse * glm::vec4(Direction, 0.0f));
+		return Mesh.raycast(LocalOrigin, LocalDirection, MaxDistance);
+	};
+
+	if (MMovingObjectMesh.isBuilt())
+	{
+		const float Distance = castLocal(MMovingObjectMesh, MovingObjectMatrix, Hit.Distance);
+		if (Distance >= 0.0f)
+		{
+			Hit.Target = PickTarget::MovingObject;
+			Hit.Distance = Distance;
+		}
+	}
+
+	if (MInstances != nullptr && MInstanceMesh.isBuilt())
+	{
+		// Instances are visited front to back by box, each test only needs to beat the nearest hit so far.
+		// Animated boxes hold every pose, the mesh test uses the one drawn at Time
+		const std::vector<glm::mat4>& Transforms = MInstances->getTransforms();
+		const bool Animated = MInstances->hasAnimations();
+		float Nearest = Hit.Distance;
+		auto testInstance = [&](const std::uint32_t Index)
+		{
+			const glm::mat4 Transform = Animated ? MInstances->getAnimatedTransform(Index, Time) : Transforms[Index];
+			const float Distance = castLocal(MInstanceMesh, Transform, Nearest);
+			if (Distance >= 0.0f && Distance < Nearest)
+			{
+				Nearest = Distance;
+			}
+			return Distance;
+		};
+		const BvhRayHit InstanceHit = MInstanceBvh.raycast(Origin, Direction, Hit.Distance, testInstance);
+		if (InstanceHit.Index != InstanceBvh::NoHit)
+		{
+			Hit.Target = PickTarget::Instance;
+			Hit.Instance = InstanceHit.Index;
+			Hit.Handle = MInstances->getHandle(InstanceHit.Index);
+			Hit.Distance = InstanceHit.Distance;
+		}
+	}
+
+	if (Hit.Target != PickTarget::None)
+	{
+		Hit.Position = Origin + Direction * Hit.Distance;
+	}
+	const std::chrono::duration<double, std::micro> Elapsed = std::chrono::steady_clock::now() - Start;
+	Hit.Microseconds = Elapsed.count();
+	return Hit;
+}
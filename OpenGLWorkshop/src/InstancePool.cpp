@@ -0,0 +1,326 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstancePool.cpp
+Description : Implementations for the pooled instance transform store.
+			  Despawns swap-remove so the GPU buffer always stays dense
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstancePool.h"
+
+#include <algorithm>
+
+#include "GlState.h"
+
+constexpr std::uint32_t NoDenseIndex = 0xFFFFFFFFu;
+
+InstancePool::InstancePool(const unsigned int InitialCapacity)
+	: MAnimatedCount(0), MBuffer(0), MAnimationBuffer(0), MBufferCapacity(0), MUploadCount(0),
+	  MDirtyBegin(NoDenseIndex), MDirtyEnd(0), MRevision(0)
+{
+	MTransforms.reserve(InitialCapacity);
+	MAnimations.reserve(InitialCapacity);
+	MDenseToSlot.reserve(InitialCapacity);
+	MSlotToDense.reserve(InitialCapacity);
+	MGenerations.reserve(InitialCapacity);
+}
+
+InstancePool::~InstancePool()
+{
+	releaseBuffer();
+}
+
+InstanceHandle InstancePool::spawn(const glm::mat4& Transform, const InstanceAnimation& Animation)
+{
+	std::uint32_t Slot;
+	if (!MFreeSlots.empty())
+	{
+		// Reuse the most recently freed slot, its generation was bumped on despawn
+		Slot = MFreeSlots.back();
+		MFreeSlots.pop_back();
+	}
+	else
+	{
+		Slot = static_cast<std::uint32_t>(MSlotToDense.size());
+		MSlotToDense.push_back(NoDenseIndex);
+		MGenerations.push_back(0);
+	}
+
+	const auto DenseIndex = static_cast<std::uint32_t>(MTransforms.size());
+	MTransforms.push_back(Transform);
+	MAnimations.push_back(Animation);
+	MAnimatedCount += InstanceAnimator::isAnimated(Animation) ? 1 : 0;
+	MDenseToSlot.push_back(Slot);
+	MSlotToDense[Slot] = DenseIndex;
+	markDirty(DenseIndex);
+
+	return {Slot, MGenerations[Slot]};
+}
+
+bool InstancePool::despawn(const InstanceHandle Handle)
+{
+	if (!isAlive(Handle))
+	{
+		return false;
+	}
+
+	// Swap-remove: move the last instance into the hole so the array stays dense
+	const std::uint32_t DenseIndex = MSlotToDense[Handle.Slot];
+	const auto LastIndex = static_cast<std::uint32_t>(MTransforms.size() - 1);
+	MAnimatedCount -= InstanceAnimator::isAnimated(MAnimations[DenseIndex]) ? 1 : 0;
+	if (DenseIndex != LastIndex)
+	{
+		const std::uint32_t MovedSlot = MDenseToSlot[LastIndex];
+		MTransforms[DenseIndex] = MTransforms[LastIndex];
+		MAnimations[DenseIndex] = MAnimations[LastIndex];
+		MDenseToSlot[DenseIndex] = MovedSlot;
+		MSlotToDense[MovedSlot] = DenseIndex;
+		markDirty(DenseIndex);
+	}
+	MTransforms.pop_back();
+	MAnimations.pop_back();
+	MDenseToSlot.pop_back();
+	MRevision++;
+
+	MSlotToDense[Handle.Slot] = NoDenseIndex;
+	MGenerations[Handle.Slot]++;
+	MFreeSlots.push_back(Handle.Slot);
+	return true;
+}
+
+void InstancePool::clear()
+{
+	for (const std::uint32_t Slot : MDenseToSlot)
+	{
+		MSlotToDense[Slot] = NoDenseIndex;
+		MGenerations[Slot]++;
+		MFreeSlots.push_back(Slot);
+	}
+	MTransforms.clear();
+	MAnimations.clear();
+	MAnimatedCount = 0;
+	MDenseToSlot.clear();
+	MDirtyBegin = NoDenseIndex;
+	MDirtyEnd = 0;
+	MRevision++;
+}
+
+bool InstancePool::isAlive(const InstanceHandle Handle) const
+{
+	return Handle.Slot < MSlotToDense.size() && MGenerations[Handle.Slot] == Handle.Generation &&
+		MSlotToDense[Handle.Slot] != NoDenseIndex;
+}
+
+bool InstancePool::setTransform(const InstanceHandle Handle, const glm::mat4& Transform)
+{
+	if (!isAlive(Handle))
+	{
+		return false;
+	}
+
+	const std::uint32_t DenseIndex = MSlotToDense[Handle.Slot];
+	MTransforms[DenseIndex] = Transform;
+	markDirty(DenseIndex);
+	return true;
+}
+
+const glm::mat4* InstancePool::getTransform(const InstanceHandle Handle) const
+{
+	return isAlive(Handle) ? &MTransforms[MSlotToDense[Handle.Slot]] : nullptr;
+}
+
+bool InstancePool::setAnimation(const InstanceHandle Handle, const InstanceAnimation& Animation)
+{
+	if (!isAlive(Handle))
+	{
+		return false;
+	}
+
+	const std::uint32_t DenseIndex = MSlotToDense[Handle.Slot];
+	MAnimatedCount -= InstanceAnimator::isAnimated(MAnimations[DenseIndex]) ? 1 : 0;
+	MAnimatedCount += InstanceAnimator::isAnimated(Animation) ? 1 : 0;
+	MAnimations[DenseIndex] = Animation;
+	markDirty(DenseIndex);
+	return true;
+}
+
+const std::vector<glm::mat4>& InstancePool::getTransforms() const
+{
+	return MTransforms;
+}
+
+unsigned int InstancePool::getCount() const
+{
+	return static_cast<unsigned int>(MTransforms.size());
+}
+
+InstanceHandle InstancePool::getHandle(const unsigned int DenseIndex) const
+{
+	if (DenseIndex >= MDenseToSlot.size())
+	{
+		return InvalidInstanceHandle;
+	}
+	const std::uint32_t Slot = MDenseToSlot[DenseIndex];
+	return {Slot, MGenerations[Slot]};
+}
+
+const std::vector<InstanceAnimation>& InstancePool::getAnimations() const
+{
+	return MAnimations;
+}
+
+bool InstancePool::hasAnimations() const
+{
+	return MAnimatedCount > 0;
+}
+
+glm::mat4 InstancePool::getAnimatedTransform(const unsigned int DenseIndex, const float Time) const
+{
+	return InstanceAnimator::evaluate(MTransforms[DenseIndex], MAnimations[DenseIndex], Time);
+}
+
+std::uint64_t InstancePool::getRevision() const
+{
+	return MRevision;
+}
+
+void InstancePool::attachToVao(const GLuint Vao, const GLuint FirstAttribute)
+{
+	if (MBuffer == 0)
+	{
+		growBuffer(std::max(getCount(), 1u));
+	}
+	MAttachedVaos.emplace_back(Vao, FirstAttribute);
+	bindAttributes(Vao, FirstAttribute);
+}
+
+void InstancePool::upload()
+{
+	const unsigned int Count = getCount();
+	if (Count > MBufferCapacity)
+	{
+		growBuffer(Count);
+	}
+
+	// Only the touched range goes over the bus, removed tail entries are simply ignored
+	const std::uint32_t DirtyEnd = std::min(MDirtyEnd, static_cast<std::uint32_t>(Count));
+	if (MDirtyBegin < DirtyEnd)
+	{
+		glNamedBufferSubData(MBuffer, static_cast<GLintptr>(MDirtyBegin * sizeof(glm::mat4)),
+		                     static_cast<GLsizeiptr>((DirtyEnd - MDirtyBegin) * sizeof(glm::mat4)),
+		                     &MTransforms[MDirtyBegin]);
+		glNamedBufferSubData(MAnimationBuffer, static_cast<GLintptr>(MDirtyBegin * sizeof(InstanceAnimation)),
+		                     static_cast<GLsizeiptr>((DirtyEnd - MDirtyBegin) * sizeof(InstanceAnimation)),
+		                     &MAnimations[MDirtyBegin]);
+	}
+
+	MDirtyBegin = NoDenseIndex;
+	MDirtyEnd = 0;
+	MUploadCount = Count;
+}
+
+GLuint InstancePool::getBuffer() const
+{
+	return MBuffer;
+}
+
+GLuint InstancePool::getAnimationBuffer() const
+{
+	return MAnimationBuffer;
+}
+
+unsigned int InstancePool::getUploadCount() const
+{
+	return MUploadCount;
+}
+
+void InstancePool::releaseBuffer()
+{
+	if (MBuffer != 0)
+	{
+		GlState::deleteBuffers(1, &MBuffer);
+		GlState::deleteBuffers(1, &MAnimationBuffer);
+		MBuffer = 0;
+		MAnimationBuffer = 0;
+		MBufferCapacity = 0;
+		MUploadCount = 0;
+	}
+}
+
+void InstancePool::markDirty(const std::uint32_t DenseIndex)
+{
+	MDirtyBegin = std::min(MDirtyBegin, DenseIndex);
+	MDirtyEnd = std::max(MDirtyEnd, DenseIndex + 1);
+	MRevision++;
+}
+
+void InstancePool::growBuffer(const unsigned int RequiredCapacity)
+{
+	unsigned int NewCapacity = std::max(MBufferCapacity, 64u);
+	while (NewCapacity < RequiredCapacity)
+	{
+		NewCapacity *= 2;
+	}
+
+	// Carry the already uploaded instances across on the GPU instead of re-uploading them
+	auto growOne = [&](GLuint& Buffer, const std::size_t Stride)
+	{
+		GLuint NewBuffer;
+		glCreateBuffers(1, &NewBuffer);
+		glNamedBufferData(NewBuffer, static_cast<GLsizeiptr>(NewCapacity * Stride), nullptr, GL_DYNAMIC_DRAW);
+		if (Buffer != 0 && MUploadCount > 0)
+		{
+			glCopyNamedBufferSubData(Buffer, NewBuffer, 0, 0, static_cast<GLsizeiptr>(MUploadCount * Stride));
+		}
+		if (Buffer != 0)
+		{
+			GlState::deleteBuffers(1, &Buffer);
+		}
+		Buffer = NewBuffer;
+	};
+
+	if (MBuffer == 0)
+	{
+		// First allocation, everything currently pooled still has to go up once
+		MDirtyBegin = 0;
+		MDirtyEnd = getCount();
+	}
+	growOne(MBuffer, sizeof(glm::mat4));
+	growOne(MAnimationBuffer, sizeof(InstanceAnimation));
+	MBufferCapacity = NewCapacity;
+
+	for (const auto& [Vao, FirstAttribute] : MAttachedVaos)
+	{
+		bindAttributes(Vao, FirstAttribute);
+	}
+}
+
+void InstancePool::bindAttributes(const GLuint Vao, const GLuint FirstAttribute) const
+{
+	// A mat4 attribute takes four consecutive vec4 locations, each reading its own binding of the same index so
+	// the render queue can repoint them. Edited directly, so nothing bound changes
+	auto bindAttribute = [Vao](const GLuint Attribute, const GLuint Buffer, const std::size_t Offset,
+	                           const std::size_t Stride)
+	{
+		glEnableVertexArrayAttrib(Vao, Attribute);
+		glVertexArrayAttribFormat(Vao, Attribute, 4, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(Vao, Attribute, Attribute);
+		glVertexArrayVertexBuffer(Vao, Attribute, Buffer, static_cast<GLintptr>(Offset), static_cast<GLsizei>(Stride));
+		glVertexArrayBindingDivisor(Vao, Attribute, 1);
+	};
+	for (GLuint I = 0; I < 4; I++)
+	{
+		bindAttribute(FirstAttribute + I, MBuffer, I * sizeof(glm::vec4), sizeof(glm::mat4));
+	}
+	for (GLuint I = 0; I < 2; I++)
+	{
+		bindAttribute(FirstAttribute + 4 + I, MAnimationBuffer, I * sizeof(glm::vec4), sizeof(InstanceAnimation));
+	}
+}
@@ -0,0 +1,85 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceScatter.cpp
+Description : Implementations for deterministic random instance placement
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstanceScatter.h"
+#include "CounterRng.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <gtc/constants.hpp>
+#include <gtc/quaternion.hpp>
+
+void InstanceScatter::generate(const ScatterSettings& Settings, const std::size_t Begin, const std::size_t End,
+                               TransformStorage& Transforms)
+{
+	const Philox4x32::Key Key = Philox4x32::makeKey(Settings.Seed);
+	const glm::vec3 Axis = normalize(Settings.RotationAxis);
+
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		// Counter word 0/1 is the instance index, word 2 selects the block of four numbers
+		const auto Low = static_cast<std::uint32_t>(I);
+		const auto High = static_cast<std::uint32_t>(static_cast<std::uint64_t>(I) >> 32);
+		const Philox4x32::Counter Placement = Philox4x32::generate({Low, High, 0, 0}, Key);
+		const Philox4x32::Counter Extra = Philox4x32::generate({Low, High, 1, 0}, Key);
+
+		const float Angle = Philox4x32::toRange(Placement[0], Settings.MinAngle, Settings.MaxAngle);
+		const glm::vec3 Position(Philox4x32::toRange(Placement[1], Settings.MinDisplacement, Settings.MaxDisplacement),
+		                         Philox4x32::toRange(Placement[2], Settings.MinDisplacement, Settings.MaxDisplacement),
+		                         Philox4x32::toRange(Placement[3], Settings.MinDisplacement, Settings.MaxDisplacement));
+		const float Scale = Philox4x32::toRange(Extra[0], Settings.MinScale, Settings.MaxScale);
+
+		Transforms.setTransform(I, Position, angleAxis(glm::radians(Angle), Axis), glm::vec3(Scale));
+	}
+}
+
+void InstanceScatter::generateParallel(const ScatterSettings& Settings, const std::size_t Count,
+                                       TransformStorage& Transforms)
+{
+	Transforms.resize(Count);
+	Parallel::forRange(Count, 16384, [&](const std::size_t Begin, const std::size_t End)
+	{
+		generate(Settings, Begin, End, Transforms);
+	});
+}
+
+void InstanceScatter::generateAnimations(const ScatterSettings& Settings, const std::size_t Begin,
+                                         const std::size_t End, std::vector<InstanceAnimation>& Animations)
+{
+	if (Animations.size() < End)
+	{
+		Animations.resize(End);
+	}
+
+	const Philox4x32::Key Key = Philox4x32::makeKey(Settings.Seed);
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		const auto Low = static_cast<std::uint32_t>(I);
+		const auto High = static_cast<std::uint32_t>(static_cast<std::uint64_t>(I) >> 32);
+		const Philox4x32::Counter Spin = Philox4x32::generate({Low, High, 2, 0}, Key);
+		const Philox4x32::Counter Bob = Philox4x32::generate({Low, High, 3, 0}, Key);
+
+		// Uniform direction from a height and an angle around the pole
+		const float Height = Philox4x32::toRange(Spin[0], -1.0f, 1.0f);
+		const float Around = Philox4x32::toRange(Spin[1], 0.0f, glm::two_pi<float>());
+		const float Ring = std::sqrt(std::max(0.0f, 1.0f - Height * Height));
+		const glm::vec3 Axis(Ring * std::cos(Around), Height, Ring * std::sin(Around));
+
+		Animations[I].Spin = glm::vec4(Axis, Philox4x32::toRange(Spin[2], Settings.MinSpinRate, Settings.MaxSpinRate));
+		Animations[I].Bob = glm::vec4(Philox4x32::toRange(Bob[0], Settings.MinBobAmplitude, Settings.MaxBobAmplitude),
+		                              Philox4x32::toRange(Bob[1], Settings.MinBobRate, Settings.MaxBobRate),
+		                              Philox4x32::toRange(Bob[2], 0.0f, glm::two_pi<float>()), 0.0f);
+	}
+}
@@ -0,0 +1,180 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : InstanceStream.cpp
+Description : Implementations for per frame instance data written straight
+			  into persistently mapped buffers, fenced as a ring
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "InstanceStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "RenderBackend.h"
+#include "GlCapture.h"
+
+constexpr std::size_t MinRegionCapacity = 4096;
+
+InstanceStream::InstanceStream()
+	: MBackend(&GlBackend::get())
+{
+}
+
+InstanceStream::~InstanceStream()
+{
+	release();
+}
+
+GLuint InstanceStream::reserve(const std::size_t Count)
+{
+	MWaitMilliseconds = 0.0;
+	if (!MRegionWaited)
+	{
+		waitForRegion();
+	}
+	if (MUsed + Count > MRegionCapacity)
+	{
+		grow(MUsed + Count);
+	}
+
+	const auto BaseInstance = static_cast<GLuint>(static_cast<std::size_t>(MRegion) * MRegionCapacity + MUsed);
+	MUsed += Count;
+	return BaseInstance;
+}
+
+void InstanceStream::write(const GLuint BaseInstance, const glm::mat4* Transforms,
+                           const InstanceAnimation* Animations, const std::size_t Count)
+{
+	// Coherent, so the copies are visible to every draw issued after them without a flush
+	std::memcpy(MTransforms + BaseInstance, Transforms, Count * sizeof(glm::mat4));
+	GlCapture::recordMappedWrite(MTransforms + BaseInstance, Transforms, Count * sizeof(glm::mat4));
+	if (Animations != nullptr)
+	{
+		std::memcpy(MAnimations + BaseInstance, Animations, Count * sizeof(InstanceAnimation));
+		GlCapture::recordMappedWrite(MAnimations + BaseInstance, Animations, Count * sizeof(InstanceAnimation));
+	}
+}
+
+void InstanceStream::finishRegion()
+{
+	if (!MRegionWaited)
+	{
+		return; // Nothing was reserved, the region is still free
+	}
+
+	MFences[MRegion] = MBackend->fence();
+	MRegion = (MRegion + 1) % Regions;
+	MUsed = 0;
+	MRegionWaited = false;
+
+	// Draws naming them have been issued, and GL keeps a buffer alive for those until they finish
+	if (!MRetired.empty())
+	{
+		MBackend->deleteBuffers(static_cast<GLsizei>(MRetired.size()), MRetired.data());
+		MRetired.clear();
+	}
+}
+
+void InstanceStream::setBackend(RenderBackend& Backend)
+{
+	release();
+	MBackend = &Backend;
+}
+
+GLuint InstanceStream::getTransformBuffer() const
+{
+	return MTransformBuffer;
+}
+
+GLuint InstanceStream::getAnimationBuffer() const
+{
+	return MAnimationBuffer;
+}
+
+double InstanceStream::getWaitMilliseconds() const
+{
+	return MWaitMilliseconds;
+}
+
+void InstanceStream::grow(const std::size_t RequiredCapacity)
+{
+	std::size_t Capacity = std::max(MRegionCapacity * 2, MinRegionCapacity);
+	while (Capacity < RequiredCapacity)
+	{
+		Capacity *= 2;
+	}
+
+	// Packets already replayed this region name the old buffers, so they live until it's submitted
+	if (MTransformBuffer != 0)
+	{
+		MRetired.push_back(MTransformBuffer);
+		MRetired.push_back(MAnimationBuffer);
+	}
+
+	// Every region of the new buffers is free, the fences left over only make a later wait cautious
+	auto create = [this, Capacity](GLuint& Buffer, const std::size_t Stride)
+	{
+		void* Mapped = nullptr;
+		Buffer = MBackend->createMappedBuffer(Capacity * Regions * Stride, Mapped);
+		return Mapped;
+	};
+	MTransforms = static_cast<glm::mat4*>(create(MTransformBuffer, sizeof(glm::mat4)));
+	MAnimations = static_cast<InstanceAnimation*>(create(MAnimationBuffer, sizeof(InstanceAnimation)));
+	MRegionCapacity = Capacity;
+	MUsed = 0;
+}
+
+void InstanceStream::waitForRegion()
+{
+	MRegionWaited = true;
+	GLsync& Fence = MFences[MRegion];
+	if (Fence == nullptr)
+	{
+		return;
+	}
+
+	const auto Start = std::chrono::steady_clock::now();
+	MBackend->waitFence(Fence);
+	Fence = nullptr;
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MWaitMilliseconds = Elapsed.count();
+}
+
+void InstanceStream::release()
+{
+	for (GLsync& Fence : MFences)
+	{
+		if (Fence != nullptr)
+		{
+			MBackend->deleteFence(Fence);
+			Fence = nullptr;
+		}
+	}
+	if (!MRetired.empty())
+	{
+		MBackend->deleteBuffers(static_cast<GLsizei>(MRetired.size()), MRetired.data());
+		MRetired.clear();
+	}
+	if (MTransformBuffer != 0)
+	{
+		MBackend->deleteBuffers(1, &MTransformBuffer);
+		MBackend->deleteBuffers(1, &MAnimationBuffer);
+	}
+	MTransformBuffer = 0;
+	MAnimationBuffer = 0;
+	MTransforms = nullptr;
+	MAnimations = nullptr;
+	MRegionCapacity = 0;
+	MRegion = 0;
+	MUsed = 0;
+	MRegionWaited = false;
+}
@@ -0,0 +1,522 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : JobSystem.cpp
+Description : Implementations for a work-stealing job system with one
+			  worker per core, job counters and parallel loops
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "TraceRecorder.h"
+
+namespace
+{
+	constexpr std::size_t MaxThreadSlots = 256; // Workers plus every other thread that has submitted
+	constexpr std::size_t JobMask = JobSystem::DequeCapacity - 1;
+	constexpr int IdleSpins = 64; // Fruitless searches before a worker goes to sleep
+
+	// A queued job and whether its slot in the owner's ring is still in use, set until an executor copies it out
+	struct JobRecord
+	{
+		Job Task{};
+		std::atomic<bool> Busy{false};
+	};
+
+	// Chase-Lev deque in the C11 formulation of Le, Pop, Cohen and Zappa Nardelli, at a fixed capacity. Only
+	// the owner pushes and pops, at the bottom, and any thread steals from the top
+	class WorkStealingDeque
+	{
+	public:
+		bool push(JobRecord* Record)
+		{
+			const std::int64_t Bottom = MBottom.load(std::memory_order_relaxed);
+			const std::int64_t Top = MTop.load(std::memory_order_acquire);
+			if (Bottom - Top >= static_cast<std::int64_t>(JobSystem::DequeCapacity))
+			{
+				return false;
+			}
+			MItems[Bottom & JobMask].store(Record, std::memory_order_relaxed);
+			MBottom.store(Bottom + 1, std::memory_order_release);
+			return true;
+		}
+
+		JobRecord* pop()
+		{
+			const std::int64_t Bottom = MBottom.load(std::memory_order_relaxed) - 1;
+			MBottom.store(Bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			std::int64_t Top = MTop.load(std::memory_order_relaxed);
+			if (Top > Bottom)
+			{
+				MBottom.store(Bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			JobRecord* Record = MItems[Bottom & JobMask].load(std::memory_order_relaxed);
+			if (Top == Bottom)
+			{
+				// The last job, thieves may be racing for it
+				if (!MTop.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst,
+				                                  std::memory_order_relaxed))
+				{
+					Record = nullptr;
+				}
+				MBottom.store(Bottom + 1, std::memory_order_relaxed);
+			}
+			return Record;
+		}
+
+		JobRecord* steal()
+		{
+			std::int64_t Top = MTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::int64_t Bottom = MBottom.load(std::memory_order_acquire);
+			if (Top >= Bottom)
+			{
+				return nullptr;
+			}
+
+			JobRecord* Record = MItems[Top & JobMask].load(std::memory_order_relaxed);
+			if (!MTop.compare_exchange_strong(Top, Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return Record;
+		}
+
+		[[nodiscard]] bool isEmpty() const
+		{
+			return MBottom.load(std::memory_order_relaxed) <= MTop.load(std::memory_order_relaxed);
+		}
+
+	private:
+		alignas(64) std::atomic<std::int64_t> MTop{0};
+		alignas(64) std::atomic<std::int64_t> MBottom{0};
+		std::atomic<JobRecord*> MItems[JobSystem::DequeCapacity]{};
+	};
+
+	// Owned by one thread at a time. Records are handed out round the ring and reused once executed
+	struct ThreadSlot
+	{
+		WorkStealingDeque Deque;
+		JobRecord Records[JobSystem::DequeCapacity];
+		std::size_t NextRecord = 0;
+		std::atomic<bool> Claimed{false};
+		std::uint32_t Seed = 0; // Picks where each search for a victim starts
+		std::atomic<std::uint64_t> Executed{0};
+		std::atomic<std::uint64_t> Stolen{0};
+		std::atomic<std::uint64_t> StealAttempts{0};
+		std::atomic<std::uint64_t> Inline{0};
+	};
+
+	struct SystemState
+	{
+		std::atomic<ThreadSlot*> Slots[MaxThreadSlots]{};
+		std::atomic<std::size_t> SlotCount{0}; // Slots ever allocated, none are freed until exit
+		std::mutex SlotMutex;
+
+		std::mutex StartMutex;
+		std::vector<std::thread> Workers;
+		std::atomic<unsigned int> ThreadCount{0};
+		std::atomic<bool> Running{false};
+
+		std::mutex SleepMutex;
+		std::condition_variable Wake;
+		std::atomic<int> Sleeping{0};
+		std::uint64_t WakeEpoch = 0; // Guarded by SleepMutex, bumped on every wake so none are lost
+
+		~SystemState();
+	};
+
+	SystemState& state()
+	{
+		static SystemState State;
+		return State;
+	}
+
+	ThreadSlot* claimSlot()
+	{
+		SystemState& State = state();
+		std::lock_guard<std::mutex> Lock(State.SlotMutex);
+		for (std::size_t I = 0; I < MaxThreadSlots; I++)
+		{
+			ThreadSlot* Slot = State.Slots[I].load(std::memory_order_acquire);
+			if (Slot == nullptr)
+			{
+				Slot = new ThreadSlot;
+				Slot->Claimed.store(true, std::memory_order_relaxed);
+				Slot->Seed = static_cast<std::uint32_t>(I * 2654435761u + 1);
+				State.Slots[I].store(Slot, std::memory_order_release);
+				State.SlotCount.store(I + 1, std::memory_order_release);
+				return Slot;
+			}
+
+			// Left by a thread that has exited, anything it queued is still there to run
+			bool Expected = false;
+			if (Slot->Claimed.compare_exchange_strong(Expected, true, std::memory_order_acquire))
+			{
+				return Slot;
+			}
+		}
+		std::terminate();
+	}
+
+	// Releases the thread's slot for reuse when the thread exits
+	struct SlotLease
+	{
+		ThreadSlot* Slot = nullptr;
+
+		~SlotLease()
+		{
+			if (Slot != nullptr)
+			{
+				Slot->Claimed.store(false, std::memory_order_release);
+			}
+		}
+	};
+
+	thread_local SlotLease GLease;
+
+	ThreadSlot& currentSlot()
+	{
+		if (GLease.Slot == nullptr)
+		{
+			GLease.Slot = claimSlot();
+		}
+		return *GLease.Slot;
+	}
+
+	JobRecord* findJob(ThreadSlot& Self)
+	{
+		if (JobRecord* Record = Self.Deque.pop())
+		{
+			return Record;
+		}
+
+		SystemState& State = state();
+		const std::size_t Count = State.SlotCount.load(std::memory_order_acquire);
+		Self.Seed = Self.Seed * 1664525u + 1013904223u;
+		const std::size_t First = (Self.Seed >> 8) % Count;
+		for (std::size_t I = 0; I < Count; I++)
+		{
+			ThreadSlot* Victim = State.Slots[(First + I) % Count].load(std::memory_order_acquire);
+			if (Victim == nullptr || Victim == &Self || Victim->Deque.isEmpty())
+			{
+				continue;
+			}
+			Self.StealAttempts.fetch_add(1, std::memory_order_relaxed);
+			if (JobRecord* Record = Victim->Deque.steal())
+			{
+				Self.Stolen.fetch_add(1, std::memory_order_relaxed);
+				return Record;
+			}
+		}
+		return nullptr;
+	}
+
+	void execute(JobRecord* Record)
+	{
+		// Copied out first so the owner can reuse the record while this runs
+		const Job Task = Record->Task;
+		Record->Busy.store(false, std::memory_order_release);
+		JobSystem::run(Task);
+	}
+
+	void wakeOne()
+	{
+		SystemState& State = state();
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (State.Sleeping.load(std::memory_order_relaxed) > 0)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(State.SleepMutex);
+				State.WakeEpoch++;
+			}
+			State.Wake.notify_one();
+		}
+	}
+
+	void workerLoop()
+	{
+		TraceRecorder::setThreadName("job worker");
+		SystemState& State = state();
+		ThreadSlot& Self = currentSlot();
+		int Idle = 0;
+		while (State.Running.load(std::memory_order_acquire))
+		{
+			if (JobRecord* Record = findJob(Self))
+			{
+				execute(Record);
+				Idle = 0;
+				continue;
+			}
+			if (++Idle < IdleSpins)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Announce the sleep before a last search, so a submit either sees the sleeper or its job is found
+			std::unique_lock<std::mutex> Lock(State.SleepMutex);
+			const std::uint64_t Epoch = State.WakeEpoch;
+			State.Sleeping.fetch_add(1, std::memory_order_seq_cst);
+			Lock.unlock();
+			if (JobRecord* Record = findJob(Self))
+			{
+				State.Sleeping.fetch_sub(1, std::memory_order_relaxed);
+				execute(Record);
+				Idle = 0;
+				continue;
+			}
+			Lock.lock();
+			State.Wake.wait(Lock, [&]
+			{
+				return State.WakeEpoch != Epoch || !State.Running.load(std::memory_order_acquire);
+			});
+			Lock.unlock();
+			State.Sleeping.fetch_sub(1, std::memory_order_relaxed);
+			Idle = 0;
+		}
+	}
+
+	void stopWorkers(SystemState& State)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(State.SleepMutex);
+			State.Running.store(false, std::memory_order_release);
+			State.WakeEpoch++;
+		}
+		State.Wake.notify_all();
+		for (std::thread& Worker : State.Workers)
+		{
+			Worker.join();
+		}
+		State.Workers.clear();
+	}
+
+	SystemState::~SystemState()
+	{
+		stopWorkers(*this);
+		for (std::atomic<ThreadSlot*>& Slot : Slots)
+		{
+			delete Slot.load(std::memory_order_relaxed);
+		}
+	}
+
+	void ensureStarted()
+	{
+		if (state().ThreadCount.load(std::memory_order_acquire) == 0)
+		{
+			JobSystem::start(0);
+		}
+	}
+
+	struct RangeTask
+	{
+		const JobSystem::RangeFunction* Body;
+		JobCounter* Counter;
+	};
+
+	// Runs [Begin, End) a grain at a time, handing the upper half to thieves whenever the deque runs dry
+	void runRange(const RangeTask& Range, std::size_t Begin, std::size_t End, const std::size_t Grain)
+	{
+		ThreadSlot& Self = currentSlot();
+		while (Begin < End)
+		{
+			if (End - Begin >= 2 * Grain && Self.Deque.isEmpty())
+			{
+				const std::size_t Middle = Begin + (End - Begin) / 2;
+				JobSystem::submit({[](const Job& Task)
+				{
+					runRange(*static_cast<const RangeTask*>(Task.Data), Task.Begin, Task.End, Task.Grain);
+				}, const_cast<RangeTask*>(&Range), Middle, End, Grain, Range.Counter, nullptr});
+				End = Middle;
+				continue;
+			}
+
+			const std::size_t Next = std::min(Begin + Grain, End);
+			(*Range.Body)(Begin, Next);
+			Begin = Next;
+		}
+	}
+}
+
+bool JobCounter::isDone() const
+{
+	return MCount.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::start(const unsigned int ThreadCount)
+{
+	SystemState& State = state();
+	std::lock_guard<std::mutex> Lock(State.StartMutex);
+	const unsigned int Count = ThreadCount != 0 ? ThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	if (State.Running.load(std::memory_order_relaxed) && State.ThreadCount.load(std::memory_order_relaxed) == Count)
+	{
+		return;
+	}
+
+	stopWorkers(State);
+	State.Running.store(true, std::memory_order_release);
+	for (unsigned int Worker = 1; Worker < Count; Worker++)
+	{
+		State.Workers.emplace_back(workerLoop);
+	}
+	State.ThreadCount.store(Count, std::memory_order_release);
+}
+
+unsigned int JobSystem::getThreadCount()
+{
+	ensureStarted();
+	return state().ThreadCount.load(std::memory_order_acquire);
+}
+
+void JobSystem::submit(const Job& Task)
+{
+	ensureStarted();
+	if (Task.Counter != nullptr)
+	{
+		Task.Counter->MCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	ThreadSlot& Self = currentSlot();
+	JobRecord& Record = Self.Records[Self.NextRecord & JobMask];
+	if (Record.Busy.load(std::memory_order_acquire))
+	{
+		// The ring has come round to a job nobody has picked up yet
+		Self.Inline.fetch_add(1, std::memory_order_relaxed);
+		run(Task);
+		return;
+	}
+
+	Record.Task = Task;
+	Record.Busy.store(true, std::memory_order_relaxed);
+	if (!Self.Deque.push(&Record))
+	{
+		Record.Busy.store(false, std::memory_order_relaxed);
+		Self.Inline.fetch_add(1, std::memory_order_relaxed);
+		run(Task);
+		return;
+	}
+	Self.NextRecord++;
+	wakeOne();
+}
+
+void JobSystem::run(const Job& Task)
+{
+	if (Task.After != nullptr && !Task.After->isDone())
+	{
+		wait(*Task.After);
+	}
+	if (TraceRecorder::isRecording())
+	{
+		const std::uint64_t Start = TraceRecorder::now();
+		Task.Function(Task);
+		TraceRecorder::record(TraceCategory::Job, "job", Start, TraceRecorder::now());
+	}
+	else
+	{
+		Task.Function(Task);
+	}
+	currentSlot().Executed.fetch_add(1, std::memory_order_relaxed);
+
+	// The decrement is the last touch, a waiter may destroy the counter straight after
+	if (Task.Counter != nullptr)
+	{
+		Task.Counter->MCount.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void JobSystem::wait(const JobCounter& Counter)
+{
+	ThreadSlot& Self = currentSlot();
+	while (!Counter.isDone())
+	{
+		if (JobRecord* Record = findJob(Self))
+		{
+			execute(Record);
+			continue;
+		}
+		// Whatever is left is already running elsewhere
+		std::this_thread::yield();
+	}
+}
+
+bool JobSystem::tryRunJob()
+{
+	if (JobRecord* Record = findJob(currentSlot()))
+	{
+		execute(Record);
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::parallelFor(const std::size_t Count, const std::size_t MinGrain, const RangeFunction& Body)
+{
+	if (Count == 0)
+	{
+		return;
+	}
+
+	const std::size_t Grain = std::max<std::size_t>(MinGrain, 1);
+	if (Count <= Grain || getThreadCount() <= 1)
+	{
+		Body(0, Count);
+		return;
+	}
+
+	JobCounter Counter;
+	const RangeTask Range{&Body, &Counter};
+	runRange(Range, 0, Count, Grain);
+	wait(Counter);
+}
+
+JobSystemStats JobSystem::getStats()
+{
+	SystemState& State = state();
+	JobSystemStats Stats{};
+	const std::size_t Count = State.SlotCount.load(std::memory_order_acquire);
+	for (std::size_t I = 0; I < Count; I++)
+	{
+		if (const ThreadSlot* Slot = State.Slots[I].load(std::memory_order_acquire))
+		{
+			Stats.Executed += Slot->Executed.load(std::memory_order_relaxed);
+			Stats.Stolen += Slot->Stolen.load(std::memory_order_relaxed);
+			Stats.StealAttempts += Slot->StealAttempts.load(std::memory_order_relaxed);
+			Stats.Inline += Slot->Inline.load(std::memory_order_relaxed);
+		}
+	}
+	return Stats;
+}
+
+void JobSystem::resetStats()
+{
+	SystemState& State = state();
+	const std::size_t Count = State.SlotCount.load(std::memory_order_acquire);
+	for (std::size_t I = 0; I < Count; I++)
+	{
+		if (ThreadSlot* Slot = State.Slots[I].load(std::memory_order_acquire))
+		{
+			Slot->Executed.store(0, std::memory_order_relaxed);
+			Slot->Stolen.store(0, std::memory_order_relaxed);
+			Slot->StealAttempts.store(0, std::memory_order_relaxed);
+			Slot->Inline.store(0, std::memory_order_relaxed);
+		}
+	}
+}
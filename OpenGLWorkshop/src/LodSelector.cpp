@@ -0,0 +1,175 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : LodSelector.cpp
+Description : Implementations for per instance level of detail selection
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "LodSelector.h"
+#include "Parallel.h"
+
+#include <algorithm>
+
+constexpr std::uint8_t UnassignedLevel = 0xFF;
+constexpr std::size_t SelectBlock = 4096; // Visible instances per task, fixed so the batches never depend on threads
+
+LodSelector::LodSelector()
+	: MThresholds{48.0f, 20.0f, 8.0f}, MHysteresis(0.15f), MBucketOffsets{}, MBucketCounts{}
+{
+}
+
+void LodSelector::select(const InstancePool& Instances, const std::vector<std::uint32_t>& Visible,
+                         const std::vector<float>& PixelDiameters, const int LevelCount)
+{
+	const int Levels = std::clamp(LevelCount, 1, MaxLods);
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const auto Count = static_cast<unsigned int>(Visible.size());
+	const std::size_t BlockCount = (Count + SelectBlock - 1) / SelectBlock;
+
+	MFrameLevels.resize(Count);
+	MBlockCursors.resize(BlockCount * MaxLods);
+
+	// Grow the per slot history up front so the blocks below only ever write their own slots
+	std::uint32_t SlotEnd = 0;
+	for (unsigned int I = 0; I < Count; I++)
+	{
+		SlotEnd = std::max(SlotEnd, Instances.getHandle(Visible[I]).Slot + 1);
+	}
+	if (SlotEnd > MSlotLevels.size())
+	{
+		MSlotLevels.resize(SlotEnd, UnassignedLevel);
+	}
+
+	Parallel::forRange(BlockCount, 1, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t Block = Begin; Block < End; Block++)
+		{
+			unsigned int* Counts = &MBlockCursors[Block * MaxLods];
+			std::fill(Counts, Counts + MaxLods, 0u);
+			const unsigned int Last = std::min(static_cast<unsigned int>((Block + 1) * SelectBlock), Count);
+			for (auto I = static_cast<unsigned int>(Block * SelectBlock); I < Last; I++)
+			{
+				const std::uint32_t Slot = Instances.getHandle(Visible[I]).Slot;
+				const int Level = chooseLevel(MSlotLevels[Slot], PixelDiameters[I], Levels);
+				MSlotLevels[Slot] = static_cast<std::uint8_t>(Level);
+				MFrameLevels[I] = static_cast<std::uint8_t>(Level);
+				Counts[Level]++;
+			}
+		}
+	});
+
+	// Counting sort into contiguous per level ranges. Each block writes after the earlier blocks at its level,
+	// so the batches come out in visible order whatever the thread count
+	unsigned int Offset = 0;
+	for (int Level = 0; Level < MaxLods; Level++)
+	{
+		MBucketOffsets[Level] = Offset;
+		for (std::size_t Block = 0; Block < BlockCount; Block++)
+		{
+			const unsigned int Counted = MBlockCursors[Block * MaxLods + Level];
+			MBlockCursors[Block * MaxLods + Level] = Offset;
+			Offset += Counted;
+		}
+		MBucketCounts[Level] = Offset - MBucketOffsets[Level];
+	}
+
+	MBatched.resize(Count);
+	MBatchedAnimations.clear();
+	// Animations ride along in the same order so the GPU pairs them with their base transforms
+	const bool Animated = Instances.hasAnimations();
+	const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+	if (Animated)
+	{
+		MBatchedAnimations.resize(Count);
+	}
+	Parallel::forRange(BlockCount, 1, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t Block = Begin; Block < End; Block++)
+		{
+			unsigned int* Cursor = &MBlockCursors[Block * MaxLods];
+			const unsigned int Last = std::min(static_cast<unsigned int>((Block + 1) * SelectBlock), Count);
+			for (auto I = static_cast<unsigned int>(Block * SelectBlock); I < Last; I++)
+			{
+				const unsigned int Target = Cursor[MFrameLevels[I]]++;
+				MBatched[Target] = Transforms[Visible[I]];
+				if (Animated)
+				{
+					MBatchedAnimations[Target] = Animations[Visible[I]];
+				}
+			}
+		}
+	});
+}
+
+void LodSelector::setThreshold(const int Level, const float PixelDiameter)
+{
+	if (Level >= 0 && Level < MaxLods - 1)
+	{
+		MThresholds[Level] = PixelDiameter;
+	}
+}
+
+void LodSelector::setHysteresis(const float Fraction)
+{
+	MHysteresis = std::clamp(Fraction, 0.0f, 0.9f);
+}
+
+const std::vector<glm::mat4>& LodSelector::getBatchedTransforms() const
+{
+	return MBatched;
+}
+
+const std::vector<InstanceAnimation>& LodSelector::getBatchedAnimations() const
+{
+	return MBatchedAnimations;
+}
+
+void LodSelector::takeBatches(std::vector<glm::mat4>& Transforms, std::vector<InstanceAnimation>& Animations)
+{
+	MBatched.swap(Transforms);
+	MBatchedAnimations.swap(Animations);
+}
+
+unsigned int LodSelector::getBucketOffset(const int Level) const
+{
+	return MBucketOffsets[Level];
+}
+
+unsigned int LodSelector::getBucketCount(const int Level) const
+{
+	return MBucketCounts[Level];
+}
+
+int LodSelector::chooseLevel(const int Current, const float PixelDiameter, const int LevelCount) const
+{
+	int Level = Current;
+	if (Current == UnassignedLevel)
+	{
+		// First sighting picks the plain threshold level with no hysteresis band
+		Level = 0;
+		while (Level < LevelCount - 1 && PixelDiameter < MThresholds[Level])
+		{
+			Level++;
+		}
+		return Level;
+	}
+
+	// Only cross a threshold once the size is clearly past it, so instances near a boundary don't flicker
+	Level = std::min(Level, LevelCount - 1);
+	while (Level < LevelCount - 1 && PixelDiameter < MThresholds[Level] * (1.0f - MHysteresis))
+	{
+		Level++;
+	}
+	while (Level > 0 && PixelDiameter > MThresholds[Level - 1] * (1.0f + MHysteresis))
+	{
+		Level--;
+	}
+	return Level;
+}
@@ -0,0 +1,381 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : MeshSimplifier.cpp
+Description : Implementations for quadric error metric simplification.
+			  Collapses run in passes of independent edges ordered by
+			  cost, which keeps the implementation free of a mutable
+			  priority queue while staying close to greedy order
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "MeshSimplifier.h"
+
+#include <glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+// Symmetric 4x4 plane quadric, only the upper triangle is stored
+struct Quadric
+{
+	double A00 = 0, A01 = 0, A02 = 0, A03 = 0;
+	double A11 = 0, A12 = 0, A13 = 0;
+	double A22 = 0, A23 = 0;
+	double A33 = 0;
+	double Weight = 0;
+
+	static Quadric fromPlane(const glm::dvec3& Normal, const double Distance, const double Weight)
+	{
+		Quadric Q;
+		Q.A00 = Weight * Normal.x * Normal.x;
+		Q.A01 = Weight * Normal.x * Normal.y;
+		Q.A02 = Weight * Normal.x * Normal.z;
+		Q.A03 = Weight * Normal.x * Distance;
+		Q.A11 = Weight * Normal.y * Normal.y;
+		Q.A12 = Weight * Normal.y * Normal.z;
+		Q.A13 = Weight * Normal.y * Distance;
+		Q.A22 = Weight * Normal.z * Normal.z;
+		Q.A23 = Weight * Normal.z * Distance;
+		Q.A33 = Weight * Distance * Distance;
+		Q.Weight = Weight;
+		return Q;
+	}
+
+	void add(const Quadric& Other)
+	{
+		A00 += Other.A00;
+		A01 += Other.A01;
+		A02 += Other.A02;
+		A03 += Other.A03;
+		A11 += Other.A11;
+		A12 += Other.A12;
+		A13 += Other.A13;
+		A22 += Other.A22;
+		A23 += Other.A23;
+		A33 += Other.A33;
+		Weight += Other.Weight;
+	}
+
+	// Weighted mean of squared distances from P to every accumulated plane
+	[[nodiscard]] double evaluate(const glm::dvec3& P) const
+	{
+		const double Sum = A00 * P.x * P.x + 2.0 * A01 * P.x * P.y + 2.0 * A02 * P.x * P.z + 2.0 * A03 * P.x +
+			A11 * P.y * P.y + 2.0 * A12 * P.y * P.z + 2.0 * A13 * P.y +
+			A22 * P.z * P.z + 2.0 * A23 * P.z + A33;
+		return Weight > 0.0 ? std::abs(Sum) / Weight : 0.0;
+	}
+};
+
+struct Collapse
+{
+	std::uint32_t From;
+	std::uint32_t To;
+	double Cost;
+};
+
+static std::uint64_t makeEdgeKey(const std::uint32_t A, const std::uint32_t B)
+{
+	return A < B
+		       ? (static_cast<std::uint64_t>(A) << 32) | B
+		       : (static_cast<std::uint64_t>(B) << 32) | A;
+}
+
+std::vector<unsigned int> MeshSimplifier::simplify(const std::vector<float>& Vertices, const std::size_t Stride,
+                                                   const std::vector<unsigned int>& Indices,
+                                                   const std::size_t TargetIndexCount, const float TargetError,
+                                                   float* ResultError)
+{
+	const std::size_t VertexCount = Vertices.size() / Stride;
+	std::vector<unsigned int> Result = Indices;
+	if (ResultError)
+	{
+		*ResultError = 0.0f;
+	}
+	if (VertexCount == 0 || Indices.size() <= TargetIndexCount)
+	{
+		return Result;
+	}
+
+	// Weld vertices that only differ by attributes, collapses happen between positions
+	glm::dvec3 Min(1.0e30), Max(-1.0e30);
+	std::vector<std::uint32_t> VertexPosition(VertexCount);
+	std::vector<glm::dvec3> Positions;
+	std::vector<std::vector<std::uint32_t>> PositionVertices;
+	{
+		std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> Buckets;
+		for (std::size_t V = 0; V < VertexCount; V++)
+		{
+			const float* P = &Vertices[V * Stride];
+			std::uint32_t Bits[3];
+			std::memcpy(Bits, P, sizeof(Bits));
+			const std::uint64_t Hash = (Bits[0] * 73856093ull) ^ (Bits[1] * 19349663ull) ^ (Bits[2] * 83492791ull);
+
+			std::uint32_t Found = 0xFFFFFFFFu;
+			for (const std::uint32_t Candidate : Buckets[Hash])
+			{
+				const glm::dvec3& Other = Positions[Candidate];
+				if (Other.x == P[0] && Other.y == P[1] && Other.z == P[2])
+				{
+					Found = Candidate;
+					break;
+				}
+			}
+			if (Found == 0xFFFFFFFFu)
+			{
+				Found = static_cast<std::uint32_t>(Positions.size());
+				Positions.emplace_back(P[0], P[1], P[2]);
+				PositionVertices.emplace_back();
+				Buckets[Hash].push_back(Found);
+				Min = glm::min(Min, Positions.back());
+				Max = glm::max(Max, Positions.back());
+			}
+			VertexPosition[V] = Found;
+			PositionVertices[Found].push_back(static_cast<std::uint32_t>(V));
+		}
+	}
+
+	// Work in unit space so quadric errors are relative to the mesh extent
+	const double Extent = std::max({Max.x - Min.x, Max.y - Min.y, Max.z - Min.z, 1.0e-12});
+	for (glm::dvec3& P : Positions)
+	{
+		P = (P - Min) / Extent;
+	}
+
+	// Face quadrics plus constraint planes along open edges so borders don't erode
+	std::vector<Quadric> Quadrics(Positions.size());
+	{
+		std::unordered_map<std::uint64_t, int> EdgeUse;
+		for (std::size_t I = 0; I + 2 < Result.size(); I += 3)
+		{
+			const std::uint32_t P0 = VertexPosition[Result[I]];
+			const std::uint32_t P1 = VertexPosition[Result[I + 1]];
+			const std::uint32_t P2 = VertexPosition[Result[I + 2]];
+			const glm::dvec3 Cross = cross(Positions[P1] - Positions[P0], Positions[P2] - Positions[P0]);
+			const double Area = length(Cross);
+			if (Area <= 0.0)
+			{
+				continue;
+			}
+			const glm::dvec3 Normal = Cross / Area;
+			const Quadric Q = Quadric::fromPlane(Normal, -dot(Normal, Positions[P0]), Area * 0.5);
+			Quadrics[P0].add(Q);
+			Quadrics[P1].add(Q);
+			Quadrics[P2].add(Q);
+			EdgeUse[makeEdgeKey(P0, P1)]++;
+			EdgeUse[makeEdgeKey(P1, P2)]++;
+			EdgeUse[makeEdgeKey(P2, P0)]++;
+		}
+
+		for (std::size_t I = 0; I + 2 < Result.size(); I += 3)
+		{
+			const std::uint32_t Corners[3] = {
+				VertexPosition[Result[I]], VertexPosition[Result[I + 1]], VertexPosition[Result[I + 2]]
+			};
+			const glm::dvec3 FaceNormal = cross(Positions[Corners[1]] - Positions[Corners[0]],
+			                                    Positions[Corners[2]] - Positions[Corners[0]]);
+			for (int Edge = 0; Edge < 3; Edge++)
+			{
+				const std::uint32_t A = Corners[Edge];
+				const std::uint32_t B = Corners[(Edge + 1) % 3];
+				if (EdgeUse[makeEdgeKey(A, B)] != 1)
+				{
+					continue;
+				}
+				const glm::dvec3 EdgeVector = Positions[B] - Positions[A];
+				const glm::dvec3 Cross = cross(EdgeVector, FaceNormal);
+				const double Length = length(Cross);
+				if (Length <= 0.0)
+				{
+					continue;
+				}
+				const glm::dvec3 Normal = Cross / Length;
+				const Quadric Q = Quadric::fromPlane(Normal, -dot(Normal, Positions[A]), dot(EdgeVector, EdgeVector) * 10.0);
+				Quadrics[A].add(Q);
+				Quadrics[B].add(Q);
+			}
+		}
+	}
+
+	const double MaxCost = static_cast<double>(TargetError) * TargetError;
+	double WorstCost = 0.0;
+	std::vector<std::uint32_t> Remap(Positions.size());
+	std::vector<std::uint8_t> Locked(Positions.size());
+	std::vector<std::vector<std::uint32_t>> PositionTriangles(Positions.size());
+	std::vector<Collapse> Collapses;
+
+	while (Result.size() > TargetIndexCount)
+	{
+		const std::size_t TriangleCount = Result.size() / 3;
+
+		for (auto& Triangles : PositionTriangles)
+		{
+			Triangles.clear();
+		}
+		for (std::size_t T = 0; T < TriangleCount; T++)
+		{
+			for (int Corner = 0; Corner < 3; Corner++)
+			{
+				PositionTriangles[VertexPosition[Result[T * 3 + Corner]]].push_back(static_cast<std::uint32_t>(T));
+			}
+		}
+
+		// Cheapest direction for every edge still in the mesh
+		Collapses.clear();
+		std::unordered_map<std::uint64_t, bool> Seen;
+		for (std::size_t T = 0; T < TriangleCount; T++)
+		{
+			for (int Corner = 0; Corner < 3; Corner++)
+			{
+				const std::uint32_t A = VertexPosition[Result[T * 3 + Corner]];
+				const std::uint32_t B = VertexPosition[Result[T * 3 + (Corner + 1) % 3]];
+				if (A == B || !Seen.emplace(makeEdgeKey(A, B), true).second)
+				{
+					continue;
+				}
+				Quadric Combined = Quadrics[A];
+				Combined.add(Quadrics[B]);
+				const double CostToB = Combined.evaluate(Positions[B]);
+				const double CostToA = Combined.evaluate(Positions[A]);
+				Collapses.push_back(CostToB <= CostToA ? Collapse{A, B, CostToB} : Collapse{B, A, CostToA});
+			}
+		}
+		std::sort(Collapses.begin(), Collapses.end(), [](const Collapse& Left, const Collapse& Right)
+		{
+			return Left.Cost < Right.Cost;
+		});
+
+		// Each collapse removes about two triangles, don't overshoot the target in one pass
+		const std::size_t CollapseBudget = std::max<std::size_t>((Result.size() - TargetIndexCount) / 6, 1);
+		std::size_t Performed = 0;
+		for (std::uint32_t P = 0; P < Remap.size(); P++)
+		{
+			Remap[P] = P;
+		}
+		std::fill(Locked.begin(), Locked.end(), 0);
+
+		for (const Collapse& Candidate : Collapses)
+		{
+			if (Candidate.Cost > MaxCost || Performed >= CollapseBudget)
+			{
+				break;
+			}
+			if (Locked[Candidate.From] || Locked[Candidate.To])
+			{
+				continue;
+			}
+
+			// Reject collapses that would flip a surviving triangle around From
+			bool Flips = false;
+			for (const std::uint32_t T : PositionTriangles[Candidate.From])
+			{
+				std::uint32_t Corners[3];
+				bool HasTo = false;
+				for (int Corner = 0; Corner < 3; Corner++)
+				{
+					Corners[Corner] = VertexPosition[Result[T * 3 + Corner]];
+					HasTo |= Corners[Corner] == Candidate.To;
+				}
+				if (HasTo)
+				{
+					continue;
+				}
+				const glm::dvec3 Before = cross(Positions[Corners[1]] - Positions[Corners[0]],
+				                                Positions[Corners[2]] - Positions[Corners[0]]);
+				glm::dvec3 Moved[3];
+				for (int Corner = 0; Corner < 3; Corner++)
+				{
+					Moved[Corner] = Positions[Corners[Corner] == Candidate.From ? Candidate.To : Corners[Corner]];
+				}
+				const glm::dvec3 After = cross(Moved[1] - Moved[0], Moved[2] - Moved[0]);
+				if (dot(Before, After) <= 0.0)
+				{
+					Flips = true;
+					break;
+				}
+			}
+			if (Flips)
+			{
+				continue;
+			}
+
+			// Lock the whole neighbourhood so flip checks in this pass stay valid
+			for (const std::uint32_t T : PositionTriangles[Candidate.From])
+			{
+				for (int Corner = 0; Corner < 3; Corner++)
+				{
+					Locked[VertexPosition[Result[T * 3 + Corner]]] = 1;
+				}
+			}
+			Remap[Candidate.From] = Candidate.To;
+			Quadrics[Candidate.To].add(Quadrics[Candidate.From]);
+			WorstCost = std::max(WorstCost, Candidate.Cost);
+			Performed++;
+		}
+
+		if (Performed == 0)
+		{
+			break;
+		}
+
+		// Move collapsed corners onto the vertex at the target position with the closest attributes
+		std::vector<unsigned int> Next;
+		Next.reserve(Result.size());
+		for (std::size_t T = 0; T < TriangleCount; T++)
+		{
+			unsigned int Corners[3];
+			for (int Corner = 0; Corner < 3; Corner++)
+			{
+				const unsigned int Vertex = Result[T * 3 + Corner];
+				const std::uint32_t Target = Remap[VertexPosition[Vertex]];
+				if (Target == VertexPosition[Vertex])
+				{
+					Corners[Corner] = Vertex;
+					continue;
+				}
+
+				float BestDistance = 1.0e30f;
+				unsigned int Best = PositionVertices[Target].front();
+				for (const std::uint32_t Candidate : PositionVertices[Target])
+				{
+					float Distance = 0.0f;
+					for (std::size_t Attribute = 3; Attribute < Stride; Attribute++)
+					{
+						const float Delta = Vertices[Candidate * Stride + Attribute] - Vertices[Vertex * Stride + Attribute];
+						Distance += Delta * Delta;
+					}
+					if (Distance < BestDistance)
+					{
+						BestDistance = Distance;
+						Best = Candidate;
+					}
+				}
+				Corners[Corner] = Best;
+			}
+
+			// Drop triangles that collapsed to a line
+			const std::uint32_t P0 = VertexPosition[Corners[0]];
+			const std::uint32_t P1 = VertexPosition[Corners[1]];
+			const std::uint32_t P2 = VertexPosition[Corners[2]];
+			if (P0 != P1 && P1 != P2 && P2 != P0)
+			{
+				Next.insert(Next.end(), Corners, Corners + 3);
+			}
+		}
+		Result.swap(Next);
+	}
+
+	if (ResultError)
+	{
+		*ResultError = static_cast<float>(std::sqrt(WorstCost));
+	}
+	return Result;
+}
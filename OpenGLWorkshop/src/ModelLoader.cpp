@@ -16,30 +16,67 @@ Mail : ayoub.ahmad@mds.ac.nz
 #include "ModelLoader.h"
 #include "tiny_obj_loader.h"
 #include "stb_image.h"
+#include "MeshSimplifier.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+// Triangle budget and allowed error for each generated level, relative to the previous level
+constexpr float LodReduction = 0.5f;
+constexpr float LodTargetErrors[ModelLoader::LodCount] = {0.0f, 0.01f, 0.02f, 0.05f};
 
 Model ModelLoader::loadModel(const char* ModelPath, const char* TexturePath) const
 {
+	const ProfileScope Scope("load model", true);
 	Model Model = {};
+
+	DecodedTexture Texture{};
+	JobCounter TextureDecoded;
+	auto Decode = [&] { decodeTexture(TexturePath, Texture); };
+	JobSystem::submit(TextureDecoded, Decode);
+
 	tinyobj::attrib_t Attrib;
 	std::vector<tinyobj::shape_t> Shapes;
 	std::vector<tinyobj::material_t> Materials;
 	std::string Warn, Err;
 
-	bool Ret = LoadObj(&Attrib, &Shapes, &Materials, &Warn, &Err, ModelPath);
+	bool Ret;
+	{
+		const TraceScope Trace(TraceCategory::Asset, "parse model", ModelPath);
+		Ret = LoadObj(&Attrib, &Shapes, &Materials, &Warn, &Err, ModelPath);
+	}
 	if (!Ret)
 	{
 		std::cerr << "Failed to load model: " << Err << std::endl;
+		JobSystem::wait(TextureDecoded);
+		stbi_image_free(Texture.Data);
 		return Model;
 	}
 
 	std::vector<float> Vertices;
 	std::vector<unsigned int> Indices;
+	std::unordered_map<std::uint64_t, unsigned int> UniqueVertices;
 
 	// Structured binding
 	for (const auto& [name, mesh, lines, points] : Shapes)
 	{
 		for (const auto& [vertex_index, normal_index, texcoord_index] : mesh.indices)
 		{
+			// Corners sharing position and texture coordinate become one indexed vertex
+			const std::uint64_t Key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(vertex_index)) << 32) |
+				static_cast<std::uint32_t>(texcoord_index);
+			const auto [Existing, Inserted] = UniqueVertices.try_emplace(
+				Key, static_cast<unsigned int>(Vertices.size() / 5));
+			if (!Inserted)
+			{
+				Indices.push_back(Existing->second);
+				continue;
+			}
+
 			Vertices.push_back(Attrib.vertices[3 * static_cast<size_t>(vertex_index) + 0]);
 			Vertices.push_back(Attrib.vertices[3 * static_cast<size_t>(vertex_index) + 1]);
 			Vertices.push_back(Attrib.vertices[3 * static_cast<size_t>(vertex_index) + 2]);
@@ -53,14 +90,19 @@ Model ModelLoader::loadModel(const char* ModelPath, const char* TexturePath) con
 				Vertices.push_back(0.0f);
 				Vertices.push_back(0.0f);
 			}
-			Indices.push_back(Indices.size());
+			Indices.push_back(Existing->second);
 		}
 	}
 
+	computeBounds(Model, Vertices);
+	generateLods(Model, Vertices, Indices);
+	buildOccluder(Model, Vertices, Indices);
+	buildPickMesh(Model, Vertices, Indices);
 	setupModel(Model, Vertices, Indices);
 
-	// Load the texture
-	Model.Texture = loadTexture(TexturePath);
+	// Usually decoded by now, otherwise this thread helps with whatever is still queued
+	JobSystem::wait(TextureDecoded);
+	Model.Texture = uploadTexture(Texture, TexturePath);
 	// TODO: Load ship and instanced objects with different textures
 
 	return Model;
@@ -68,57 +110,156 @@ Model ModelLoader::loadModel(const char* ModelPath, const char* TexturePath) con
 
 void ModelLoader::setupModel(Model& Model, const std::vector<float>& Vertices, const std::vector<unsigned int>& Indices)
 {
-	glGenVertexArrays(1, &Model.Vao);
-	glGenBuffers(1, &Model.Vbo);
-	glGenBuffers(1, &Model.Ebo);
+	// Created and filled directly, so loading never disturbs what the renderer has bound
+	glCreateVertexArrays(1, &Model.Vao);
+	glCreateBuffers(1, &Model.Vbo);
+	glCreateBuffers(1, &Model.Ebo);
+
+	glNamedBufferData(Model.Vbo, static_cast<GLsizeiptr>(Vertices.size() * sizeof(float)), Vertices.data(),
+	                  GL_STATIC_DRAW);
+	glNamedBufferData(Model.Ebo, static_cast<GLsizeiptr>(Indices.size() * sizeof(unsigned int)), Indices.data(),
+	                  GL_STATIC_DRAW);
+
+	// Position and texture coordinates interleaved in binding 0
+	glVertexArrayVertexBuffer(Model.Vao, 0, Model.Vbo, 0, 5 * sizeof(float));
+	glVertexArrayElementBuffer(Model.Vao, Model.Ebo);
+
+	glEnableVertexArrayAttrib(Model.Vao, 0);
+	glVertexArrayAttribFormat(Model.Vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(Model.Vao, 0, 0);
 
-	glBindVertexArray(Model.Vao);
+	glEnableVertexArrayAttrib(Model.Vao, 1);
+	glVertexArrayAttribFormat(Model.Vao, 1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+	glVertexArrayAttribBinding(Model.Vao, 1, 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, Model.Vbo);
-	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(Vertices.size() * sizeof(float)), Vertices.data(),
-	             GL_STATIC_DRAW);
+	Model.IndexCount = Model.Lods.empty() ? static_cast<int>(Indices.size()) : Model.Lods.front().IndexCount;
+}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Model.Ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(Indices.size() * sizeof(unsigned int)),
-	             Indices.data(), GL_STATIC_DRAW);
+void ModelLoader::generateLods(Model& Model, const std::vector<float>& Vertices, std::vector<unsigned int>& Indices)
+{
+	// Every level is simplified from the one before it and appended to the same index list
+	const std::vector<unsigned int> Base = Indices;
+	Model.Lods.push_back({0, static_cast<int>(Base.size()), 0.0f});
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), static_cast<void*>(nullptr));
+	std::vector<unsigned int> Previous = Base;
+	for (int Level = 1; Level < LodCount; Level++)
+	{
+		const auto Target = static_cast<std::size_t>(static_cast<float>(Previous.size()) * LodReduction) / 3 * 3;
+		float Error = 0.0f;
+		std::vector<unsigned int> Simplified = MeshSimplifier::simplify(Vertices, 5, Previous, Target,
+		                                                                LodTargetErrors[Level], &Error);
+		if (Simplified.empty() || Simplified.size() >= Previous.size())
+		{
+			break; // Nothing left to remove within the error budget
+		}
 
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+		Model.Lods.push_back({static_cast<int>(Indices.size()), static_cast<int>(Simplified.size()), Error});
+		Indices.insert(Indices.end(), Simplified.begin(), Simplified.end());
+		Previous.swap(Simplified);
+	}
+}
 
-	glBindVertexArray(0);
+void ModelLoader::computeBounds(Model& Model, const std::vector<float>& Vertices)
+{
+	glm::vec3 Min(0.0f), Max(0.0f);
+	for (std::size_t I = 0; I + 4 < Vertices.size(); I += 5)
+	{
+		const glm::vec3 Position(Vertices[I], Vertices[I + 1], Vertices[I + 2]);
+		Min = I == 0 ? Position : glm::min(Min, Position);
+		Max = I == 0 ? Position : glm::max(Max, Position);
+	}
 
-	Model.IndexCount = static_cast<int>(Indices.size());
+	Model.BoundsMin = Min;
+	Model.BoundsMax = Max;
+	Model.BoundsCenter = (Min + Max) * 0.5f;
+	Model.BoundsRadius = 0.0f;
+	for (std::size_t I = 0; I + 4 < Vertices.size(); I += 5)
+	{
+		const glm::vec3 Position(Vertices[I], Vertices[I + 1], Vertices[I + 2]);
+		Model.BoundsRadius = std::max(Model.BoundsRadius, glm::length(Position - Model.BoundsCenter));
+	}
 }
 
-GLuint ModelLoader::loadTexture(const char* Path)
+void ModelLoader::buildOccluder(Model& Model, const std::vector<float>& Vertices,
+                                const std::vector<unsigned int>& Indices)
 {
+	// Only the positions the coarsest level references, reindexed densely
+	const ModelLod& Coarsest = Model.Lods.back();
+	std::unordered_map<unsigned int, unsigned int> Remap;
+	Model.OccluderIndices.reserve(Coarsest.IndexCount);
+	for (int I = Coarsest.IndexOffset; I < Coarsest.IndexOffset + Coarsest.IndexCount; I++)
+	{
+		const auto [Entry, Inserted] = Remap.try_emplace(Indices[I], static_cast<unsigned int>(Remap.size()));
+		if (Inserted)
+		{
+			const std::size_t Base = static_cast<std::size_t>(Indices[I]) * 5;
+			Model.OccluderVertices.emplace_back(Vertices[Base], Vertices[Base + 1], Vertices[Base + 2]);
+		}
+		Model.OccluderIndices.push_back(Entry->second);
+	}
+}
+
+void ModelLoader::buildPickMesh(Model& Model, const std::vector<float>& Vertices,
+                                const std::vector<unsigned int>& Indices)
+{
+	// Every position, LOD 0 references nearly all of them
+	Model.PickVertices.reserve(Vertices.size() / 5);
+	for (std::size_t I = 0; I + 4 < Vertices.size(); I += 5)
+	{
+		Model.PickVertices.emplace_back(Vertices[I], Vertices[I + 1], Vertices[I + 2]);
+	}
+	const ModelLod& Finest = Model.Lods.front();
+	Model.PickIndices.assign(Indices.begin() + Finest.IndexOffset,
+	                         Indices.begin() + Finest.IndexOffset + Finest.IndexCount);
+}
+
+void ModelLoader::decodeTexture(const char* Path, DecodedTexture& Texture)
+{
+	const TraceScope Trace(TraceCategory::Asset, "decode texture", Path);
+	Texture.Data = stbi_load(Path, &Texture.Width, &Texture.Height, &Texture.Components, 0);
+}
+
+GLuint ModelLoader::uploadTexture(const DecodedTexture& Texture, const char* Path)
+{
+	const TraceScope Trace(TraceCategory::Asset, "upload texture", Path);
 	GLuint TextureId;
-	glGenTextures(1, &TextureId);
+	glCreateTextures(GL_TEXTURE_2D, 1, &TextureId);
 
-	int Width, Height, NrComponents;
-	unsigned char* Data = stbi_load(Path, &Width, &Height, &NrComponents, 0);
+	unsigned char* Data = Texture.Data;
 	if (Data)
 	{
 		GLenum Format = 0;
-		if (NrComponents == 1)
+		GLenum InternalFormat = 0;
+		if (Texture.Components == 1)
+		{
 			Format = GL_RED;
-		else if (NrComponents == 3)
+			InternalFormat = GL_R8;
+		}
+		else if (Texture.Components == 3)
+		{
 			Format = GL_RGB;
-		else if (NrComponents == 4)
+			InternalFormat = GL_RGB8;
+		}
+		else if (Texture.Components == 4)
+		{
 			Format = GL_RGBA;
+			InternalFormat = GL_RGBA8;
+		}
 
-		glBindTexture(GL_TEXTURE_2D, TextureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(Format), Width, Height, 0, static_cast<GLint>(Format),
-		             GL_UNSIGNED_BYTE, Data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// Immutable storage with the full mip chain, filled without binding the texture
+		GLsizei Levels = 1;
+		for (int Size = std::max(Texture.Width, Texture.Height); Size > 1; Size /= 2)
+		{
+			Levels++;
+		}
+		glTextureStorage2D(TextureId, Levels, InternalFormat, Texture.Width, Texture.Height);
+		glTextureSubImage2D(TextureId, 0, 0, 0, Texture.Width, Texture.Height, Format, GL_UNSIGNED_BYTE, Data);
+		glGenerateTextureMipmap(TextureId);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(TextureId, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(TextureId, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTextureParameteri(TextureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTextureParameteri(TextureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 		stbi_image_free(Data);
 	}
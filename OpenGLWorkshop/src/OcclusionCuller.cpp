@@ -0,0 +1,463 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : OcclusionCuller.cpp
+Description : Implementations for CPU occlusion culling with a SIMD
+			  tile rasteriser
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "OcclusionCuller.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+constexpr float NearW = 1.0e-4f; // Clip space w below which a point is treated as behind the camera
+constexpr std::size_t TestGrain = 1024;
+
+OcclusionCuller::OcclusionCuller()
+	: MWidth(0), MHeight(0), MTilesX(0), MTilesY(0)
+{
+	setViewport(4, 3);
+}
+
+void OcclusionCuller::setViewport(const unsigned int Width, const unsigned int Height)
+{
+	// Height rounded up to whole tiles, the width is already a multiple of the SIMD and tile widths
+	const float Aspect = static_cast<float>(std::max(Height, 1u)) / static_cast<float>(std::max(Width, 1u));
+	const int Rows = static_cast<int>(std::ceil(BufferWidth * Aspect));
+	MWidth = BufferWidth;
+	MHeight = std::max(TileSize, (Rows + TileSize - 1) / TileSize * TileSize);
+	MTilesX = MWidth / TileSize;
+	MTilesY = MHeight / TileSize;
+	MDepth.assign(static_cast<std::size_t>(MWidth) * MHeight, 1.0f);
+	MTileMaxDepth.assign(static_cast<std::size_t>(MTilesX) * MTilesY, 1.0f);
+}
+
+void OcclusionCuller::addOccluder(const Model& Model, const glm::mat4& Transform)
+{
+	MQueuedOccluders.emplace_back(&Model, Transform);
+}
+
+void OcclusionCuller::cull(const InstancePool& Instances, const Model& Model, const std::vector<std::uint32_t>& Visible,
+                           const std::vector<float>& PixelDiameters, const glm::mat4& ViewProjection,
+                           const OcclusionSettings& Settings, const float Time)
+{
+	const auto RasterStart = std::chrono::steady_clock::now();
+	MStats = {};
+	MTriangles.clear();
+	const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+	const bool Animated = Instances.hasAnimations();
+	auto transformOf = [&](const std::uint32_t Index)
+	{
+		return Animated ? Instances.getAnimatedTransform(Index, Time) : Transforms[Index];
+	};
+
+	// The biggest instances on screen hide the most, they are also never tested against themselves
+	MCandidates.clear();
+	for (std::size_t I = 0; I < Visible.size(); I++)
+	{
+		if (PixelDiameters[I] >= Settings.MinOccluderPixels)
+		{
+			MCandidates.emplace_back(PixelDiameters[I], static_cast<std::uint32_t>(I));
+		}
+	}
+	const std::size_t OccluderCount = std::min(MCandidates.size(), static_cast<std::size_t>(
+		                                           std::max(Settings.MaxOccluders, 0)));
+	std::partial_sort(MCandidates.begin(), MCandidates.begin() + static_cast<std::ptrdiff_t>(OccluderCount),
+	                  MCandidates.end(), [](const auto& Left, const auto& Right) { return Left.first > Right.first; });
+	MCandidates.resize(OccluderCount);
+
+	for (const auto& [Diameter, Position] : MCandidates)
+	{
+		setupTriangles(Model, ViewProjection * transformOf(Visible[Position]));
+	}
+	for (const auto& [QueuedModel, Transform] : MQueuedOccluders)
+	{
+		setupTriangles(*QueuedModel, ViewProjection * Transform);
+	}
+	MStats.Occluders = static_cast<unsigned int>(OccluderCount + MQueuedOccluders.size());
+	MStats.OccluderTriangles = static_cast<unsigned int>(MTriangles.size());
+	MQueuedOccluders.clear();
+
+	// Each worker owns whole rows of tiles, so no two threads write the same pixel
+	std::fill(MDepth.begin(), MDepth.end(), 1.0f);
+	Parallel::forRange(MTilesY, 2, [this](const std::size_t Begin, const std::size_t End)
+	{
+		rasteriseTiles(static_cast<int>(Begin), static_cast<int>(End));
+	});
+
+	const auto TestStart = std::chrono::steady_clock::now();
+	const std::chrono::duration<double, std::milli> RasterElapsed = TestStart - RasterStart;
+	MStats.RasterMilliseconds = RasterElapsed.count();
+
+	MResults.assign(Visible.size(), 1);
+	if (!MTriangles.empty())
+	{
+		Parallel::forRange(Visible.size(), TestGrain, [&](const std::size_t Begin, const std::size_t End)
+		{
+			for (std::size_t I = Begin; I < End; I++)
+			{
+				MResults[I] = isOccluded(Model, ViewProjection * transformOf(Visible[I])) ? 0 : 1;
+			}
+		});
+		for (const auto& [Diameter, Position] : MCandidates)
+		{
+			MResults[Position] = 1;
+		}
+	}
+
+	MVisible.clear();
+	MPixelDiameters.clear();
+	for (std::size_t I = 0; I < Visible.size(); I++)
+	{
+		if (MResults[I])
+		{
+			MVisible.push_back(Visible[I]);
+			MPixelDiameters.push_back(PixelDiameters[I]);
+		}
+	}
+	MStats.Tested = static_cast<unsigned int>(Visible.size());
+	MStats.Occluded = static_cast<unsigned int>(Visible.size() - MVisible.size());
+
+	const std::chrono::duration<double, std::milli> TestElapsed = std::chrono::steady_clock::now() - TestStart;
+	MStats.TestMilliseconds = TestElapsed.count();
+}
+
+const std::vector<std::uint32_t>& OcclusionCuller::getVisible() const
+{
+	return MVisible;
+}
+
+const std::vector<float>& OcclusionCuller::getPixelDiameters() const
+{
+	return MPixelDiameters;
+}
+
+const OcclusionStats& OcclusionCuller::getStats() const
+{
+	return MStats;
+}
+
+const std::vector<float>& OcclusionCuller::getDepth() const
+{
+	return MDepth;
+}
+
+int OcclusionCuller::getWidth() const
+{
+	return MWidth;
+}
+
+int OcclusionCuller::getHeight() const
+{
+	return MHeight;
+}
+
+void OcclusionCuller::setupTriangles(const Model& Model, const glm::mat4& Mvp)
+{
+	const glm::vec2 Viewport(static_cast<float>(MWidth), static_cast<float>(MHeight));
+	for (std::size_t I = 0; I + 2 < Model.OccluderIndices.size(); I += 3)
+	{
+		glm::vec3 Screen[3];
+		bool BehindCamera = false;
+		for (int Corner = 0; Corner < 3; Corner++)
+		{
+			const glm::vec4 Clip = Mvp * glm::vec4(Model.OccluderVertices[Model.OccluderIndices[I + Corner]], 1.0f);
+			BehindCamera |= Clip.w < NearW;
+			const glm::vec3 Ndc = glm::vec3(Clip) / Clip.w;
+			Screen[Corner] = glm::vec3((glm::vec2(Ndc) * 0.5f + 0.5f) * Viewport, Ndc.z * 0.5f + 0.5f);
+		}
+
+		// Dropping a triangle only lets more through, so anything awkward is skipped rather than clipped
+		const float Area = (Screen[1].x - Screen[0].x) * (Screen[2].y - Screen[0].y) -
+			(Screen[2].x - Screen[0].x) * (Screen[1].y - Screen[0].y);
+		if (BehindCamera || Area <= 0.0f)
+		{
+			continue;
+		}
+
+		OccluderTriangle Triangle;
+		Triangle.MinX = std::max(0, static_cast<int>(std::floor(std::min({Screen[0].x, Screen[1].x, Screen[2].x}))));
+		Triangle.MinY = std::max(0, static_cast<int>(std::floor(std::min({Screen[0].y, Screen[1].y, Screen[2].y}))));
+		Triangle.MaxX = std::min(MWidth - 1,
+		                         static_cast<int>(std::floor(std::max({Screen[0].x, Screen[1].x, Screen[2].x}))));
+		Triangle.MaxY = std::min(MHeight - 1,
+		                         static_cast<int>(std::floor(std::max({Screen[0].y, Screen[1].y, Screen[2].y}))));
+		if (Triangle.MinX > Triangle.MaxX || Triangle.MinY > Triangle.MaxY)
+		{
+			continue;
+		}
+
+		// Edge functions are positive inside a counter clockwise triangle
+		for (int Edge = 0; Edge < 3; Edge++)
+		{
+			const glm::vec3& From = Screen[Edge];
+			const glm::vec3& To = Screen[(Edge + 1) % 3];
+			Triangle.EdgeA[Edge] = From.y - To.y;
+			Triangle.EdgeB[Edge] = To.x - From.x;
+			Triangle.EdgeC[Edge] = -Triangle.EdgeA[Edge] * From.x - Triangle.EdgeB[Edge] * From.y;
+		}
+
+		// Screen space depth is linear after the perspective divide
+		const float DepthX = ((Screen[1].z - Screen[0].z) * (Screen[2].y - Screen[0].y) -
+			(Screen[2].z - Screen[0].z) * (Screen[1].y - Screen[0].y)) / Area;
+		const float DepthY = ((Screen[2].z - Screen[0].z) * (Screen[1].x - Screen[0].x) -
+			(Screen[1].z - Screen[0].z) * (Screen[2].x - Screen[0].x)) / Area;
+		Triangle.DepthA = DepthX;
+		Triangle.DepthB = DepthY;
+		Triangle.DepthC = Screen[0].z - DepthX * Screen[0].x - DepthY * Screen[0].y;
+		MTriangles.push_back(Triangle);
+	}
+}
+
+// Scalar rows of one triangle, clipped to [RowBegin, RowEnd). Pixel centres are at half coordinates
+[[maybe_unused]] static void rasteriseScalar(const OccluderTriangle& Triangle, float* Depth, const int Width,
+                                            const int RowBegin, const int RowEnd)
+{
+	for (int Y = RowBegin; Y < RowEnd; Y++)
+	{
+		const float CentreY = static_cast<float>(Y) + 0.5f;
+		float* Row = Depth + static_cast<std::size_t>(Y) * Width;
+		for (int X = Triangle.MinX; X <= Triangle.MaxX; X++)
+		{
+			const float CentreX = static_cast<float>(X) + 0.5f;
+			bool Inside = true;
+			for (int Edge = 0; Edge < 3; Edge++)
+			{
+				Inside &= Triangle.EdgeA[Edge] * CentreX + Triangle.EdgeB[Edge] * CentreY + Triangle.EdgeC[Edge] >= 0.0f;
+			}
+			if (Inside)
+			{
+				const float Z = Triangle.DepthA * CentreX + Triangle.DepthB * CentreY + Triangle.DepthC;
+				Row[X] = std::min(Row[X], std::max(Z, 0.0f));
+			}
+		}
+	}
+}
+
+#if SIMD_X86
+// Four pixels per step. BufferWidth is a multiple of 8 so a step never runs off the end of a row
+static void rasteriseSse(const OccluderTriangle& Triangle, float* Depth, const int Width, const int RowBegin,
+                         const int RowEnd)
+{
+	const int FirstX = Triangle.MinX & ~3;
+	const __m128 LaneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 Zero = _mm_setzero_ps();
+	__m128 StepA[3];
+	for (int Edge = 0; Edge < 3; Edge++)
+	{
+		StepA[Edge] = _mm_set1_ps(Triangle.EdgeA[Edge] * 4.0f);
+	}
+	const __m128 DepthStep = _mm_set1_ps(Triangle.DepthA * 4.0f);
+
+	for (int Y = RowBegin; Y < RowEnd; Y++)
+	{
+		const float CentreY = static_cast<float>(Y) + 0.5f;
+		const __m128 X = _mm_add_ps(_mm_set1_ps(static_cast<float>(FirstX)), LaneOffsets);
+		__m128 EdgeValue[3];
+		for (int Edge = 0; Edge < 3; Edge++)
+		{
+			EdgeValue[Edge] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Triangle.EdgeA[Edge]), X),
+			                             _mm_set1_ps(Triangle.EdgeB[Edge] * CentreY + Triangle.EdgeC[Edge]));
+		}
+		__m128 Z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Triangle.DepthA), X),
+		                      _mm_set1_ps(Triangle.DepthB * CentreY + Triangle.DepthC));
+
+		float* Row = Depth + static_cast<std::size_t>(Y) * Width;
+		for (int Column = FirstX; Column <= Triangle.MaxX; Column += 4)
+		{
+			const __m128 Inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(EdgeValue[0], Zero), _mm_cmpge_ps(EdgeValue[1], Zero)),
+			                                 _mm_cmpge_ps(EdgeValue[2], Zero));
+			if (_mm_movemask_ps(Inside) != 0)
+			{
+				const __m128 Old = _mm_loadu_ps(Row + Column);
+				const __m128 Nearer = _mm_min_ps(Old, _mm_max_ps(Z, Zero));
+				_mm_storeu_ps(Row + Column, _mm_or_ps(_mm_and_ps(Inside, Nearer), _mm_andnot_ps(Inside, Old)));
+			}
+			for (int Edge = 0; Edge < 3; Edge++)
+			{
+				EdgeValue[Edge] = _mm_add_ps(EdgeValue[Edge], StepA[Edge]);
+			}
+			Z = _mm_add_ps(Z, DepthStep);
+		}
+	}
+}
+
+// Eight pixels per step, a whole tile row at a time
+SIMD_TARGET_AVX2 static void rasteriseAvx2(const OccluderTriangle& Triangle, float* Depth, const int Width,
+                                           const int RowBegin, const int RowEnd)
+{
+	const int FirstX = Triangle.MinX & ~7;
+	const __m256 LaneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 Zero = _mm256_setzero_ps();
+	__m256 StepA[3];
+	for (int Edge = 0; Edge < 3; Edge++)
+	{
+		StepA[Edge] = _mm256_set1_ps(Triangle.EdgeA[Edge] * 8.0f);
+	}
+	const __m256 DepthStep = _mm256_set1_ps(Triangle.DepthA * 8.0f);
+
+	for (int Y = RowBegin; Y < RowEnd; Y++)
+	{
+		const float CentreY = static_cast<float>(Y) + 0.5f;
+		const __m256 X = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(FirstX)), LaneOffsets);
+		__m256 EdgeValue[3];
+		for (int Edge = 0; Edge < 3; Edge++)
+		{
+			EdgeValue[Edge] = _mm256_fmadd_ps(_mm256_set1_ps(Triangle.EdgeA[Edge]), X,
+			                                  _mm256_set1_ps(Triangle.EdgeB[Edge] * CentreY + Triangle.EdgeC[Edge]));
+		}
+		__m256 Z = _mm256_fmadd_ps(_mm256_set1_ps(Triangle.DepthA), X,
+		                           _mm256_set1_ps(Triangle.DepthB * CentreY + Triangle.DepthC));
+
+		float* Row = Depth + static_cast<std::size_t>(Y) * Width;
+		for (int Column = FirstX; Column <= Triangle.MaxX; Column += 8)
+		{
+			const __m256 Inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(EdgeValue[0], Zero, _CMP_GE_OQ),
+			                                                  _mm256_cmp_ps(EdgeValue[1], Zero, _CMP_GE_OQ)),
+			                                    _mm256_cmp_ps(EdgeValue[2], Zero, _CMP_GE_OQ));
+			if (_mm256_movemask_ps(Inside) != 0)
+			{
+				const __m256 Old = _mm256_loadu_ps(Row + Column);
+				const __m256 Nearer = _mm256_min_ps(Old, _mm256_max_ps(Z, Zero));
+				_mm256_storeu_ps(Row + Column, _mm256_blendv_ps(Old, Nearer, Inside));
+			}
+			for (int Edge = 0; Edge < 3; Edge++)
+			{
+				EdgeValue[Edge] = _mm256_add_ps(EdgeValue[Edge], StepA[Edge]);
+			}
+			Z = _mm256_add_ps(Z, DepthStep);
+		}
+	}
+}
+#endif
+
+void OcclusionCuller::rasteriseTiles(const int TileRowBegin, const int TileRowEnd)
+{
+	const int BandBegin = TileRowBegin * TileSize;
+	const int BandEnd = TileRowEnd * TileSize;
+#if SIMD_X86
+	const bool UseAvx2 = Simd::hasAvx2();
+#endif
+
+	for (const OccluderTriangle& Triangle : MTriangles)
+	{
+		const int RowBegin = std::max(Triangle.MinY, BandBegin);
+		const int RowEnd = std::min(Triangle.MaxY + 1, BandEnd);
+		if (RowBegin >= RowEnd)
+		{
+			continue;
+		}
+#if SIMD_X86
+		if (UseAvx2)
+		{
+			rasteriseAvx2(Triangle, MDepth.data(), MWidth, RowBegin, RowEnd);
+		}
+		else
+		{
+			rasteriseSse(Triangle, MDepth.data(), MWidth, RowBegin, RowEnd);
+		}
+#else
+		rasteriseScalar(Triangle, MDepth.data(), MWidth, RowBegin, RowEnd);
+#endif
+	}
+
+	// Farthest depth per tile, the coarse level of the hierarchy
+	for (int TileY = TileRowBegin; TileY < TileRowEnd; TileY++)
+	{
+		for (int TileX = 0; TileX < MTilesX; TileX++)
+		{
+			float Farthest = 0.0f;
+			for (int Y = TileY * TileSize; Y < (TileY + 1) * TileSize; Y++)
+			{
+				const float* Row = &MDepth[static_cast<std::size_t>(Y) * MWidth + TileX * TileSize];
+				for (int X = 0; X < TileSize; X++)
+				{
+					Farthest = std::max(Farthest, Row[X]);
+				}
+			}
+			MTileMaxDepth[static_cast<std::size_t>(TileY) * MTilesX + TileX] = Farthest;
+		}
+	}
+}
+
+bool OcclusionCuller::isOccluded(const Model& Model, const glm::mat4& Mvp) const
+{
+	// Corners of the model space box in clip space, built from one corner and the three edge vectors
+	const glm::vec3 Extent = Model.BoundsMax - Model.BoundsMin;
+	const glm::vec4 Origin = Mvp * glm::vec4(Model.BoundsMin, 1.0f);
+	const glm::vec4 AxisX = Mvp[0] * Extent.x;
+	const glm::vec4 AxisY = Mvp[1] * Extent.y;
+	const glm::vec4 AxisZ = Mvp[2] * Extent.z;
+
+	glm::vec2 ScreenMin(1.0e30f), ScreenMax(-1.0e30f);
+	float NearestDepth = 1.0f;
+	for (int Corner = 0; Corner < 8; Corner++)
+	{
+		const glm::vec4 Clip = Origin + ((Corner & 1) ? AxisX : glm::vec4(0.0f)) +
+			((Corner & 2) ? AxisY : glm::vec4(0.0f)) + ((Corner & 4) ? AxisZ : glm::vec4(0.0f));
+		if (Clip.w < NearW)
+		{
+			return false; // Straddles the camera
+		}
+		const glm::vec3 Ndc = glm::vec3(Clip) / Clip.w;
+		ScreenMin = glm::min(ScreenMin, glm::vec2(Ndc));
+		ScreenMax = glm::max(ScreenMax, glm::vec2(Ndc));
+		NearestDepth = std::min(NearestDepth, Ndc.z * 0.5f + 0.5f);
+	}
+
+	const int MinX = std::max(0, static_cast<int>(std::floor((ScreenMin.x * 0.5f + 0.5f) * MWidth)));
+	const int MinY = std::max(0, static_cast<int>(std::floor((ScreenMin.y * 0.5f + 0.5f) * MHeight)));
+	const int MaxX = std::min(MWidth - 1, static_cast<int>(std::floor((ScreenMax.x * 0.5f + 0.5f) * MWidth)));
+	const int MaxY = std::min(MHeight - 1, static_cast<int>(std::floor((ScreenMax.y * 0.5f + 0.5f) * MHeight)));
+	if (MinX > MaxX || MinY > MaxY)
+	{
+		return false; // Off screen, frustum culling decides those
+	}
+
+	// Whole tiles compare against their maximum, partly covered tiles fall back to the pixels inside the box
+	for (int TileY = MinY / TileSize; TileY <= MaxY / TileSize; TileY++)
+	{
+		const int TileMinY = TileY * TileSize;
+		const int RowBegin = std::max(MinY, TileMinY);
+		const int RowEnd = std::min(MaxY, TileMinY + TileSize - 1);
+		for (int TileX = MinX / TileSize; TileX <= MaxX / TileSize; TileX++)
+		{
+			if (MTileMaxDepth[static_cast<std::size_t>(TileY) * MTilesX + TileX] < NearestDepth)
+			{
+				continue;
+			}
+
+			const int TileMinX = TileX * TileSize;
+			const int ColumnBegin = std::max(MinX, TileMinX);
+			const int ColumnEnd = std::min(MaxX, TileMinX + TileSize - 1);
+			if (ColumnBegin == TileMinX && ColumnEnd == TileMinX + TileSize - 1 && RowBegin == TileMinY &&
+				RowEnd == TileMinY + TileSize - 1)
+			{
+				return false;
+			}
+			for (int Y = RowBegin; Y <= RowEnd; Y++)
+			{
+				const float* Row = &MDepth[static_cast<std::size_t>(Y) * MWidth];
+				for (int X = ColumnBegin; X <= ColumnEnd; X++)
+				{
+					if (Row[X] >= NearestDepth)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
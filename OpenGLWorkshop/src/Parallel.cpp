@@ -0,0 +1,31 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Parallel.cpp
+Description : Implementations for splitting index ranges across the job
+			  system's threads
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "Parallel.h"
+
+void Parallel::forRange(const std::size_t Count, const std::size_t MinGrain, const RangeFunction& Body)
+{
+	JobSystem::parallelFor(Count, MinGrain, Body);
+}
+
+unsigned int Parallel::getThreadCount()
+{
+	return JobSystem::getThreadCount();
+}
+
+void Parallel::setThreadCount(const unsigned int Count)
+{
+	JobSystem::start(Count);
+}
@@ -0,0 +1,426 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Profiler.cpp
+Description : Implementations for a frame profiler of nested CPU scopes with
+			  matching GPU timer queries read back frames later
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "TraceRecorder.h"
+
+namespace
+{
+	// The latest HistoryLength frames' times of one scope
+	struct SampleRing
+	{
+		double Values[Profiler::HistoryLength];
+		std::size_t Count;
+		std::size_t Next;
+
+		void add(const double Value)
+		{
+			Values[Next] = Value;
+			Next = (Next + 1) % Profiler::HistoryLength;
+			Count = std::min(Count + 1, Profiler::HistoryLength);
+		}
+
+		[[nodiscard]] ProfileSummary summarise() const
+		{
+			ProfileSummary Summary{0.0, 0.0, 0.0, Count};
+			if (Count == 0)
+			{
+				return Summary;
+			}
+			std::vector<double> Sorted(Values, Values + Count);
+			std::sort(Sorted.begin(), Sorted.end());
+			double Sum = 0.0;
+			for (const double Value : Sorted)
+			{
+				Sum += Value;
+			}
+			const auto P99Index = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(Count))) - 1;
+			Summary.Min = Sorted.front();
+			Summary.Average = Sum / static_cast<double>(Count);
+			Summary.P99 = Sorted[P99Index];
+			return Summary;
+		}
+	};
+
+	struct ProfileNode
+	{
+		const char* Name;
+		int Parent; // -1 at the top of a thread
+		int Depth;
+		std::vector<int> Children;
+		double FrameMilliseconds; // Summed over the calls of the frame so far
+		unsigned int FrameCalls;
+		unsigned int LastCalls;
+		SampleRing Cpu;
+		SampleRing Gpu;
+	};
+
+	constexpr std::size_t Unstamped = ~std::size_t{0}; // The end of a timing whose scope outlived its frame
+
+	// A GPU scope as issued, its queries indexing the slot's pool
+	struct GpuTiming
+	{
+		int Node;
+		std::size_t Begin;
+		std::size_t End;
+	};
+
+	// The queries of one frame in flight, reused once its results are read or dropped
+	struct QuerySlot
+	{
+		std::vector<GLuint> Queries;
+		std::size_t Used;
+		std::vector<GpuTiming> Timings;
+		bool Traced; // Issued while a trace was recording, with the GPU clock's offset from the CPU's then
+		std::int64_t TraceOffset;
+	};
+
+	std::mutex GMutex; // Guards everything below but the thread locals
+	std::vector<ProfileNode> GNodes;
+	std::vector<int> GRoots;
+	QuerySlot GSlots[Profiler::FrameLatency];
+	std::size_t GFrameIndex = 0;
+	bool GInFrame = false;
+	int GFrameNode = -1;
+	std::size_t GFrameTiming = 0;
+	std::chrono::steady_clock::time_point GFrameStart;
+	std::thread::id GGlThread;
+	ProfilerStats GStats{};
+	std::atomic<bool> GEnabled{true};
+
+	// A GPU timing left open by a scope, only closed by it within the same frame
+	struct OpenTiming
+	{
+		std::size_t Frame;
+		std::ptrdiff_t Index; // Into the frame's slot, -1 for scopes without GPU timing
+	};
+
+	thread_local std::vector<int> TScopes; // Open on this thread, innermost last
+	thread_local std::vector<OpenTiming> TTimings; // Matching TScopes
+
+	// Compared by text, as the same literal may have a different address in another translation unit
+	int findNode(const int Parent, const char* Name)
+	{
+		const std::vector<int>& Siblings = Parent < 0 ? GRoots : GNodes[Parent].Children;
+		for (const int Node : Siblings)
+		{
+			if (std::strcmp(GNodes[Node].Name, Name) == 0)
+			{
+				return Node;
+			}
+		}
+
+		ProfileNode Created{};
+		Created.Name = Name;
+		Created.Parent = Parent;
+		Created.Depth = Parent < 0 ? 0 : GNodes[Parent].Depth + 1;
+		GNodes.push_back(Created);
+		const auto Node = static_cast<int>(GNodes.size() - 1);
+		(Parent < 0 ? GRoots : GNodes[Parent].Children).push_back(Node);
+		return Node;
+	}
+
+	// Writes a timestamp into the next free query of the current frame's slot
+	std::size_t stampQuery()
+	{
+		QuerySlot& Slot = GSlots[GFrameIndex % Profiler::FrameLatency];
+		if (Slot.Used == Slot.Queries.size())
+		{
+			GLuint Query = 0;
+			glCreateQueries(GL_TIMESTAMP, 1, &Query);
+			Slot.Queries.push_back(Query);
+			GStats.Queries++;
+		}
+		glQueryCounter(Slot.Queries[Slot.Used], GL_TIMESTAMP);
+		return Slot.Used++;
+	}
+
+	bool canTimeGpu()
+	{
+		return GInFrame && std::this_thread::get_id() == GGlThread;
+	}
+
+	// Reads a slot's timings if every one has arrived, summed per scope, and frees the slot either way
+	void readSlot(QuerySlot& Slot)
+	{
+		if (Slot.Timings.empty())
+		{
+			Slot.Used = 0;
+			return;
+		}
+
+		bool Available = true;
+		for (std::size_t Query = 0; Available && Query < Slot.Used; Query++)
+		{
+			GLint Result = GL_FALSE;
+			glGetQueryObjectiv(Slot.Queries[Query], GL_QUERY_RESULT_AVAILABLE, &Result);
+			Available = Result == GL_TRUE;
+		}
+
+		if (Available)
+		{
+			std::vector<double> Milliseconds(GNodes.size(), -1.0);
+			for (const GpuTiming& Timing : Slot.Timings)
+			{
+				if (Timing.End == Unstamped)
+				{
+					continue;
+				}
+				GLuint64 Begin = 0;
+				GLuint64 End = 0;
+				glGetQueryObjectui64v(Slot.Queries[Timing.Begin], GL_QUERY_RESULT, &Begin);
+				glGetQueryObjectui64v(Slot.Queries[Timing.End], GL_QUERY_RESULT, &End);
+				if (Slot.Traced)
+				{
+					TraceRecorder::record(TraceCategory::Gpu, GNodes[Timing.Node].Name,
+					                      static_cast<std::uint64_t>(static_cast<std::int64_t>(Begin) + Slot.TraceOffset),
+					                      static_cast<std::uint64_t>(static_cast<std::int64_t>(End) + Slot.TraceOffset));
+				}
+				const double Elapsed = End > Begin ? static_cast<double>(End - Begin) / 1000000.0 : 0.0;
+				Milliseconds[Timing.Node] = std::max(Milliseconds[Timing.Node], 0.0) + Elapsed;
+			}
+			for (std::size_t Node = 0; Node < Milliseconds.size(); Node++)
+			{
+				if (Milliseconds[Node] >= 0.0)
+				{
+					GNodes[Node].Gpu.add(Milliseconds[Node]);
+				}
+			}
+			GStats.GpuFramesRead++;
+		}
+		else
+		{
+			GStats.GpuFramesDropped++;
+		}
+		Slot.Used = 0;
+		Slot.Timings.clear();
+	}
+
+	void appendEntries(const int Node, std::vector<ProfileEntry>& Entries)
+	{
+		const ProfileNode& Scope = GNodes[Node];
+		Entries.push_back({Scope.Name, Scope.Depth, Scope.LastCalls, Scope.Cpu.summarise(), Scope.Gpu.summarise()});
+		for (const int Child : Scope.Children)
+		{
+			appendEntries(Child, Entries);
+		}
+	}
+}
+
+void Profiler::beginFrame(const char* Name)
+{
+	if (!GEnabled)
+	{
+		return;
+	}
+
+	std::lock_guard Lock(GMutex);
+	GGlThread = std::this_thread::get_id();
+	readSlot(GSlots[GFrameIndex % FrameLatency]);
+
+	GInFrame = true;
+	GFrameNode = findNode(-1, Name);
+	GFrameStart = std::chrono::steady_clock::now();
+	QuerySlot& Slot = GSlots[GFrameIndex % FrameLatency];
+
+	// The GL clock only lines up with the CPU's in a trace through an offset taken once a frame
+	Slot.Traced = TraceRecorder::isRecording();
+	if (Slot.Traced)
+	{
+		GLint64 GpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &GpuNow);
+		Slot.TraceOffset = static_cast<std::int64_t>(TraceRecorder::now()) - GpuNow;
+	}
+	Slot.Timings.push_back({GFrameNode, stampQuery(), Unstamped});
+	GFrameTiming = Slot.Timings.size() - 1;
+}
+
+void Profiler::endFrame()
+{
+	std::lock_guard Lock(GMutex);
+	if (!GInFrame)
+	{
+		return;
+	}
+
+	QuerySlot& Slot = GSlots[GFrameIndex % FrameLatency];
+	Slot.Timings[GFrameTiming].End = stampQuery();
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - GFrameStart;
+	GNodes[GFrameNode].FrameMilliseconds += Elapsed.count();
+	GNodes[GFrameNode].FrameCalls++;
+
+	// Scopes that didn't run this frame add no sample, so their history covers the frames they did
+	for (ProfileNode& Node : GNodes)
+	{
+		if (Node.FrameCalls > 0)
+		{
+			Node.Cpu.add(Node.FrameMilliseconds);
+			Node.LastCalls = Node.FrameCalls;
+			Node.FrameMilliseconds = 0.0;
+			Node.FrameCalls = 0;
+		}
+	}
+	GInFrame = false;
+	GFrameIndex++;
+	GStats.Frames++;
+}
+
+void Profiler::setEnabled(const bool Enabled)
+{
+	GEnabled = Enabled;
+}
+
+bool Profiler::isEnabled()
+{
+	return GEnabled;
+}
+
+void Profiler::reset()
+{
+	std::lock_guard Lock(GMutex);
+	for (QuerySlot& Slot : GSlots)
+	{
+		if (!Slot.Queries.empty())
+		{
+			glDeleteQueries(static_cast<GLsizei>(Slot.Queries.size()), Slot.Queries.data());
+		}
+		Slot = {};
+	}
+	GNodes.clear();
+	GRoots.clear();
+	GFrameIndex = 0;
+	GInFrame = false;
+	GFrameNode = -1;
+	GStats = {};
+}
+
+std::vector<ProfileEntry> Profiler::getReport()
+{
+	std::lock_guard Lock(GMutex);
+	std::vector<ProfileEntry> Entries;
+	for (const int Root : GRoots)
+	{
+		appendEntries(Root, Entries);
+	}
+	return Entries;
+}
+
+void Profiler::printReport(std::ostream& Out)
+{
+	const std::vector<ProfileEntry> Entries = getReport();
+	const ProfilerStats Stats = getStats();
+	Out << "Profile (min/avg/p99 ms over up to " << HistoryLength << " frames, GPU read " << FrameLatency
+		<< " frames late, " << Stats.GpuFramesDropped << " GPU frames dropped as not yet available)\n";
+	for (const ProfileEntry& Entry : Entries)
+	{
+		const std::string Name = std::string(static_cast<std::size_t>(Entry.Depth) * 2, ' ') + Entry.Name;
+		Out << "  " << std::left << std::setw(24) << Name << std::right << " cpu " << Entry.Cpu.Min << " / "
+			<< Entry.Cpu.Average << " / " << Entry.Cpu.P99;
+		if (Entry.Gpu.Samples > 0)
+		{
+			Out << ", gpu " << Entry.Gpu.Min << " / " << Entry.Gpu.Average << " / " << Entry.Gpu.P99;
+		}
+		if (Entry.Calls > 1)
+		{
+			Out << " (" << Entry.Calls << " calls)";
+		}
+		Out << "\n";
+	}
+}
+
+ProfilerStats Profiler::getStats()
+{
+	std::lock_guard Lock(GMutex);
+	return GStats;
+}
+
+int Profiler::pushScope(const char* Name, const bool Gpu)
+{
+	if (!GEnabled)
+	{
+		return -1;
+	}
+
+	std::lock_guard Lock(GMutex);
+	const int Node = findNode(TScopes.empty() ? -1 : TScopes.back(), Name);
+	TScopes.push_back(Node);
+	OpenTiming Timing{GFrameIndex, -1};
+	if (Gpu && canTimeGpu())
+	{
+		QuerySlot& Slot = GSlots[GFrameIndex % FrameLatency];
+		Slot.Timings.push_back({Node, stampQuery(), Unstamped});
+		Timing.Index = static_cast<std::ptrdiff_t>(Slot.Timings.size() - 1);
+	}
+	TTimings.push_back(Timing);
+	return Node;
+}
+
+void Profiler::popScope(const int Node, const double Milliseconds)
+{
+	std::lock_guard Lock(GMutex);
+	const OpenTiming Timing = TTimings.back();
+	TScopes.pop_back();
+	TTimings.pop_back();
+
+	// A reset while the scope was open dropped its node
+	if (static_cast<std::size_t>(Node) >= GNodes.size())
+	{
+		return;
+	}
+	GNodes[Node].FrameMilliseconds += Milliseconds;
+	GNodes[Node].FrameCalls++;
+	if (Timing.Index >= 0 && Timing.Frame == GFrameIndex && canTimeGpu())
+	{
+		GSlots[GFrameIndex % FrameLatency].Timings[Timing.Index].End = stampQuery();
+	}
+}
+
+ProfileScope::ProfileScope(const char* Name, const bool Gpu)
+	: MName(Name), MNode(Profiler::pushScope(Name, Gpu)), MTraced(TraceRecorder::isRecording())
+{
+	if (MNode >= 0 || MTraced)
+	{
+		MStart = std::chrono::steady_clock::now();
+	}
+}
+
+ProfileScope::~ProfileScope()
+{
+	if (MNode < 0 && !MTraced)
+	{
+		return;
+	}
+	const auto End = std::chrono::steady_clock::now();
+	if (MNode >= 0)
+	{
+		const std::chrono::duration<double, std::milli> Elapsed = End - MStart;
+		Profiler::popScope(MNode, Elapsed.count());
+	}
+	if (MTraced)
+	{
+		TraceRecorder::record(TraceCategory::Scope, MName, TraceRecorder::toNanoseconds(MStart),
+		                      TraceRecorder::toNanoseconds(End));
+	}
+}
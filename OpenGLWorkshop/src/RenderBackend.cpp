@@ -0,0 +1,374 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : RenderBackend.cpp
+Description : Implementations for the backends a frame's draws are submitted
+			  through, GL and a null backend that only validates and counts
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "RenderBackend.h"
+
+#include <glm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include "GlState.h"
+#include "InstanceAnimation.h"
+#include "GlCapture.h"
+
+namespace
+{
+	constexpr GLbitfield MappingFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	constexpr GLbitfield ClearBits = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+	constexpr GLuint MaxTextureUnits = 32;
+
+	// Elements a draw reads, over every instance
+	unsigned long long countElements(const DrawPacket& Packet)
+	{
+		return static_cast<unsigned long long>(Packet.Count) * std::max<GLsizei>(Packet.InstanceCount, 1);
+	}
+}
+
+const BackendStats& RenderBackend::getStats() const
+{
+	return MStats;
+}
+
+void RenderBackend::resetStats()
+{
+	MStats = {};
+}
+
+GlBackend& GlBackend::get()
+{
+	static GlBackend Backend;
+	return Backend;
+}
+
+const char* GlBackend::getName() const
+{
+	return "gl";
+}
+
+void GlBackend::clear(const GLbitfield Mask)
+{
+	glClear(Mask);
+	MStats.Clears++;
+}
+
+void GlBackend::useProgram(const GLuint Program)
+{
+	GlState::useProgram(Program);
+	MStats.ProgramBinds++;
+}
+
+void GlBackend::setUniforms(const RenderQueue::UniformSet& Set, const GLuint Program)
+{
+	Set.Setter(Program);
+	MStats.UniformSets++;
+}
+
+void GlBackend::bindTexture(const GLuint Unit, const GLuint Texture)
+{
+	GlState::bindTexture(Unit, Texture);
+	MStats.TextureBinds++;
+}
+
+void GlBackend::bindVertexArray(const GLuint Vao)
+{
+	GlState::bindVertexArray(Vao);
+	MStats.VaoBinds++;
+}
+
+void GlBackend::bindInstanceSources(const GLuint Vao, const GLuint Transforms, const GLuint Animations)
+{
+	RenderQueue::bindInstanceSource(Vao, Transforms);
+	RenderQueue::bindAnimationSource(Vao, Animations);
+	MStats.SourceBinds++;
+}
+
+void GlBackend::draw(const DrawPacket& Packet)
+{
+	if (Packet.Indexed)
+	{
+		const auto* Offset = reinterpret_cast<void*>(static_cast<std::uintptr_t>(Packet.First) *
+			sizeof(unsigned int));
+		if (Packet.InstanceCount > 0)
+		{
+			glDrawElementsInstancedBaseInstance(Packet.Mode, Packet.Count, GL_UNSIGNED_INT, Offset,
+			                                    Packet.InstanceCount, Packet.BaseInstance);
+		}
+		else
+		{
+			glDrawElements(Packet.Mode, Packet.Count, GL_UNSIGNED_INT, Offset);
+		}
+	}
+	else if (Packet.InstanceCount > 0)
+	{
+		glDrawArraysInstancedBaseInstance(Packet.Mode, static_cast<GLint>(Packet.First), Packet.Count,
+		                                  Packet.InstanceCount, Packet.BaseInstance);
+	}
+	else
+	{
+		glDrawArrays(Packet.Mode, static_cast<GLint>(Packet.First), Packet.Count);
+	}
+	MStats.Draws++;
+	MStats.Elements += countElements(Packet);
+}
+
+void GlBackend::flush()
+{
+	// GL works through its draws on its own
+}
+
+GLuint GlBackend::createMappedBuffer(const std::size_t Size, void*& Mapped)
+{
+	GLuint Buffer = 0;
+	glCreateBuffers(1, &Buffer);
+	glNamedBufferStorage(Buffer, static_cast<GLsizeiptr>(Size), nullptr, MappingFlags);
+	Mapped = glMapNamedBufferRange(Buffer, 0, static_cast<GLsizeiptr>(Size), MappingFlags);
+	MStats.BuffersCreated++;
+	return Buffer;
+}
+
+void GlBackend::deleteBuffers(const GLsizei Count, const GLuint* Buffers)
+{
+	// Deleting a buffer unmaps it
+	GlState::deleteBuffers(Count, Buffers);
+}
+
+GLsync GlBackend::fence()
+{
+	MStats.Fences++;
+	return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void GlBackend::waitFence(const GLsync Fence)
+{
+	constexpr GLuint64 TimeoutNanoseconds = 1000000;
+	GLbitfield Flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true)
+	{
+		const GLenum Result = glClientWaitSync(Fence, Flags, TimeoutNanoseconds);
+		if (Result == GL_ALREADY_SIGNALED || Result == GL_CONDITION_SATISFIED || Result == GL_WAIT_FAILED)
+		{
+			break;
+		}
+		Flags = 0; // Flushed once is enough
+	}
+	glDeleteSync(Fence);
+}
+
+void GlBackend::deleteFence(const GLsync Fence)
+{
+	glDeleteSync(Fence);
+}
+
+void GlBackend::checkErrors(const char* Stage)
+{
+	const GLenum Err = glGetError();
+	if (Err != GL_NO_ERROR)
+	{
+		std::cerr << "OpenGL error (" << Stage << "): " << Err << std::endl;
+	}
+}
+
+const char* NullBackend::getName() const
+{
+	return "null";
+}
+
+void NullBackend::clear(const GLbitfield Mask)
+{
+	if (Mask == 0 || (Mask & ~ClearBits) != 0)
+	{
+		reject("clear of unknown buffers");
+		return;
+	}
+	MStats.Clears++;
+}
+
+void NullBackend::useProgram(const GLuint Program)
+{
+	MProgram = Program;
+	MStats.ProgramBinds++;
+}
+
+void NullBackend::setUniforms(const RenderQueue::UniformSet& Set, const GLuint Program)
+{
+	// The setter would reach GL, so it is only checked for
+	if (!Set.Setter || Program == 0 || Program != MProgram)
+	{
+		reject("uniforms set on a program that isn't bound");
+		return;
+	}
+	MStats.UniformSets++;
+}
+
+void NullBackend::bindTexture(const GLuint Unit, GLuint)
+{
+	if (Unit >= MaxTextureUnits)
+	{
+		reject("texture bound past the last unit");
+		return;
+	}
+	MStats.TextureBinds++;
+}
+
+void NullBackend::bindVertexArray(const GLuint Vao)
+{
+	MVao = Vao;
+	MStats.VaoBinds++;
+}
+
+void NullBackend::bindInstanceSources(const GLuint Vao, const GLuint Transforms, const GLuint Animations)
+{
+	if (Vao == 0 || Transforms == 0)
+	{
+		reject("instance sources pointed at nothing");
+		return;
+	}
+	const auto Found = std::find_if(MSources.begin(), MSources.end(), [Vao](const VaoSources& Sources)
+	{
+		return Sources.Vao == Vao;
+	});
+	if (Found == MSources.end())
+	{
+		MSources.push_back({Vao, Transforms, Animations});
+	}
+	else
+	{
+		Found->Transforms = Transforms;
+		Found->Animations = Animations;
+	}
+	MStats.SourceBinds++;
+}
+
+void NullBackend::draw(const DrawPacket& Packet)
+{
+	if (MProgram == 0 || Packet.Program != MProgram)
+	{
+		reject("draw without its program bound");
+		return;
+	}
+	if (MVao == 0 || Packet.Vao != MVao)
+	{
+		reject("draw without its vertex array bound");
+		return;
+	}
+	if (Packet.Count <= 0 || Packet.InstanceCount < 0)
+	{
+		reject("draw of nothing");
+		return;
+	}
+	if (Packet.Mode != GL_TRIANGLES && Packet.Mode != GL_TRIANGLE_STRIP && Packet.Mode != GL_TRIANGLE_FAN &&
+		Packet.Mode != GL_LINES && Packet.Mode != GL_LINE_STRIP && Packet.Mode != GL_POINTS)
+	{
+		reject("draw of an unknown primitive");
+		return;
+	}
+
+	// Only buffers made here have a known size, the pool's own buffers are GL's to check
+	if (Packet.InstanceCount > 0)
+	{
+		const auto Sources = std::find_if(MSources.begin(), MSources.end(), [this](const VaoSources& Candidate)
+		{
+			return Candidate.Vao == MVao;
+		});
+		if (Sources != MSources.end())
+		{
+			const std::size_t End = static_cast<std::size_t>(Packet.BaseInstance) + Packet.InstanceCount;
+			const HostBuffer* Transforms = findBuffer(Sources->Transforms);
+			const HostBuffer* Animations = findBuffer(Sources->Animations);
+			if ((Transforms != nullptr && End * sizeof(glm::mat4) > Transforms->Size) ||
+				(Animations != nullptr && End * sizeof(InstanceAnimation) > Animations->Size))
+			{
+				reject("draw reading instances past the end of their buffer");
+				return;
+			}
+		}
+	}
+	MStats.Draws++;
+	MStats.Elements += countElements(Packet);
+}
+
+void NullBackend::flush()
+{
+}
+
+GLuint NullBackend::createMappedBuffer(const std::size_t Size, void*& Mapped)
+{
+	HostBuffer Buffer{MNextName--, Size, std::make_unique<unsigned char[]>(Size)};
+	Mapped = Buffer.Memory.get();
+	MBuffers.push_back(std::move(Buffer));
+	MStats.BuffersCreated++;
+	return MBuffers.back().Name;
+}
+
+void NullBackend::deleteBuffers(const GLsizei Count, const GLuint* Buffers)
+{
+	for (GLsizei I = 0; I < Count; I++)
+	{
+		const GLuint Name = Buffers[I];
+		MBuffers.erase(std::remove_if(MBuffers.begin(), MBuffers.end(), [Name](const HostBuffer& Buffer)
+		{
+			return Buffer.Name == Name;
+		}), MBuffers.end());
+	}
+}
+
+GLsync NullBackend::fence()
+{
+	// Nothing was issued, so there is never anything to wait for
+	MStats.Fences++;
+	return nullptr;
+}
+
+void NullBackend::waitFence(GLsync)
+{
+}
+
+void NullBackend::deleteFence(GLsync)
+{
+}
+
+void NullBackend::checkErrors(const char* Stage)
+{
+	if (MUnreported > 0)
+	{
+		std::cerr << "Null backend (" << Stage << "): " << MUnreported << " invalid commands, first: " << MProblem
+			<< std::endl;
+	}
+	MUnreported = 0;
+	MProblem = nullptr;
+}
+
+void NullBackend::reject(const char* Problem)
+{
+	if (MProblem == nullptr)
+	{
+		MProblem = Problem;
+	}
+	MStats.Invalid++;
+	MUnreported++;
+}
+
+const NullBackend::HostBuffer* NullBackend::findBuffer(const GLuint Name) const
+{
+	for (const HostBuffer& Buffer : MBuffers)
+	{
+		if (Buffer.Name == Name)
+		{
+			return &Buffer;
+		}
+	}
+	return nullptr;
+}
@@ -0,0 +1,265 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : RenderQueue.cpp
+Description : Implementations for a render queue of draw packets collected
+			  into buckets, radix sorted by state and submitted in order
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "RenderQueue.h"
+
+#include <glm.hpp>
+#include <algorithm>
+#include <chrono>
+
+#include "InstanceAnimation.h"
+#include "RenderBackend.h"
+
+BucketId RenderQueue::addBucket(std::string Name)
+{
+	MBuckets.push_back({std::move(Name), {}, {}, {}});
+	return MBuckets.size() - 1;
+}
+
+std::size_t RenderQueue::getBucketCount() const
+{
+	return MBuckets.size();
+}
+
+const std::string& RenderQueue::getBucketName(const BucketId Bucket) const
+{
+	return MBuckets[Bucket].Name;
+}
+
+std::uint64_t RenderQueue::makeKey(const RenderPass Pass, const GLuint Program, const GLuint Texture, const GLuint Vao,
+                                   const float Depth)
+{
+	constexpr std::uint64_t DepthMax = (1ull << DepthBits) - 1;
+	const auto Quantised = static_cast<std::uint64_t>(std::clamp(Depth, 0.0f, 1.0f) * static_cast<float>(DepthMax));
+
+	std::uint64_t Key = static_cast<std::uint64_t>(Pass) & ((1ull << PassBits) - 1);
+	Key = Key << ProgramBits | (Program & ((1ull << ProgramBits) - 1));
+	Key = Key << TextureBits | (Texture & ((1ull << TextureBits) - 1));
+	Key = Key << VaoBits | (Vao & ((1ull << VaoBits) - 1));
+	return Key << DepthBits | std::min(Quantised, DepthMax);
+}
+
+std::uint32_t RenderQueue::addUniforms(UniformSetter Setter, const std::optional<SceneUniforms>& Scene)
+{
+	MUniforms.push_back({std::move(Setter), Scene});
+	return static_cast<std::uint32_t>(MUniforms.size() - 1);
+}
+
+void RenderQueue::push(const BucketId Bucket, const std::uint64_t Key, const DrawPacket& Packet)
+{
+	CommandBucket& Target = MBuckets[Bucket];
+	Target.Entries.push_back({Key, static_cast<std::uint32_t>(Target.Packets.size())});
+	Target.Packets.push_back(Packet);
+	MStats.Packets++;
+}
+
+void RenderQueue::sort()
+{
+	const auto Start = std::chrono::steady_clock::now();
+	for (CommandBucket& Target : MBuckets)
+	{
+		radixSort(Target.Entries, Target.Scratch);
+	}
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.SortMilliseconds += Elapsed.count();
+}
+
+void RenderQueue::submit()
+{
+	submit(GlBackend::get());
+}
+
+void RenderQueue::submit(RenderBackend& Backend)
+{
+	const auto Start = std::chrono::steady_clock::now();
+
+	// Nothing is assumed bound beforehand, so the first packet sets everything it uses
+	constexpr GLuint Unknown = ~0u;
+	GLuint Program = Unknown;
+	GLuint Texture = Unknown;
+	GLuint Vao = Unknown;
+	GLuint InstanceBuffer = Unknown;
+	GLuint AnimationBuffer = Unknown;
+	MProgramUniforms.clear();
+
+	for (const CommandBucket& Source : MBuckets)
+	{
+		for (const Entry& Item : Source.Entries)
+		{
+			const DrawPacket& Packet = Source.Packets[Item.Packet];
+			if (Packet.Program != Program)
+			{
+				Backend.useProgram(Packet.Program);
+				Program = Packet.Program;
+				MStats.ProgramBinds++;
+			}
+			if (Packet.Uniforms != NoUniforms)
+			{
+				// Uniforms stay with their program, so each remembers its own set across program changes
+				std::uint32_t* Current = nullptr;
+				for (std::pair<GLuint, std::uint32_t>& Set : MProgramUniforms)
+				{
+					if (Set.first == Program)
+					{
+						Current = &Set.second;
+					}
+				}
+				if (Current == nullptr)
+				{
+					MProgramUniforms.emplace_back(Program, NoUniforms);
+					Current = &MProgramUniforms.back().second;
+				}
+				if (*Current != Packet.Uniforms)
+				{
+					Backend.setUniforms(MUniforms[Packet.Uniforms], Program);
+					*Current = Packet.Uniforms;
+					MStats.UniformSets++;
+				}
+			}
+			if (Packet.Texture != 0 && Packet.Texture != Texture)
+			{
+				Backend.bindTexture(0, Packet.Texture);
+				Texture = Packet.Texture;
+				MStats.TextureBinds++;
+			}
+			if (Packet.Vao != Vao)
+			{
+				// Instance sources belong to the VAO, so another one's are no guide to this one's
+				Backend.bindVertexArray(Packet.Vao);
+				Vao = Packet.Vao;
+				InstanceBuffer = Unknown;
+				AnimationBuffer = Unknown;
+				MStats.VaoBinds++;
+			}
+			if (Packet.InstanceBuffer != 0 &&
+				(Packet.InstanceBuffer != InstanceBuffer || Packet.AnimationBuffer != AnimationBuffer))
+			{
+				Backend.bindInstanceSources(Packet.Vao, Packet.InstanceBuffer, Packet.AnimationBuffer);
+				InstanceBuffer = Packet.InstanceBuffer;
+				AnimationBuffer = Packet.AnimationBuffer;
+				MStats.SourceBinds++;
+			}
+
+			Backend.draw(Packet);
+			MStats.Draws++;
+		}
+	}
+
+	MStats.StateChanges = MStats.ProgramBinds + MStats.TextureBinds + MStats.VaoBinds + MStats.SourceBinds +
+		MStats.UniformSets;
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.SubmitMilliseconds += Elapsed.count();
+}
+
+void RenderQueue::clear()
+{
+	for (CommandBucket& Target : MBuckets)
+	{
+		Target.Entries.clear();
+		Target.Packets.clear();
+	}
+	MUniforms.clear();
+	MStats = {};
+}
+
+const std::vector<RenderQueue::Entry>& RenderQueue::getEntries(const BucketId Bucket) const
+{
+	return MBuckets[Bucket].Entries;
+}
+
+std::size_t RenderQueue::getPacketCount() const
+{
+	return MStats.Packets;
+}
+
+const RenderQueueStats& RenderQueue::getStats() const
+{
+	return MStats;
+}
+
+void RenderQueue::bindInstanceSource(const GLuint Vao, const GLuint Buffer)
+{
+	for (GLuint I = 0; I < 4; I++)
+	{
+		glVertexArrayVertexBuffer(Vao, 3 + I, Buffer, static_cast<GLintptr>(I * sizeof(glm::vec4)), sizeof(glm::mat4));
+	}
+}
+
+void RenderQueue::bindAnimationSource(const GLuint Vao, const GLuint Buffer)
+{
+	for (GLuint I = 0; I < 2; I++)
+	{
+		if (Buffer == 0)
+		{
+			glDisableVertexArrayAttrib(Vao, 7 + I);
+			continue;
+		}
+		glEnableVertexArrayAttrib(Vao, 7 + I);
+		glVertexArrayVertexBuffer(Vao, 7 + I, Buffer, static_cast<GLintptr>(I * sizeof(glm::vec4)),
+		                          sizeof(InstanceAnimation));
+	}
+}
+
+void RenderQueue::radixSort(std::vector<Entry>& Entries, std::vector<Entry>& Scratch)
+{
+	constexpr int DigitBits = 8;
+	constexpr int Digits = 64 / DigitBits;
+	constexpr std::size_t Radix = 1u << DigitBits;
+	if (Entries.size() < 2)
+	{
+		return;
+	}
+
+	// Every digit's histogram in one read of the keys
+	std::size_t Counts[Digits][Radix] = {};
+	for (const Entry& Item : Entries)
+	{
+		for (int Digit = 0; Digit < Digits; Digit++)
+		{
+			Counts[Digit][(Item.Key >> (Digit * DigitBits)) & (Radix - 1)]++;
+		}
+	}
+
+	Scratch.resize(Entries.size());
+	std::vector<Entry>* From = &Entries;
+	std::vector<Entry>* To = &Scratch;
+	for (int Digit = 0; Digit < Digits; Digit++)
+	{
+		const int Shift = Digit * DigitBits;
+
+		// Keys that all share this digit are already in order by it, most of the pass and program bits
+		if (Counts[Digit][(Entries.front().Key >> Shift) & (Radix - 1)] == Entries.size())
+		{
+			continue;
+		}
+
+		std::size_t Offsets[Radix];
+		std::size_t Total = 0;
+		for (std::size_t Value = 0; Value < Radix; Value++)
+		{
+			Offsets[Value] = Total;
+			Total += Counts[Digit][Value];
+		}
+		for (const Entry& Item : *From)
+		{
+			(*To)[Offsets[(Item.Key >> Shift) & (Radix - 1)]++] = Item;
+		}
+		std::swap(From, To);
+	}
+	if (From != &Entries)
+	{
+		Entries.swap(Scratch);
+	}
+}
@@ -14,6 +14,10 @@ Mail : ayoub.ahmad@mds.ac.nz
 
 #include "Renderer.h"
 
+#include <chrono>
+
+#include "GlCapture.h"
+
 // UI Quad position and dimensions
 constexpr float QuadX = 100.0f;
 constexpr float QuadY = 100.0f;
@@ -21,86 +25,436 @@ constexpr float QuadWidth = 200.0f;
 constexpr float QuadHeight = 200.0f;
 
 Renderer::Renderer(const unsigned int Width, const unsigned int Height, GLFWwindow* Window)
-	: MWidth(Width), MHeight(Height), MWindow(Window), MObjectPosition(0.0f, 0.0f, 0.0f), MCamera(20.0f, 1.0f)
+	: MWidth(Width), MHeight(Height), MWindow(Window), MInput{}, MFrame(&MInitialFrame), MPipeline{},
+	  MLodEnabled(true), MCullingEnabled(true), MImpostorAtlas(nullptr), MImpostorProgram(0), MImpostorsEnabled(true),
+	  MImpostorPixelDiameter(16.0f), MOcclusionEnabled(true), MMovingObjectOccluder(nullptr), MCollisionEnabled(true),
+	  MSwarmModel(nullptr), MSwarmRunning(true), MStats{}, MBackend(&GlBackend::get()), MDefaultInstance(0)
 {
+	MOcclusionCuller.setViewport(Width, Height);
+	MQueueBucket = MQueue.addBucket("immediate");
 }
 
-void Renderer::renderScene(const GLuint ShaderProgram, const Model& Model, GLuint InstanceBuffer,
-                           const GLuint InstanceCount, const std::vector<glm::mat4>& ModelMatrices)
+Renderer::~Renderer()
 {
-	// Update camera
-	constexpr float DeltaTime = 0.005f; // Fix time for speed
-	MCamera.update(DeltaTime);
+	if (MDefaultInstance != 0)
+	{
+		GlState::deleteBuffers(1, &MDefaultInstance);
+	}
+}
 
-	// Handle camera input
-	MCamera.processInput(MWindow, DeltaTime);
+void Renderer::setFrame(const FrameSnapshot& Frame, const PipelineStats& Pipeline)
+{
+	MFrame = &Frame;
+	MPipeline = Pipeline;
 
-	// Use the camera matrices for rendering
-	const glm::mat4 Projection = MCamera.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
-	const glm::mat4 View = MCamera.getViewMatrix();
+	// Contacts are reported here rather than from the simulation thread
+	for (const ContactEvent& Event : Frame.ContactEvents)
+	{
+		if (Event.Type == ContactEventType::Begin)
+		{
+			std::cout << "Moving object hit instance (slot " << Event.Instance.Slot << ", generation "
+				<< Event.Instance.Generation << ")\n";
+		}
+	}
+}
+
+void Renderer::prepareScene(const FrameSnapshot& Frame, const Model& Model, const InstancePool& Instances,
+                            PreparedScene& Prepared)
+{
+	const ProfileScope Scope("cull");
+	const Camera& View = Frame.Viewpoint;
+	const glm::mat4 Projection = View.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
+	const glm::mat4 ViewProjection = Projection * View.getViewMatrix();
+	const bool Animated = Instances.hasAnimations();
+
+	Prepared.Frame = &Frame;
+	Prepared.Culling = {};
+	Prepared.Occlusion = {};
+	Prepared.ImpostorTransforms.clear();
+	Prepared.ImpostorAnimations.clear();
+	Prepared.ProjectionScale = static_cast<float>(MHeight) / (2.0f * tan(View.getFieldOfView() * 0.5f));
+
+	const bool UseLod = MLodEnabled && Model.Lods.size() > 1;
+	const bool UseImpostors = MImpostorsEnabled && MImpostorAtlas != nullptr;
+	Prepared.Culled = MCullingEnabled || UseLod || UseImpostors;
+	Prepared.Fading = Prepared.Culled && UseImpostors;
+	Prepared.LevelCount = UseLod ? static_cast<int>(Model.Lods.size()) : 1;
+	if (!Prepared.Culled)
+	{
+		// Drawn in a single call straight from the pool
+		Prepared.VisibleCount = Instances.getCount();
+		return;
+	}
 
-	// Render instanced objects
-	glBindVertexArray(Model.Vao);
-	for (unsigned int I = 0; I < InstanceCount; I++)
+	// Frustum and contribution tests share one pass, which also yields the projected sizes LOD needs
+	CullSettings Settings = MCullSettings;
+	Settings.FrustumCulling &= MCullingEnabled;
+	Settings.ContributionCulling &= MCullingEnabled;
+	MCuller.cull(Instances, Model, ViewProjection, View.getPosition(), Prepared.ProjectionScale, Settings,
+	             Frame.AnimationTime);
+	Prepared.Culling = MCuller.getStats();
+	const std::vector<std::uint32_t>* MeshVisible = &MCuller.getVisible();
+	const std::vector<float>* MeshPixelDiameters = &MCuller.getPixelDiameters();
+
+	// Instances hidden behind the largest ones, or behind the moving object, are dropped before submission
+	if (MOcclusionEnabled)
 	{
-		glm::mat4 Mvp = Projection * View * ModelMatrices[I];
-		const GLint MvpLocation = glGetUniformLocation(ShaderProgram, "mvp");
-		if (MvpLocation == -1)
+		if (MMovingObjectOccluder != nullptr)
 		{
-			std::cerr << "Could not find uniform location for 'mvp'" << std::endl;
+			MOcclusionCuller.addOccluder(*MMovingObjectOccluder, getMovingObjectMatrix(Frame.ObjectPosition));
 		}
-		else
+		MOcclusionCuller.cull(Instances, Model, *MeshVisible, *MeshPixelDiameters, ViewProjection,
+		                      MOcclusionSettings, Frame.AnimationTime);
+		Prepared.Occlusion = MOcclusionCuller.getStats();
+		MeshVisible = &MOcclusionCuller.getVisible();
+		MeshPixelDiameters = &MOcclusionCuller.getPixelDiameters();
+	}
+
+	Prepared.VisibleCount = static_cast<unsigned int>(MeshVisible->size());
+
+	// Small instances go to impostors, the fade band is drawn both ways and dithered between them
+	if (UseImpostors)
+	{
+		const std::vector<glm::mat4>& Transforms = Instances.getTransforms();
+		const std::vector<InstanceAnimation>& Animations = Instances.getAnimations();
+		const float FadeEnd = MImpostorPixelDiameter * ImpostorFadeRatio;
+		MMeshVisible.clear();
+		MMeshPixelDiameters.clear();
+		for (std::size_t I = 0; I < MeshVisible->size(); I++)
 		{
-			glUniformMatrix4fv(MvpLocation, 1, GL_FALSE, value_ptr(Mvp));
+			const float PixelDiameter = (*MeshPixelDiameters)[I];
+			if (PixelDiameter >= MImpostorPixelDiameter)
+			{
+				MMeshVisible.push_back((*MeshVisible)[I]);
+				MMeshPixelDiameters.push_back(PixelDiameter);
+			}
+			if (PixelDiameter < FadeEnd)
+			{
+				Prepared.ImpostorTransforms.push_back(Transforms[(*MeshVisible)[I]]);
+				if (Animated)
+				{
+					Prepared.ImpostorAnimations.push_back(Animations[(*MeshVisible)[I]]);
+				}
+			}
 		}
-		glDrawElements(GL_TRIANGLES, Model.IndexCount, GL_UNSIGNED_INT, nullptr);
+		MeshVisible = &MMeshVisible;
+		MeshPixelDiameters = &MMeshPixelDiameters;
 	}
-	glBindVertexArray(0);
 
-	checkOpenGlError("renderScene");
+	// The selector keeps each slot's level across frames, its batches move out to the prepared scene
+	MLodSelector.select(Instances, *MeshVisible, *MeshPixelDiameters, Prepared.LevelCount);
+	MLodSelector.takeBatches(Prepared.Batched, Prepared.BatchedAnimations);
+	for (int Level = 0; Level < LodSelector::MaxLods; Level++)
+	{
+		Prepared.BucketOffsets[Level] = MLodSelector.getBucketOffset(Level);
+		Prepared.BucketCounts[Level] = MLodSelector.getBucketCount(Level);
+	}
 }
 
-void Renderer::renderMovingObject(const GLuint ShaderProgram, const Model& MovingObjectModel)
+void Renderer::beginScene(const Model& Model, InstancePool& Instances, const PreparedScene& Prepared)
+{
+	// Push any spawned, moved or despawned instances to the GPU buffer. Animated instances then move on the
+	// GPU alone, the CPU side only poses them again where it has to test them
+	Instances.upload();
+
+	// Picking reads the instance BVH, which only does work when instances have changed
+	MPicker.update(Instances, Model);
+
+	// Draws and triangles are added as command buffers execute
+	MStats = {};
+	MBackend->resetStats();
+	MStats.Collision = Prepared.Frame->Collision;
+	MStats.SimulationSteps = Prepared.Frame->Steps;
+	MStats.Interpolation = Prepared.Frame->Interpolation;
+	MStats.Pipeline = MPipeline;
+	MStats.Swarm = MFrame->Swarm;
+	if (Prepared.Culled)
+	{
+		MStats.Culling = Prepared.Culling;
+		MStats.Occlusion = Prepared.Occlusion;
+		MStats.Instances = Prepared.VisibleCount;
+		for (int Level = 0; Level < Prepared.LevelCount; Level++)
+		{
+			MStats.LodInstances[Level] = Prepared.BucketCounts[Level];
+		}
+		MStats.ImpostorInstances = static_cast<unsigned int>(Prepared.ImpostorTransforms.size());
+	}
+	else
+	{
+		MStats.Instances = Instances.getCount();
+		MStats.LodInstances[0] = Instances.getCount();
+	}
+	MStats.TrianglesWithoutLod = static_cast<unsigned long long>(MStats.Instances) * (Model.IndexCount / 3);
+}
+
+void Renderer::recordScene(CommandBuffer& Commands, const GLuint ShaderProgram, const Model& Model,
+                           const InstancePool& Instances, const PreparedScene& Prepared) const
 {
-	// Update camera
-	constexpr float DeltaTime = 0.01f; // Fix time for speed
-	MCamera.update(DeltaTime);
+	const ProfileScope Scope("record scene");
+
+	// Use the camera matrices for rendering, as interpolated for the prepared frame
+	const Camera& View = Prepared.Frame->Viewpoint;
+	const glm::mat4 Projection = View.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
+	const glm::mat4 ViewMatrix = View.getViewMatrix();
+	const bool Animated = Instances.hasAnimations();
+
+	// Per instance model matrices come from the instance buffer, mvp only carries the camera
+	const glm::mat4 ViewProjection = Projection * ViewMatrix;
+	SceneUniforms Uniforms{};
+	Uniforms.Mvp = ViewProjection;
+	Uniforms.Instanced = true;
+	Uniforms.Animated = Animated;
+	Uniforms.Time = Prepared.Frame->AnimationTime;
+
+	DrawPacket Packet{ShaderProgram, Model.Texture, Model.Vao, 0, 0, GL_TRIANGLES, true, 0, 0, 0, 0,
+	                  RenderQueue::NoUniforms};
+	if (Prepared.Culled)
+	{
+		if (Prepared.Fading)
+		{
+			applyFading(Uniforms, Model, Prepared);
+		}
+
+		// Mesh batches first, the impostors after them
+		const std::uint32_t First = Commands.addInstances(Prepared.Batched.data(),
+		                                                  Animated ? Prepared.BatchedAnimations.data() : nullptr,
+		                                                  Prepared.Batched.size());
+		const std::uint32_t ImpostorFirst = Commands.addInstances(
+			Prepared.ImpostorTransforms.data(), Animated ? Prepared.ImpostorAnimations.data() : nullptr,
+			Prepared.ImpostorTransforms.size());
+		Packet.InstanceBuffer = CommandBuffer::RecordedInstances;
+		Packet.AnimationBuffer = Animated ? CommandBuffer::RecordedInstances : 0;
+		Packet.Uniforms = Commands.addUniforms([Uniforms](const GLuint Program)
+		{
+			setSceneUniforms(Program, Uniforms);
+		}, Uniforms);
+
+		// One instanced draw per level, each reading its own range of the instance stream. Finer levels are
+		// nearer the camera, so they stand in for depth
+		for (int Level = 0; Level < Prepared.LevelCount; Level++)
+		{
+			const unsigned int Count = Prepared.BucketCounts[Level];
+			if (Count == 0)
+			{
+				continue;
+			}
+			const ModelLod& Lod = Model.Lods[Level];
+			Packet.Count = static_cast<GLsizei>(Lod.IndexCount);
+			Packet.First = static_cast<GLuint>(Lod.IndexOffset);
+			Packet.InstanceCount = static_cast<GLsizei>(Count);
+			Packet.BaseInstance = First + Prepared.BucketOffsets[Level];
+			const float Depth = static_cast<float>(Level) / static_cast<float>(LodSelector::MaxLods);
+			Commands.push(RenderQueue::makeKey(RenderPass::Opaque, ShaderProgram, Model.Texture, Model.Vao, Depth),
+			              Packet);
+		}
+
+		if (!Prepared.ImpostorTransforms.empty())
+		{
+			recordImpostors(Commands, Uniforms, Prepared, ImpostorFirst);
+		}
+	}
+	else if (Instances.getCount() > 0)
+	{
+		// Render instanced objects in a single draw straight from the pool
+		Packet.InstanceBuffer = Instances.getBuffer();
+		Packet.AnimationBuffer = Instances.getAnimationBuffer();
+		Packet.Uniforms = Commands.addUniforms([Uniforms](const GLuint Program)
+		{
+			setSceneUniforms(Program, Uniforms);
+		}, Uniforms);
+		Packet.Count = static_cast<GLsizei>(Model.IndexCount);
+		Packet.InstanceCount = static_cast<GLsizei>(Instances.getCount());
+		Commands.push(RenderQueue::makeKey(RenderPass::Opaque, ShaderProgram, Model.Texture, Model.Vao, 0.0f),
+		              Packet);
+	}
+}
 
-	// Handle object movement
-	processObjectMovement(DeltaTime);
+void Renderer::recordMovingObject(CommandBuffer& Commands, const GLuint ShaderProgram,
+                                  const Model& MovingObjectModel) const
+{
+	const ProfileScope Scope("record object");
 
 	// Use the camera matrices for rendering
-	const glm::mat4 Projection = MCamera.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
-	const glm::mat4 View = MCamera.getViewMatrix();
-	glm::mat4 ModelMatrix = translate(glm::mat4(1.0f), MObjectPosition);
+	const Camera& View = MFrame->Viewpoint;
+	const glm::mat4 Projection = View.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
+	SceneUniforms Uniforms{};
+	Uniforms.Mvp = Projection * View.getViewMatrix() * getMovingObjectMatrix();
+	const std::uint32_t Set = Commands.addUniforms([Uniforms](const GLuint Program)
+	{
+		setSceneUniforms(Program, Uniforms);
+	}, Uniforms);
+
+	const float Depth = distance(View.getPosition(), MFrame->ObjectPosition) / Camera::FarPlane;
+	Commands.push(RenderQueue::makeKey(RenderPass::Opaque, ShaderProgram, MovingObjectModel.Texture,
+	                                   MovingObjectModel.Vao, Depth),
+	              {ShaderProgram, MovingObjectModel.Texture, MovingObjectModel.Vao, 0, 0, GL_TRIANGLES, true,
+	               static_cast<GLsizei>(MovingObjectModel.IndexCount), 0, 0, 0, Set});
+}
 
-	// Scale down the moving object
-	ModelMatrix = scale(ModelMatrix, glm::vec3(0.001f));
+void Renderer::recordSwarm(CommandBuffer& Commands, const GLuint ShaderProgram) const
+{
+	const ProfileScope Scope("record swarm");
+	const std::vector<glm::mat4>& Transforms = MFrame->SwarmTransforms;
+	if (MSwarmModel == nullptr || Transforms.empty())
+	{
+		return;
+	}
 
-	// Rotate the object to face the screen (+Z)
-	ModelMatrix = rotate(ModelMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const std::uint32_t First = Commands.addInstances(Transforms.data(), nullptr, Transforms.size());
+	const Camera& View = MFrame->Viewpoint;
+	const glm::mat4 Projection = View.getProjectionMatrix(static_cast<float>(MWidth) / static_cast<float>(MHeight));
+	SceneUniforms Uniforms{};
+	Uniforms.Mvp = Projection * View.getViewMatrix();
+	Uniforms.Instanced = true;
+	const std::uint32_t Set = Commands.addUniforms([Uniforms](const GLuint Program)
+	{
+		setSceneUniforms(Program, Uniforms);
+	}, Uniforms);
 
-	glm::mat4 Mvp = Projection * View * ModelMatrix;
-	const GLint MvpLocation = glGetUniformLocation(ShaderProgram, "mvp");
-	if (MvpLocation == -1)
+	// Ships are a few pixels across at most, with LOD on they all draw at the coarsest level
+	ModelLod Lod{0, MSwarmModel->IndexCount, 0.0f};
+	if (MLodEnabled && !MSwarmModel->Lods.empty())
 	{
-		std::cerr << "Could not find uniform location for 'mvp'" << std::endl;
+		Lod = MSwarmModel->Lods.back();
 	}
-	else
+	const auto Count = static_cast<GLsizei>(Transforms.size());
+	Commands.push(RenderQueue::makeKey(RenderPass::Opaque, ShaderProgram, MSwarmModel->Texture, MSwarmModel->Vao,
+	                                   0.0f),
+	              {ShaderProgram, MSwarmModel->Texture, MSwarmModel->Vao, CommandBuffer::RecordedInstances, 0,
+	               GL_TRIANGLES, true, static_cast<GLsizei>(Lod.IndexCount), static_cast<GLuint>(Lod.IndexOffset),
+	               Count, First, Set});
+}
+
+void Renderer::execute(RenderQueue& Queue, const BucketId Bucket, const CommandBuffer& Commands)
+{
+	const ProfileScope Scope("execute");
+	const auto Start = std::chrono::steady_clock::now();
+
+	// The only copy the GL thread makes, straight into mapped memory the draws read
+	const std::vector<glm::mat4>& Transforms = Commands.getTransforms();
+	const std::vector<InstanceAnimation>& Animations = Commands.getAnimations();
+	GLuint BaseInstance = 0;
+	if (!Transforms.empty())
 	{
-		glUniformMatrix4fv(MvpLocation, 1, GL_FALSE, value_ptr(Mvp));
+		BaseInstance = MStream.reserve(Transforms.size());
+		MStats.Commands.WaitMilliseconds += MStream.getWaitMilliseconds();
+		MStream.write(BaseInstance, Transforms.data(), Animations.empty() ? nullptr : Animations.data(),
+		              Transforms.size());
 	}
+	Commands.replay(Queue, Bucket, MStream.getTransformBuffer(), MStream.getAnimationBuffer(), BaseInstance);
+
+	for (const RecordedDraw& Draw : Commands.getDraws())
+	{
+		// The render stats count the instanced draws, the moving object isn't among them
+		const DrawPacket& Packet = Draw.Packet;
+		if (Packet.InstanceCount == 0)
+		{
+			continue;
+		}
+		const GLsizei Triangles = Packet.Mode == GL_TRIANGLE_STRIP ? Packet.Count - 2 : Packet.Count / 3;
+		MStats.DrawCalls++;
+		MStats.Triangles += static_cast<unsigned long long>(Packet.InstanceCount) * Triangles;
+	}
+	MStats.Commands.Buffers++;
+	MStats.Commands.Packets += static_cast<unsigned int>(Commands.getDraws().size());
+	MStats.Commands.Instances += static_cast<unsigned int>(Transforms.size());
+	MStats.Commands.RecordMilliseconds += Commands.getRecordMilliseconds();
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	MStats.Commands.ExecuteMilliseconds += Elapsed.count();
+}
+
+void Renderer::queueScene(RenderQueue& Queue, const BucketId Bucket, const GLuint ShaderProgram, const Model& Model,
+                          InstancePool& Instances, const PreparedScene& Prepared)
+{
+	beginScene(Model, Instances, Prepared);
+	MCommands.begin();
+	recordScene(MCommands, ShaderProgram, Model, Instances, Prepared);
+	MCommands.end();
+	execute(Queue, Bucket, MCommands);
+}
+
+void Renderer::queueMovingObject(RenderQueue& Queue, const BucketId Bucket, const GLuint ShaderProgram,
+                                 const Model& MovingObjectModel)
+{
+	MCommands.begin();
+	recordMovingObject(MCommands, ShaderProgram, MovingObjectModel);
+	MCommands.end();
+	execute(Queue, Bucket, MCommands);
+}
+
+void Renderer::queueSwarm(RenderQueue& Queue, const BucketId Bucket, const GLuint ShaderProgram)
+{
+	MCommands.begin();
+	recordSwarm(MCommands, ShaderProgram);
+	MCommands.end();
+	execute(Queue, Bucket, MCommands);
+}
+
+void Renderer::submit(RenderQueue& Queue)
+{
+	const ProfileScope Scope("draw queue", true);
+	Queue.sort();
+	Queue.submit(*MBackend);
+	MBackend->flush();
+	MStream.finishRegion();
+	MStats.Queue = Queue.getStats();
+	MStats.State = GlState::getStats();
+	MStats.Backend = MBackend->getStats();
+	MBackend->checkErrors("submit");
+}
+
+void Renderer::renderScene(const GLuint ShaderProgram, const Model& Model, InstancePool& Instances,
+                           const PreparedScene& Prepared)
+{
+	const ProfileScope Scope("renderScene", true);
+	MQueue.clear();
+	queueScene(MQueue, MQueueBucket, ShaderProgram, Model, Instances, Prepared);
+	submit(MQueue);
+}
+
+void Renderer::renderScene(const GLuint ShaderProgram, const Model& Model, InstancePool& Instances)
+{
+	prepareScene(*MFrame, Model, Instances, MPrepared);
+	renderScene(ShaderProgram, Model, Instances, MPrepared);
+}
+
+void Renderer::renderMovingObject(const GLuint ShaderProgram, const Model& MovingObjectModel)
+{
+	const ProfileScope Scope("renderMovingObject", true);
+	MQueue.clear();
+	queueMovingObject(MQueue, MQueueBucket, ShaderProgram, MovingObjectModel);
+	submit(MQueue);
+}
+
+void Renderer::renderSwarm(const GLuint ShaderProgram)
+{
+	const ProfileScope Scope("renderSwarm", true);
+	MQueue.clear();
+	queueSwarm(MQueue, MQueueBucket, ShaderProgram);
+	submit(MQueue);
+}
 
-	// Bind the model's VAO and draw
-	glBindVertexArray(MovingObjectModel.Vao);
-	glDrawElements(GL_TRIANGLES, MovingObjectModel.IndexCount, GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
+glm::mat4 Renderer::getMovingObjectMatrix() const
+{
+	return getMovingObjectMatrix(MFrame->ObjectPosition);
+}
+
+glm::mat4 Renderer::getMovingObjectMatrix(const glm::vec3& Position)
+{
+	glm::mat4 ModelMatrix = translate(glm::mat4(1.0f), Position);
+
+	// Scale down the moving object
+	ModelMatrix = scale(ModelMatrix, glm::vec3(0.001f));
 
-	checkOpenGlError("renderMovingObject");
+	// Rotate the object to face the screen (+Z)
+	ModelMatrix = rotate(ModelMatrix, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	return ModelMatrix;
 }
 
 void Renderer::renderUiElement(const GLuint ShaderProgram) const
 {
+	const ProfileScope Scope("ui", true);
+
 	// UI rendering setup
 	const glm::mat4 OrthoProjection = glm::ortho(0.0f, static_cast<float>(MWidth), static_cast<float>(MHeight), 0.0f);
 	constexpr auto Model = glm::mat4(1.0f);
@@ -122,11 +476,23 @@ void Renderer::renderUiElement(const GLuint ShaderProgram) const
 
 void Renderer::processInput()
 {
+	// Held keys are read here only, so every fixed step of the frame sees the same input
+	MInput.Camera = Camera::sampleInput(MWindow);
+	MInput.Object = sampleObjectInput();
+
 	// Debouncing
 	static bool CursorToggled = false;
 	static bool WireframeToggled = false;
 	static bool MousePositionLogged = false;
 	static bool CameraModeToggled = false;
+	static bool LodToggled = false;
+	static bool StatsLogged = false;
+	static bool CullingToggled = false;
+	static bool ImpostorsToggled = false;
+	static bool OcclusionToggled = false;
+	static bool PickClicked = false;
+	static bool CollisionToggled = false;
+	static bool SwarmToggled = false;
 
 	// Cursor visibility toggle (1)
 	if (glfwGetKey(MWindow, GLFW_KEY_1) == GLFW_PRESS && !CursorToggled)
@@ -146,7 +512,7 @@ void Renderer::processInput()
 	{
 		static bool WireframeMode = false;
 		WireframeMode = !WireframeMode;
-		glPolygonMode(GL_FRONT_AND_BACK, WireframeMode ? GL_LINE : GL_FILL);
+		GlState::polygonMode(WireframeMode ? GL_LINE : GL_FILL);
 		WireframeToggled = true;
 	}
 	if (glfwGetKey(MWindow, GLFW_KEY_2) == GLFW_RELEASE)
@@ -167,10 +533,104 @@ void Renderer::processInput()
 		MousePositionLogged = false;
 	}
 
+	// Level of detail toggle (4)
+	if (glfwGetKey(MWindow, GLFW_KEY_4) == GLFW_PRESS && !LodToggled)
+	{
+		MLodEnabled = !MLodEnabled;
+		std::cout << "LOD " << (MLodEnabled ? "enabled" : "disabled") << "\n";
+		LodToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_4) == GLFW_RELEASE)
+	{
+		LodToggled = false;
+	}
+
+	// Render stats log (5)
+	if (glfwGetKey(MWindow, GLFW_KEY_5) == GLFW_PRESS && !StatsLogged)
+	{
+		printStats();
+		StatsLogged = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_5) == GLFW_RELEASE)
+	{
+		StatsLogged = false;
+	}
+
+	// Frustum and contribution culling toggle (6)
+	if (glfwGetKey(MWindow, GLFW_KEY_6) == GLFW_PRESS && !CullingToggled)
+	{
+		MCullingEnabled = !MCullingEnabled;
+		std::cout << "Culling " << (MCullingEnabled ? "enabled" : "disabled") << "\n";
+		CullingToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_6) == GLFW_RELEASE)
+	{
+		CullingToggled = false;
+	}
+
+	// Far field impostor toggle (7)
+	if (glfwGetKey(MWindow, GLFW_KEY_7) == GLFW_PRESS && !ImpostorsToggled)
+	{
+		MImpostorsEnabled = !MImpostorsEnabled;
+		std::cout << "Impostors " << (MImpostorsEnabled ? "enabled" : "disabled") << "\n";
+		ImpostorsToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_7) == GLFW_RELEASE)
+	{
+		ImpostorsToggled = false;
+	}
+
+	// Occlusion culling toggle (8)
+	if (glfwGetKey(MWindow, GLFW_KEY_8) == GLFW_PRESS && !OcclusionToggled)
+	{
+		MOcclusionEnabled = !MOcclusionEnabled;
+		std::cout << "Occlusion culling " << (MOcclusionEnabled ? "enabled" : "disabled") << "\n";
+		OcclusionToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_8) == GLFW_RELEASE)
+	{
+		OcclusionToggled = false;
+	}
+
+	// Moving object collision toggle (9)
+	if (glfwGetKey(MWindow, GLFW_KEY_9) == GLFW_PRESS && !CollisionToggled)
+	{
+		MCollisionEnabled = !MCollisionEnabled;
+		std::cout << "Collision " << (MCollisionEnabled ? "enabled" : "disabled") << "\n";
+		CollisionToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_9) == GLFW_RELEASE)
+	{
+		CollisionToggled = false;
+	}
+
+	// Swarm pause toggle (0)
+	if (glfwGetKey(MWindow, GLFW_KEY_0) == GLFW_PRESS && !SwarmToggled)
+	{
+		MSwarmRunning = !MSwarmRunning;
+		std::cout << "Swarm " << (MSwarmRunning ? "running" : "paused") << "\n";
+		SwarmToggled = true;
+	}
+	if (glfwGetKey(MWindow, GLFW_KEY_0) == GLFW_RELEASE)
+	{
+		SwarmToggled = false;
+	}
+
+	// Pick the instance or moving object under the cursor (left mouse button)
+	if (glfwGetMouseButton(MWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !PickClicked)
+	{
+		pickUnderCursor();
+		PickClicked = true;
+	}
+	if (glfwGetMouseButton(MWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE)
+	{
+		PickClicked = false;
+	}
+
 	// Toggle automatic camera (space)
 	if (glfwGetKey(MWindow, GLFW_KEY_SPACE) == GLFW_PRESS && !CameraModeToggled)
 	{
-		MCamera.toggleMode();
+		toggleCameraMode();
 		CameraModeToggled = false;
 		// Needs to be false then true below for some reason or it won't work. Maybe the way I coded it?
 	}
@@ -180,46 +640,143 @@ void Renderer::processInput()
 	}
 }
 
-void Renderer::processObjectMovement(const float DeltaTime)
+glm::vec3 Renderer::sampleObjectInput() const
 {
-	const float MovementSpeed = 5.0f * DeltaTime;
-
 	// *ISSUES* with implementing movement based off the camera's view. Opted for fixed.
 	// Fix movement regardless of camera rotation
 	constexpr auto WorldX = glm::vec3(0.0f, 0.0f, -1.0f); // Fixed forward (X) direction
 	constexpr auto WorldZ = glm::vec3(1.0f, 0.0f, 0.0f); // Fixed right (Z) direction
 	constexpr auto WorldY = glm::vec3(0.0f, 1.0f, 0.0f); // Fixed up (Y) direction
 
+	glm::vec3 Direction(0.0f);
 	// +X movement
 	if (glfwGetKey(MWindow, GLFW_KEY_A) == GLFW_PRESS)
 	{
-		MObjectPosition += WorldX * MovementSpeed;
+		Direction += WorldX;
 	}
 	// -X movement
 	if (glfwGetKey(MWindow, GLFW_KEY_D) == GLFW_PRESS)
 	{
-		MObjectPosition -= WorldX * MovementSpeed;
+		Direction -= WorldX;
 	}
 	// -Z movement
 	if (glfwGetKey(MWindow, GLFW_KEY_S) == GLFW_PRESS)
 	{
-		MObjectPosition -= WorldZ * MovementSpeed;
+		Direction -= WorldZ;
 	}
 	// +Z movement
 	if (glfwGetKey(MWindow, GLFW_KEY_W) == GLFW_PRESS)
 	{
-		MObjectPosition += WorldZ * MovementSpeed;
+		Direction += WorldZ;
 	}
 	// +Y movement
 	if (glfwGetKey(MWindow, GLFW_KEY_E) == GLFW_PRESS)
 	{
-		MObjectPosition += WorldY * MovementSpeed;
+		Direction += WorldY;
 	}
 	// -Y movement
 	if (glfwGetKey(MWindow, GLFW_KEY_Q) == GLFW_PRESS)
 	{
-		MObjectPosition -= WorldY * MovementSpeed;
+		Direction -= WorldY;
+	}
+	return Direction;
+}
+
+void Renderer::pickUnderCursor() const
+{
+	int WindowWidth, WindowHeight;
+	glfwGetWindowSize(MWindow, &WindowWidth, &WindowHeight);
+	if (WindowWidth <= 0 || WindowHeight <= 0)
+	{
+		return;
+	}
+
+	// With the cursor hidden (1) the pick goes through the centre of the screen
+	double Xpos = WindowWidth * 0.5, Ypos = WindowHeight * 0.5;
+	if (glfwGetInputMode(MWindow, GLFW_CURSOR) == GLFW_CURSOR_NORMAL)
+	{
+		glfwGetCursorPos(MWindow, &Xpos, &Ypos);
+	}
+
+	glm::vec3 Origin, Direction;
+	MFrame->Viewpoint.getCursorRay(Xpos, Ypos, WindowWidth, WindowHeight, Origin, Direction);
+	const PickHit Hit = MPicker.pick(Origin, Direction, getMovingObjectMatrix(), MFrame->AnimationTime);
+	switch (Hit.Target)
+	{
+	case PickTarget::Instance:
+		std::cout << "Picked instance " << Hit.Instance << " (slot " << Hit.Handle.Slot << ", generation "
+			<< Hit.Handle.Generation << ")";
+		break;
+	case PickTarget::MovingObject:
+		std::cout << "Picked the moving object";
+		break;
+	default:
+		std::cout << "Nothing under the cursor (" << Hit.Microseconds << " us)\n";
+		return;
+	}
+	std::cout << " at " << Hit.Distance << " units, (" << Hit.Position.x << ", " << Hit.Position.y << ", "
+		<< Hit.Position.z << ") in " << Hit.Microseconds << " us\n";
+}
+
+void Renderer::applyFading(SceneUniforms& Uniforms, const Model& Model, const PreparedScene& Prepared) const
+{
+	Uniforms.Fading = true;
+	Uniforms.CameraPosition = Prepared.Frame->Viewpoint.getPosition();
+	Uniforms.Bounds = glm::vec4(Model.BoundsCenter, Model.BoundsRadius);
+	Uniforms.ProjectionScale = Prepared.ProjectionScale;
+	Uniforms.FadeRange = glm::vec2(MImpostorPixelDiameter, MImpostorPixelDiameter * ImpostorFadeRatio);
+}
+
+void Renderer::setSceneUniforms(const GLuint Program, const SceneUniforms& Uniforms)
+{
+	const GLint MvpLocation = glGetUniformLocation(Program, "mvp");
+	if (MvpLocation == -1)
+	{
+		std::cerr << "Could not find uniform location for 'mvp'" << std::endl;
+	}
+	else
+	{
+		glUniformMatrix4fv(MvpLocation, 1, GL_FALSE, value_ptr(Uniforms.Mvp));
+	}
+	glUniform1i(glGetUniformLocation(Program, "instanced"), Uniforms.Instanced ? GL_TRUE : GL_FALSE);
+	glUniform1i(glGetUniformLocation(Program, "animated"), Uniforms.Animated ? GL_TRUE : GL_FALSE);
+	glUniform1f(glGetUniformLocation(Program, "time"), Uniforms.Time);
+	setFadeUniforms(Program, Uniforms);
+}
+
+void Renderer::setFadeUniforms(const GLuint Program, const SceneUniforms& Uniforms)
+{
+	glUniform1i(glGetUniformLocation(Program, "fading"), Uniforms.Fading ? GL_TRUE : GL_FALSE);
+	if (!Uniforms.Fading)
+	{
+		return;
 	}
+	glUniform3fv(glGetUniformLocation(Program, "cameraPosition"), 1, value_ptr(Uniforms.CameraPosition));
+	glUniform4fv(glGetUniformLocation(Program, "bounds"), 1, value_ptr(Uniforms.Bounds));
+	glUniform1f(glGetUniformLocation(Program, "projectionScale"), Uniforms.ProjectionScale);
+	glUniform2fv(glGetUniformLocation(Program, "fadeRange"), 1, value_ptr(Uniforms.FadeRange));
+}
+
+void Renderer::recordImpostors(CommandBuffer& Commands, const SceneUniforms& Scene, const PreparedScene& Prepared,
+                               const unsigned int BaseInstance) const
+{
+	const bool Animated = !Prepared.ImpostorAnimations.empty();
+	const int GridSize = MImpostorAtlas->GridSize;
+	const std::uint32_t Set = Commands.addUniforms([Scene, Animated, GridSize](const GLuint Program)
+	{
+		glUniformMatrix4fv(glGetUniformLocation(Program, "viewProjection"), 1, GL_FALSE, value_ptr(Scene.Mvp));
+		glUniform1i(glGetUniformLocation(Program, "gridSize"), GridSize);
+		glUniform1i(glGetUniformLocation(Program, "animated"), Animated ? GL_TRUE : GL_FALSE);
+		glUniform1f(glGetUniformLocation(Program, "time"), Scene.Time);
+		setFadeUniforms(Program, Scene);
+	});
+
+	const auto Count = static_cast<unsigned int>(Prepared.ImpostorTransforms.size());
+	Commands.push(RenderQueue::makeKey(RenderPass::Impostor, MImpostorProgram, MImpostorAtlas->Texture,
+	                                   MImpostorAtlas->QuadVao, 1.0f),
+	              {MImpostorProgram, MImpostorAtlas->Texture, MImpostorAtlas->QuadVao, CommandBuffer::RecordedInstances,
+	               Animated ? CommandBuffer::RecordedInstances : 0, GL_TRIANGLE_STRIP, false, 4, 0,
+	               static_cast<GLsizei>(Count), BaseInstance, Set});
 }
 
 bool Renderer::isMouseOverQuad(const double MouseX, const double MouseY, const float QuadX, const float QuadY,
@@ -237,13 +794,169 @@ void Renderer::checkOpenGlError(const std::string& Stmt)
 	}
 }
 
-Camera& Renderer::getCamera()
+SimulationInput Renderer::takeSimulationInput()
 {
-	return MCamera;
+	MInput.CollisionEnabled = MCollisionEnabled;
+	MInput.SwarmRunning = MSwarmRunning;
+	const SimulationInput Input = MInput;
+	MInput.CameraModeToggles = 0;
+	return Input;
+}
+
+void Renderer::toggleCameraMode()
+{
+	MInput.CameraModeToggles++;
+}
+
+const Camera& Renderer::getCamera() const
+{
+	return MFrame->Viewpoint;
 }
 
 void Renderer::updateWindowSize(const int Width, const int Height)
 {
 	this->MWidth = Width;
 	this->MHeight = Height;
+	MOcclusionCuller.setViewport(Width, Height);
+}
+
+void Renderer::setMinPixelDiameter(const float PixelDiameter)
+{
+	MCullSettings.MinPixelDiameter = PixelDiameter;
+}
+
+void Renderer::setImpostors(const ImpostorAtlas& Atlas, const GLuint ImpostorProgram)
+{
+	MImpostorAtlas = &Atlas;
+	MImpostorProgram = ImpostorProgram;
+}
+
+void Renderer::setImpostorsEnabled(const bool Enabled)
+{
+	MImpostorsEnabled = Enabled;
+}
+
+void Renderer::setImpostorPixelDiameter(const float PixelDiameter)
+{
+	MImpostorPixelDiameter = PixelDiameter;
+}
+
+void Renderer::setOcclusionEnabled(const bool Enabled)
+{
+	MOcclusionEnabled = Enabled;
+}
+
+void Renderer::setMovingObjectOccluder(const Model& MovingObjectModel)
+{
+	MMovingObjectOccluder = &MovingObjectModel;
+}
+
+void Renderer::setPickModels(const Model& InstanceModel, const Model& MovingObjectModel)
+{
+	MPicker.setModels(InstanceModel, MovingObjectModel);
+}
+
+void Renderer::setCollisionEnabled(const bool Enabled)
+{
+	MCollisionEnabled = Enabled;
+}
+
+void Renderer::setSwarmModel(const Model& ShipModel)
+{
+	MSwarmModel = &ShipModel;
+
+	// Instance matrix format only, the swarm's packets point it at the instance stream. Until then it reads a
+	// lone identity matrix, which the moving object's non-instanced draw ignores
+	if (MDefaultInstance == 0)
+	{
+		constexpr auto Identity = glm::mat4(1.0f);
+		glCreateBuffers(1, &MDefaultInstance);
+		glNamedBufferStorage(MDefaultInstance, sizeof(glm::mat4), &Identity, 0);
+	}
+	for (GLuint I = 0; I < 4; I++)
+	{
+		glEnableVertexArrayAttrib(ShipModel.Vao, 3 + I);
+		glVertexArrayAttribFormat(ShipModel.Vao, 3 + I, 4, GL_FLOAT, GL_FALSE, 0);
+		glVertexArrayAttribBinding(ShipModel.Vao, 3 + I, 3 + I);
+		glVertexArrayBindingDivisor(ShipModel.Vao, 3 + I, 1);
+	}
+	RenderQueue::bindInstanceSource(ShipModel.Vao, MDefaultInstance);
+}
+
+void Renderer::setSwarmRunning(const bool Running)
+{
+	MSwarmRunning = Running;
+}
+
+void Renderer::setBackend(RenderBackend& Backend)
+{
+	MBackend = &Backend;
+	MStream.setBackend(Backend);
+}
+
+RenderBackend& Renderer::getBackend() const
+{
+	return *MBackend;
+}
+
+const RenderStats& Renderer::getStats() const
+{
+	return MStats;
+}
+
+void Renderer::printStats() const
+{
+	std::cout << "Render stats (LOD " << (MLodEnabled ? "on" : "off") << ", culling "
+		<< (MCullingEnabled ? "on" : "off") << ", impostors " << (MImpostorsEnabled ? "on" : "off") << ", occlusion "
+		<< (MOcclusionEnabled ? "on" : "off") << ")\n";
+	std::cout << "  Draw calls          : " << MStats.DrawCalls << "\n";
+	std::cout << "  Instances           : " << MStats.Instances << "\n";
+	std::cout << "  Triangles submitted : " << MStats.Triangles << "\n";
+	std::cout << "  Triangles at LOD 0  : " << MStats.TrianglesWithoutLod << "\n";
+	std::cout << "  Instances per LOD   :";
+	for (const unsigned int Count : MStats.LodInstances)
+	{
+		std::cout << " " << Count;
+	}
+	std::cout << "\n";
+	std::cout << "  Impostors           : " << MStats.ImpostorInstances << "\n";
+	std::cout << "  Culling             : " << MStats.Culling.Tested << " tested, " << MStats.Culling.FrustumCulled
+		<< " outside frustum, " << MStats.Culling.ContributionCulled << " under " << MCullSettings.MinPixelDiameter
+		<< " px, " << MStats.Culling.Visible << " visible in " << MStats.Culling.Milliseconds << " ms\n";
+	std::cout << "  Occlusion           : " << MStats.Occlusion.Occluders << " occluders (" <<
+		MStats.Occlusion.OccluderTriangles << " triangles) rasterised in " << MStats.Occlusion.RasterMilliseconds
+		<< " ms, " << MStats.Occlusion.Occluded << " of " << MStats.Occlusion.Tested << " hidden in "
+		<< MStats.Occlusion.TestMilliseconds << " ms\n";
+	std::cout << "  Collision           : " << (MCollisionEnabled ? "on, " : "off, ") << MStats.Collision.Candidates
+		<< " candidates from " << MStats.Collision.CellsVisited << " cells, " << MStats.Collision.Contacts
+		<< " contacts in " << MStats.Collision.QueryMilliseconds << " ms\n";
+	std::cout << "  Swarm               : " << MStats.Swarm.Agents << " agents (" << (MSwarmRunning ? "running" : "paused")
+		<< "), " << MStats.Swarm.Neighbours << " neighbours each, hash " << MStats.Swarm.HashMilliseconds
+		<< " ms, steer " << MStats.Swarm.SteerMilliseconds << " ms, integrate " << MStats.Swarm.IntegrateMilliseconds
+		<< " ms, transforms " << MStats.Swarm.TransformMilliseconds << " ms\n";
+	std::cout << "  Simulation          : " << MStats.SimulationSteps << " fixed steps last frame, drawn "
+		<< MStats.Interpolation << " of the way into the latest\n";
+	std::cout << "  Pipeline            : " << (MStats.Pipeline.Threaded ? "threaded" : "serial") << ", simulation "
+		<< MStats.Pipeline.SimulationMilliseconds << " ms, render " << MStats.Pipeline.RenderMilliseconds
+		<< " ms, waited " << MStats.Pipeline.WaitMilliseconds << " ms, frame " << MStats.Pipeline.FrameMilliseconds
+		<< " ms\n";
+	std::cout << "  Command buffers     : " << MStats.Commands.Buffers << " executed, " << MStats.Commands.Packets
+		<< " packets, " << MStats.Commands.Instances << " instances streamed, recorded in "
+		<< MStats.Commands.RecordMilliseconds << " ms, executed in " << MStats.Commands.ExecuteMilliseconds
+		<< " ms on the GL thread (" << MStats.Commands.WaitMilliseconds << " ms waiting on the GPU)\n";
+	std::cout << "  Render queue        : " << MStats.Queue.Packets << " packets, " << MStats.Queue.Draws << " draws, "
+		<< MStats.Queue.StateChanges << " state changes (" << MStats.Queue.ProgramBinds << " programs, "
+		<< MStats.Queue.TextureBinds << " textures, " << MStats.Queue.VaoBinds << " VAOs, " << MStats.Queue.SourceBinds
+		<< " instance sources, " << MStats.Queue.UniformSets << " uniform sets), sorted in "
+		<< MStats.Queue.SortMilliseconds << " ms, submitted in " << MStats.Queue.SubmitMilliseconds << " ms\n";
+	std::cout << "  GL state            : " << MStats.State.TotalIssued << " calls issued, " << MStats.State.TotalFiltered
+		<< " filtered as already current (" << MStats.State.Issued[static_cast<int>(GlStateCall::Program)] << "/"
+		<< MStats.State.Filtered[static_cast<int>(GlStateCall::Program)] << " programs, "
+		<< MStats.State.Issued[static_cast<int>(GlStateCall::Texture)] << "/"
+		<< MStats.State.Filtered[static_cast<int>(GlStateCall::Texture)] << " textures, "
+		<< MStats.State.Issued[static_cast<int>(GlStateCall::VertexArray)] << "/"
+		<< MStats.State.Filtered[static_cast<int>(GlStateCall::VertexArray)] << " VAOs)\n";
+	std::cout << "  Backend             : " << MBackend->getName() << ", " << MStats.Backend.Draws << " draws of "
+		<< MStats.Backend.Elements << " elements, " << MStats.Backend.Invalid << " invalid commands dropped, "
+		<< MStats.Backend.Skipped << " skipped\n";
 }
@@ -14,6 +14,8 @@ Mail : ayoub.ahmad@mds.ac.nz
 **************************************************************************/
 
 #include "ShaderLoader.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
 
 ShaderLoader::ShaderLoader() = default;
 
@@ -21,6 +23,8 @@ ShaderLoader::~ShaderLoader() = default;
 
 GLuint ShaderLoader::createProgram(const char* VertexShaderFilename, const char* FragmentShaderFilename)
 {
+	const ProfileScope Scope("load shaders", true);
+
 	// Create shaders using .frag and .vert external files
 	const GLuint VertexShaderId = createShader(GL_VERTEX_SHADER, VertexShaderFilename);
 	const GLuint FragmentShaderId = createShader(GL_FRAGMENT_SHADER, FragmentShaderFilename);
@@ -49,6 +53,8 @@ GLuint ShaderLoader::createProgram(const char* VertexShaderFilename, const char*
 
 GLuint ShaderLoader::createShader(const GLenum ShaderType, const char* ShaderName)
 {
+	const TraceScope Trace(TraceCategory::Asset, "compile shader", ShaderName);
+
 	// Read the shader files and save the source code as strings
 	const std::string ShaderSourceCode = readShaderFile(ShaderName);
 
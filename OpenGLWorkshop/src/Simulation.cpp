@@ -0,0 +1,143 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : Simulation.cpp
+Description : Implementations for the simulated world, stepped on a
+			  fixed timestep and posed into snapshots for the renderer
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "Simulation.h"
+
+#include <chrono>
+
+#include "Renderer.h"
+
+Simulation::Simulation()
+	: MFrame(0), MInput{}, MObjectPosition(0.0f), MPreviousObjectPosition(0.0f), MInstances(nullptr),
+	  MInstanceModel(nullptr), MMovingObjectModel(nullptr), MSwarm(nullptr)
+{
+	MInput.CollisionEnabled = true;
+	MInput.SwarmRunning = true;
+}
+
+void Simulation::setInstances(const InstancePool& Instances, const Model& Model)
+{
+	MInstances = &Instances;
+	MInstanceModel = &Model;
+}
+
+void Simulation::setMovingObject(const Model& MovingObjectModel)
+{
+	MMovingObjectModel = &MovingObjectModel;
+}
+
+void Simulation::setSwarm(FlockSimulation& Swarm)
+{
+	MSwarm = &Swarm;
+}
+
+void Simulation::runFrame(const SimulationInput& Input, const double Now, FrameSnapshot& Snapshot)
+{
+	const auto Start = std::chrono::steady_clock::now();
+	setInput(Input);
+	const int Steps = MClock.beginFrame(Now);
+	for (int Step = 0; Step < Steps; Step++)
+	{
+		step(MClock.getStep());
+	}
+	capture(MClock.getAlpha(), static_cast<float>(MClock.getRenderTime()), Snapshot);
+	Snapshot.Steps = static_cast<unsigned int>(Steps);
+
+	const std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Start;
+	Snapshot.SimulationMilliseconds = Elapsed.count();
+}
+
+void Simulation::step(const float DeltaTime)
+{
+	MCamera.update(DeltaTime, MInput.Camera);
+
+	// The moving object, at a fixed five units a second along whatever keys are held this frame
+	MPreviousObjectPosition = MObjectPosition;
+	MObjectPosition += MInput.Object * (5.0f * DeltaTime);
+	if (MInput.CollisionEnabled && MInstances != nullptr && MMovingObjectModel != nullptr)
+	{
+		resolveCollisions();
+	}
+
+	if (MSwarm != nullptr && MInput.SwarmRunning)
+	{
+		MSwarm->step(DeltaTime);
+	}
+}
+
+void Simulation::capture(const float Alpha, const float Time, FrameSnapshot& Snapshot)
+{
+	MCamera.interpolate(Alpha);
+	Snapshot.Frame = MFrame++;
+	Snapshot.Viewpoint = MCamera;
+	Snapshot.ObjectPosition = mix(MPreviousObjectPosition, MObjectPosition, Alpha);
+	Snapshot.AnimationTime = Time;
+	Snapshot.Interpolation = Alpha;
+	Snapshot.Steps = 0;
+	Snapshot.Collision = MCollisionGrid.getStats();
+	Snapshot.ContactEvents.swap(MContactEvents);
+	MContactEvents.clear();
+
+	Snapshot.SwarmTransforms.clear();
+	Snapshot.Swarm = {};
+	if (MSwarm != nullptr)
+	{
+		// A paused swarm holds its last state rather than blending towards it again
+		MSwarm->interpolate(MInput.SwarmRunning ? Alpha : 1.0f);
+		Snapshot.SwarmTransforms = MSwarm->getTransforms();
+		Snapshot.Swarm = MSwarm->getStats();
+	}
+}
+
+void Simulation::setInput(const SimulationInput& Input)
+{
+	if (Input.CameraModeToggles % 2 != 0)
+	{
+		MCamera.toggleMode();
+	}
+	MInput = Input;
+}
+
+const glm::vec3& Simulation::getObjectPosition() const
+{
+	return MObjectPosition;
+}
+
+const FrameClock& Simulation::getClock() const
+{
+	return MClock;
+}
+
+void Simulation::resolveCollisions()
+{
+	MCollisionGrid.sync(*MInstances, *MInstanceModel);
+
+	// Collides the simulated position, the drawn one trails it by up to a step
+	const BvhBounds Box = InstanceBvh::transformBounds(MMovingObjectModel->BoundsMin, MMovingObjectModel->BoundsMax,
+	                                                   Renderer::getMovingObjectMatrix(MObjectPosition));
+	MCollisionGrid.collide(Box);
+
+	// Push the object back out along every contact so it can't fly through the field
+	glm::vec3 Correction(0.0f);
+	for (const Contact& Hit : MCollisionGrid.getContacts())
+	{
+		Correction -= Hit.Normal * Hit.Depth;
+	}
+	MObjectPosition += Correction;
+
+	// Reported by the render thread once the frame is drawn
+	const std::vector<ContactEvent>& Events = MCollisionGrid.getEvents();
+	MContactEvents.insert(MContactEvents.end(), Events.begin(), Events.end());
+}
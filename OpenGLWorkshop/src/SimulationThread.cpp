@@ -0,0 +1,122 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SimulationThread.cpp
+Description : Implementations for running the simulation a frame ahead
+			  of rendering on its own thread through double-buffered
+			  snapshots
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "SimulationThread.h"
+
+SimulationThread::SimulationThread(Simulation& World, const bool Threaded)
+	: MWorld(World), MReading(0), MPending(false), MReady(false), MStopping(false), MInput{}, MNow(0.0), MStats{},
+	  MAcquired(false)
+{
+	MWorld.capture(1.0f, 0.0f, MSnapshots[MReading]);
+	MStats.Threaded = Threaded;
+	if (Threaded)
+	{
+		MThread = std::thread(&SimulationThread::run, this);
+	}
+}
+
+SimulationThread::~SimulationThread()
+{
+	if (MThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(MMutex);
+			MStopping = true;
+		}
+		MSubmitted.notify_one();
+		MThread.join();
+	}
+}
+
+const FrameSnapshot& SimulationThread::acquire()
+{
+	const auto Start = std::chrono::steady_clock::now();
+	{
+		std::unique_lock<std::mutex> Lock(MMutex);
+		MFinished.wait(Lock, [this] { return !MPending; });
+		if (MReady)
+		{
+			MReading = 1 - MReading;
+			MReady = false;
+		}
+	}
+	const auto End = std::chrono::steady_clock::now();
+
+	// The caller's stage runs from one acquire returning to the next being called
+	const FrameSnapshot& Snapshot = MSnapshots[MReading];
+	MStats.SimulationMilliseconds = Snapshot.SimulationMilliseconds;
+	MStats.WaitMilliseconds = std::chrono::duration<double, std::milli>(End - Start).count();
+	if (MAcquired)
+	{
+		MStats.FrameMilliseconds = std::chrono::duration<double, std::milli>(End - MLastAcquire).count();
+		MStats.RenderMilliseconds = MStats.FrameMilliseconds - MStats.WaitMilliseconds;
+		if (!MStats.Threaded)
+		{
+			MStats.RenderMilliseconds -= Snapshot.SimulationMilliseconds;
+		}
+	}
+	MLastAcquire = End;
+	MAcquired = true;
+	return Snapshot;
+}
+
+void SimulationThread::submit(const SimulationInput& Input, const double Now)
+{
+	if (!MStats.Threaded)
+	{
+		MWorld.runFrame(Input, Now, MSnapshots[1 - MReading]);
+		MReady = true;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(MMutex);
+		MInput = Input;
+		MNow = Now;
+		MPending = true;
+	}
+	MSubmitted.notify_one();
+}
+
+const PipelineStats& SimulationThread::getStats() const
+{
+	return MStats;
+}
+
+void SimulationThread::run()
+{
+	std::unique_lock<std::mutex> Lock(MMutex);
+	while (true)
+	{
+		MSubmitted.wait(Lock, [this] { return MPending || MStopping; });
+		if (MStopping)
+		{
+			return;
+		}
+
+		// The caller only swaps buffers in acquire, which waits for this frame first
+		const SimulationInput Input = MInput;
+		const double Now = MNow;
+		FrameSnapshot& Target = MSnapshots[1 - MReading];
+		Lock.unlock();
+		MWorld.runFrame(Input, Now, Target);
+		Lock.lock();
+
+		MPending = false;
+		MReady = true;
+		MFinished.notify_one();
+	}
+}
@@ -0,0 +1,970 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SoftwareBackend.cpp
+Description : Implementations for a backend rasterising on the CPU, binned
+			  into screen tiles and shaded eight pixels at a time
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "SoftwareBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "GlState.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+namespace
+{
+	constexpr GLbitfield ClearBits = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+	constexpr GLuint MaxTextureUnits = 32;
+	constexpr std::size_t VertexFloats = 5; // Position then texture coordinate, as ModelLoader lays them out
+	constexpr std::size_t ChunkTriangles = 8192; // Roughly, chunks hold whole instances
+	constexpr std::uint32_t ClearColour = 0xff000000; // Opaque black, as the app clears to
+	constexpr std::uint8_t NearOutcode = 1 << 4; // z below -w. Bits are below then above -w and w, for x, y then z
+
+	// Value at each corner as a plane over the screen, A * X + B * Y + C
+	void setPlane(float (&Plane)[3], const float (&Value)[3], const float (&X)[3], const float (&Y)[3],
+	              const float InverseArea)
+	{
+		Plane[0] = ((Value[1] - Value[0]) * (Y[2] - Y[0]) - (Value[2] - Value[0]) * (Y[1] - Y[0])) * InverseArea;
+		Plane[1] = ((Value[2] - Value[0]) * (X[1] - X[0]) - (Value[1] - Value[0]) * (X[2] - X[0])) * InverseArea;
+		Plane[2] = Value[0] - Plane[0] * X[0] - Plane[1] * Y[0];
+	}
+
+	// Of a value no less than 0, where truncating is flooring
+	int ceilToInt(const float Value)
+	{
+		const int Truncated = static_cast<int>(Value);
+		return static_cast<float>(Truncated) < Value ? Truncated + 1 : Truncated;
+	}
+
+	// Texel for a repeating texture coordinate, nearest to it
+	std::uint32_t sampleScalar(const std::uint32_t* Texels, const int Width, const int Height, const float U,
+	                           const float V)
+	{
+		const int X = std::min(static_cast<int>((U - std::floor(U)) * static_cast<float>(Width)), Width - 1);
+		const int Y = std::min(static_cast<int>((V - std::floor(V)) * static_cast<float>(Height)), Height - 1);
+		return Texels[static_cast<std::size_t>(Y) * Width + X];
+	}
+}
+
+// Pixels [ColBegin, ColEnd] of rows [RowBegin, RowEnd], one at a time. Pixel centres are at half coordinates
+[[maybe_unused]] static void rasteriseScalar(const RasterTriangle& Triangle, const std::uint32_t* Texels,
+                                            const int TexWidth, const int TexHeight, std::uint32_t* Colour,
+                                            float* Depth, const int Stride, const int ColBegin, const int ColEnd,
+                                            const int RowBegin, const int RowEnd)
+{
+	for (int Y = RowBegin; Y <= RowEnd; Y++)
+	{
+		const float CentreY = static_cast<float>(Y) + 0.5f;
+		std::uint32_t* ColourRow = Colour + static_cast<std::size_t>(Y) * Stride;
+		float* DepthRow = Depth + static_cast<std::size_t>(Y) * Stride;
+		for (int X = ColBegin; X <= ColEnd; X++)
+		{
+			const float CentreX = static_cast<float>(X) + 0.5f;
+			bool Inside = true;
+			for (int Edge = 0; Edge < 3; Edge++)
+			{
+				const float Distance = Triangle.EdgeA[Edge] * CentreX + Triangle.EdgeB[Edge] * CentreY;
+				Inside &= Distance + Triangle.EdgeC[Edge] >= 0.0f;
+			}
+			const float Z = Triangle.Depth[0] * CentreX + Triangle.Depth[1] * CentreY + Triangle.Depth[2];
+			if (!Inside || !(Z < DepthRow[X]))
+			{
+				continue;
+			}
+			const float W = 1.0f / (Triangle.InverseW[0] * CentreX + Triangle.InverseW[1] * CentreY +
+				Triangle.InverseW[2]);
+			const float U = (Triangle.U[0] * CentreX + Triangle.U[1] * CentreY + Triangle.U[2]) * W;
+			const float V = (Triangle.V[0] * CentreX + Triangle.V[1] * CentreY + Triangle.V[2]) * W;
+			DepthRow[X] = Z;
+			ColourRow[X] = sampleScalar(Texels, TexWidth, TexHeight, U, V);
+		}
+	}
+}
+
+#if SIMD_X86
+// Eight pixels per step from ColBegin, which is a multiple of 8 in a row padded to one, so a step never leaves its
+// tile. Every value is evaluated from the pixel's own coordinates rather than stepped, so it is the same whichever
+// tile the pixel falls in
+SIMD_TARGET_AVX2 static void rasteriseAvx2(const RasterTriangle& Triangle, const std::uint32_t* Texels,
+                                           const int TexWidth, const int TexHeight, std::uint32_t* Colour,
+                                           float* Depth, const int Stride, const int ColBegin, const int ColEnd,
+                                           const int RowBegin, const int RowEnd)
+{
+	const __m256 LaneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 Zero = _mm256_setzero_ps();
+	const __m256 One = _mm256_set1_ps(1.0f);
+	const __m256 TexSize[2] = {_mm256_set1_ps(static_cast<float>(TexWidth)),
+	                           _mm256_set1_ps(static_cast<float>(TexHeight))};
+	const __m256 TexLast[2] = {_mm256_set1_ps(static_cast<float>(TexWidth - 1)),
+	                           _mm256_set1_ps(static_cast<float>(TexHeight - 1))};
+	const __m256i RowTexels = _mm256_set1_epi32(TexWidth);
+	__m256 EdgeA[3];
+	for (int Edge = 0; Edge < 3; Edge++)
+	{
+		EdgeA[Edge] = _mm256_set1_ps(Triangle.EdgeA[Edge]);
+	}
+	const __m256 DepthA = _mm256_set1_ps(Triangle.Depth[0]);
+	const __m256 InverseWA = _mm256_set1_ps(Triangle.InverseW[0]);
+	const __m256 UA = _mm256_set1_ps(Triangle.U[0]);
+	const __m256 VA = _mm256_set1_ps(Triangle.V[0]);
+
+	for (int Y = RowBegin; Y <= RowEnd; Y++)
+	{
+		const float CentreY = static_cast<float>(Y) + 0.5f;
+		__m256 EdgeRow[3];
+		for (int Edge = 0; Edge < 3; Edge++)
+		{
+			EdgeRow[Edge] = _mm256_set1_ps(Triangle.EdgeB[Edge] * CentreY + Triangle.EdgeC[Edge]);
+		}
+		const __m256 DepthRow = _mm256_set1_ps(Triangle.Depth[1] * CentreY + Triangle.Depth[2]);
+		const __m256 InverseWRow = _mm256_set1_ps(Triangle.InverseW[1] * CentreY + Triangle.InverseW[2]);
+		const __m256 URow = _mm256_set1_ps(Triangle.U[1] * CentreY + Triangle.U[2]);
+		const __m256 VRow = _mm256_set1_ps(Triangle.V[1] * CentreY + Triangle.V[2]);
+		std::uint32_t* ColourRow = Colour + static_cast<std::size_t>(Y) * Stride;
+		float* DepthValues = Depth + static_cast<std::size_t>(Y) * Stride;
+
+		for (int Column = ColBegin; Column <= ColEnd; Column += 8)
+		{
+			const __m256 X = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(Column)), LaneOffsets);
+			__m256 Inside = _mm256_cmp_ps(_mm256_fmadd_ps(EdgeA[0], X, EdgeRow[0]), Zero, _CMP_GE_OQ);
+			Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_fmadd_ps(EdgeA[1], X, EdgeRow[1]), Zero, _CMP_GE_OQ));
+			Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_fmadd_ps(EdgeA[2], X, EdgeRow[2]), Zero, _CMP_GE_OQ));
+			if (_mm256_movemask_ps(Inside) == 0)
+			{
+				continue;
+			}
+
+			const __m256 Z = _mm256_fmadd_ps(DepthA, X, DepthRow);
+			const __m256 OldDepth = _mm256_loadu_ps(DepthValues + Column);
+			const __m256 Passed = _mm256_and_ps(Inside, _mm256_cmp_ps(Z, OldDepth, _CMP_LT_OQ));
+			if (_mm256_movemask_ps(Passed) == 0)
+			{
+				continue;
+			}
+
+			// Texture coordinates over w divided by the interpolated 1 / w, wrapped into [0, 1)
+			const __m256 W = _mm256_div_ps(One, _mm256_fmadd_ps(InverseWA, X, InverseWRow));
+			__m256 U = _mm256_mul_ps(_mm256_fmadd_ps(UA, X, URow), W);
+			__m256 V = _mm256_mul_ps(_mm256_fmadd_ps(VA, X, VRow), W);
+			U = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(U, _mm256_floor_ps(U)), TexSize[0]), TexLast[0]);
+			V = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(V, _mm256_floor_ps(V)), TexSize[1]), TexLast[1]);
+			const __m256i Index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(V), RowTexels),
+			                                       _mm256_cvttps_epi32(U));
+
+			// Only lanes that passed are gathered, the rest may hold any index
+			const __m256i Texel = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(),
+			                                                  reinterpret_cast<const int*>(Texels), Index,
+			                                                  _mm256_castps_si256(Passed), 4);
+			auto* ColourBlock = reinterpret_cast<float*>(ColourRow + Column);
+			_mm256_storeu_ps(ColourBlock, _mm256_blendv_ps(_mm256_loadu_ps(ColourBlock), _mm256_castsi256_ps(Texel),
+			                                               Passed));
+			_mm256_storeu_ps(DepthValues + Column, _mm256_blendv_ps(OldDepth, Z, Passed));
+		}
+	}
+}
+#endif
+
+SoftwareBackend::SoftwareBackend(const unsigned int Width, const unsigned int Height, const unsigned int TileSize)
+	: MWidth(std::max(Width, 1u)), MHeight(std::max(Height, 1u)), MTileSize(std::max(TileSize / 8 * 8, 8u)),
+	  MTilesX(0), MTilesY(0), MStride(0), MAvx2(Simd::hasAvx2())
+{
+	layoutTiles();
+}
+
+void SoftwareBackend::addModel(const Model& Model)
+{
+	const bool Known = std::any_of(MMeshes.begin(), MMeshes.end(), [&Model](const Mesh& Candidate)
+	{
+		return Candidate.Vao == Model.Vao;
+	});
+	if (!Known)
+	{
+		Mesh Loaded{Model.Vao, {}, {}, {}};
+		GLint Size = 0;
+		glGetNamedBufferParameteriv(Model.Vbo, GL_BUFFER_SIZE, &Size);
+		Loaded.Vertices.resize(static_cast<std::size_t>(Size) / sizeof(float));
+		glGetNamedBufferSubData(Model.Vbo, 0, Size, Loaded.Vertices.data());
+		glGetNamedBufferParameteriv(Model.Ebo, GL_BUFFER_SIZE, &Size);
+		Loaded.Indices.resize(static_cast<std::size_t>(Size) / sizeof(unsigned int));
+		glGetNamedBufferSubData(Model.Ebo, 0, Size, Loaded.Indices.data());
+		MMeshes.push_back(std::move(Loaded));
+	}
+
+	if (Model.Texture != 0 && !findTexture(Model.Texture))
+	{
+		Texture Loaded{Model.Texture, 0, 0, {}};
+		glGetTextureLevelParameteriv(Model.Texture, 0, GL_TEXTURE_WIDTH, &Loaded.Width);
+		glGetTextureLevelParameteriv(Model.Texture, 0, GL_TEXTURE_HEIGHT, &Loaded.Height);
+		if (Loaded.Width > 0 && Loaded.Height > 0)
+		{
+			Loaded.Texels.resize(static_cast<std::size_t>(Loaded.Width) * Loaded.Height);
+			glGetTextureImage(Model.Texture, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+			                  static_cast<GLsizei>(Loaded.Texels.size() * sizeof(std::uint32_t)), Loaded.Texels.data());
+			MTextures.push_back(std::move(Loaded));
+		}
+	}
+}
+
+void SoftwareBackend::addInstancePool(const InstancePool& Pool)
+{
+	MPool = &Pool;
+}
+
+void SoftwareBackend::resize(const unsigned int Width, const unsigned int Height)
+{
+	if (std::max(Width, 1u) == MWidth && std::max(Height, 1u) == MHeight)
+	{
+		return;
+	}
+	flush();
+	MWidth = std::max(Width, 1u);
+	MHeight = std::max(Height, 1u);
+	layoutTiles();
+}
+
+void SoftwareBackend::setTileSize(const unsigned int TileSize)
+{
+	flush();
+	MTileSize = std::max(TileSize / 8 * 8, 8u);
+	layoutTiles();
+}
+
+void SoftwareBackend::setAvx2Enabled(const bool Enabled)
+{
+	flush();
+	MAvx2 = Enabled && Simd::hasAvx2();
+}
+
+unsigned int SoftwareBackend::getWidth() const
+{
+	return MWidth;
+}
+
+unsigned int SoftwareBackend::getHeight() const
+{
+	return MHeight;
+}
+
+unsigned int SoftwareBackend::getTileSize() const
+{
+	return MTileSize;
+}
+
+const SoftwareStats& SoftwareBackend::getRasterStats() const
+{
+	return MRasterStats;
+}
+
+void SoftwareBackend::readPixels(std::vector<std::uint32_t>& Pixels) const
+{
+	Pixels.resize(static_cast<std::size_t>(MWidth) * MHeight);
+	for (unsigned int Y = 0; Y < MHeight; Y++)
+	{
+		const auto Row = MColour.begin() + static_cast<std::ptrdiff_t>(Y) * MStride;
+		std::copy(Row, Row + MWidth, Pixels.begin() + static_cast<std::ptrdiff_t>(Y) * MWidth);
+	}
+}
+
+void SoftwareBackend::present(const int WindowWidth, const int WindowHeight)
+{
+	// The whole padded image is uploaded and only the visible part blitted
+	const unsigned int Rows = MTilesY * MTileSize;
+	if (MPresentTexture == 0 || MPresentWidth != MStride || MPresentHeight != Rows)
+	{
+		if (MPresentTexture != 0)
+		{
+			glDeleteFramebuffers(1, &MPresentFramebuffer);
+			GlState::deleteTextures(1, &MPresentTexture);
+		}
+		glCreateTextures(GL_TEXTURE_2D, 1, &MPresentTexture);
+		glTextureStorage2D(MPresentTexture, 1, GL_RGBA8, static_cast<GLsizei>(MStride), static_cast<GLsizei>(Rows));
+		glCreateFramebuffers(1, &MPresentFramebuffer);
+		glNamedFramebufferTexture(MPresentFramebuffer, GL_COLOR_ATTACHMENT0, MPresentTexture, 0);
+		MPresentWidth = MStride;
+		MPresentHeight = Rows;
+	}
+	glTextureSubImage2D(MPresentTexture, 0, 0, 0, static_cast<GLsizei>(MStride), static_cast<GLsizei>(Rows), GL_RGBA,
+	                    GL_UNSIGNED_BYTE, MColour.data());
+	glBlitNamedFramebuffer(MPresentFramebuffer, 0, 0, 0, static_cast<GLint>(MWidth), static_cast<GLint>(MHeight), 0, 0,
+	                       WindowWidth, WindowHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	float Farthest = 1.0f; // GLEW declares the value non-const
+	glClearNamedFramebufferfv(0, GL_DEPTH, 0, &Farthest);
+}
+
+bool SoftwareBackend::writeImage(const char* Path, const std::vector<std::uint32_t>& Pixels, const unsigned int Width,
+                                 const unsigned int Height)
+{
+	FILE* File = std::fopen(Path, "wb");
+	if (File == nullptr)
+	{
+		std::cerr << "Failed to open " << Path << " for writing" << std::endl;
+		return false;
+	}
+	std::fprintf(File, "P6\n%u %u\n255\n", Width, Height);
+	std::vector<unsigned char> Row(static_cast<std::size_t>(Width) * 3);
+	for (unsigned int Y = Height; Y-- > 0;)
+	{
+		for (unsigned int X = 0; X < Width; X++)
+		{
+			const std::uint32_t Pixel = Pixels[static_cast<std::size_t>(Y) * Width + X];
+			Row[X * 3] = static_cast<unsigned char>(Pixel & 0xff);
+			Row[X * 3 + 1] = static_cast<unsigned char>((Pixel >> 8) & 0xff);
+			Row[X * 3 + 2] = static_cast<unsigned char>((Pixel >> 16) & 0xff);
+		}
+		std::fwrite(Row.data(), 1, Row.size(), File);
+	}
+	const bool Written = std::ferror(File) == 0;
+	std::fclose(File);
+	return Written;
+}
+
+const char* SoftwareBackend::getName() const
+{
+	return "software";
+}
+
+void SoftwareBackend::clear(const GLbitfield Mask)
+{
+	if (Mask == 0 || (Mask & ~ClearBits) != 0)
+	{
+		reject("clear of unknown buffers");
+		return;
+	}
+
+	// Anything queued belongs to what is being cleared away, but still counts as drawn
+	flush();
+	if (Mask & GL_COLOR_BUFFER_BIT)
+	{
+		std::fill(MColour.begin(), MColour.end(), ClearColour);
+	}
+	if (Mask & GL_DEPTH_BUFFER_BIT)
+	{
+		std::fill(MDepth.begin(), MDepth.end(), 1.0f);
+	}
+	MRasterStats = {};
+	MStats.Clears++;
+}
+
+void SoftwareBackend::useProgram(const GLuint Program)
+{
+	MProgram = Program;
+	MStats.ProgramBinds++;
+}
+
+void SoftwareBackend::setUniforms(const RenderQueue::UniformSet& Set, const GLuint Program)
+{
+	if (Program == 0 || Program != MProgram)
+	{
+		reject("uniforms set on a program that isn't bound");
+		return;
+	}
+	const auto Found = std::find_if(MProgramScenes.begin(), MProgramScenes.end(), [Program](const auto& Scene)
+	{
+		return Scene.first == Program;
+	});
+	if (Found == MProgramScenes.end())
+	{
+		MProgramScenes.emplace_back(Program, Set.Scene);
+	}
+	else
+	{
+		Found->second = Set.Scene;
+	}
+	MStats.UniformSets++;
+}
+
+void SoftwareBackend::bindTexture(const GLuint Unit, const GLuint Texture)
+{
+	if (Unit >= MaxTextureUnits)
+	{
+		reject("texture bound past the last unit");
+		return;
+	}
+	if (Unit == 0)
+	{
+		MTexture = Texture;
+	}
+	MStats.TextureBinds++;
+}
+
+void SoftwareBackend::bindVertexArray(const GLuint Vao)
+{
+	MVao = Vao;
+	MStats.VaoBinds++;
+}
+
+void SoftwareBackend::bindInstanceSources(const GLuint Vao, const GLuint Transforms, const GLuint Animations)
+{
+	if (Vao == 0 || Transforms == 0)
+	{
+		reject("instance sources pointed at nothing");
+		return;
+	}
+	const auto Found = std::find_if(MSources.begin(), MSources.end(), [Vao](const VaoSources& Sources)
+	{
+		return Sources.Vao == Vao;
+	});
+	if (Found == MSources.end())
+	{
+		MSources.push_back({Vao, Transforms, Animations});
+	}
+	else
+	{
+		Found->Transforms = Transforms;
+		Found->Animations = Animations;
+	}
+	MStats.SourceBinds++;
+}
+
+void SoftwareBackend::draw(const DrawPacket& Packet)
+{
+	if (MProgram == 0 || Packet.Program != MProgram || MVao == 0 || Packet.Vao != MVao)
+	{
+		reject("draw without its program and vertex array bound");
+		return;
+	}
+	if (Packet.Count <= 0 || Packet.InstanceCount < 0)
+	{
+		reject("draw of nothing");
+		return;
+	}
+
+	// Only indexed triangles shaded by the scene shader, from models that were added, can be drawn here
+	const auto Scene = std::find_if(MProgramScenes.begin(), MProgramScenes.end(), [this](const auto& Candidate)
+	{
+		return Candidate.first == MProgram;
+	});
+	if (Scene == MProgramScenes.end() || !Scene->second || Packet.Mode != GL_TRIANGLES || !Packet.Indexed)
+	{
+		skip("draw not shaded by the scene shader or not indexed triangles");
+		return;
+	}
+	const MeshRange* Range = findRange(MVao, Packet.First, Packet.Count);
+	const std::optional<std::uint32_t> Texture = findTexture(MTexture);
+	if (Range == nullptr || !Texture)
+	{
+		skip("draw of a mesh or texture addModel wasn't given");
+		return;
+	}
+
+	QueuedDraw Queued{Range, *Texture, *Scene->second, nullptr, nullptr, 1};
+	if (Packet.InstanceCount > 0)
+	{
+		Queued.InstanceCount = static_cast<std::size_t>(Packet.InstanceCount);
+	}
+	if (Packet.InstanceCount > 0 && Queued.Scene.Instanced)
+	{
+		const auto Sources = std::find_if(MSources.begin(), MSources.end(), [this](const VaoSources& Candidate)
+		{
+			return Candidate.Vao == MVao;
+		});
+		if (Sources == MSources.end())
+		{
+			skip("instanced draw with no instance buffers bound");
+			return;
+		}
+		const std::size_t End = static_cast<std::size_t>(Packet.BaseInstance) + Queued.InstanceCount;
+		if (MPool != nullptr && Sources->Transforms != 0 && Sources->Transforms == MPool->getBuffer())
+		{
+			// The pool's own buffer only GL can read, but its CPU side holds the same instances in the same order
+			if (End > MPool->getCount())
+			{
+				reject("draw reading instances past the end of the pool");
+				return;
+			}
+			Queued.Transforms = MPool->getTransforms().data() + Packet.BaseInstance;
+			if (Queued.Scene.Animated)
+			{
+				Queued.Animations = MPool->getAnimations().data() + Packet.BaseInstance;
+			}
+		}
+		else
+		{
+			// Otherwise they're read from mapped buffers made here
+			const HostBuffer* Transforms = findBuffer(Sources->Transforms);
+			const HostBuffer* Animations = findBuffer(Sources->Animations);
+			if (Transforms == nullptr || (Queued.Scene.Animated && Animations == nullptr))
+			{
+				skip("instanced draw from a buffer only GL can read");
+				return;
+			}
+			if (End * sizeof(glm::mat4) > Transforms->Size ||
+				(Queued.Scene.Animated && End * sizeof(InstanceAnimation) > Animations->Size))
+			{
+				reject("draw reading instances past the end of their buffer");
+				return;
+			}
+			Queued.Transforms = reinterpret_cast<const glm::mat4*>(Transforms->Memory.get()) + Packet.BaseInstance;
+			if (Queued.Scene.Animated)
+			{
+				Queued.Animations = reinterpret_cast<const InstanceAnimation*>(Animations->Memory.get()) +
+					Packet.BaseInstance;
+			}
+		}
+	}
+
+	MDraws.push_back(Queued);
+	MStats.Draws++;
+	MStats.Elements += static_cast<unsigned long long>(Packet.Count) * Queued.InstanceCount;
+}
+
+void SoftwareBackend::flush()
+{
+	if (MDraws.empty())
+	{
+		return;
+	}
+	const auto Start = std::chrono::steady_clock::now();
+
+	// Chunks depend only on the draws, never on the thread count, and are binned in draw order below
+	std::size_t ChunkCount = 0;
+	for (std::size_t DrawIndex = 0; DrawIndex < MDraws.size(); DrawIndex++)
+	{
+		const QueuedDraw& Draw = MDraws[DrawIndex];
+		const std::size_t Triangles = std::max<std::size_t>(Draw.Range->Indices.size() / 3, 1);
+		const std::size_t PerChunk = std::max<std::size_t>(ChunkTriangles / Triangles, 1);
+		for (std::size_t First = 0; First < Draw.InstanceCount; First += PerChunk)
+		{
+			if (ChunkCount == MChunks.size())
+			{
+				MChunks.emplace_back();
+			}
+			GeometryChunk& Chunk = MChunks[ChunkCount++];
+			Chunk.Draw = static_cast<std::uint32_t>(DrawIndex);
+			Chunk.First = First;
+			Chunk.End = std::min(First + PerChunk, Draw.InstanceCount);
+		}
+	}
+	Parallel::forRange(ChunkCount, 1, [this](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			transformChunk(MChunks[I]);
+		}
+	});
+
+	// Counting sort of every chunk's bins by tile, keeping draw order within each tile
+	const std::size_t TileCount = static_cast<std::size_t>(MTilesX) * MTilesY;
+	std::fill(MTileStarts.begin(), MTileStarts.end(), 0u);
+	for (std::size_t I = 0; I < ChunkCount; I++)
+	{
+		for (const std::uint32_t Tile : MChunks[I].Bins)
+		{
+			MTileStarts[Tile + 1]++;
+		}
+		MRasterStats.Triangles += MChunks[I].Read;
+		MRasterStats.Rasterised += static_cast<unsigned int>(MChunks[I].Triangles.size());
+	}
+	for (std::size_t Tile = 0; Tile < TileCount; Tile++)
+	{
+		MTileStarts[Tile + 1] += MTileStarts[Tile];
+	}
+	MTileTriangles.resize(MTileStarts[TileCount]);
+	MTileCursors.assign(MTileStarts.begin(), MTileStarts.end() - 1);
+	for (std::size_t I = 0; I < ChunkCount; I++)
+	{
+		const GeometryChunk& Chunk = MChunks[I];
+		for (std::size_t Entry = 0; Entry < Chunk.Bins.size(); Entry++)
+		{
+			MTileTriangles[MTileCursors[Chunk.Bins[Entry]]++] = &Chunk.Triangles[Chunk.BinTriangles[Entry]];
+		}
+	}
+	const auto RasterStart = std::chrono::steady_clock::now();
+
+	// Each tile is one job's alone, so no two threads write the same pixel
+	Parallel::forRange(TileCount, 1, [this](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t Tile = Begin; Tile < End; Tile++)
+		{
+			rasteriseTile(Tile);
+		}
+	});
+
+	const auto Finish = std::chrono::steady_clock::now();
+	const std::chrono::duration<double, std::milli> GeometryElapsed = RasterStart - Start;
+	const std::chrono::duration<double, std::milli> RasterElapsed = Finish - RasterStart;
+	MRasterStats.Chunks += static_cast<unsigned int>(ChunkCount);
+	MRasterStats.BinEntries += static_cast<unsigned int>(MTileTriangles.size());
+	MRasterStats.TileSize = MTileSize;
+	MRasterStats.Threads = Parallel::getThreadCount();
+	MRasterStats.Avx2 = MAvx2;
+	MRasterStats.GeometryMilliseconds += GeometryElapsed.count();
+	MRasterStats.RasterMilliseconds += RasterElapsed.count();
+	MDraws.clear();
+}
+
+GLuint SoftwareBackend::createMappedBuffer(const std::size_t Size, void*& Mapped)
+{
+	HostBuffer Buffer{MNextName--, Size, std::make_unique<unsigned char[]>(Size)};
+	Mapped = Buffer.Memory.get();
+	MBuffers.push_back(std::move(Buffer));
+	MStats.BuffersCreated++;
+	return MBuffers.back().Name;
+}
+
+void SoftwareBackend::deleteBuffers(const GLsizei Count, const GLuint* Buffers)
+{
+	// Queued draws may still read them
+	flush();
+	for (GLsizei I = 0; I < Count; I++)
+	{
+		const GLuint Name = Buffers[I];
+		MBuffers.erase(std::remove_if(MBuffers.begin(), MBuffers.end(), [Name](const HostBuffer& Buffer)
+		{
+			return Buffer.Name == Name;
+		}), MBuffers.end());
+	}
+}
+
+GLsync SoftwareBackend::fence()
+{
+	// Draws are finished by the time anything could wait on them
+	MStats.Fences++;
+	return nullptr;
+}
+
+void SoftwareBackend::waitFence(GLsync)
+{
+}
+
+void SoftwareBackend::deleteFence(GLsync)
+{
+}
+
+void SoftwareBackend::checkErrors(const char* Stage)
+{
+	if (MUnreported > 0)
+	{
+		std::cerr << "Software backend (" << Stage << "): " << MUnreported << " invalid commands, first: " << MProblem
+			<< std::endl;
+	}
+	MUnreported = 0;
+	MProblem = nullptr;
+}
+
+void SoftwareBackend::layoutTiles()
+{
+	MTilesX = (MWidth + MTileSize - 1) / MTileSize;
+	MTilesY = (MHeight + MTileSize - 1) / MTileSize;
+	MStride = MTilesX * MTileSize;
+	const std::size_t Pixels = static_cast<std::size_t>(MStride) * MTilesY * MTileSize;
+	MColour.assign(Pixels, ClearColour);
+	MDepth.assign(Pixels, 1.0f);
+	MTileStarts.assign(static_cast<std::size_t>(MTilesX) * MTilesY + 1, 0u);
+}
+
+void SoftwareBackend::transformChunk(GeometryChunk& Chunk) const
+{
+	const QueuedDraw& Draw = MDraws[Chunk.Draw];
+	const MeshRange& Range = *Draw.Range;
+	Chunk.Triangles.clear();
+	Chunk.Bins.clear();
+	Chunk.BinTriangles.clear();
+	Chunk.Read = 0;
+	Chunk.Clip.resize(Range.Positions.size());
+	Chunk.Projected.resize(Range.Positions.size());
+	Chunk.Outcodes.resize(Range.Positions.size());
+
+	for (std::size_t Instance = Chunk.First; Instance < Chunk.End; Instance++)
+	{
+		glm::mat4 Mvp = Draw.Scene.Mvp;
+		if (Draw.Transforms != nullptr)
+		{
+			const glm::mat4& Transform = Draw.Transforms[Instance];
+			Mvp *= Draw.Animations != nullptr
+				       ? InstanceAnimator::evaluate(Transform, Draw.Animations[Instance], Draw.Scene.Time)
+				       : Transform;
+		}
+
+		// Each vertex is projected once however many triangles share it, those behind the near plane are left to
+		// the triangles clipping them
+		for (std::size_t Vertex = 0; Vertex < Range.Positions.size(); Vertex++)
+		{
+			const glm::vec4 Clip = Mvp * glm::vec4(Range.Positions[Vertex], 1.0f);
+			std::uint8_t Outcode = 0;
+			for (int Axis = 0; Axis < 3; Axis++)
+			{
+				Outcode |= (Clip[Axis] < -Clip.w ? 1 : 0) << (Axis * 2);
+				Outcode |= (Clip[Axis] > Clip.w ? 2 : 0) << (Axis * 2);
+			}
+			Chunk.Clip[Vertex] = Clip;
+			Chunk.Outcodes[Vertex] = Outcode;
+			if ((Outcode & NearOutcode) == 0)
+			{
+				Chunk.Projected[Vertex] = project(Clip, Range.TexCoords[Vertex]);
+			}
+		}
+
+		for (std::size_t I = 0; I + 2 < Range.Indices.size(); I += 3)
+		{
+			Chunk.Read++;
+			const std::uint32_t Corners[3] = {Range.Indices[I], Range.Indices[I + 1], Range.Indices[I + 2]};
+			const std::uint8_t Outcodes[3] = {Chunk.Outcodes[Corners[0]], Chunk.Outcodes[Corners[1]],
+			                                  Chunk.Outcodes[Corners[2]]};
+
+			// Wholly outside one side of the view volume
+			if ((Outcodes[0] & Outcodes[1] & Outcodes[2]) != 0)
+			{
+				continue;
+			}
+			if (((Outcodes[0] | Outcodes[1] | Outcodes[2]) & NearOutcode) == 0)
+			{
+				const ProjectedVertex* Projected[3] = {&Chunk.Projected[Corners[0]], &Chunk.Projected[Corners[1]],
+				                                       &Chunk.Projected[Corners[2]]};
+				setupTriangle(Chunk, Projected, Draw.Texture);
+				continue;
+			}
+
+			// Clipped to the near plane, z = -w, leaving up to four corners drawn as a fan
+			ProjectedVertex Polygon[4];
+			int PolygonSize = 0;
+			for (int Corner = 0; Corner < 3; Corner++)
+			{
+				const std::uint32_t From = Corners[Corner];
+				const std::uint32_t To = Corners[(Corner + 1) % 3];
+				const float FromDistance = Chunk.Clip[From].z + Chunk.Clip[From].w;
+				const float ToDistance = Chunk.Clip[To].z + Chunk.Clip[To].w;
+				if (FromDistance >= 0.0f)
+				{
+					Polygon[PolygonSize++] = project(Chunk.Clip[From], Range.TexCoords[From]);
+				}
+				if ((FromDistance >= 0.0f) != (ToDistance >= 0.0f))
+				{
+					const float T = FromDistance / (FromDistance - ToDistance);
+					Polygon[PolygonSize++] = project(glm::mix(Chunk.Clip[From], Chunk.Clip[To], T),
+					                                 glm::mix(Range.TexCoords[From], Range.TexCoords[To], T));
+				}
+			}
+			for (int Corner = 1; Corner + 1 < PolygonSize; Corner++)
+			{
+				const ProjectedVertex* Fan[3] = {&Polygon[0], &Polygon[Corner], &Polygon[Corner + 1]};
+				setupTriangle(Chunk, Fan, Draw.Texture);
+			}
+		}
+	}
+}
+
+ProjectedVertex SoftwareBackend::project(const glm::vec4& Clip, const glm::vec2& TexCoord) const
+{
+	const float InverseW = 1.0f / Clip.w;
+	return {(Clip.x * InverseW * 0.5f + 0.5f) * static_cast<float>(MWidth),
+	        (Clip.y * InverseW * 0.5f + 0.5f) * static_cast<float>(MHeight), Clip.z * InverseW * 0.5f + 0.5f,
+	        InverseW, TexCoord.x * InverseW, TexCoord.y * InverseW};
+}
+
+void SoftwareBackend::setupTriangle(GeometryChunk& Chunk, const ProjectedVertex* const (&Corners)[3],
+                                    const std::uint32_t Texture) const
+{
+	const float X[3] = {Corners[0]->X, Corners[1]->X, Corners[2]->X};
+	const float Y[3] = {Corners[0]->Y, Corners[1]->Y, Corners[2]->Y};
+
+	// Counter clockwise faces the camera, the rest are culled as GL culls back faces
+	const float Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+	if (!(Area > 0.0f))
+	{
+		return;
+	}
+
+	// Columns and rows of the pixel centres inside the bounds, clamped as floats first since a corner near the
+	// camera can land far off screen. Triangles falling between centres end here
+	RasterTriangle Triangle;
+	Triangle.MinX = ceilToInt(std::clamp(std::min({X[0], X[1], X[2]}) - 0.5f, 0.0f, static_cast<float>(MWidth)));
+	Triangle.MinY = ceilToInt(std::clamp(std::min({Y[0], Y[1], Y[2]}) - 0.5f, 0.0f, static_cast<float>(MHeight)));
+	Triangle.MaxX = static_cast<int>(std::clamp(std::max({X[0], X[1], X[2]}) - 0.5f, 0.0f,
+	                                            static_cast<float>(MWidth - 1)));
+	Triangle.MaxY = static_cast<int>(std::clamp(std::max({Y[0], Y[1], Y[2]}) - 0.5f, 0.0f,
+	                                            static_cast<float>(MHeight - 1)));
+	if (Triangle.MinX > Triangle.MaxX || Triangle.MinY > Triangle.MaxY)
+	{
+		return;
+	}
+
+	for (int Edge = 0; Edge < 3; Edge++)
+	{
+		const int Next = (Edge + 1) % 3;
+		Triangle.EdgeA[Edge] = Y[Edge] - Y[Next];
+		Triangle.EdgeB[Edge] = X[Next] - X[Edge];
+		Triangle.EdgeC[Edge] = -Triangle.EdgeA[Edge] * X[Edge] - Triangle.EdgeB[Edge] * Y[Edge];
+	}
+	const float InverseArea = 1.0f / Area;
+	setPlane(Triangle.Depth, {Corners[0]->Z, Corners[1]->Z, Corners[2]->Z}, X, Y, InverseArea);
+	setPlane(Triangle.InverseW, {Corners[0]->InverseW, Corners[1]->InverseW, Corners[2]->InverseW}, X, Y, InverseArea);
+	setPlane(Triangle.U, {Corners[0]->U, Corners[1]->U, Corners[2]->U}, X, Y, InverseArea);
+	setPlane(Triangle.V, {Corners[0]->V, Corners[1]->V, Corners[2]->V}, X, Y, InverseArea);
+	Triangle.Texture = Texture;
+
+	// Into every tile its bounds touch, unless one edge has the whole tile outside. Most triangles are a few
+	// pixels across and touch one tile, which needs no test
+	const auto Index = static_cast<std::uint32_t>(Chunk.Triangles.size());
+	const int Size = static_cast<int>(MTileSize);
+	const int FirstTileX = Triangle.MinX / Size;
+	const int FirstTileY = Triangle.MinY / Size;
+	const int LastTileX = Triangle.MaxX / Size;
+	const int LastTileY = Triangle.MaxY / Size;
+	if (FirstTileX == LastTileX && FirstTileY == LastTileY)
+	{
+		Chunk.Bins.push_back(static_cast<std::uint32_t>(FirstTileY) * MTilesX + static_cast<std::uint32_t>(FirstTileX));
+		Chunk.BinTriangles.push_back(Index);
+		Chunk.Triangles.push_back(Triangle);
+		return;
+	}
+	const std::size_t BinsBefore = Chunk.Bins.size();
+	for (int TileY = FirstTileY; TileY <= LastTileY; TileY++)
+	{
+		for (int TileX = FirstTileX; TileX <= LastTileX; TileX++)
+		{
+			const float Left = static_cast<float>(TileX * Size) + 0.5f;
+			const float Bottom = static_cast<float>(TileY * Size) + 0.5f;
+			bool Covered = true;
+			for (int Edge = 0; Edge < 3 && Covered; Edge++)
+			{
+				// Tested at the tile's pixel centre furthest inside the edge, with a hundredth of a pixel to spare so
+				// rounding never drops a tile the pixel test would have covered
+				const float CornerX = Triangle.EdgeA[Edge] >= 0.0f ? Left + static_cast<float>(Size - 1) : Left;
+				const float CornerY = Triangle.EdgeB[Edge] >= 0.0f ? Bottom + static_cast<float>(Size - 1) : Bottom;
+				const float Margin = (std::abs(Triangle.EdgeA[Edge]) + std::abs(Triangle.EdgeB[Edge])) * 0.01f;
+				Covered = Triangle.EdgeA[Edge] * CornerX + Triangle.EdgeB[Edge] * CornerY + Triangle.EdgeC[Edge] >=
+					-Margin;
+			}
+			if (Covered)
+			{
+				Chunk.Bins.push_back(static_cast<std::uint32_t>(TileY) * MTilesX + static_cast<std::uint32_t>(TileX));
+				Chunk.BinTriangles.push_back(Index);
+			}
+		}
+	}
+	if (Chunk.Bins.size() > BinsBefore)
+	{
+		Chunk.Triangles.push_back(Triangle);
+	}
+}
+
+void SoftwareBackend::rasteriseTile(const std::size_t Tile)
+{
+	const int Size = static_cast<int>(MTileSize);
+	const int TileLeft = static_cast<int>(Tile % MTilesX) * Size;
+	const int TileBottom = static_cast<int>(Tile / MTilesX) * Size;
+	const auto Stride = static_cast<int>(MStride);
+	for (std::uint32_t Entry = MTileStarts[Tile]; Entry < MTileStarts[Tile + 1]; Entry++)
+	{
+		const RasterTriangle& Triangle = *MTileTriangles[Entry];
+		const Texture& Sampled = MTextures[Triangle.Texture];
+		const int ColBegin = std::max(Triangle.MinX, TileLeft);
+		const int ColEnd = std::min(Triangle.MaxX, TileLeft + Size - 1);
+		const int RowBegin = std::max(Triangle.MinY, TileBottom);
+		const int RowEnd = std::min(Triangle.MaxY, TileBottom + Size - 1);
+#if SIMD_X86
+		if (MAvx2)
+		{
+			rasteriseAvx2(Triangle, Sampled.Texels.data(), Sampled.Width, Sampled.Height, MColour.data(),
+			              MDepth.data(), Stride, ColBegin & ~7, ColEnd, RowBegin, RowEnd);
+			continue;
+		}
+#endif
+		rasteriseScalar(Triangle, Sampled.Texels.data(), Sampled.Width, Sampled.Height, MColour.data(), MDepth.data(),
+		                Stride, ColBegin, ColEnd, RowBegin, RowEnd);
+	}
+}
+
+void SoftwareBackend::reject(const char* Problem)
+{
+	if (MProblem == nullptr)
+	{
+		MProblem = Problem;
+	}
+	MStats.Invalid++;
+	MUnreported++;
+}
+
+void SoftwareBackend::skip(const char* const Reason)
+{
+	MStats.Skipped++;
+	if (std::find(MSkipReasons.begin(), MSkipReasons.end(), Reason) == MSkipReasons.end())
+	{
+		MSkipReasons.push_back(Reason);
+		std::cerr << "Software backend skipped: " << Reason << " (further ones are only counted)" << std::endl;
+	}
+}
+
+const SoftwareBackend::HostBuffer* SoftwareBackend::findBuffer(const GLuint Name) const
+{
+	for (const HostBuffer& Buffer : MBuffers)
+	{
+		if (Buffer.Name == Name)
+		{
+			return &Buffer;
+		}
+	}
+	return nullptr;
+}
+
+const SoftwareBackend::MeshRange* SoftwareBackend::findRange(const GLuint Vao, const GLuint First,
+                                                             const GLsizei Count)
+{
+	const auto Found = std::find_if(MMeshes.begin(), MMeshes.end(), [Vao](const Mesh& Candidate)
+	{
+		return Candidate.Vao == Vao;
+	});
+	if (Found == MMeshes.end() || static_cast<std::size_t>(First) + Count > Found->Indices.size())
+	{
+		return nullptr;
+	}
+	for (const std::unique_ptr<MeshRange>& Range : Found->Ranges)
+	{
+		if (Range->First == First && Range->Count == Count)
+		{
+			return Range.get();
+		}
+	}
+
+	// Renumbered so an instance transforms only the vertices its level uses
+	auto Range = std::make_unique<MeshRange>();
+	Range->First = First;
+	Range->Count = Count;
+	const std::size_t VertexCount = Found->Vertices.size() / VertexFloats;
+	std::vector<std::uint32_t> Renumbered(VertexCount, ~0u);
+	for (std::size_t I = First; I < First + static_cast<std::size_t>(Count); I++)
+	{
+		const unsigned int Original = Found->Indices[I];
+		if (Original >= VertexCount)
+		{
+			return nullptr;
+		}
+		if (Renumbered[Original] == ~0u)
+		{
+			Renumbered[Original] = static_cast<std::uint32_t>(Range->Positions.size());
+			const float* Vertex = &Found->Vertices[Original * VertexFloats];
+			Range->Positions.emplace_back(Vertex[0], Vertex[1], Vertex[2]);
+			Range->TexCoords.emplace_back(Vertex[3], Vertex[4]);
+		}
+		Range->Indices.push_back(Renumbered[Original]);
+	}
+	Found->Ranges.push_back(std::move(Range));
+	return Found->Ranges.back().get();
+}
+
+std::optional<std::uint32_t> SoftwareBackend::findTexture(const GLuint Name) const
+{
+	for (std::size_t I = 0; I < MTextures.size(); I++)
+	{
+		if (MTextures[I].Name == Name)
+		{
+			return static_cast<std::uint32_t>(I);
+		}
+	}
+	return std::nullopt;
+}
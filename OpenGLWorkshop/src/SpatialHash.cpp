@@ -0,0 +1,123 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : SpatialHash.cpp
+Description : Implementations for the Z-order bucketed grid and its
+			  parallel counting sort build
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "SpatialHash.h"
+#include "Parallel.h"
+
+#include <algorithm>
+
+constexpr std::size_t MinBuckets = 64; // Two bits per axis, four cells before the grid wraps
+constexpr std::size_t BucketsPerPoint = 4;
+constexpr std::size_t HashGrain = 4096; // Points per task, below this threads cost more than they save
+
+SpatialHash::SpatialHash(const float CellSize)
+	: MCellSize(CellSize), MInverseCellSize(1.0f / CellSize), MBucketMask(0)
+{
+}
+
+void SpatialHash::setCellSize(const float CellSize)
+{
+	MCellSize = CellSize;
+	MInverseCellSize = 1.0f / CellSize;
+}
+
+void SpatialHash::build(const float* X, const float* Y, const float* Z, const std::size_t Count)
+{
+	std::size_t BucketCount = MinBuckets;
+	while (BucketCount < Count * BucketsPerPoint)
+	{
+		BucketCount *= 2;
+	}
+	if (BucketCount != MCursors.size())
+	{
+		// Atomics can't be moved, so the table is replaced rather than resized
+		MCursors = std::vector<std::atomic<std::uint32_t>>(BucketCount);
+		MBucketStarts.resize(BucketCount + 1);
+		MBucketMask = static_cast<std::uint32_t>(BucketCount - 1);
+	}
+	MPointBuckets.resize(Count);
+	MSorted.resize(Count);
+	for (std::atomic<std::uint32_t>& Cursor : MCursors)
+	{
+		Cursor.store(0, std::memory_order_relaxed);
+	}
+
+	// Count the points per bucket
+	Parallel::forRange(Count, HashGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			const std::uint32_t Bucket = bucketOf(static_cast<int>(std::floor(X[I] * MInverseCellSize)),
+			                                      static_cast<int>(std::floor(Y[I] * MInverseCellSize)),
+			                                      static_cast<int>(std::floor(Z[I] * MInverseCellSize)));
+			MPointBuckets[I] = Bucket;
+			MCursors[Bucket].fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+
+	// Exclusive prefix sum, the counts become each bucket's next write position
+	std::uint32_t Running = 0;
+	for (std::size_t Bucket = 0; Bucket < BucketCount; Bucket++)
+	{
+		MBucketStarts[Bucket] = Running;
+		Running += MCursors[Bucket].load(std::memory_order_relaxed);
+		MCursors[Bucket].store(MBucketStarts[Bucket], std::memory_order_relaxed);
+	}
+	MBucketStarts[BucketCount] = Running;
+
+	Parallel::forRange(Count, HashGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t I = Begin; I < End; I++)
+		{
+			const std::uint32_t Slot = MCursors[MPointBuckets[I]].fetch_add(1, std::memory_order_relaxed);
+			MSorted[Slot] = static_cast<std::uint32_t>(I);
+		}
+	});
+
+	// Threads race for slots within a bucket, sorting each one keeps queries and anything summed over
+	// them identical whatever the thread count
+	Parallel::forRange(BucketCount, HashGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		for (std::size_t Bucket = Begin; Bucket < End; Bucket++)
+		{
+			const std::uint32_t First = MBucketStarts[Bucket];
+			const std::uint32_t Last = MBucketStarts[Bucket + 1];
+			if (Last - First > 1)
+			{
+				std::sort(MSorted.begin() + First, MSorted.begin() + Last);
+			}
+		}
+	});
+}
+
+const std::vector<std::uint32_t>& SpatialHash::getSorted() const
+{
+	return MSorted;
+}
+
+float SpatialHash::getCellSize() const
+{
+	return MCellSize;
+}
+
+std::size_t SpatialHash::getBucketCount() const
+{
+	return MCursors.size();
+}
+
+std::size_t SpatialHash::getPointCount() const
+{
+	return MSorted.size();
+}
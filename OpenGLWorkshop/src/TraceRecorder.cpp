@@ -0,0 +1,288 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : TraceRecorder.cpp
+Description : Implementations for recording timed events into per thread
+			  buffers and writing them out in Chrome's trace format
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr std::size_t MaxThreads = 256; // Threads that ever record, later ones are ignored
+	constexpr int GpuThread = 0; // Thread ids in the file start at 1, GPU events all go to this one
+	constexpr const char* CategoryNames[] = {"scope", "task", "job", "gpu", "asset"};
+
+	struct TraceEvent
+	{
+		const char* Name;
+		std::uint64_t Start;
+		std::uint64_t End;
+		TraceCategory Category;
+		char Detail[TraceRecorder::DetailLength + 1]; // Empty for none
+	};
+
+	// Single producer, single consumer: the owning thread advances Head, a flush advances Tail
+	struct ThreadBuffer
+	{
+		std::unique_ptr<TraceEvent[]> Events{new TraceEvent[TraceRecorder::EventsPerThread]};
+		std::atomic<std::size_t> Head{0};
+		std::atomic<std::size_t> Tail{0};
+		std::atomic<std::size_t> Dropped{0};
+		std::atomic<const char*> Name{nullptr};
+		int Id = 0;
+	};
+
+	// Registered once per thread and kept until exit, a flush may still read a finished thread's events
+	struct BufferRegistry
+	{
+		std::atomic<ThreadBuffer*> Buffers[MaxThreads]{};
+		std::atomic<std::size_t> Count{0}; // Claimed slots, may pass MaxThreads
+
+		~BufferRegistry()
+		{
+			for (std::atomic<ThreadBuffer*>& Buffer : Buffers)
+			{
+				delete Buffer.load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	BufferRegistry GRegistry;
+	std::atomic<bool> GRecording{false};
+	std::atomic<std::uint64_t> GEpoch{0}; // Event times are written relative to the latest start
+	std::size_t GWritten = 0;
+
+	thread_local ThreadBuffer* TBuffer = nullptr;
+	thread_local bool TRegistered = false;
+
+	ThreadBuffer* currentBuffer()
+	{
+		if (!TRegistered)
+		{
+			TRegistered = true;
+			const std::size_t Slot = GRegistry.Count.fetch_add(1, std::memory_order_relaxed);
+			if (Slot < MaxThreads)
+			{
+				TBuffer = new ThreadBuffer;
+				TBuffer->Id = static_cast<int>(Slot) + 1;
+				GRegistry.Buffers[Slot].store(TBuffer, std::memory_order_release);
+			}
+		}
+		return TBuffer;
+	}
+
+	void writeEscaped(std::ostream& Out, const char* Text)
+	{
+		for (; *Text != '\0'; Text++)
+		{
+			const char Character = *Text;
+			if (Character == '"' || Character == '\\')
+			{
+				Out << '\\' << Character;
+			}
+			else if (static_cast<unsigned char>(Character) < 0x20)
+			{
+				Out << ' ';
+			}
+			else
+			{
+				Out << Character;
+			}
+		}
+	}
+
+	// Follows the process name, which is always written first
+	void writeThreadName(std::ostream& Out, const int Id, const char* Name)
+	{
+		Out << ",\n" << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << Id << R"(,"args":{"name":")";
+		writeEscaped(Out, Name);
+		Out << "\"}}";
+	}
+}
+
+void TraceRecorder::start()
+{
+	const std::size_t Count = std::min(GRegistry.Count.load(std::memory_order_acquire), MaxThreads);
+	for (std::size_t I = 0; I < Count; I++)
+	{
+		if (ThreadBuffer* Buffer = GRegistry.Buffers[I].load(std::memory_order_acquire))
+		{
+			Buffer->Tail.store(Buffer->Head.load(std::memory_order_acquire), std::memory_order_release);
+			Buffer->Dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+	GEpoch.store(now(), std::memory_order_relaxed);
+	GRecording.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::stop()
+{
+	GRecording.store(false, std::memory_order_release);
+}
+
+bool TraceRecorder::isRecording()
+{
+	return GRecording.load(std::memory_order_acquire);
+}
+
+bool TraceRecorder::flush(const char* Path)
+{
+	std::ofstream Out(Path);
+	if (!Out)
+	{
+		std::cerr << "Failed to open trace file: " << Path << std::endl;
+		return false;
+	}
+
+	const std::uint64_t Epoch = GEpoch.load(std::memory_order_relaxed);
+	const std::size_t Count = std::min(GRegistry.Count.load(std::memory_order_acquire), MaxThreads);
+	Out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+	Out << "\n" << R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"OpenGL Demo 2"}})";
+	writeThreadName(Out, GpuThread, "GPU");
+
+	GWritten = 0;
+	char Number[32];
+	for (std::size_t I = 0; I < Count; I++)
+	{
+		ThreadBuffer* Buffer = GRegistry.Buffers[I].load(std::memory_order_acquire);
+		if (Buffer == nullptr)
+		{
+			continue;
+		}
+		const char* Name = Buffer->Name.load(std::memory_order_acquire);
+		const std::string Fallback = "thread " + std::to_string(Buffer->Id);
+		writeThreadName(Out, Buffer->Id, Name != nullptr ? Name : Fallback.c_str());
+
+		const std::size_t Head = Buffer->Head.load(std::memory_order_acquire);
+		std::size_t Tail = Buffer->Tail.load(std::memory_order_relaxed);
+		for (; Tail != Head; Tail++)
+		{
+			const TraceEvent& Event = Buffer->Events[Tail % EventsPerThread];
+			const int Thread = Event.Category == TraceCategory::Gpu ? GpuThread : Buffer->Id;
+			const double Start = (static_cast<double>(Event.Start) - static_cast<double>(Epoch)) / 1000.0;
+			const std::uint64_t Nanoseconds = Event.End > Event.Start ? Event.End - Event.Start : 0;
+			const double Duration = static_cast<double>(Nanoseconds) / 1000.0;
+			Out << ",\n" << R"({"name":")";
+			writeEscaped(Out, Event.Name);
+			Out << R"(","cat":")" << CategoryNames[static_cast<int>(Event.Category)] << R"(","ph":"X","ts":)";
+			std::snprintf(Number, sizeof(Number), "%.3f", Start);
+			Out << Number << R"(,"dur":)";
+			std::snprintf(Number, sizeof(Number), "%.3f", Duration);
+			Out << Number << R"(,"pid":1,"tid":)" << Thread;
+			if (Event.Detail[0] != '\0')
+			{
+				Out << R"(,"args":{"detail":")";
+				writeEscaped(Out, Event.Detail);
+				Out << "\"}";
+			}
+			Out << "}";
+			GWritten++;
+		}
+		Buffer->Tail.store(Head, std::memory_order_release);
+	}
+	Out << "\n]}\n";
+	return static_cast<bool>(Out);
+}
+
+void TraceRecorder::setThreadName(const char* Name)
+{
+	if (ThreadBuffer* Buffer = currentBuffer())
+	{
+		Buffer->Name.store(Name, std::memory_order_release);
+	}
+}
+
+std::uint64_t TraceRecorder::now()
+{
+	return toNanoseconds(std::chrono::steady_clock::now());
+}
+
+std::uint64_t TraceRecorder::toNanoseconds(const std::chrono::steady_clock::time_point Time)
+{
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(Time.time_since_epoch()).count());
+}
+
+void TraceRecorder::record(const TraceCategory Category, const char* Name, const std::uint64_t Start,
+                           const std::uint64_t End, const char* Detail)
+{
+	if (!isRecording())
+	{
+		return;
+	}
+	ThreadBuffer* Buffer = currentBuffer();
+	if (Buffer == nullptr)
+	{
+		return;
+	}
+
+	const std::size_t Head = Buffer->Head.load(std::memory_order_relaxed);
+	if (Head - Buffer->Tail.load(std::memory_order_acquire) == EventsPerThread)
+	{
+		Buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	TraceEvent& Event = Buffer->Events[Head % EventsPerThread];
+	Event.Name = Name;
+	Event.Start = Start;
+	Event.End = End;
+	Event.Category = Category;
+	Event.Detail[0] = '\0';
+	if (Detail != nullptr)
+	{
+		// The end of a path says more than its start
+		const std::size_t Length = std::strlen(Detail);
+		const char* Kept = Length > DetailLength ? Detail + (Length - DetailLength) : Detail;
+		std::strncpy(Event.Detail, Kept, DetailLength);
+		Event.Detail[DetailLength] = '\0';
+	}
+	Buffer->Head.store(Head + 1, std::memory_order_release);
+}
+
+TraceStats TraceRecorder::getStats()
+{
+	TraceStats Stats{0, GWritten, 0};
+	const std::size_t Count = std::min(GRegistry.Count.load(std::memory_order_acquire), MaxThreads);
+	for (std::size_t I = 0; I < Count; I++)
+	{
+		if (const ThreadBuffer* Buffer = GRegistry.Buffers[I].load(std::memory_order_acquire))
+		{
+			Stats.Threads++;
+			Stats.Dropped += Buffer->Dropped.load(std::memory_order_relaxed);
+		}
+	}
+	return Stats;
+}
+
+TraceScope::TraceScope(const TraceCategory Category, const char* Name, const char* Detail)
+	: MCategory(Category), MName(Name), MDetail(Detail), MStart(TraceRecorder::isRecording() ? TraceRecorder::now() : 0)
+{
+}
+
+TraceScope::~TraceScope()
+{
+	if (MStart != 0)
+	{
+		TraceRecorder::record(MCategory, MName, MStart, TraceRecorder::now(), MDetail);
+	}
+}
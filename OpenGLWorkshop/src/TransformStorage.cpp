@@ -0,0 +1,276 @@
+/***********************************************************************
+Bachelor of Software Engineering
+Media Design School
+Auckland
+New Zealand
+
+(c) 2024 Media Design School
+
+File Name : TransformStorage.cpp
+Description : Implementations for structure of arrays transform storage
+			  and the scalar, SSE and AVX2 matrix composition kernels
+Author : Shikomisen (Ayoub Ahmad)
+Mail : ayoub.ahmad@mds.ac.nz
+**************************************************************************/
+
+#include "TransformStorage.h"
+#include "Parallel.h"
+#include "Simd.h"
+
+#include <algorithm>
+
+constexpr std::size_t ComposeBlockGrain = 1024; // Blocks of eight per task
+
+std::size_t TransformStorage::size() const
+{
+	return PositionX.size();
+}
+
+void TransformStorage::resize(const std::size_t Count)
+{
+	for (std::vector<float>* Component : {&PositionX, &PositionY, &PositionZ, &RotationX, &RotationY, &RotationZ,
+	                                      &RotationW, &ScaleX, &ScaleY, &ScaleZ})
+	{
+		Component->resize(Count);
+	}
+}
+
+void TransformStorage::setTransform(const std::size_t Index, const glm::vec3& Position, const glm::quat& Rotation,
+                                    const glm::vec3& Scale)
+{
+	PositionX[Index] = Position.x;
+	PositionY[Index] = Position.y;
+	PositionZ[Index] = Position.z;
+	RotationX[Index] = Rotation.x;
+	RotationY[Index] = Rotation.y;
+	RotationZ[Index] = Rotation.z;
+	RotationW[Index] = Rotation.w;
+	ScaleX[Index] = Scale.x;
+	ScaleY[Index] = Scale.y;
+	ScaleZ[Index] = Scale.z;
+}
+
+void TransformStorage::pushTransform(const glm::vec3& Position, const glm::quat& Rotation, const glm::vec3& Scale)
+{
+	resize(size() + 1);
+	setTransform(size() - 1, Position, Rotation, Scale);
+}
+
+void TransformComposer::compose(const TransformStorage& Transforms, const std::size_t Begin, const std::size_t End,
+                                glm::mat4* Out)
+{
+#if SIMD_X86
+	if (Simd::hasAvx2())
+	{
+		composeAvx2(Transforms, Begin, End, Out);
+	}
+	else
+	{
+		composeSse(Transforms, Begin, End, Out);
+	}
+#else
+	composeScalar(Transforms, Begin, End, Out);
+#endif
+}
+
+void TransformComposer::composeParallel(const TransformStorage& Transforms, glm::mat4* Out)
+{
+	const std::size_t Count = Transforms.size();
+	Parallel::forRange((Count + 7) / 8, ComposeBlockGrain, [&](const std::size_t Begin, const std::size_t End)
+	{
+		const std::size_t First = Begin * 8;
+		compose(Transforms, First, std::min(End * 8, Count), Out + First);
+	});
+}
+
+void TransformComposer::composeScalar(const TransformStorage& Transforms, const std::size_t Begin,
+                                      const std::size_t End, glm::mat4* Out)
+{
+	for (std::size_t I = Begin; I < End; I++)
+	{
+		const float X = Transforms.RotationX[I];
+		const float Y = Transforms.RotationY[I];
+		const float Z = Transforms.RotationZ[I];
+		const float W = Transforms.RotationW[I];
+		const float Sx = Transforms.ScaleX[I];
+		const float Sy = Transforms.ScaleY[I];
+		const float Sz = Transforms.ScaleZ[I];
+
+		// Same expansion as glm::mat3_cast, columns scaled by the per-axis scale
+		glm::mat4& Matrix = Out[I - Begin];
+		Matrix[0] = glm::vec4((1.0f - 2.0f * (Y * Y + Z * Z)) * Sx, 2.0f * (X * Y + W * Z) * Sx,
+		                      2.0f * (X * Z - W * Y) * Sx, 0.0f);
+		Matrix[1] = glm::vec4(2.0f * (X * Y - W * Z) * Sy, (1.0f - 2.0f * (X * X + Z * Z)) * Sy,
+		                      2.0f * (Y * Z + W * X) * Sy, 0.0f);
+		Matrix[2] = glm::vec4(2.0f * (X * Z + W * Y) * Sz, 2.0f * (Y * Z - W * X) * Sz,
+		                      (1.0f - 2.0f * (X * X + Y * Y)) * Sz, 0.0f);
+		Matrix[3] = glm::vec4(Transforms.PositionX[I], Transforms.PositionY[I], Transforms.PositionZ[I], 1.0f);
+	}
+}
+
+void TransformComposer::composeSse(const TransformStorage& Transforms, const std::size_t Begin,
+                                   const std::size_t End, glm::mat4* Out)
+{
+	std::size_t I = Begin;
+#if SIMD_X86
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Zero = _mm_setzero_ps();
+
+	// Four transforms per iteration, one lane each
+	for (; I + 4 <= End; I += 4)
+	{
+		const __m128 Qx = _mm_loadu_ps(&Transforms.RotationX[I]);
+		const __m128 Qy = _mm_loadu_ps(&Transforms.RotationY[I]);
+		const __m128 Qz = _mm_loadu_ps(&Transforms.RotationZ[I]);
+		const __m128 Qw = _mm_loadu_ps(&Transforms.RotationW[I]);
+		const __m128 Sx = _mm_loadu_ps(&Transforms.ScaleX[I]);
+		const __m128 Sy = _mm_loadu_ps(&Transforms.ScaleY[I]);
+		const __m128 Sz = _mm_loadu_ps(&Transforms.ScaleZ[I]);
+
+		const __m128 X2 = _mm_add_ps(Qx, Qx);
+		const __m128 Y2 = _mm_add_ps(Qy, Qy);
+		const __m128 Z2 = _mm_add_ps(Qz, Qz);
+		const __m128 Xx = _mm_mul_ps(Qx, X2);
+		const __m128 Yy = _mm_mul_ps(Qy, Y2);
+		const __m128 Zz = _mm_mul_ps(Qz, Z2);
+		const __m128 Xy = _mm_mul_ps(Qx, Y2);
+		const __m128 Xz = _mm_mul_ps(Qx, Z2);
+		const __m128 Yz = _mm_mul_ps(Qy, Z2);
+		const __m128 Wx = _mm_mul_ps(Qw, X2);
+		const __m128 Wy = _mm_mul_ps(Qw, Y2);
+		const __m128 Wz = _mm_mul_ps(Qw, Z2);
+
+		__m128 C0X = _mm_mul_ps(_mm_sub_ps(One, _mm_add_ps(Yy, Zz)), Sx);
+		__m128 C0Y = _mm_mul_ps(_mm_add_ps(Xy, Wz), Sx);
+		__m128 C0Z = _mm_mul_ps(_mm_sub_ps(Xz, Wy), Sx);
+		__m128 C0W = Zero;
+		__m128 C1X = _mm_mul_ps(_mm_sub_ps(Xy, Wz), Sy);
+		__m128 C1Y = _mm_mul_ps(_mm_sub_ps(One, _mm_add_ps(Xx, Zz)), Sy);
+		__m128 C1Z = _mm_mul_ps(_mm_add_ps(Yz, Wx), Sy);
+		__m128 C1W = Zero;
+		__m128 C2X = _mm_mul_ps(_mm_add_ps(Xz, Wy), Sz);
+		__m128 C2Y = _mm_mul_ps(_mm_sub_ps(Yz, Wx), Sz);
+		__m128 C2Z = _mm_mul_ps(_mm_sub_ps(One, _mm_add_ps(Xx, Yy)), Sz);
+		__m128 C2W = Zero;
+		__m128 C3X = _mm_loadu_ps(&Transforms.PositionX[I]);
+		__m128 C3Y = _mm_loadu_ps(&Transforms.PositionY[I]);
+		__m128 C3Z = _mm_loadu_ps(&Transforms.PositionZ[I]);
+		__m128 C3W = One;
+
+		// Transpose lanes back into one column per matrix
+		_MM_TRANSPOSE4_PS(C0X, C0Y, C0Z, C0W);
+		_MM_TRANSPOSE4_PS(C1X, C1Y, C1Z, C1W);
+		_MM_TRANSPOSE4_PS(C2X, C2Y, C2Z, C2W);
+		_MM_TRANSPOSE4_PS(C3X, C3Y, C3Z, C3W);
+
+		float* Dst = reinterpret_cast<float*>(Out + (I - Begin));
+		_mm_storeu_ps(Dst + 0, C0X);
+		_mm_storeu_ps(Dst + 4, C1X);
+		_mm_storeu_ps(Dst + 8, C2X);
+		_mm_storeu_ps(Dst + 12, C3X);
+		_mm_storeu_ps(Dst + 16, C0Y);
+		_mm_storeu_ps(Dst + 20, C1Y);
+		_mm_storeu_ps(Dst + 24, C2Y);
+		_mm_storeu_ps(Dst + 28, C3Y);
+		_mm_storeu_ps(Dst + 32, C0Z);
+		_mm_storeu_ps(Dst + 36, C1Z);
+		_mm_storeu_ps(Dst + 40, C2Z);
+		_mm_storeu_ps(Dst + 44, C3Z);
+		_mm_storeu_ps(Dst + 48, C0W);
+		_mm_storeu_ps(Dst + 52, C1W);
+		_mm_storeu_ps(Dst + 56, C2W);
+		_mm_storeu_ps(Dst + 60, C3W);
+	}
+#endif
+	composeScalar(Transforms, I, End, Out + (I - Begin));
+}
+
+#if SIMD_X86
+// Transposes four 8-wide registers and writes the resulting column into eight consecutive matrices
+SIMD_TARGET_AVX2 static void storeColumns8(const __m256 X, const __m256 Y, const __m256 Z, const __m256 W,
+                                           float* Dst)
+{
+	const __m256 T0 = _mm256_unpacklo_ps(X, Y);
+	const __m256 T1 = _mm256_unpackhi_ps(X, Y);
+	const __m256 T2 = _mm256_unpacklo_ps(Z, W);
+	const __m256 T3 = _mm256_unpackhi_ps(Z, W);
+	const __m256 R0 = _mm256_shuffle_ps(T0, T2, 0x44); // Matrices 0 and 4
+	const __m256 R1 = _mm256_shuffle_ps(T0, T2, 0xEE); // Matrices 1 and 5
+	const __m256 R2 = _mm256_shuffle_ps(T1, T3, 0x44); // Matrices 2 and 6
+	const __m256 R3 = _mm256_shuffle_ps(T1, T3, 0xEE); // Matrices 3 and 7
+
+	_mm_storeu_ps(Dst + 0 * 16, _mm256_castps256_ps128(R0));
+	_mm_storeu_ps(Dst + 1 * 16, _mm256_castps256_ps128(R1));
+	_mm_storeu_ps(Dst + 2 * 16, _mm256_castps256_ps128(R2));
+	_mm_storeu_ps(Dst + 3 * 16, _mm256_castps256_ps128(R3));
+	_mm_storeu_ps(Dst + 4 * 16, _mm256_extractf128_ps(R0, 1));
+	_mm_storeu_ps(Dst + 5 * 16, _mm256_extractf128_ps(R1, 1));
+	_mm_storeu_ps(Dst + 6 * 16, _mm256_extractf128_ps(R2, 1));
+	_mm_storeu_ps(Dst + 7 * 16, _mm256_extractf128_ps(R3, 1));
+}
+
+SIMD_TARGET_AVX2 static std::size_t composeAvx2Block(const TransformStorage& Transforms, std::size_t I,
+                                                     const std::size_t End, float* Dst)
+{
+	const __m256 One = _mm256_set1_ps(1.0f);
+	const __m256 Zero = _mm256_setzero_ps();
+
+	// Eight transforms per iteration, one lane each
+	for (; I + 8 <= End; I += 8, Dst += 8 * 16)
+	{
+		const __m256 Qx = _mm256_loadu_ps(&Transforms.RotationX[I]);
+		const __m256 Qy = _mm256_loadu_ps(&Transforms.RotationY[I]);
+		const __m256 Qz = _mm256_loadu_ps(&Transforms.RotationZ[I]);
+		const __m256 Qw = _mm256_loadu_ps(&Transforms.RotationW[I]);
+		const __m256 Sx = _mm256_loadu_ps(&Transforms.ScaleX[I]);
+		const __m256 Sy = _mm256_loadu_ps(&Transforms.ScaleY[I]);
+		const __m256 Sz = _mm256_loadu_ps(&Transforms.ScaleZ[I]);
+
+		const __m256 X2 = _mm256_add_ps(Qx, Qx);
+		const __m256 Y2 = _mm256_add_ps(Qy, Qy);
+		const __m256 Z2 = _mm256_add_ps(Qz, Qz);
+		const __m256 Xx = _mm256_mul_ps(Qx, X2);
+		const __m256 Yy = _mm256_mul_ps(Qy, Y2);
+		const __m256 Zz = _mm256_mul_ps(Qz, Z2);
+		const __m256 Xy = _mm256_mul_ps(Qx, Y2);
+		const __m256 Xz = _mm256_mul_ps(Qx, Z2);
+		const __m256 Yz = _mm256_mul_ps(Qy, Z2);
+		const __m256 Wx = _mm256_mul_ps(Qw, X2);
+		const __m256 Wy = _mm256_mul_ps(Qw, Y2);
+		const __m256 Wz = _mm256_mul_ps(Qw, Z2);
+
+		storeColumns8(_mm256_mul_ps(_mm256_sub_ps(One, _mm256_add_ps(Yy, Zz)), Sx),
+		              _mm256_mul_ps(_mm256_add_ps(Xy, Wz), Sx),
+		              _mm256_mul_ps(_mm256_sub_ps(Xz, Wy), Sx), Zero, Dst + 0);
+		storeColumns8(_mm256_mul_ps(_mm256_sub_ps(Xy, Wz), Sy),
+		              _mm256_mul_ps(_mm256_sub_ps(One, _mm256_add_ps(Xx, Zz)), Sy),
+		              _mm256_mul_ps(_mm256_add_ps(Yz, Wx), Sy), Zero, Dst + 4);
+		storeColumns8(_mm256_mul_ps(_mm256_add_ps(Xz, Wy), Sz),
+		              _mm256_mul_ps(_mm256_sub_ps(Yz, Wx), Sz),
+		              _mm256_mul_ps(_mm256_sub_ps(One, _mm256_add_ps(Xx, Yy)), Sz), Zero, Dst + 8);
+		storeColumns8(_mm256_loadu_ps(&Transforms.PositionX[I]), _mm256_loadu_ps(&Transforms.PositionY[I]),
+		              _mm256_loadu_ps(&Transforms.PositionZ[I]), One, Dst + 12);
+	}
+	return I;
+}
+#endif
+
+void TransformComposer::composeAvx2(const TransformStorage& Transforms, const std::size_t Begin,
+                                    const std::size_t End, glm::mat4* Out)
+{
+#if SIMD_X86
+	const std::size_t I = composeAvx2Block(Transforms, Begin, End, reinterpret_cast<float*>(Out));
+	composeSse(Transforms, I, End, Out + (I - Begin));
+#else
+	composeScalar(Transforms, Begin, End, Out);
+#endif
+}
+
+const char* TransformComposer::getKernelName()
+{
+#if SIMD_X86
+	return Simd::hasAvx2() ? "AVX2 (8 wide)" : "SSE (4 wide)";
+#else
+	return "Scalar";
+#endif
+}